@@ -431,3 +431,46 @@ void CIN_Close( cinematics_t *cin ) {
 	CIN_Free( cin );
 	CIN_FreePool( &mempool );
 }
+
+/*
+* CIN_Benchmark_f
+*
+* Decodes a cinematic as fast as possible without displaying it.
+*/
+void CIN_Benchmark_f( void ) {
+	bool yuv, redraw;
+	unsigned int frames = 0;
+	uint64_t start, usec;
+	cinematics_t *cin;
+
+	if( trap_Cmd_Argc() != 2 ) {
+		Com_Printf( "Usage: %s <filename>\n", trap_Cmd_Argv( 0 ) );
+		return;
+	}
+
+	start = trap_Microseconds();
+
+	cin = CIN_Open( trap_Cmd_Argv( 1 ), trap_Milliseconds(), CIN_NOAUDIO, &yuv, NULL );
+	if( !cin ) {
+		Com_Printf( "Couldn't open %s\n", trap_Cmd_Argv( 1 ) );
+		return;
+	}
+
+	while( true ) {
+		if( yuv ) {
+			if( !CIN_ReadNextFrameYUV( cin, NULL, NULL, NULL, NULL, &redraw ) ) {
+				break;
+			}
+		} else {
+			if( !CIN_ReadNextFrame( cin, NULL, NULL, NULL, NULL, &redraw ) ) {
+				break;
+			}
+		}
+		frames++;
+	}
+
+	CIN_Close( cin );
+
+	usec = trap_Microseconds() - start;
+	Com_Printf( "%u frames in %.3f seconds: %.1f fps\n", frames, usec / 1000000.0, usec ? frames * 1000000.0 / usec : 0.0 );
+}
@@ -116,4 +116,6 @@ void CIN_Reset( cinematics_t *cin, int64_t cur_time );
 
 void CIN_Close( cinematics_t *cin );
 
+void CIN_Benchmark_f( void );
+
 #endif
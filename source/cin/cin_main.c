@@ -34,6 +34,8 @@ int CIN_API( void ) {
 bool CIN_Init( bool verbose ) {
 	cinPool = CIN_AllocPool( "Generic pool" );
 
+	trap_Cmd_AddCommand( "cinbenchmark", CIN_Benchmark_f );
+
 	return true;
 }
 
@@ -41,6 +43,8 @@ bool CIN_Init( bool verbose ) {
 * CIN_Shutdown
 */
 void CIN_Shutdown( bool verbose ) {
+	trap_Cmd_RemoveCommand( "cinbenchmark" );
+
 	CIN_FreePool( &cinPool );
 }
 
@@ -24,7 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // cin_public.h -- cinematics playback as a separate dll, making the engine
 // container- and format- agnostic
 
-#define CIN_API_VERSION             8
+#define CIN_API_VERSION             9
 
 #define CIN_LOOP                    1
 #define CIN_NOAUDIO                 2
@@ -131,6 +131,18 @@ typedef struct {
 	void *( *Sys_LoadLibrary )( const char *name, dllfunc_t * funcs );
 	void ( *Sys_UnloadLibrary )( void **lib );
 
+	// multithreading
+	struct qthread_s *( *Thread_Create )( void *( *routine )( void* ), void *param );
+	void ( *Thread_Join )( struct qthread_s *thread );
+	struct qmutex_s *( *Mutex_Create )( void );
+	void ( *Mutex_Destroy )( struct qmutex_s **mutex );
+	void ( *Mutex_Lock )( struct qmutex_s *mutex );
+	void ( *Mutex_Unlock )( struct qmutex_s *mutex );
+	struct qcondvar_s *( *CondVar_Create )( void );
+	void ( *CondVar_Destroy )( struct qcondvar_s **cond );
+	bool ( *CondVar_Wait )( struct qcondvar_s *cond, struct qmutex_s *mutex, unsigned int timeout_msec );
+	void ( *CondVar_Wake )( struct qcondvar_s *cond );
+
 	// managed memory allocation
 	struct mempool_s *( *Mem_AllocPool )( const char *name, const char *filename, int fileline );
 	void *( *Mem_Alloc )( struct mempool_s *pool, size_t size, const char *filename, int fileline );
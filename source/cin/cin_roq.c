@@ -32,16 +32,56 @@ Based on work by Dr. Tim Ferguson: http://www.csse.monash.edu.au/~timf/
 #include "cin_roq.h"
 #include "roq.h"
 
+#if ( defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 ) ) && !defined ( C_ONLY )
+# include <emmintrin.h>
+# define CIN_SSE2
+#elif ( defined ( __ARM_NEON__ ) || defined ( __ARM_NEON ) ) && !defined ( C_ONLY )
+# include <arm_neon.h>
+# define CIN_NEON
+#endif
+
+// Frames are decoded on a separate thread up to RoQ_LOOKAHEAD_FRAMES ahead of
+// the one being displayed, so reading the next frame is usually just a matter of
+// taking it out of the queue.
+#define RoQ_LOOKAHEAD_FRAMES    4
+#define RoQ_QUEUE_SIZE          ( RoQ_LOOKAHEAD_FRAMES + 1 )
+
+typedef struct {
+	bool video;                     // false for the end of file
+	cin_yuv_t cyuv;
+	uint8_t         *pixels;
+	size_t pixelsSize;
+
+	// audio chunks preceding the frame, in the order they were read
+	unsigned short channels;
+	unsigned int numSamples;        // per channel
+	unsigned int samplesSize;
+	short           *samples;
+} roq_frame_t;
+
 typedef struct {
 	roq_chunk_t chunk;
 	roq_cell_t cells[256];
 	roq_qcell_t qcells[256];
 
+	int width, height;
 	int width_2;
 	int height_2;
+	unsigned int decodedFrames;
 
 	cin_yuv_t cyuv[2];
 	uint8_t         *yuv_pixels;
+
+	struct qthread_s *thread;
+	struct qmutex_s *lock;
+	struct qcondvar_s *filled, *drained;
+	volatile bool quit;
+
+	// frames are written at tail by the decoder and read at head, the frame at
+	// head stays in place until the next read as the caller may still be using it
+	unsigned int head, tail;
+	roq_frame_t *current;
+	roq_frame_t frames[RoQ_QUEUE_SIZE];
 } roq_info_t;
 
 static short snd_sqr_arr[256];
@@ -110,12 +150,12 @@ static void RoQ_ReadInfo( cinematics_t *cin ) {
 
 	width = LittleShort( t[0] );
 	height = LittleShort( t[1] );
-	if( cin->width != width || cin->height != height ) {
+	if( roq->width != width || roq->height != height ) {
 		int i, j;
 		int width_2 = width / 2, height_2 = height / 2;
 
-		cin->width = width;
-		cin->height = height;
+		roq->width = width;
+		roq->height = height;
 
 		if( roq->yuv_pixels ) {
 			CIN_Free( roq->yuv_pixels );
@@ -208,63 +248,153 @@ static void RoQ_ApplyVector2x2( cinematics_t *cin, int xpos, int ypos, const roq
 }
 
 /*
-* RoQ_ApplyVector4x4
+* RoQ_CopyRows8
 */
-static void RoQ_ApplyVector4x4( cinematics_t *cin, int xpos, int ypos, const roq_cell_t *cell ) {
-	uint8_t *dst_y0, *dst_y1;
-	uint8_t *dst_u0, *dst_v0;
-	uint8_t p[4], u[2], v[2];
-	roq_info_t *roq = cin->fdata;
-	cin_img_plane_t *y_plane, *u_plane, *v_plane;
-	int xpos_2 = xpos / 2, ypos_2 = ypos / 2;
+static inline void RoQ_CopyRows8( uint8_t *dst, int dst_stride, const uint8_t *src, int src_stride, int rows ) {
+	int j;
+
+	for( j = 0; j < rows; j++ ) {
+#if defined( CIN_SSE2 )
+		_mm_storel_epi64( ( __m128i * )dst, _mm_loadl_epi64( ( const __m128i * )src ) );
+#elif defined( CIN_NEON )
+		vst1_u8( dst, vld1_u8( src ) );
+#else
+		memcpy( dst, src, 8 );
+#endif
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
 
-	// Y
-	y_plane = &roq->cyuv[0].yuv[0];
-	dst_y0 = y_plane->data + ypos * y_plane->stride + xpos;
-	dst_y1 = dst_y0 + y_plane->stride;
+/*
+* RoQ_CopyRows4
+*/
+static inline void RoQ_CopyRows4( uint8_t *dst, int dst_stride, const uint8_t *src, int src_stride, int rows ) {
+	int j;
 
-	p[0] = p[1] = cell->y[0];
-	p[2] = p[3] = cell->y[1];
-	*(int *)dst_y0 = *(int *)p;
-	*(int *)dst_y1 = *(int *)p;
+	for( j = 0; j < rows; j++ ) {
+		memcpy( dst, src, 4 );
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
 
-	dst_y0 += y_plane->stride * 2;
-	dst_y1 += y_plane->stride * 2;
+/*
+* RoQ_CopyRows2
+*/
+static inline void RoQ_CopyRows2( uint8_t *dst, int dst_stride, const uint8_t *src, int src_stride, int rows ) {
+	int j;
 
-	p[0] = p[1] = cell->y[2];
-	p[2] = p[3] = cell->y[3];
-	*(int *)dst_y0 = *(int *)p;
-	*(int *)dst_y1 = *(int *)p;
+	for( j = 0; j < rows; j++ ) {
+		memcpy( dst, src, 2 );
+		src += src_stride;
+		dst += dst_stride;
+	}
+}
 
-	// U
-	u_plane = &roq->cyuv[0].yuv[1];
-	dst_u0 = u_plane->data + ypos_2 * u_plane->stride + xpos_2;
+/*
+* RoQ_ApplyVector8x8
+*
+* Fills an 8x8 block with four 4x4 vectors, each of them being a 2x2 cell scaled up.
+*/
+static void RoQ_ApplyVector8x8( cinematics_t *cin, int xpos, int ypos, const roq_qcell_t *qcell ) {
+	int i;
+	uint8_t *dst;
+	uint8_t y[16], u[2][4], v[2][4];
+	const roq_cell_t *cell[4];
+	roq_info_t *roq = cin->fdata;
+	cin_img_plane_t *plane;
 
-	// V
-	v_plane = &roq->cyuv[0].yuv[2];
-	dst_v0 = v_plane->data + ypos_2 * v_plane->stride + xpos_2;
+	for( i = 0; i < 4; i++ ) {
+		cell[i] = roq->cells + qcell->idx[i];
+	}
+
+	// the block at half resolution, row by row
+	for( i = 0; i < 4; i++ ) {
+		const roq_cell_t *left = cell[i & 2], *right = cell[( i & 2 ) + 1];
+		int r = ( i & 1 ) * 2;
+
+		y[i * 4 + 0] = left->y[r];
+		y[i * 4 + 1] = left->y[r + 1];
+		y[i * 4 + 2] = right->y[r];
+		y[i * 4 + 3] = right->y[r + 1];
+	}
 
-	u[0] = u[1] = cell->u;
-	v[0] = v[1] = cell->v;
+	for( i = 0; i < 2; i++ ) {
+		u[i][0] = u[i][1] = cell[i * 2]->u;
+		u[i][2] = u[i][3] = cell[i * 2 + 1]->u;
+		v[i][0] = v[i][1] = cell[i * 2]->v;
+		v[i][2] = v[i][3] = cell[i * 2 + 1]->v;
+	}
 
-	*(short *)dst_u0 = *(short *)u;
-	*(short *)dst_v0 = *(short *)v;
+	// Y
+	plane = &roq->cyuv[0].yuv[0];
+	dst = plane->data + ypos * plane->stride + xpos;
+
+#if defined( CIN_SSE2 )
+	{
+		__m128i p = _mm_loadu_si128( ( const __m128i * )y );
+		__m128i rows[4];
+
+		rows[0] = _mm_unpacklo_epi8( p, p );
+		rows[1] = _mm_srli_si128( rows[0], 8 );
+		rows[2] = _mm_unpackhi_epi8( p, p );
+		rows[3] = _mm_srli_si128( rows[2], 8 );
+
+		for( i = 0; i < 4; i++ ) {
+			_mm_storel_epi64( ( __m128i * )dst, rows[i] );
+			_mm_storel_epi64( ( __m128i * )( dst + plane->stride ), rows[i] );
+			dst += plane->stride * 2;
+		}
+	}
+#elif defined( CIN_NEON )
+	for( i = 0; i < 2; i++ ) {
+		uint8x8_t p = vld1_u8( y + i * 8 );
+		uint8x8x2_t rows = vzip_u8( p, p );
+
+		vst1_u8( dst, rows.val[0] );
+		vst1_u8( dst + plane->stride, rows.val[0] );
+		dst += plane->stride * 2;
+		vst1_u8( dst, rows.val[1] );
+		vst1_u8( dst + plane->stride, rows.val[1] );
+		dst += plane->stride * 2;
+	}
+#else
+	for( i = 0; i < 4; i++ ) {
+		int j;
+		uint8_t row[8];
 
-	dst_u0 += u_plane->stride;
-	dst_v0 += v_plane->stride;
+		for( j = 0; j < 8; j++ ) {
+			row[j] = y[i * 4 + j / 2];
+		}
+		memcpy( dst, row, 8 );
+		memcpy( dst + plane->stride, row, 8 );
+		dst += plane->stride * 2;
+	}
+#endif
 
-	*(short *)dst_u0 = *(short *)u;
-	*(short *)dst_v0 = *(short *)v;
+	// U
+	plane = &roq->cyuv[0].yuv[1];
+	dst = plane->data + ( ypos / 2 ) * plane->stride + xpos / 2;
+	for( i = 0; i < 4; i++, dst += plane->stride ) {
+		memcpy( dst, u[i / 2], 4 );
+	}
+
+	// V
+	plane = &roq->cyuv[0].yuv[2];
+	dst = plane->data + ( ypos / 2 ) * plane->stride + xpos / 2;
+	for( i = 0; i < 4; i++, dst += plane->stride ) {
+		memcpy( dst, v[i / 2], 4 );
+	}
 }
 
 /*
 * RoQ_ApplyMotion4x4
 */
 static void RoQ_ApplyMotion4x4( cinematics_t *cin, int xpos, int ypos, uint8_t mv, char mean_x, char mean_y ) {
-	int i, j;
+	int i;
 	int xpos_2, ypos_2;
 	int xpos1, ypos1, xpos1_2, ypos1_2;
-	uint8_t *src, *dst;
 	roq_info_t *roq = cin->fdata;
 	cin_img_plane_t *plane, *plane1;
 
@@ -280,25 +410,15 @@ static void RoQ_ApplyMotion4x4( cinematics_t *cin, int xpos, int ypos, uint8_t m
 	// Y
 	plane  = &roq->cyuv[0].yuv[0];
 	plane1 = &roq->cyuv[1].yuv[0];
-	dst = plane->data  + ( ypos *  plane->stride  + xpos );
-	src = plane1->data + ( ypos1 * plane1->stride + xpos1 );
-	for( j = 0; j < 4; j++ ) {
-		*(int *)dst = *(int *)src;
-		src += plane1->stride;
-		dst += plane->stride;
-	}
+	RoQ_CopyRows4( plane->data + ( ypos * plane->stride + xpos ), plane->stride,
+				   plane1->data + ( ypos1 * plane1->stride + xpos1 ), plane1->stride, 4 );
 
 	// UV
 	for( i = 1; i < 3; i++ ) {
 		plane  = &roq->cyuv[0].yuv[i];
 		plane1 = &roq->cyuv[1].yuv[i];
-		dst = plane->data  + ( ypos_2 *  plane->stride  + xpos_2 );
-		src = plane1->data + ( ypos1_2 * plane1->stride + xpos1_2 );
-		for( j = 0; j < 2; j++ ) {
-			*(short *)dst = *(short *)src;
-			src += plane1->stride;
-			dst += plane->stride;
-		}
+		RoQ_CopyRows2( plane->data + ( ypos_2 * plane->stride + xpos_2 ), plane->stride,
+					   plane1->data + ( ypos1_2 * plane1->stride + xpos1_2 ), plane1->stride, 2 );
 	}
 }
 
@@ -306,10 +426,9 @@ static void RoQ_ApplyMotion4x4( cinematics_t *cin, int xpos, int ypos, uint8_t m
 * RoQ_ApplyMotion8x8
 */
 static void RoQ_ApplyMotion8x8( cinematics_t *cin, int xpos, int ypos, uint8_t mv, char mean_x, char mean_y ) {
-	int i, j;
+	int i;
 	int xpos_2, ypos_2;
 	int xpos1, ypos1, xpos1_2, ypos1_2;
-	uint8_t *src, *dst;
 	roq_info_t *roq = cin->fdata;
 	cin_img_plane_t *plane, *plane1;
 
@@ -325,25 +444,15 @@ static void RoQ_ApplyMotion8x8( cinematics_t *cin, int xpos, int ypos, uint8_t m
 	// Y
 	plane  = &roq->cyuv[0].yuv[0];
 	plane1 = &roq->cyuv[1].yuv[0];
-	dst = plane->data  + ( ypos *  plane->stride  + xpos );
-	src = plane1->data + ( ypos1 * plane1->stride + xpos1 );
-	for( j = 0; j < 8; j++ ) {
-		memcpy( dst, src, 8 );
-		src += plane1->stride;
-		dst += plane->stride;
-	}
+	RoQ_CopyRows8( plane->data + ( ypos * plane->stride + xpos ), plane->stride,
+				   plane1->data + ( ypos1 * plane1->stride + xpos1 ), plane1->stride, 8 );
 
 	// UV
 	for( i = 1; i < 3; i++ ) {
 		plane  = &roq->cyuv[0].yuv[i];
 		plane1 = &roq->cyuv[1].yuv[i];
-		dst = plane->data  + ( ypos_2 *  plane->stride  + xpos_2 );
-		src = plane1->data + ( ypos1_2 * plane1->stride + xpos1_2 );
-		for( j = 0; j < 4; j++ ) {
-			*(int *)dst = *(int *)src;
-			src += plane1->stride;
-			dst += plane->stride;
-		}
+		RoQ_CopyRows4( plane->data + ( ypos_2 * plane->stride + xpos_2 ), plane->stride,
+					   plane1->data + ( ypos1_2 * plane1->stride + xpos1_2 ), plane1->stride, 4 );
 	}
 }
 
@@ -351,7 +460,7 @@ static void RoQ_ApplyMotion8x8( cinematics_t *cin, int xpos, int ypos, uint8_t m
 * RoQ_ReadVideo
 */
 #define RoQ_READ_BLOCK  0x4000
-static cin_yuv_t *RoQ_ReadVideo( cinematics_t *cin ) {
+static void RoQ_ReadVideo( cinematics_t *cin ) {
 	roq_info_t *roq = cin->fdata;
 	roq_chunk_t *chunk = &roq->chunk;
 	int i, vqflg, vqflg_pos, vqid;
@@ -391,10 +500,7 @@ static cin_yuv_t *RoQ_ReadVideo( cinematics_t *cin ) {
 					case RoQ_ID_SLD:
 						RoQ_ReadByte( c );
 						qcell = roq->qcells + c;
-						RoQ_ApplyVector4x4( cin, xp, yp, roq->cells + qcell->idx[0] );
-						RoQ_ApplyVector4x4( cin, xp + 4, yp, roq->cells + qcell->idx[1] );
-						RoQ_ApplyVector4x4( cin, xp, yp + 4, roq->cells + qcell->idx[2] );
-						RoQ_ApplyVector4x4( cin, xp + 4, yp + 4, roq->cells + qcell->idx[3] );
+						RoQ_ApplyVector8x8( cin, xp, yp, qcell );
 						break;
 
 					case RoQ_ID_CCC:
@@ -449,31 +555,52 @@ static cin_yuv_t *RoQ_ReadVideo( cinematics_t *cin ) {
 			}
 
 		xpos += 16;
-		if( xpos >= cin->width ) {
-			xpos -= cin->width;
+		if( xpos >= roq->width ) {
+			xpos -= roq->width;
 
 			ypos += 16;
-			if( ypos >= cin->height ) {
+			if( ypos >= roq->height ) {
 				RoQ_SkipBlock( cin, remaining );     // ignore remaining trash
 				break;
 			}
 		}
 	}
-
-	return roq->cyuv;
 }
 
 /*
 * RoQ_ReadAudio
 */
-static void RoQ_ReadAudio( cinematics_t *cin ) {
+static void RoQ_ReadAudio( cinematics_t *cin, roq_frame_t *frame ) {
 	unsigned int i;
 	int snd_left, snd_right;
 	uint8_t raw[RoQ_READ_BLOCK];
-	short samples[RoQ_READ_BLOCK];
+	short *samples;
 	roq_info_t *roq = cin->fdata;
 	roq_chunk_t *chunk = &roq->chunk;
-	unsigned int remaining, read;
+	unsigned int remaining, read, needed;
+	unsigned short channels = ( chunk->id == RoQ_SOUND_MONO ? 1 : 2 );
+
+	if( frame->numSamples && frame->channels != channels ) {
+		Com_DPrintf( "Audio channels changed mid-frame in %s\n", cin->name );
+		RoQ_SkipChunk( cin );
+		return;
+	}
+
+	needed = frame->numSamples * channels + chunk->size;
+	if( needed > frame->samplesSize ) {
+		unsigned int size = max( needed, frame->samplesSize * 2 );
+
+		samples = CIN_Alloc( cin->mempool, size * sizeof( *samples ) );
+		if( frame->samples ) {
+			memcpy( samples, frame->samples, frame->numSamples * channels * sizeof( *samples ) );
+			CIN_Free( frame->samples );
+		}
+		frame->samples = samples;
+		frame->samplesSize = size;
+	}
+
+	frame->channels = channels;
+	samples = frame->samples + frame->numSamples * channels;
 
 	if( chunk->id == RoQ_SOUND_MONO ) {
 		snd_left = chunk->argument;
@@ -493,10 +620,8 @@ static void RoQ_ReadAudio( cinematics_t *cin ) {
 				samples[i] = (short)snd_left;
 				snd_left = (short)snd_left;
 			}
-
-			CIN_RawSamplesToListeners( cin, read, cin->s_rate, 2, 1, (uint8_t *)samples );
-		} else if( chunk->id == RoQ_SOUND_STEREO ) {
-			for( i = 0; i < read; i += 2 ) {
+		} else {
+			for( i = 0; i + 1 < read; i += 2 ) {
 				snd_left += snd_sqr_arr[raw[i]];
 				samples[i + 0] = (short)snd_left;
 				snd_left = (short)snd_left;
@@ -505,25 +630,35 @@ static void RoQ_ReadAudio( cinematics_t *cin ) {
 				samples[i + 1] = (short)snd_right;
 				snd_right = (short)snd_right;
 			}
-
-			CIN_RawSamplesToListeners( cin, read / 2, cin->s_rate, 2, 2, (uint8_t *)samples );
 		}
+
+		samples += read;
 	}
+
+	frame->numSamples += chunk->size / channels;
 }
 
 /*
-* RoQ_ReadNextFrameYUV_CIN
+* RoQ_DecodeFrame
+*
+* Reads chunks up to and including the next video frame, which is copied
+* out of the decoding buffers.
 */
-cin_yuv_t *RoQ_ReadNextFrameYUV_CIN( cinematics_t *cin, bool *redraw ) {
+static void RoQ_DecodeFrame( cinematics_t *cin, roq_frame_t *frame ) {
+	int i;
+	size_t size;
+	uint8_t *pixels;
 	roq_info_t *roq = cin->fdata;
 	roq_chunk_t *chunk = &roq->chunk;
-	cin_yuv_t *cyuv = NULL;
+
+	frame->video = false;
+	frame->numSamples = 0;
 
 	while( !trap_FS_Eof( cin->file ) ) {
 		RoQ_ReadChunk( cin );
 
 		if( trap_FS_Eof( cin->file ) ) {
-			return NULL;
+			return;
 		}
 		if( chunk->size <= 0 ) {
 			continue;
@@ -532,10 +667,14 @@ cin_yuv_t *RoQ_ReadNextFrameYUV_CIN( cinematics_t *cin, bool *redraw ) {
 		if( chunk->id == RoQ_INFO ) {
 			RoQ_ReadInfo( cin );
 		} else if( ( chunk->id == RoQ_SOUND_MONO || chunk->id == RoQ_SOUND_STEREO ) ) {
-			RoQ_ReadAudio( cin );
-		} else if( chunk->id == RoQ_QUAD_VQ ) {
-			*redraw = true;
-			cyuv = RoQ_ReadVideo( cin );
+			if( cin->flags & CIN_NOAUDIO ) {
+				RoQ_SkipChunk( cin );
+			} else {
+				RoQ_ReadAudio( cin, frame );
+			}
+		} else if( chunk->id == RoQ_QUAD_VQ && roq->yuv_pixels ) {
+			RoQ_ReadVideo( cin );
+			frame->video = true;
 			break;
 		} else if( chunk->id == RoQ_QUAD_CODEBOOK ) {
 			RoQ_ReadCodebook( cin );
@@ -544,23 +683,163 @@ cin_yuv_t *RoQ_ReadNextFrameYUV_CIN( cinematics_t *cin, bool *redraw ) {
 		}
 	}
 
-	if( cyuv ) {
-		if( cin->frame > 0 ) {
-			// swap buffers
-			cin_yuv_t tp;
-			tp = roq->cyuv[0]; roq->cyuv[0] = roq->cyuv[1]; roq->cyuv[1] = tp;
-		} else {
-			int i;
-			// init back buffer for inter-frame motion compensation
-			for( i = 0; i < 3; i++ ) {
-				memcpy( roq->cyuv[1].yuv[i].data, roq->cyuv[0].yuv[i].data,
-						roq->cyuv[0].yuv[i].width * roq->cyuv[0].yuv[i].height );
-			}
+	if( !frame->video ) {
+		return;
+	}
+
+	size = roq->width * roq->height + roq->width_2 * roq->height_2 * 2;
+	if( frame->pixelsSize < size ) {
+		if( frame->pixels ) {
+			CIN_Free( frame->pixels );
+		}
+		frame->pixels = CIN_Alloc( cin->mempool, size );
+		frame->pixelsSize = size;
+	}
+
+	frame->cyuv = roq->cyuv[0];
+	for( i = 0, pixels = frame->pixels; i < 3; i++ ) {
+		cin_img_plane_t *plane = &frame->cyuv.yuv[i];
+
+		memcpy( pixels, plane->data, plane->stride * plane->height );
+		plane->data = pixels;
+		pixels += plane->stride * plane->height;
+	}
+
+	if( roq->decodedFrames > 0 ) {
+		// swap buffers
+		cin_yuv_t tp;
+		tp = roq->cyuv[0]; roq->cyuv[0] = roq->cyuv[1]; roq->cyuv[1] = tp;
+	} else {
+		// init back buffer for inter-frame motion compensation
+		for( i = 0; i < 3; i++ ) {
+			memcpy( roq->cyuv[1].yuv[i].data, roq->cyuv[0].yuv[i].data,
+					roq->cyuv[0].yuv[i].width * roq->cyuv[0].yuv[i].height );
+		}
+	}
+	roq->decodedFrames++;
+}
+
+/*
+* RoQ_DecoderThread
+*/
+static void *RoQ_DecoderThread( void *param ) {
+	cinematics_t *cin = param;
+	roq_info_t *roq = cin->fdata;
+	roq_frame_t *frame;
+
+	while( true ) {
+		trap_Mutex_Lock( roq->lock );
+		while( !roq->quit && roq->tail - roq->head >= RoQ_QUEUE_SIZE ) {
+			trap_CondVar_Wait( roq->drained, roq->lock, Q_THREADS_WAIT_INFINITE );
+		}
+		if( roq->quit ) {
+			trap_Mutex_Unlock( roq->lock );
+			break;
+		}
+		frame = &roq->frames[roq->tail % RoQ_QUEUE_SIZE];
+		trap_Mutex_Unlock( roq->lock );
+
+		RoQ_DecodeFrame( cin, frame );
+
+		trap_Mutex_Lock( roq->lock );
+		roq->tail++;
+		trap_CondVar_Wake( roq->filled );
+		trap_Mutex_Unlock( roq->lock );
+
+		if( !frame->video ) {
+			// end of file, stay idle until reset
+			break;
 		}
-		cin->frame++;
 	}
 
-	return cyuv;
+	return NULL;
+}
+
+/*
+* RoQ_StartDecoder
+*/
+static void RoQ_StartDecoder( cinematics_t *cin ) {
+	roq_info_t *roq = cin->fdata;
+
+	roq->quit = false;
+	roq->head = roq->tail = 0;
+	roq->current = NULL;
+	roq->decodedFrames = 0;
+	roq->thread = trap_Thread_Create( RoQ_DecoderThread, cin );
+}
+
+/*
+* RoQ_StopDecoder
+*
+* Discards all decoded frames.
+*/
+static void RoQ_StopDecoder( cinematics_t *cin ) {
+	roq_info_t *roq = cin->fdata;
+
+	if( !roq->thread ) {
+		return;
+	}
+
+	trap_Mutex_Lock( roq->lock );
+	roq->quit = true;
+	trap_CondVar_Wake( roq->drained );
+	trap_Mutex_Unlock( roq->lock );
+
+	trap_Thread_Join( roq->thread );
+	roq->thread = NULL;
+
+	roq->head = roq->tail = 0;
+	roq->current = NULL;
+}
+
+/*
+* RoQ_ReadNextFrameYUV_CIN
+*/
+cin_yuv_t *RoQ_ReadNextFrameYUV_CIN( cinematics_t *cin, bool *redraw ) {
+	roq_info_t *roq = cin->fdata;
+	roq_frame_t *frame;
+
+	if( !roq->thread ) {
+		return NULL;
+	}
+
+	trap_Mutex_Lock( roq->lock );
+
+	frame = roq->current;
+	if( frame ) {
+		if( !frame->video ) {
+			// stay at the end of file
+			trap_Mutex_Unlock( roq->lock );
+			return NULL;
+		}
+
+		// the previous frame is no longer used by the caller
+		roq->current = NULL;
+		roq->head++;
+		trap_CondVar_Wake( roq->drained );
+	}
+
+	while( roq->head == roq->tail ) {
+		trap_CondVar_Wait( roq->filled, roq->lock, Q_THREADS_WAIT_INFINITE );
+	}
+	frame = roq->current = &roq->frames[roq->head % RoQ_QUEUE_SIZE];
+
+	trap_Mutex_Unlock( roq->lock );
+
+	if( frame->numSamples ) {
+		CIN_RawSamplesToListeners( cin, frame->numSamples, cin->s_rate, 2, frame->channels, (uint8_t *)frame->samples );
+	}
+
+	if( !frame->video ) {
+		return NULL;
+	}
+
+	*redraw = true;
+	cin->width = frame->cyuv.image_width;
+	cin->height = frame->cyuv.image_height;
+	cin->frame++;
+
+	return &frame->cyuv;
 }
 
 /*
@@ -591,6 +870,12 @@ bool RoQ_Init_CIN( cinematics_t *cin ) {
 
 	cin->headerlen = trap_FS_Tell( cin->file );
 
+	roq->lock = trap_Mutex_Create();
+	roq->filled = trap_CondVar_Create();
+	roq->drained = trap_CondVar_Create();
+
+	RoQ_StartDecoder( cin );
+
 	return true;
 }
 
@@ -605,15 +890,51 @@ bool RoQ_HasOggAudio_CIN( cinematics_t *cin ) {
 * RoQ_Shutdown_CIN
 */
 void RoQ_Shutdown_CIN( cinematics_t *cin ) {
+	int i;
+	roq_info_t *roq = cin->fdata;
+
+	if( !roq ) {
+		return;
+	}
+
+	RoQ_StopDecoder( cin );
+
+	for( i = 0; i < RoQ_QUEUE_SIZE; i++ ) {
+		if( roq->frames[i].pixels ) {
+			CIN_Free( roq->frames[i].pixels );
+		}
+		if( roq->frames[i].samples ) {
+			CIN_Free( roq->frames[i].samples );
+		}
+	}
+	memset( roq->frames, 0, sizeof( roq->frames ) );
+
+	if( roq->yuv_pixels ) {
+		CIN_Free( roq->yuv_pixels );
+		roq->yuv_pixels = NULL;
+	}
 
+	if( roq->lock ) {
+		trap_Mutex_Destroy( &roq->lock );
+	}
+	if( roq->filled ) {
+		trap_CondVar_Destroy( &roq->filled );
+	}
+	if( roq->drained ) {
+		trap_CondVar_Destroy( &roq->drained );
+	}
 }
 
 /*
 * RoQ_Reset_CIN
 */
 void RoQ_Reset_CIN( cinematics_t *cin ) {
+	RoQ_StopDecoder( cin );
+
 	// try again from the beginning if looping
 	trap_FS_Seek( cin->file, cin->headerlen, FS_SEEK_SET );
+
+	RoQ_StartDecoder( cin );
 }
 
 /*
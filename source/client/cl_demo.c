@@ -29,7 +29,7 @@ static void CL_PauseDemo( bool paused );
 * Dumps the current net message, prefixed by the length
 */
 void CL_WriteDemoMessage( msg_t *msg ) {
-	if( cls.demo.file <= 0 ) {
+	if( !cls.demo.file ) {
 		cls.demo.recording = false;
 		return;
 	}
@@ -66,7 +66,7 @@ void CL_Stop_f( void ) {
 	}
 
 	// finish up
-	SNAP_StopDemoRecording( cls.demo.file );
+	SNAP_StopDemoRecording( cls.demo.file, cls.demo.index );
 
 	// write some meta information about the match/demo
 	CL_SetDemoMetaKeyValue( "hostname", cl.configstrings[CS_HOSTNAME] );
@@ -80,7 +80,7 @@ void CL_Stop_f( void ) {
 	CL_SetDemoMetaKeyValue( "matchscore", cl.configstrings[CS_MATCHSCORE] );
 	CL_SetDemoMetaKeyValue( "matchuuid", cl.configstrings[CS_MATCHUUID] );
 
-	FS_FCloseFile( cls.demo.file );
+	DemoStream_Close( &cls.demo.file );
 
 	SNAP_WriteDemoMetaData( cls.demo.filename, cls.demo.meta_data, cls.demo.meta_data_realsize );
 
@@ -99,7 +99,8 @@ void CL_Stop_f( void ) {
 		Com_Printf( "Stopped demo: %s\n", cls.demo.filename );
 	}
 
-	cls.demo.file = 0; // file id
+	SNAP_FreeDemoIndex( cls.demo.index );
+	cls.demo.index = NULL;
 	Mem_ZoneFree( cls.demo.filename );
 	Mem_ZoneFree( cls.demo.name );
 	cls.demo.filename = NULL;
@@ -115,6 +116,7 @@ void CL_Stop_f( void ) {
 * Begins recording a demo from the current position
 */
 void CL_Record_f( void ) {
+	int file;
 	char *name;
 	size_t name_size;
 	bool silent;
@@ -169,12 +171,14 @@ void CL_Record_f( void ) {
 		return;
 	}
 
-	if( FS_FOpenFile( name, &cls.demo.file, FS_WRITE ) == -1 ) {
+	if( FS_FOpenFile( name, &file, FS_WRITE ) == -1 ) {
 		Com_Printf( "Error: Couldn't create the demo file.\n" );
 		Mem_ZoneFree( name );
 		return;
 	}
 
+	cls.demo.file = DemoStream_Open( file, FS_WRITE, cl_democompression->integer );
+
 	if( !silent ) {
 		Com_Printf( "Recording demo: %s\n", name );
 	}
@@ -184,6 +188,8 @@ void CL_Record_f( void ) {
 	cls.demo.recording = true;
 	cls.demo.basetime = cls.demo.duration = cls.demo.time = 0;
 	cls.demo.name = ZoneCopyString( demoname );
+	cls.demo.index = SNAP_CreateDemoIndex();
+	cls.demo.keyframe_requested = false;
 
 	// don't start saving messages until a non-delta compressed message is received
 	CL_AddReliableCommand( "nodelta" ); // request non delta compressed frame from server
@@ -198,8 +204,9 @@ void CL_Record_f( void ) {
 //================================================================
 
 // demo file
-static int demofilehandle;
+static struct demostream_s *demofilehandle;
 static int demofilelen, demofilelentotal;
+static struct demoindex_s *demoindex;
 
 /*
 * CL_BeginDemoAviDump
@@ -255,12 +262,12 @@ void CL_DemoCompleted( void ) {
 		CL_StopDemoAviDump();
 	}
 
-	if( demofilehandle ) {
-		FS_FCloseFile( demofilehandle );
-		demofilehandle = 0;
-	}
+	DemoStream_Close( &demofilehandle );
 	demofilelen = demofilelentotal = 0;
 
+	SNAP_FreeDemoIndex( demoindex );
+	demoindex = NULL;
+
 	cls.demo.playing = false;
 	cls.demo.basetime = cls.demo.duration = cls.demo.time = 0;
 	Mem_ZoneFree( cls.demo.filename );
@@ -332,6 +339,51 @@ void CL_ReadDemoPackets( void ) {
 	cls.demo.play_jump = false;
 }
 
+/*
+* CL_SeekDemoKeyframe
+*
+* Continues reading the demo from the last indexed non-delta frame before the current
+* server time. Returns false if there's no such keyframe, or it isn't worth it.
+*/
+static bool CL_SeekDemoKeyframe( void ) {
+	int i, offset;
+	int64_t keyframeTime, snapTime;
+	char *configstrings;
+
+	if( !demoindex ) {
+		return false;
+	}
+
+	configstrings = Mem_TempMalloc( MAX_CONFIGSTRINGS * MAX_CONFIGSTRING_CHARS );
+
+	// forward jumps only skip to the keyframe if it's past the last read snap
+	snapTime = cl.snapShots[cl.receivedSnapNum & UPDATE_MASK].serverTime;
+	offset = SNAP_FindDemoKeyframe( demoindex, cl.serverTime, &keyframeTime, configstrings );
+	if( offset < 0 || ( cl.serverTime >= snapTime && keyframeTime <= snapTime ) ) {
+		Mem_TempFree( configstrings );
+		return false;
+	}
+
+	// the messages in between aren't read, so catch up on their configstrings
+	for( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		const char *cs = configstrings + i * MAX_CONFIGSTRING_CHARS;
+		if( strcmp( cl.configstrings[i], cs ) ) {
+			CL_UpdateConfigString( i, cs );
+		}
+	}
+
+	Mem_TempFree( configstrings );
+
+	DemoStream_Seek( demofilehandle, offset, FS_SEEK_SET );
+	demofilelen = demofilelentotal - offset;
+	cl.pendingSnapNum = cl.currentSnapNum = cl.receivedSnapNum = 0;
+
+	// server commands after the keyframe may have been executed before the jump
+	cls.lastExecutedServerCommand = 0;
+
+	return true;
+}
+
 /*
 * CL_LatchedDemoJump
 *
@@ -350,9 +402,11 @@ void CL_LatchedDemoJump( void ) {
 
 	CL_AdjustServerTime( 1 );
 
-	if( cl.serverTime < cl.snapShots[cl.receivedSnapNum & UPDATE_MASK].serverTime ) {
+	if( CL_SeekDemoKeyframe() ) {
+		// reading continues from the closest keyframe
+	} else if( cl.serverTime < cl.snapShots[cl.receivedSnapNum & UPDATE_MASK].serverTime ) {
 		demofilelen = demofilelentotal;
-		FS_Seek( demofilehandle, 0, FS_SEEK_SET );
+		DemoStream_Seek( demofilehandle, 0, FS_SEEK_SET );
 		cl.currentSnapNum = cl.receivedSnapNum = 0;
 	}
 
@@ -410,10 +464,14 @@ static void CL_StartDemo( const char *demoname, bool pause_on_stop ) {
 
 	memset( &cls.demo, 0, sizeof( cls.demo ) );
 
-	demofilehandle = tempdemofilehandle;
+	demofilehandle = DemoStream_Open( tempdemofilehandle, FS_READ, 0 );
 	demofilelentotal = tempdemofilelen;
 	demofilelen = demofilelentotal;
 
+	// demos recorded with a keyframe index can be seeked without reading them from the start
+	demoindex = SNAP_ReadDemoIndex( demofilehandle );
+	DemoStream_Seek( demofilehandle, 0, FS_SEEK_SET );
+
 	cls.servername = ZoneCopyString( COM_FileBase( servername ) );
 	COM_StripExtension( cls.servername );
 
@@ -532,6 +590,98 @@ void CL_DemoJump_f( void ) {
 	cls.demo.play_jump_latched = true;
 }
 
+/*
+* CL_IndexDemo_f
+*
+* demoindex <demoname>
+*
+* Adds a keyframe index to a demo recorded without one, so it can be seeked faster
+*/
+void CL_IndexDemo_f( void ) {
+	char *name, *filename;
+	const char *absname = NULL;
+	size_t name_size;
+	int file, length, end, marker = 0, numKeyframes;
+	struct demostream_s *demofile;
+	struct demoindex_s *index;
+
+	if( Cmd_Argc() != 2 ) {
+		Com_Printf( "Usage: demoindex <demoname>\n" );
+		return;
+	}
+
+	name_size = sizeof( char ) * ( strlen( "demos/" ) + strlen( Cmd_Argv( 1 ) ) + strlen( APP_DEMO_EXTENSION_STR ) + 1 );
+	name = Mem_TempMalloc( name_size );
+
+	Q_snprintfz( name, name_size, "demos/%s", Cmd_Argv( 1 ) );
+	COM_SanitizeFilePath( name );
+	COM_DefaultExtension( name, APP_DEMO_EXTENSION_STR, name_size );
+
+	// the index is appended, so the demo can't be in a pak
+	if( COM_ValidateRelativeFilename( name ) ) {
+		absname = FS_AbsoluteNameForFile( name );
+	}
+	if( !absname ) {
+		Q_snprintfz( name, name_size, "%s", Cmd_Argv( 1 ) );
+		COM_SanitizeFilePath( name );
+		COM_DefaultExtension( name, APP_DEMO_EXTENSION_STR, name_size );
+		absname = name;
+	}
+	filename = TempCopyString( absname );
+	Mem_TempFree( name );
+
+	FS_FOpenAbsoluteFile( filename, &file, FS_READ );
+	if( !file ) {
+		Com_Printf( "No valid demo file found\n" );
+		Mem_TempFree( filename );
+		return;
+	}
+
+	demofile = DemoStream_Open( file, FS_READ, 0 );
+
+	index = SNAP_ReadDemoIndex( demofile );
+	if( index ) {
+		Com_Printf( "%s already has a keyframe index\n", filename );
+		SNAP_FreeDemoIndex( index );
+		DemoStream_Close( &demofile );
+		Mem_TempFree( filename );
+		return;
+	}
+
+	// offsets are in the uncompressed stream
+	DemoStream_Seek( demofile, 0, FS_SEEK_END );
+	length = DemoStream_Tell( demofile );
+
+	index = SNAP_BuildDemoIndex( demofile, &end );
+	if( DemoStream_Seek( demofile, end, FS_SEEK_SET ) == 0 && DemoStream_Read( demofile, &marker, 4 ) == 4 ) {
+		marker = LittleLong( marker );
+	}
+	DemoStream_Close( &demofile );
+
+	numKeyframes = SNAP_NumDemoKeyframes( index );
+	if( !numKeyframes ) {
+		Com_Printf( "Failed to index %s\n", filename );
+	} else if( !( end + 4 == length && marker == -1 ) && end != length ) {
+		Com_Printf( "%s has unreadable data at %i\n", filename, end );
+	} else if( FS_FOpenAbsoluteFile( filename, &file, FS_READ | FS_UPDATE ) == -1 ) {
+		Com_Printf( "Couldn't open %s for writing\n", filename );
+	} else {
+		demofile = DemoStream_Open( file, FS_APPEND, cl_democompression->integer );
+		if( end == length ) {
+			// the recording was interrupted, but ended on a complete message
+			SNAP_StopDemoRecording( demofile, index );
+		} else {
+			SNAP_WriteDemoIndex( demofile, index );
+		}
+		DemoStream_Close( &demofile );
+
+		Com_Printf( "Indexed %s: %i keyframes\n", filename, numKeyframes );
+	}
+
+	SNAP_FreeDemoIndex( index );
+	Mem_TempFree( filename );
+}
+
 /*
 * CL_PlayDemoToAvi_f
 *
@@ -603,9 +753,12 @@ size_t CL_ReadDemoMetaData( const char *demopath, char *meta_data, size_t meta_d
 		}
 
 		if( demolength > 0 ) {
-			meta_data_realsize = SNAP_ReadDemoMetaData( demofile, meta_data, meta_data_size );
+			struct demostream_s *demostream = DemoStream_Open( demofile, FS_READ, 0 );
+			meta_data_realsize = SNAP_ReadDemoMetaData( demostream, meta_data, meta_data_size );
+			DemoStream_Close( &demostream );
+		} else {
+			FS_FCloseFile( demofile );
 		}
-		FS_FCloseFile( demofile );
 
 		Mem_TempFree( name );
 	}
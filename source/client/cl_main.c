@@ -44,6 +44,7 @@ cvar_t *cl_demoavi_video;
 cvar_t *cl_demoavi_audio;
 cvar_t *cl_demoavi_fps;
 cvar_t *cl_demoavi_scissor;
+cvar_t *cl_democompression;
 
 //
 // userinfo
@@ -1862,6 +1863,7 @@ static void CL_InitLocal( void ) {
 	cl_demoavi_fps =    Cvar_Get( "cl_demoavi_fps", "30.3", CVAR_ARCHIVE );
 	cl_demoavi_fps->modified = true;
 	cl_demoavi_scissor =    Cvar_Get( "cl_demoavi_scissor", "0", CVAR_ARCHIVE );
+	cl_democompression =    Cvar_Get( "cl_democompression", "1", CVAR_ARCHIVE );
 
 	rcon_client_password =  Cvar_Get( "rcon_password", "", 0 );
 	rcon_address =      Cvar_Get( "rcon_address", "", 0 );
@@ -1948,12 +1950,14 @@ static void CL_InitLocal( void ) {
 	Cmd_AddCommand( "pingserver", CL_PingServer_f );
 	Cmd_AddCommand( "demopause", CL_PauseDemo_f );
 	Cmd_AddCommand( "demojump", CL_DemoJump_f );
+	Cmd_AddCommand( "demoindex", CL_IndexDemo_f );
 	Cmd_AddCommand( "showserverip", CL_ShowServerIP_f );
 	Cmd_AddCommand( "downloadstatus", CL_DownloadStatus_f );
 	Cmd_AddCommand( "downloadcancel", CL_DownloadCancel_f );
 
 	Cmd_SetCompletionFunc( "demo", CL_DemoComplete );
 	Cmd_SetCompletionFunc( "demoavi", CL_DemoComplete );
+	Cmd_SetCompletionFunc( "demoindex", CL_DemoComplete );
 }
 
 /*
@@ -1984,6 +1988,7 @@ static void CL_ShutdownLocal( void ) {
 	Cmd_RemoveCommand( "pingserver" );
 	Cmd_RemoveCommand( "demopause" );
 	Cmd_RemoveCommand( "demojump" );
+	Cmd_RemoveCommand( "demoindex" );
 	Cmd_RemoveCommand( "showserverip" );
 	Cmd_RemoveCommand( "downloadstatus" );
 	Cmd_RemoveCommand( "downloadcancel" );
@@ -979,6 +979,18 @@ static void CL_ParseFrame( msg_t *msg ) {
 
 			if( !cls.demo.waiting ) {
 				cls.demo.duration = snap->serverTime - cls.demo.basetime;
+
+				// ask for a non-delta frame every now and then so players can seek to it,
+				// the message is written to the demo after it's parsed
+				if( SNAP_DemoKeyframeDue( cls.demo.index, snap->serverTime ) ) {
+					if( !snap->delta ) {
+						SNAP_AddDemoKeyframe( cls.demo.index, DemoStream_Tell( cls.demo.file ), snap->serverTime, cl.configstrings[0] );
+						cls.demo.keyframe_requested = false;
+					} else if( !cls.demo.keyframe_requested ) {
+						CL_AddReliableCommand( "nodelta" );
+						cls.demo.keyframe_requested = true;
+					}
+				}
 			}
 			cls.demo.time = cls.demo.duration;
 		}
@@ -1066,7 +1078,7 @@ static void CL_CvarInfoRequest_f( void ) {
 /*
 * CL_UpdateConfigString
 */
-static void CL_UpdateConfigString( int idx, const char *s ) {
+void CL_UpdateConfigString( int idx, const char *s ) {
 	if( !s ) {
 		return;
 	}
@@ -242,6 +242,10 @@ size_t SCR_FontXHeight( qfontface_t *font ) {
 	return FTLIB_FontXHeight( font );
 }
 
+unsigned int SCR_FontAtlasGeneration( qfontface_t *font ) {
+	return FTLIB_FontAtlasGeneration( font );
+}
+
 fdrawchar_t SCR_SetDrawCharIntercept( fdrawchar_t intercept ) {
 	return FTLIB_SetDrawCharIntercept( intercept );
 }
@@ -722,6 +726,8 @@ void SCR_UpdateScreen( void ) {
 	forceclear = cinematic || ( cls.state == CA_DISCONNECTED );
 	timedemo = cl_timedemo->integer != 0 && cls.demo.playing;
 
+	FTLIB_BeginFrame();
+
 	for( i = 0; i < numframes; i++ ) {
 		re.BeginFrame( separation[i], forceclear, forcevsync, timedemo );
 
@@ -31,19 +31,65 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 //#define SERVERBROWSER_PROTOCOL_VERSION	12
 #endif
 
+#define SERVERLIST_HASH_SIZE                1024
+
+// Info queries are queued by pingserver and sent from CL_ServerListFrame, batched
+// into as few system calls as possible and paced at serverQuery.rate queries per
+// second, so that we neither flood our own link nor crawl through the list.
+//
+// Once all the queries sent during a period at the current rate are either answered
+// or timed out, the rate is raised if few of them were lost and cut if many were.
+// Some servers in the master list are always down, so the loss is compared to the
+// lowest loss seen so far rather than to zero. cl_serverQueryRate caps the rate.
+#define SERVER_QUERY_TIMEOUT                1000    // msecs until an unanswered query counts as lost
+#define SERVER_QUERY_RETRIES                2
+#define SERVER_QUERY_MIN_RATE               20      // queries per second
+#define SERVER_QUERY_START_RATE             250
+#define SERVER_QUERY_PERIOD                 250     // msecs of queries sent at a rate to judge it by
+#define SERVER_QUERY_MIN_SAMPLES            16
+#define SERVER_QUERY_BATCH                  64
+
 //=========================================================
 
+typedef enum {
+	QUERY_NONE,
+	QUERY_PENDING,
+	QUERY_INFLIGHT
+} serverquerystate_t;
+
 typedef struct serverlist_s {
 	char address[48];
-	int64_t pingTimeStamp;
+	netadr_t adr;
+	int64_t pingTimeStamp;              // first query, replies to any attempt are timed from it
+	int64_t queryTimeStamp;             // last attempt, for the timeout and the loss statistics
 	int64_t lastValidPing;
 	int64_t lastUpdatedByMasterServer;
 	int64_t masterServerUpdateSeq;
 	bool isLocal;
 	struct serverlist_s *pnext;
+	struct serverlist_s *hnext;         // address hash chain
+
+	serverquerystate_t queryState;
+	int queryRetries;
+	struct serverlist_s *qprev, *qnext; // pending or in-flight queries
 } serverlist_t;
 
 serverlist_t *masterList, *favoritesList;
+static serverlist_t *masterHash[SERVERLIST_HASH_SIZE], *favoritesHash[SERVERLIST_HASH_SIZE];
+
+static struct {
+	serverlist_t pending;               // sentinels
+	serverlist_t inflight;              // in the order they were sent in
+	double rate;
+	double credit;                      // queries that may be sent right now
+	int64_t lastSendTime;
+	int64_t rateChangeTime;             // only queries sent after it are counted
+	bool backlog;                       // queries were waiting for the rate since the change
+	int answered, lost;
+	double minLoss;
+} serverQuery;
+
+static cvar_t *cl_serverQueryRate;
 
 static bool filter_allow_full = false;
 static bool filter_allow_empty = false;
@@ -65,43 +111,146 @@ int numMasterServers;
 
 //=========================================================
 
+/*
+* CL_UnlinkServerQuery
+*/
+static void CL_UnlinkServerQuery( serverlist_t *server ) {
+	if( server->queryState == QUERY_NONE ) {
+		return;
+	}
+
+	server->qprev->qnext = server->qnext;
+	server->qnext->qprev = server->qprev;
+	server->qprev = server->qnext = NULL;
+	server->queryState = QUERY_NONE;
+}
+
+/*
+* CL_LinkServerQuery
+*/
+static void CL_LinkServerQuery( serverlist_t *server, serverquerystate_t state ) {
+	serverlist_t *sentinel = ( state == QUERY_INFLIGHT ? &serverQuery.inflight : &serverQuery.pending );
+
+	CL_UnlinkServerQuery( server );
+
+	server->qnext = sentinel;
+	server->qprev = sentinel->qprev;
+	sentinel->qprev->qnext = server;
+	sentinel->qprev = server;
+	server->queryState = state;
+}
+
+/*
+* CL_ClearServerQueries
+*/
+static void CL_ClearServerQueries( void ) {
+	int i;
+	serverlist_t *sentinel, *server, *next;
+
+	for( i = 0; i < 2; i++ ) {
+		sentinel = ( i ? &serverQuery.inflight : &serverQuery.pending );
+
+		if( sentinel->qnext ) {
+			for( server = sentinel->qnext; server != sentinel; server = next ) {
+				next = server->qnext;
+				server->qprev = server->qnext = NULL;
+				server->queryState = QUERY_NONE;
+			}
+		}
+
+		sentinel->qprev = sentinel->qnext = sentinel;
+	}
+
+	serverQuery.rate = SERVER_QUERY_START_RATE;
+	serverQuery.credit = 0;
+	serverQuery.lastSendTime = serverQuery.rateChangeTime = Sys_Milliseconds();
+	serverQuery.backlog = false;
+	serverQuery.answered = serverQuery.lost = 0;
+	serverQuery.minLoss = 1.0;
+}
+
 /*
 * CL_FreeServerlist
 */
-static void CL_FreeServerlist( serverlist_t **serversList ) {
+static void CL_FreeServerlist( serverlist_t **serversList, serverlist_t **hash ) {
 	serverlist_t *ptr;
 
 	while( *serversList ) {
 		ptr = *serversList;
 		*serversList = ptr->pnext;
+		CL_UnlinkServerQuery( ptr );
 		Mem_ZoneFree( ptr );
 	}
+
+	memset( hash, 0, SERVERLIST_HASH_SIZE * sizeof( *hash ) );
 }
 
 /*
-* CL_ServerIsInList
+* CL_ServerAddressHash
 */
-static serverlist_t *CL_ServerFindInList( serverlist_t *serversList, char *adr ) {
+static unsigned int CL_ServerAddressHash( const netadr_t *adr ) {
+	const uint8_t *ip;
+	size_t i, len;
+	unsigned int hash;
+
+	switch( adr->type ) {
+		case NA_IP:
+			ip = adr->address.ipv4.ip;
+			len = sizeof( adr->address.ipv4.ip );
+			hash = adr->address.ipv4.port;
+			break;
+		case NA_IP6:
+			ip = adr->address.ipv6.ip;
+			len = sizeof( adr->address.ipv6.ip );
+			hash = adr->address.ipv6.port;
+			break;
+		default:
+			return 0;
+	}
 
+	for( i = 0; i < len; i++ ) {
+		hash = hash * 31 + ip[i];
+	}
+
+	return ( hash ^ ( hash >> 10 ) ) & ( SERVERLIST_HASH_SIZE - 1 );
+}
+
+/*
+* CL_ServerFindInList
+*/
+static serverlist_t *CL_ServerFindInList( serverlist_t **hash, const netadr_t *adr ) {
 	serverlist_t *server;
 
-	server = serversList;
-	while( server ) {
-		if( !Q_stricmp( server->address, adr ) ) {
+	for( server = hash[CL_ServerAddressHash( adr )]; server; server = server->hnext ) {
+		if( NET_CompareAddress( &server->adr, adr ) ) {
 			return server;
 		}
-		server = server->pnext;
 	}
 
 	return NULL;
 }
 
+/*
+* CL_FindServer
+*/
+static serverlist_t *CL_FindServer( const netadr_t *adr ) {
+	serverlist_t *server;
+
+	server = CL_ServerFindInList( masterHash, adr );
+	if( !server ) {
+		server = CL_ServerFindInList( favoritesHash, adr );
+	}
+
+	return server;
+}
+
 /*
 * CL_AddServerToList
 */
-static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned int days ) {
+static bool CL_AddServerToList( serverlist_t **serversList, serverlist_t **hash, char *adr, unsigned int days ) {
 	serverlist_t *newserv;
 	netadr_t nadr;
+	unsigned int hashkey;
 
 	if( !adr || !strlen( adr ) ) {
 		return false;
@@ -111,7 +260,7 @@ static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned
 		return false;
 	}
 
-	newserv = CL_ServerFindInList( *serversList, adr );
+	newserv = CL_ServerFindInList( hash, &nadr );
 	if( newserv ) {
 		// ignore excessive updates for about a second or so, which may happen
 		// when we're querying multiple master servers at once
@@ -125,7 +274,9 @@ static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned
 
 	newserv = (serverlist_t *)Mem_ZoneMalloc( sizeof( serverlist_t ) );
 	Q_strncpyz( newserv->address, adr, sizeof( newserv->address ) );
+	newserv->adr = nadr;
 	newserv->pingTimeStamp = 0;
+	newserv->queryTimeStamp = 0;
 	if( days == 0 ) {
 		newserv->lastValidPing = Com_DaysSince1900();
 	} else {
@@ -137,6 +288,10 @@ static bool CL_AddServerToList( serverlist_t **serversList, char *adr, unsigned
 	newserv->isLocal = NET_IsLocalAddress( &nadr );
 	*serversList = newserv;
 
+	hashkey = CL_ServerAddressHash( &nadr );
+	newserv->hnext = hash[hashkey];
+	hash[hashkey] = newserv;
+
 	return true;
 }
 
@@ -236,9 +391,9 @@ void CL_ReadServerCache( void ) {
 			}
 
 			if( favorite ) {
-				CL_AddServerToList( &favoritesList, adrString, (unsigned int)atoi( token ) );
+				CL_AddServerToList( &favoritesList, favoritesHash, adrString, (unsigned int)atoi( token ) );
 			} else {
-				CL_AddServerToList( &masterList, adrString, (unsigned int)atoi( token ) );
+				CL_AddServerToList( &masterList, masterHash, adrString, (unsigned int)atoi( token ) );
 			}
 		}
 	}
@@ -316,45 +471,37 @@ void CL_QueryGetStatusMessage_f( void ) {
 
 /*
 * CL_PingServer_f
+*
+* Queues info queries to one or more servers, see CL_SendServerQueries
 */
 void CL_PingServer_f( void ) {
-	char *address_string;
-	char requestString[64];
+	int i;
 	netadr_t adr;
 	serverlist_t *pingserver;
-	socket_t *socket;
 
 	if( Cmd_Argc() < 2 ) {
-		Com_Printf( "Usage: pingserver [ip:port]\n" );
-	}
-
-	address_string = Cmd_Argv( 1 );
-
-	if( !NET_StringToAddress( address_string, &adr ) ) {
-		return;
-	}
-
-	pingserver = CL_ServerFindInList( masterList, address_string );
-	if( !pingserver ) {
-		pingserver = CL_ServerFindInList( favoritesList, address_string );
-	}
-	if( !pingserver ) {
+		Com_Printf( "Usage: pingserver <ip:port> [ip:port...]\n" );
 		return;
 	}
 
-	// never request a second ping while awaiting for a ping reply
-	if( pingserver->pingTimeStamp + SERVER_PINGING_TIMEOUT > Sys_Milliseconds() ) {
-		return;
-	}
+	for( i = 1; i < Cmd_Argc(); i++ ) {
+		if( !NET_StringToAddress( Cmd_Argv( i ), &adr ) ) {
+			continue;
+		}
 
-	pingserver->pingTimeStamp = Sys_Milliseconds();
+		pingserver = CL_FindServer( &adr );
+		if( !pingserver ) {
+			continue;
+		}
 
-	Q_snprintfz( requestString, sizeof( requestString ), "info %i %s %s", SERVERBROWSER_PROTOCOL_VERSION,
-				 filter_allow_full ? "full" : "",
-				 filter_allow_empty ? "empty" : "" );
+		// never request a second ping while awaiting for a ping reply
+		if( pingserver->queryState != QUERY_NONE ) {
+			continue;
+		}
 
-	socket = ( adr.type == NA_IP6 ? &cls.socket_udp6 : &cls.socket_udp );
-	Netchan_OutOfBandPrint( socket, &adr, "%s", requestString );
+		pingserver->queryRetries = 0;
+		CL_LinkServerQuery( pingserver, QUERY_PENDING );
+	}
 }
 
 /*
@@ -371,14 +518,15 @@ void CL_ParseStatusMessage( const socket_t *socket, const netadr_t *address, msg
 	Q_strncpyz( adrString, NET_AddressToString( address ), sizeof( adrString ) );
 
 	// ping response
-	pingserver = CL_ServerFindInList( masterList, adrString );
-	if( !pingserver ) {
-		pingserver = CL_ServerFindInList( favoritesList, adrString );
-	}
+	pingserver = CL_FindServer( address );
 
 	if( pingserver && pingserver->pingTimeStamp ) { // valid ping
 		int ping = (int)(Sys_Milliseconds() - pingserver->pingTimeStamp);
 		CL_UIModule_AddToServerList( adrString, va( "\\\\ping\\\\%i%s", ping, s ) );
+		if( pingserver->queryState == QUERY_INFLIGHT && pingserver->queryTimeStamp >= serverQuery.rateChangeTime ) {
+			serverQuery.answered++;
+		}
+		CL_UnlinkServerQuery( pingserver );
 		pingserver->pingTimeStamp = 0;
 		pingserver->lastValidPing = Com_DaysSince1900();
 		return;
@@ -456,7 +604,7 @@ static void CL_ParseGetServersResponseMessage( msg_t *msg, bool extended ) {
 			continue;
 		}
 
-		CL_AddServerToList( &masterList, adrString, 0 );
+		CL_AddServerToList( &masterList, masterHash, adrString, 0 );
 	}
 }
 
@@ -466,7 +614,6 @@ static void CL_ParseGetServersResponseMessage( msg_t *msg, bool extended ) {
 */
 void CL_ParseGetServersResponse( const socket_t *socket, const netadr_t *address, msg_t *msg, bool extended ) {
 	serverlist_t *server;
-	netadr_t adr;
 
 //	CL_ReadServerCache();
 
@@ -481,8 +628,7 @@ void CL_ParseGetServersResponse( const socket_t *socket, const netadr_t *address
 	server = masterList;
 	while( server ) {
 		if( server->masterServerUpdateSeq == masterServerUpdateSeq
-			&& !( server->isLocal && Com_ServerState() )
-			&& NET_StringToAddress( server->address, &adr ) ) {
+			&& !( server->isLocal && Com_ServerState() ) ) {
 			CL_UIModule_AddToServerList( server->address, "\\\\EOT" );
 		}
 
@@ -690,11 +836,131 @@ void CL_GetServers_f( void ) {
 	Q_strncpyz( master->delayedRequestModName, modname, sizeof( master->delayedRequestModName ) );
 }
 
+/*
+* CL_UpdateServerQueryRate
+*/
+static void CL_UpdateServerQueryRate( int64_t now ) {
+	double loss;
+
+	// wait for the fate of all the queries sent during the period
+	if( now < serverQuery.rateChangeTime + SERVER_QUERY_PERIOD + SERVER_QUERY_TIMEOUT ) {
+		return;
+	}
+
+	if( serverQuery.answered + serverQuery.lost < SERVER_QUERY_MIN_SAMPLES ) {
+		if( serverQuery.inflight.qnext == &serverQuery.inflight && serverQuery.pending.qnext == &serverQuery.pending ) {
+			// idle, start over at the next refresh
+			serverQuery.rateChangeTime = now;
+			serverQuery.answered = serverQuery.lost = 0;
+		}
+		return;
+	}
+
+	loss = (double)serverQuery.lost / ( serverQuery.answered + serverQuery.lost );
+	serverQuery.minLoss = min( serverQuery.minLoss, loss );
+
+	if( loss > serverQuery.minLoss + 0.1 ) {
+		serverQuery.rate *= 0.7;
+	} else if( loss < serverQuery.minLoss + 0.05 && serverQuery.backlog ) {
+		serverQuery.rate *= 1.25;
+	}
+
+	serverQuery.rate = Q_bound( SERVER_QUERY_MIN_RATE, serverQuery.rate, max( cl_serverQueryRate->value, SERVER_QUERY_MIN_RATE ) );
+	serverQuery.rateChangeTime = now;
+	serverQuery.backlog = false;
+	serverQuery.answered = serverQuery.lost = 0;
+}
+
+/*
+* CL_ExpireServerQueries
+*/
+static void CL_ExpireServerQueries( int64_t now ) {
+	serverlist_t *server;
+
+	// in-flight queries are kept in the order they were sent in
+	while( ( server = serverQuery.inflight.qnext ) != &serverQuery.inflight ) {
+		if( server->queryTimeStamp + SERVER_QUERY_TIMEOUT > now ) {
+			break;
+		}
+
+		if( server->queryTimeStamp >= serverQuery.rateChangeTime ) {
+			serverQuery.lost++;
+		}
+
+		if( server->queryRetries++ < SERVER_QUERY_RETRIES ) {
+			CL_LinkServerQuery( server, QUERY_PENDING );
+		} else {
+			// keep the timestamp so that a late reply still gets a ping
+			CL_UnlinkServerQuery( server );
+		}
+	}
+}
+
+/*
+* CL_SendServerQueries
+*/
+static void CL_SendServerQueries( int64_t now ) {
+	int i;
+	int numAddresses[2] = { 0, 0 };
+	netadr_t addresses[2][SERVER_QUERY_BATCH];
+	socket_t *sockets[2] = { &cls.socket_udp, &cls.socket_udp6 };
+	serverlist_t *server;
+	char requestString[64];
+	size_t requestLength;
+
+	double rate = min( serverQuery.rate, max( cl_serverQueryRate->value, SERVER_QUERY_MIN_RATE ) );
+
+	serverQuery.credit += rate * (double)( now - serverQuery.lastSendTime ) * 0.001;
+	serverQuery.credit = min( serverQuery.credit, max( rate * 0.1, 1.0 ) );
+	serverQuery.lastSendTime = now;
+
+	if( serverQuery.pending.qnext == &serverQuery.pending ) {
+		// don't save up for a burst
+		serverQuery.credit = min( serverQuery.credit, 1.0 );
+		return;
+	}
+
+	Q_snprintfz( requestString, sizeof( requestString ), "info %i %s %s", SERVERBROWSER_PROTOCOL_VERSION,
+				 filter_allow_full ? "full" : "",
+				 filter_allow_empty ? "empty" : "" );
+	requestLength = strlen( requestString );
+
+	while( serverQuery.credit >= 1.0 && ( server = serverQuery.pending.qnext ) != &serverQuery.pending ) {
+		i = ( server->adr.type == NA_IP6 ? 1 : 0 );
+
+		// a late reply to the first query can't be told apart from a reply to a retry,
+		// so the ping errs on the high side rather than being timed from the retry
+		if( !server->queryRetries ) {
+			server->pingTimeStamp = now;
+		}
+		server->queryTimeStamp = now;
+		CL_LinkServerQuery( server, QUERY_INFLIGHT );
+		serverQuery.credit -= 1.0;
+
+		addresses[i][numAddresses[i]++] = server->adr;
+		if( numAddresses[i] == SERVER_QUERY_BATCH ) {
+			Netchan_OutOfBandToAddresses( sockets[i], addresses[i], numAddresses[i], requestLength, (uint8_t *)requestString );
+			numAddresses[i] = 0;
+		}
+	}
+
+	for( i = 0; i < 2; i++ ) {
+		if( numAddresses[i] ) {
+			Netchan_OutOfBandToAddresses( sockets[i], addresses[i], numAddresses[i], requestLength, (uint8_t *)requestString );
+		}
+	}
+
+	if( serverQuery.pending.qnext != &serverQuery.pending ) {
+		serverQuery.backlog = true;
+	}
+}
+
 /*
 * CL_ServerListFrame
 */
 void CL_ServerListFrame( void ) {
 	int i;
+	int64_t now;
 	masterserver_t *master;
 
 	for( i = 0, master = masterServers; i < numMasterServers; i++, master++ ) {
@@ -707,14 +973,23 @@ void CL_ServerListFrame( void ) {
 		}
 		master->delayedRequestModName[0] = '\0';
 	}
+
+	now = Sys_Milliseconds();
+	CL_ExpireServerQueries( now );
+	CL_UpdateServerQueryRate( now );
+	CL_SendServerQueries( now );
 }
 
 /*
 * CL_InitServerList
 */
 void CL_InitServerList( void ) {
-	CL_FreeServerlist( &masterList );
-	CL_FreeServerlist( &favoritesList );
+	cl_serverQueryRate = Cvar_Get( "cl_serverQueryRate", "1000", CVAR_ARCHIVE );
+
+	CL_ClearServerQueries();
+
+	CL_FreeServerlist( &masterList, masterHash );
+	CL_FreeServerlist( &favoritesList, favoritesHash );
 
 //	CL_ReadServerCache();
 
@@ -727,8 +1002,9 @@ void CL_InitServerList( void ) {
 void CL_ShutDownServerList( void ) {
 //	CL_WriteServerCache();
 
-	CL_FreeServerlist( &masterList );
-	CL_FreeServerlist( &favoritesList );
+	CL_FreeServerlist( &masterList, masterHash );
+	CL_FreeServerlist( &favoritesList, favoritesHash );
+	CL_ClearServerQueries();
 
 	CL_MasterAddressCache_Shutdown();
 }
@@ -282,6 +282,12 @@ void CL_SoundModule_Init( bool verbose ) {
 	import.BufPipe_ReadCmds = QBufPipe_ReadCmds;
 	import.BufPipe_Wait = QBufPipe_Wait;
 
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+	import.Job_Schedule = QJob_Schedule;
+	import.Job_Wait = QJob_Wait;
+	import.Job_Release = QJob_Release;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+
 	sm = Q_bound( 1, s_module->integer, num_sound_modules );
 	smfb = Q_bound( 0, s_module_fallback->integer, num_sound_modules );
 
@@ -276,6 +276,7 @@ void CL_UIModule_Init( void ) {
 	import.SCR_FontUnderline = SCR_FontUnderline;
 	import.SCR_FontAdvance = SCR_FontAdvance;
 	import.SCR_FontXHeight = SCR_FontXHeight;
+	import.SCR_FontAtlasGeneration = SCR_FontAtlasGeneration;
 	import.SCR_SetDrawCharIntercept = SCR_SetDrawCharIntercept;
 	import.SCR_strWidth = SCR_strWidth;
 	import.SCR_StrlenForWidth = SCR_StrlenForWidth;
@@ -414,6 +414,8 @@ static bool VID_LoadRefresh( const char *name ) {
 	import.Mutex_Destroy = QMutex_Destroy;
 	import.Mutex_Lock = QMutex_Lock;
 	import.Mutex_Unlock = QMutex_Unlock;
+	import.Atomic_Add = QAtomic_Add;
+	import.Atomic_CAS = QAtomic_CAS;
 
 	import.BufPipe_Create = QBufPipe_Create;
 	import.BufPipe_Destroy = QBufPipe_Destroy;
@@ -422,6 +424,14 @@ static bool VID_LoadRefresh( const char *name ) {
 	import.BufPipe_ReadCmds = QBufPipe_ReadCmds;
 	import.BufPipe_Wait = QBufPipe_Wait;
 
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+	import.Job_Schedule = QJob_Schedule;
+	import.Job_ScheduleBackground = QJob_ScheduleBackground;
+	import.Job_Wait = QJob_Wait;
+	import.Job_Done = QJob_Done;
+	import.Job_Release = QJob_Release;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+
 	file_size = strlen( LIB_DIRECTORY "/" LIB_PREFIX ) + strlen( name ) + strlen( LIB_SUFFIX ) + 1;
 	file = Mem_TempMalloc( file_size );
 	Q_snprintfz( file, file_size, LIB_DIRECTORY "/" LIB_PREFIX "%s" LIB_SUFFIX, name );
@@ -179,9 +179,12 @@ typedef struct {
 	bool playing;
 	bool paused;        // A boolean to test if demo is paused -- PLX
 
-	int file;
+	struct demostream_s *file;
 	char *filename;
 
+	struct demoindex_s *index;  // keyframes of the demo being recorded
+	bool keyframe_requested;    // waiting for a non-delta frame for the index
+
 	time_t localtime;       // time of day of demo recording
 	int64_t time;           // milliseconds passed since the start of the demo
 	int64_t duration, basetime;
@@ -317,6 +320,7 @@ extern cvar_t *cl_demoavi_video;
 extern cvar_t *cl_demoavi_audio;
 extern cvar_t *cl_demoavi_fps;
 extern cvar_t *cl_demoavi_scissor;
+extern cvar_t *cl_democompression;
 
 // wsw : debug netcode
 extern cvar_t *cl_debug_serverCmd;
@@ -529,6 +533,7 @@ void CL_Stop_f( void );
 void CL_Record_f( void );
 void CL_PauseDemo_f( void );
 void CL_DemoJump_f( void );
+void CL_IndexDemo_f( void );
 void CL_BeginDemoAviDump( void );
 size_t CL_ReadDemoMetaData( const char *demopath, char *meta_data, size_t meta_data_size );
 char **CL_DemoComplete( const char *partial );
@@ -539,6 +544,7 @@ char **CL_DemoComplete( const char *partial );
 // cl_parse.c
 //
 void CL_ParseServerMessage( msg_t *msg );
+void CL_UpdateConfigString( int idx, const char *s );
 #define SHOWNET( msg,s ) _SHOWNET( msg,s,cl_shownet->integer );
 
 void CL_FreeDownloadList( void );
@@ -579,6 +585,7 @@ size_t SCR_StrlenForWidth( const char *str, qfontface_t *font, size_t maxwidth,
 int SCR_FontUnderline( qfontface_t *font, int *thickness );
 size_t SCR_FontAdvance( qfontface_t *font );
 size_t SCR_FontXHeight( qfontface_t *font );
+unsigned int SCR_FontAtlasGeneration( qfontface_t *font );
 fdrawchar_t SCR_SetDrawCharIntercept( fdrawchar_t intercept );
 int SCR_DrawString( int x, int y, int align, const char *str, qfontface_t *font, vec4_t color, int flags );
 size_t SCR_DrawStringWidth( int x, int y, int align, const char *str, size_t maxwidth, qfontface_t *font, vec4_t color, int flags );
@@ -271,6 +271,15 @@ void FTLIB_FreeFonts( bool verbose ) {
 	}
 }
 
+/*
+* FTLIB_BeginFrame
+*/
+void FTLIB_BeginFrame( void ) {
+	if( ftlib_export ) {
+		ftlib_export->BeginFrame();
+	}
+}
+
 // drawing functions
 
 /*
@@ -329,6 +338,13 @@ size_t FTLIB_FontXHeight( struct qfontface_s *font ) {
 	return ftlib_export ? ftlib_export->FontXHeight( font ) : 0;
 }
 
+/*
+* FTLIB_FontAtlasGeneration
+*/
+unsigned int FTLIB_FontAtlasGeneration( struct qfontface_s *font ) {
+	return ftlib_export ? ftlib_export->FontAtlasGeneration( font ) : 0;
+}
+
 /*
 * FTLIB_SetDrawCharIntercept
 */
@@ -27,6 +27,7 @@ void FTLIB_TouchFont( struct qfontface_s *qfont );
 void FTLIB_TouchAllFonts( void );
 void FTLIB_PrecacheFonts( bool verbose );
 void FTLIB_FreeFonts( bool verbose );
+void FTLIB_BeginFrame( void );
 
 // drawing functions
 
@@ -37,6 +38,7 @@ size_t FTLIB_StrlenForWidth( const char *str, struct qfontface_s *font, size_t m
 int FTLIB_FontUnderline( struct qfontface_s *font, int *thickness );
 size_t FTLIB_FontAdvance( struct qfontface_s *font );
 size_t FTLIB_FontXHeight( struct qfontface_s *font );
+unsigned int FTLIB_FontAtlasGeneration( struct qfontface_s *font );
 void FTLIB_DrawRawChar( int x, int y, wchar_t num, struct qfontface_s *font, vec4_t color );
 void FTLIB_DrawClampChar( int x, int y, wchar_t num, int xmin, int ymin, int xmax, int ymax, struct qfontface_s *font, vec4_t color );
 void FTLIB_DrawClampString( int x, int y, const char *str, int xmin, int ymin, int xmax, int ymax, struct qfontface_s *font, vec4_t color, int flags );
@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // snd_public.h -- sound dll information visible to engine
 
-#define SOUND_API_VERSION   40
+#define SOUND_API_VERSION   41
 
 #define ATTN_NONE 0
 
@@ -108,6 +108,14 @@ typedef struct {
 	int ( *BufPipe_ReadCmds )( struct qbufPipe_s *queue, unsigned( **cmdHandlers )( const void * ) );
 	void ( *BufPipe_Wait )( struct qbufPipe_s *queue, int ( *read )( struct qbufPipe_s *, unsigned( ** )( const void * ), bool ),
 							unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec );
+
+	int ( *Jobs_NumWorkers )( void );
+	struct qjob_s *( *Job_Schedule )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+									  unsigned items, unsigned grain, struct qjob_s **deps, unsigned numDeps );
+	void ( *Job_Wait )( struct qjob_s *job );
+	void ( *Job_Release )( struct qjob_s **pjob );
+	void ( *Jobs_ParallelFor )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+								unsigned items, unsigned grain );
 } sound_import_t;
 
 //
@@ -23,6 +23,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 static qfontfamily_t *fontFamilies;
 
+unsigned int ftlibFrameNum;
+
 // ============================================================================
 
 #include <ft2build.h>
@@ -61,8 +63,6 @@ typedef struct {
 } qftfamily_t;
 
 typedef struct {
-	unsigned int imageCurX, imageCurY, imageCurLineHeight;
-
 	FT_Size ftsize, ftfallbacksize;
 	qfontfamily_t *fallbackFamily;
 	bool fallbackLoaded;
@@ -310,17 +310,18 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 	FT_UInt pixelMode;
 	int srcStride = 0;
 	unsigned int bitmapWidth, bitmapHeight;
-	unsigned int tempWidth = 0, tempLineHeight = 0;
-	struct shader_s *shader = qfont->shaders[qfont->numShaders - 1];
-	int shaderNum;
+	unsigned int rectX, rectY;
+	qfontshelf_t *tempShelf = NULL;
+	unsigned int tempX = 0, tempY = 0, tempWidth = 0, tempLineHeight = 0;
 	int x, y;
 	uint8_t *src, *dest;
 
 	for( ; ; ) {
 		gc = Q_GrabWCharFromColorString( &str, &num, NULL );
 		if( gc == GRABCHAR_END ) {
-			QFT_UploadRenderedGlyphs( qftGlyphTempBitmap, shader, qttf->imageCurX, qttf->imageCurY, qfont->shaderWidth, tempWidth, tempLineHeight );
-			qttf->imageCurX += tempWidth;
+			if( tempShelf ) {
+				QFT_UploadRenderedGlyphs( qftGlyphTempBitmap, qfont->shaders[tempShelf->image], tempX, tempY, qfont->shaderWidth, tempWidth, tempLineHeight );
+			}
 			break;
 		}
 
@@ -347,7 +348,7 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 		if( fterror ) {
 			Com_Printf( S_COLOR_YELLOW "Warning: Failed to load and render glyph %i for '%s', error %i\n",
 						num, qfont->family->name, fterror );
-			qglyph->shader = shader;
+			qglyph->shader = qfont->shaders[0];
 			continue;
 		}
 		ftglyph = ftsize->face->glyph;
@@ -377,13 +378,18 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 			bitmapHeight = qfont->shaderHeight;
 		}
 
-		if( ( qttf->imageCurX + tempWidth + bitmapWidth ) > qfont->shaderWidth ) {
-			QFT_UploadRenderedGlyphs( qftGlyphTempBitmap, shader, qttf->imageCurX, qttf->imageCurY, qfont->shaderWidth, tempWidth, tempLineHeight );
+		FTLIB_AllocGlyphRect( qfont, qglyph, bitmapWidth, bitmapHeight, &rectX, &rectY );
+
+		// glyphs placed next to each other on the same shelf are uploaded together
+		if( qglyph->shelf != tempShelf || rectX != tempX + tempWidth ) {
+			if( tempShelf ) {
+				QFT_UploadRenderedGlyphs( qftGlyphTempBitmap, qfont->shaders[tempShelf->image], tempX, tempY, qfont->shaderWidth, tempWidth, tempLineHeight );
+			}
+			tempShelf = qglyph->shelf;
+			tempX = rectX;
+			tempY = rectY;
 			tempWidth = 0;
 			tempLineHeight = 0;
-			qttf->imageCurX = 0;
-			qttf->imageCurY += qttf->imageCurLineHeight - 1; // overlap the previous line's margin
-			qttf->imageCurLineHeight = 0;
 		}
 
 		if( bitmapHeight > qftGlyphTempBitmapHeight ) {
@@ -392,20 +398,6 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 		}
 
 		if( bitmapHeight > tempLineHeight ) {
-			if( bitmapHeight > qttf->imageCurLineHeight ) {
-				if( ( qttf->imageCurY + bitmapHeight ) > qfont->shaderHeight ) {
-					QFT_UploadRenderedGlyphs( qftGlyphTempBitmap, shader, qttf->imageCurX, qttf->imageCurY, qfont->shaderWidth, tempWidth, tempLineHeight );
-					tempWidth = 0;
-					qttf->imageCurX = 0;
-					qttf->imageCurY = 0;
-					shaderNum = ( qfont->numShaders )++;
-					shader = trap_R_RegisterRawAlphaMask( FTLIB_FontShaderName( qfont, shaderNum ),
-														  qfont->shaderWidth, qfont->shaderHeight, NULL );
-					qfont->shaders = FTLIB_Realloc( qfont->shaders, qfont->numShaders * sizeof( struct shader_s * ) );
-					qfont->shaders[shaderNum] = shader;
-				}
-				qttf->imageCurLineHeight = bitmapHeight;
-			}
 			tempLineHeight = bitmapHeight;
 		}
 
@@ -414,11 +406,10 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 		qglyph->x_advance = ( ftglyph->advance.x + ( 1 << 5 ) ) >> 6;
 		qglyph->x_offset = ftglyph->bitmap_left;
 		qglyph->y_offset = -( (int)( ftglyph->bitmap_top ) );
-		qglyph->shader = shader;
-		qglyph->s1 = ( float )( qttf->imageCurX + tempWidth + 1 ) / ( float )qfont->shaderWidth;
-		qglyph->t1 = ( float )( qttf->imageCurY + 1 ) / ( float )qfont->shaderHeight;
-		qglyph->s2 = ( float )( qttf->imageCurX + tempWidth + 1 + qglyph->width ) / ( float )qfont->shaderWidth;
-		qglyph->t2 = ( float )( qttf->imageCurY + 1 + qglyph->height ) / ( float )qfont->shaderHeight;
+		qglyph->s1 = ( float )( rectX + 1 ) / ( float )qfont->shaderWidth;
+		qglyph->t1 = ( float )( rectY + 1 ) / ( float )qfont->shaderHeight;
+		qglyph->s2 = ( float )( rectX + 1 + qglyph->width ) / ( float )qfont->shaderWidth;
+		qglyph->t2 = ( float )( rectY + 1 + qglyph->height ) / ( float )qfont->shaderHeight;
 
 		src = ftglyph->bitmap.buffer;
 		dest = qftGlyphTempBitmap + tempWidth;
@@ -450,7 +441,7 @@ static void QFT_RenderString( qfontface_t *qfont, const char *str ) {
 		}
 		memset( dest, 0, bitmapWidth );
 
-		tempWidth += bitmapWidth - 1; // overlap the previous character's margin
+		tempWidth += bitmapWidth;
 	}
 }
 
@@ -557,10 +548,7 @@ static qfontface_t *QFT_LoadFace( qfontfamily_t *family, unsigned int size ) {
 		qfont->shaderHeight = maxShaderHeight;
 	}
 
-	qfont->numShaders = 1;
-	qfont->shaders = FTLIB_Alloc( ftlibPool, sizeof( struct shader_s * ) );
-	qfont->shaders[0] = trap_R_RegisterRawAlphaMask( FTLIB_FontShaderName( qfont, 0 ),
-													 qfont->shaderWidth, qfont->shaderHeight, NULL );
+	FTLIB_AddAtlasImage( qfont );
 	qfont->hasKerning = hasKerning;
 	qfont->f = &qft_face_funcs;
 	qfont->facedata = ( void * )qttf;
@@ -813,6 +801,8 @@ static void QFT_Shutdown( void ) {
 * FTLIB_InitSubsystems
 */
 void FTLIB_InitSubsystems( bool verbose ) {
+	FTLIB_InitAtlas();
+
 	QFT_Init( verbose );
 }
 
@@ -953,6 +943,9 @@ void FTLIB_FreeFonts( bool verbose ) {
 				FTLIB_Free( qface->shaders );
 			}
 
+			FTLIB_FreeAtlas( qface );
+			FTLIB_FreeKerningCache( qface );
+
 			for( i = 0; i < ( sizeof( qface->glyphs ) / sizeof( qface->glyphs[0] ) ); i++ ) {
 				if( qface->glyphs[i] ) {
 					FTLIB_Free( qface->glyphs[i] );
@@ -973,12 +966,16 @@ void FTLIB_FreeFonts( bool verbose ) {
 	}
 
 	fontFamilies = NULL;
+
+	FTLIB_ClearLayoutCache();
 }
 
 /*
 * FTLIB_ShutdownSubsystems
 */
 void FTLIB_ShutdownSubsystems( bool verbose ) {
+	FTLIB_ClearLayoutCache();
+
 	QFT_Shutdown();
 }
 
@@ -999,8 +996,16 @@ void FTLIB_PrintFontList( void ) {
 
 		// print all faces for this family
 		for( qface = qfamily->faces; qface; qface = qface->next ) {
-			Com_Printf( "* size: %ipt, height: %ipx, images: %i (%ix%i)\n",
-						qface->size, qface->height, qface->numShaders, qface->shaderWidth, qface->shaderHeight );
+			unsigned int numShelves = 0;
+			qfontshelf_t *shelf;
+
+			for( shelf = qface->shelves; shelf; shelf = shelf->next ) {
+				numShelves++;
+			}
+
+			Com_Printf( "* size: %ipt, height: %ipx, images: %i (%ix%i), shelves: %i, evictions: %i\n",
+						qface->size, qface->height, qface->numShaders, qface->shaderWidth, qface->shaderHeight,
+						numShelves, qface->numEvictions );
 		}
 	}
 }
@@ -1012,6 +1017,7 @@ void FTLIB_PrintFontList( void ) {
 */
 qglyph_t *FTLIB_GetGlyph( qfontface_t *font, wchar_t num ) {
 	void *glyphs;
+	qglyph_t *glyph;
 
 	if( ( num < ' ' ) || ( num > 0xffff ) ) {
 		return NULL;
@@ -1023,7 +1029,12 @@ qglyph_t *FTLIB_GetGlyph( qfontface_t *font, wchar_t num ) {
 		font->glyphs[num >> 8] = glyphs;
 	}
 
-	return font->f->getGlyph( font, glyphs, num & 255, num );
+	glyph = font->f->getGlyph( font, glyphs, num & 255, num );
+	if( glyph && glyph->shelf ) {
+		glyph->shelf->lastUsed = ftlibFrameNum;
+	}
+
+	return glyph;
 }
 
 /*
@@ -1039,3 +1050,12 @@ const char *FTLIB_FontShaderName( qfontface_t *qfont, unsigned int shaderNum ) {
 
 	return name;
 }
+
+/*
+* FTLIB_BeginFrame
+*
+* Glyphs drawn during the current frame are kept in the font images.
+*/
+void FTLIB_BeginFrame( void ) {
+	ftlibFrameNum++;
+}
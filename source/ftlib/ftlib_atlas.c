@@ -0,0 +1,272 @@
+/*
+Copyright (C) 2015 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "ftlib_local.h"
+
+// Glyphs are packed into shelves, rows of glyphs of similar height stacked from
+// the top of each font image. Once a face has ftlib_atlasImages images, the least
+// recently drawn shelf is cleared for new glyphs, and the glyphs that were in it
+// are rendered again the next time they are drawn. Shelves drawn during the
+// current frame are never cleared, so the budget is exceeded rather than drawing
+// the wrong glyphs if a single frame needs more of them. Every cleared shelf bumps
+// the atlas generation of the face, see FTLIB_FontAtlasGeneration, so that text
+// geometry built from earlier glyph coordinates can be generated again.
+
+#define FTLIB_SHELF_HEIGHT_ALIGN    4
+
+static cvar_t *ftlib_atlasImages;
+
+/*
+* FTLIB_InitAtlas
+*/
+void FTLIB_InitAtlas( void ) {
+	ftlib_atlasImages = trap_Cvar_Get( "ftlib_atlasImages", "4", CVAR_ARCHIVE );
+}
+
+/*
+* FTLIB_ShelfFits
+*
+* Whether the glyph can go into the shelf without wasting too much space.
+*/
+static inline bool FTLIB_ShelfFits( const qfontshelf_t *shelf, unsigned int height ) {
+	return shelf->height >= height && shelf->height <= height + height / 4 + FTLIB_SHELF_HEIGHT_ALIGN;
+}
+
+/*
+* FTLIB_AddAtlasImage
+*/
+unsigned int FTLIB_AddAtlasImage( qfontface_t *qfont ) {
+	unsigned int num = qfont->numShaders++;
+
+	if( qfont->shaders ) {
+		qfont->shaders = FTLIB_Realloc( qfont->shaders, qfont->numShaders * sizeof( shader_t * ) );
+		qfont->shaderUsedHeights = FTLIB_Realloc( qfont->shaderUsedHeights, qfont->numShaders * sizeof( unsigned int ) );
+	} else {
+		qfont->shaders = FTLIB_Alloc( ftlibPool, sizeof( shader_t * ) );
+		qfont->shaderUsedHeights = FTLIB_Alloc( ftlibPool, sizeof( unsigned int ) );
+	}
+
+	qfont->shaders[num] = trap_R_RegisterRawAlphaMask( FTLIB_FontShaderName( qfont, num ),
+													   qfont->shaderWidth, qfont->shaderHeight, NULL );
+	qfont->shaderUsedHeights[num] = 0;
+
+	return num;
+}
+
+/*
+* FTLIB_NewShelf
+*/
+static qfontshelf_t *FTLIB_NewShelf( qfontface_t *qfont, unsigned int image, unsigned int y, unsigned int height ) {
+	qfontshelf_t *shelf;
+
+	shelf = FTLIB_Alloc( ftlibPool, sizeof( *shelf ) );
+	shelf->image = image;
+	shelf->y = y;
+	shelf->height = height;
+	shelf->lastUsed = ftlibFrameNum;
+	shelf->next = qfont->shelves;
+	qfont->shelves = shelf;
+
+	return shelf;
+}
+
+/*
+* FTLIB_ClearShelf
+*/
+static void FTLIB_ClearShelf( qfontface_t *qfont, qfontshelf_t *shelf ) {
+	qglyph_t *glyph, *next;
+
+	for( glyph = shelf->glyphs; glyph; glyph = next ) {
+		next = glyph->nextInShelf;
+		glyph->shader = NULL;
+		glyph->shelf = NULL;
+		glyph->nextInShelf = NULL;
+	}
+
+	shelf->glyphs = NULL;
+	shelf->x = 0;
+	qfont->numEvictions++;
+}
+
+/*
+* FTLIB_EvictShelf
+*
+* Clears the least recently used shelf that the glyph fits in, splitting it if it's too tall.
+*/
+static qfontshelf_t *FTLIB_EvictShelf( qfontface_t *qfont, unsigned int height ) {
+	qfontshelf_t *shelf, *lru = NULL;
+
+	for( shelf = qfont->shelves; shelf; shelf = shelf->next ) {
+		if( shelf->lastUsed == ftlibFrameNum || shelf->height < height ) {
+			continue;
+		}
+		if( !lru || shelf->lastUsed < lru->lastUsed || ( shelf->lastUsed == lru->lastUsed && shelf->height < lru->height ) ) {
+			lru = shelf;
+		}
+	}
+
+	if( !lru ) {
+		return NULL;
+	}
+
+	FTLIB_ClearShelf( qfont, lru );
+
+	if( !FTLIB_ShelfFits( lru, height ) ) {
+		qfontshelf_t *rest;
+
+		rest = FTLIB_NewShelf( qfont, lru->image, lru->y + height, lru->height - height );
+		rest->lastUsed = lru->lastUsed;
+		lru->height = height;
+	}
+
+	return lru;
+}
+
+/*
+* FTLIB_EvictImage
+*
+* Clears the least recently used image, for glyphs taller than any shelf that can be cleared.
+*/
+static bool FTLIB_EvictImage( qfontface_t *qfont, unsigned int *image ) {
+	unsigned int i;
+	unsigned int *lastUsed;
+	qfontshelf_t *shelf, **prev;
+	bool found = false;
+
+	lastUsed = FTLIB_Alloc( ftlibPool, qfont->numShaders * sizeof( *lastUsed ) );
+	for( shelf = qfont->shelves; shelf; shelf = shelf->next ) {
+		lastUsed[shelf->image] = max( lastUsed[shelf->image], shelf->lastUsed + 1 );
+	}
+	for( i = 0; i < qfont->numShaders; i++ ) {
+		if( lastUsed[i] == ftlibFrameNum + 1 ) {
+			continue;
+		}
+		if( !found || lastUsed[i] < lastUsed[*image] ) {
+			*image = i;
+			found = true;
+		}
+	}
+	FTLIB_Free( lastUsed );
+
+	if( !found ) {
+		return false;
+	}
+
+	for( prev = &qfont->shelves; *prev; ) {
+		shelf = *prev;
+		if( shelf->image != *image ) {
+			prev = &shelf->next;
+			continue;
+		}
+
+		FTLIB_ClearShelf( qfont, shelf );
+		*prev = shelf->next;
+		FTLIB_Free( shelf );
+	}
+	qfont->shaderUsedHeights[*image] = 0;
+
+	return true;
+}
+
+/*
+* FTLIB_AddShelf
+*/
+static qfontshelf_t *FTLIB_AddShelf( qfontface_t *qfont, unsigned int height ) {
+	unsigned int i, y;
+	qfontshelf_t *shelf;
+
+	// free space at the bottom of an image
+	for( i = 0; i < qfont->numShaders; i++ ) {
+		if( qfont->shaderUsedHeights[i] + height <= qfont->shaderHeight ) {
+			break;
+		}
+	}
+
+	if( i == qfont->numShaders && qfont->numShaders >= (unsigned)max( ftlib_atlasImages->integer, 1 ) ) {
+		shelf = FTLIB_EvictShelf( qfont, height );
+		if( shelf ) {
+			return shelf;
+		}
+
+		if( !FTLIB_EvictImage( qfont, &i ) ) {
+			Com_DPrintf( "Font '%s' %ipt exceeds %i images\n", qfont->family->name, qfont->size, ftlib_atlasImages->integer );
+			i = qfont->numShaders;
+		}
+	}
+
+	if( i == qfont->numShaders ) {
+		i = FTLIB_AddAtlasImage( qfont );
+	}
+
+	y = qfont->shaderUsedHeights[i];
+	qfont->shaderUsedHeights[i] += height;
+	return FTLIB_NewShelf( qfont, i, y, height );
+}
+
+/*
+* FTLIB_AllocGlyphRect
+*
+* Finds space for the glyph bitmap, including its margins, and assigns the image to the glyph.
+*/
+void FTLIB_AllocGlyphRect( qfontface_t *qfont, qglyph_t *glyph, unsigned int width, unsigned int height, unsigned int *x, unsigned int *y ) {
+	qfontshelf_t *shelf, *best = NULL;
+
+	// the lowest shelf with room left
+	for( shelf = qfont->shelves; shelf; shelf = shelf->next ) {
+		if( shelf->x + width > qfont->shaderWidth || !FTLIB_ShelfFits( shelf, height ) ) {
+			continue;
+		}
+		if( !best || shelf->height < best->height ) {
+			best = shelf;
+		}
+	}
+
+	if( !best ) {
+		best = FTLIB_AddShelf( qfont, min( Q_ALIGN( height, FTLIB_SHELF_HEIGHT_ALIGN ), qfont->shaderHeight ) );
+	}
+
+	*x = best->x;
+	*y = best->y;
+	best->x += width;
+	best->lastUsed = ftlibFrameNum;
+
+	glyph->shader = qfont->shaders[best->image];
+	glyph->shelf = best;
+	glyph->nextInShelf = best->glyphs;
+	best->glyphs = glyph;
+}
+
+/*
+* FTLIB_FreeAtlas
+*/
+void FTLIB_FreeAtlas( qfontface_t *qfont ) {
+	qfontshelf_t *shelf, *next;
+
+	for( shelf = qfont->shelves; shelf; shelf = next ) {
+		next = shelf->next;
+		FTLIB_Free( shelf );
+	}
+	qfont->shelves = NULL;
+
+	if( qfont->shaderUsedHeights ) {
+		FTLIB_Free( qfont->shaderUsedHeights );
+		qfont->shaderUsedHeights = NULL;
+	}
+}
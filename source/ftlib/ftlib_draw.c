@@ -30,7 +30,7 @@ static fdrawchar_t drawCharIntercept = NULL;
 /*
 * FTLIB_GrabChar
 */
-static int FTLIB_GrabChar( const char **pstr, wchar_t *wc, int *colorindex, int flags ) {
+int FTLIB_GrabChar( const char **pstr, wchar_t *wc, int *colorindex, int flags ) {
 	if( flags & TEXTDRAWFLAG_NO_COLORS ) {
 		wchar_t num = Q_GrabWCharFromUtf8String( pstr );
 		*wc = num;
@@ -65,67 +65,28 @@ size_t FTLIB_FontHeight( qfontface_t *font ) {
 * doesn't count invisible characters. Counts up to given length, if any.
 */
 size_t FTLIB_strWidth( const char *str, qfontface_t *font, size_t maxlen, int flags ) {
-	const char *s = str, *olds;
-	size_t width = 0;
-	wchar_t num, prev_num = 0;
-	qglyph_t *glyph, *prev_glyph = NULL;
-	renderString_f renderString;
-	getKerning_f getKerning;
-	bool hasKerning;
+	unsigned int i;
+	const qfontlayout_t *layout;
+	const qfontlayoutchar_t *c;
 
 	if( !str || !font ) {
 		return 0;
 	}
 
-	renderString = font->f->renderString;
-	getKerning = font->f->getKerning;
-	hasKerning = ( flags & TEXTDRAWFLAG_KERNING ) && font->hasKerning;
-
-	while( *s && *s != '\n' ) {
-		if( maxlen && (size_t)( s - str ) >= maxlen ) { // stop counting at desired len
-			return width;
-		}
-
-		olds = s;
-
-		switch( FTLIB_GrabChar( &s, &num, NULL, flags ) ) {
-			case GRABCHAR_CHAR:
-				if( num < ' ' ) {
-					break;
-				}
-
-				glyph = FTLIB_GetGlyph( font, num );
-				if( !glyph ) {
-					num = FTLIB_REPLACEMENT_GLYPH;
-					glyph = FTLIB_GetGlyph( font, num );
-				}
-
-				if( !glyph->shader ) {
-					renderString( font, olds );
-				}
-
-				if( prev_num && hasKerning ) {
-					width += getKerning( font, prev_glyph, glyph );
-				}
-
-				width += glyph->x_advance;
-
-				prev_num = num;
-				prev_glyph = glyph;
-				break;
-
-			case GRABCHAR_COLOR:
-				break;
-
-			case GRABCHAR_END:
-				return width;
+	layout = FTLIB_GetStringLayout( str, font, flags );
+	if( !maxlen ) {
+		return layout->width;
+	}
 
-			default:
-				assert( 0 );
+	// stop counting at desired len
+	for( i = layout->numChars; i > 0; i-- ) {
+		c = &layout->chars[i - 1];
+		if( c->glyph && c->offset < maxlen ) {
+			return c->x + c->glyph->x_advance;
 		}
 	}
 
-	return width;
+	return 0;
 }
 
 /*
@@ -133,70 +94,24 @@ size_t FTLIB_strWidth( const char *str, qfontface_t *font, size_t maxlen, int fl
 * returns the len allowed for the string to fit inside a given width when using a given font.
 */
 size_t FTLIB_StrlenForWidth( const char *str, qfontface_t *font, size_t maxwidth, int flags ) {
-	const char *s, *olds;
-	size_t width = 0;
-	int gc;
-	int advance = 0;
-	wchar_t num, prev_num = 0;
-	qglyph_t *glyph, *prev_glyph = NULL;
-	renderString_f renderString;
-	getKerning_f getKerning;
-	bool hasKerning;
+	unsigned int i;
+	const qfontlayout_t *layout;
+	const qfontlayoutchar_t *c;
 
 	if( !str || !font ) {
 		return 0;
 	}
 
-	renderString = font->f->renderString;
-	getKerning = font->f->getKerning;
-	hasKerning = ( flags & TEXTDRAWFLAG_KERNING ) && font->hasKerning;
-
-	for( s = str; s; ) {
-		olds = s;
-		gc = FTLIB_GrabChar( &s, &num, NULL, flags );
-		if( gc == GRABCHAR_CHAR ) {
-			if( num == '\n' ) {
-				break;
-			}
-
-			if( num < ' ' ) {
-				continue;
-			}
-
-			glyph = FTLIB_GetGlyph( font, num );
-			if( !glyph ) {
-				num = FTLIB_REPLACEMENT_GLYPH;
-				glyph = FTLIB_GetGlyph( font, num );
-			}
-
-			if( !glyph->shader ) {
-				renderString( font, olds );
-			}
-
-			advance = glyph->x_advance;
-			if( hasKerning && prev_num ) {
-				advance += getKerning( font, prev_glyph, glyph );
-			}
-
-			if( maxwidth && ( ( width + advance ) > maxwidth ) ) {
-				s = olds;
-				break;
+	layout = FTLIB_GetStringLayout( str, font, flags );
+	if( maxwidth ) {
+		for( i = 0, c = layout->chars; i < layout->numChars; i++, c++ ) {
+			if( c->glyph && (size_t)( c->x + c->glyph->x_advance ) > maxwidth ) {
+				return c->offset;
 			}
-
-			width += advance;
-
-			prev_num = num;
-			prev_glyph = glyph;
-		} else if( gc == GRABCHAR_COLOR ) {
-			continue;
-		} else if( gc == GRABCHAR_END ) {
-			break;
-		} else {
-			assert( 0 );
 		}
 	}
 
-	return (unsigned int)( s - str );
+	return layout->length;
 }
 
 /*
@@ -241,6 +156,19 @@ size_t FTLIB_FontXHeight( qfontface_t *font ) {
 	return 0;
 }
 
+/*
+* FTLIB_FontAtlasGeneration
+*
+* Changes whenever glyphs are evicted from the font images, so the callers that keep
+* texture coordinates of glyphs around know when to generate them again.
+*/
+unsigned int FTLIB_FontAtlasGeneration( qfontface_t *font ) {
+	if( font ) {
+		return font->numEvictions;
+	}
+	return 0;
+}
+
 //===============================================================================
 //STRINGS DRAWING
 //===============================================================================
@@ -255,30 +183,32 @@ fdrawchar_t FTLIB_SetDrawIntercept( fdrawchar_t intercept ) {
 }
 
 /*
-* FTLIB_DrawRawChar
+* FTLIB_PrepareGlyph
 *
-* Draws one graphics character with 0 being transparent.
-* It can be clipped to the top of the screen to allow the console to be
-* smoothly scrolled off.
+* Makes sure the glyph is in the font images, and keeps it there for this frame.
 */
-void FTLIB_DrawRawChar( int x, int y, wchar_t num, qfontface_t *font, vec4_t color ) {
-	qglyph_t *glyph;
-	fdrawchar_t draw = trap_R_DrawStretchPic;
-
-	if( ( num <= ' ' ) || !font || ( y <= -font->height ) ) {
-		return;
+static void FTLIB_PrepareGlyph( qfontface_t *font, wchar_t num, qglyph_t *glyph ) {
+	if( !glyph->shader ) {
+		font->f->renderString( font, Q_WCharToUtf8Char( num ) );
 	}
 
-	glyph = FTLIB_GetGlyph( font, num );
-	if( !glyph ) {
-		num = FTLIB_REPLACEMENT_GLYPH;
-		glyph = FTLIB_GetGlyph( font, num );
+	if( glyph->shelf ) {
+		glyph->shelf->lastUsed = ftlibFrameNum;
 	}
+}
 
-	if( !glyph->shader ) {
-		font->f->renderString( font, Q_WCharToUtf8Char( num ) );
+/*
+* FTLIB_DrawRawGlyph
+*/
+static void FTLIB_DrawRawGlyph( int x, int y, wchar_t num, qglyph_t *glyph, qfontface_t *font, vec4_t color ) {
+	fdrawchar_t draw = trap_R_DrawStretchPic;
+
+	if( ( num <= ' ' ) || ( y <= -font->height ) ) {
+		return;
 	}
 
+	FTLIB_PrepareGlyph( font, num, glyph );
+
 	if( !glyph->width || !glyph->height ) {
 		return;
 	}
@@ -294,31 +224,19 @@ void FTLIB_DrawRawChar( int x, int y, wchar_t num, qfontface_t *font, vec4_t col
 }
 
 /*
-* FTLIB_DrawClampChar
-*
-* Draws one graphics character with 0 being transparent.
-* Clipped to [xmin, ymin; xmax, ymax].
+* FTLIB_DrawClampGlyph
 */
-void FTLIB_DrawClampChar( int x, int y, wchar_t num, int xmin, int ymin, int xmax, int ymax, qfontface_t *font, vec4_t color ) {
-	qglyph_t *glyph;
+static void FTLIB_DrawClampGlyph( int x, int y, wchar_t num, qglyph_t *glyph, int xmin, int ymin, int xmax, int ymax, qfontface_t *font, vec4_t color ) {
 	int x2, y2;
 	float s1 = 0.0f, t1 = 0.0f, s2 = 1.0f, t2 = 1.0f;
 	float tw, th;
 	fdrawchar_t draw = trap_R_DrawStretchPic;
 
-	if( ( num <= ' ' ) || !font || ( xmax <= xmin ) || ( ymax <= ymin ) ) {
+	if( ( num <= ' ' ) || ( xmax <= xmin ) || ( ymax <= ymin ) ) {
 		return;
 	}
 
-	glyph = FTLIB_GetGlyph( font, num );
-	if( !glyph ) {
-		num = FTLIB_REPLACEMENT_GLYPH;
-		glyph = FTLIB_GetGlyph( font, num );
-	}
-
-	if( !glyph->shader ) {
-		font->f->renderString( font, Q_WCharToUtf8Char( num ) );
-	}
+	FTLIB_PrepareGlyph( font, num, glyph );
 
 	if( !glyph->width || !glyph->height ) {
 		return;
@@ -366,78 +284,80 @@ void FTLIB_DrawClampChar( int x, int y, wchar_t num, int xmin, int ymin, int xma
 }
 
 /*
-* FTLIB_DrawClampString
+* FTLIB_DrawRawChar
+*
+* Draws one graphics character with 0 being transparent.
+* It can be clipped to the top of the screen to allow the console to be
+* smoothly scrolled off.
 */
-void FTLIB_DrawClampString( int x, int y, const char *str, int xmin, int ymin, int xmax, int ymax, qfontface_t *font, vec4_t color, int flags ) {
-	int xoffset = 0;
-	vec4_t scolor;
-	int colorindex;
-	wchar_t num, prev_num = 0;
-	const char *s = str, *olds;
-	int gc;
-	qglyph_t *glyph, *prev_glyph = NULL;
-	renderString_f renderString;
-	getKerning_f getKerning;
-	bool hasKerning;
+void FTLIB_DrawRawChar( int x, int y, wchar_t num, qfontface_t *font, vec4_t color ) {
+	qglyph_t *glyph;
 
-	if( !str || !font ) {
+	if( ( num <= ' ' ) || !font || ( y <= -font->height ) ) {
 		return;
 	}
-	if( ( xmax <= xmin ) || ( ymax <= ymin ) || ( x > xmax ) || ( y > ymax ) ) {
-		return;
+
+	glyph = FTLIB_GetGlyph( font, num );
+	if( !glyph ) {
+		num = FTLIB_REPLACEMENT_GLYPH;
+		glyph = FTLIB_GetGlyph( font, num );
 	}
 
-	Vector4Copy( color, scolor );
+	FTLIB_DrawRawGlyph( x, y, num, glyph, font, color );
+}
 
-	renderString = font->f->renderString;
-	getKerning = font->f->getKerning;
-	hasKerning = ( flags & TEXTDRAWFLAG_KERNING ) && font->hasKerning;
+/*
+* FTLIB_DrawClampChar
+*
+* Draws one graphics character with 0 being transparent.
+* Clipped to [xmin, ymin; xmax, ymax].
+*/
+void FTLIB_DrawClampChar( int x, int y, wchar_t num, int xmin, int ymin, int xmax, int ymax, qfontface_t *font, vec4_t color ) {
+	qglyph_t *glyph;
 
-	while( 1 ) {
-		olds = s;
-		gc = FTLIB_GrabChar( &s, &num, &colorindex, flags );
-		if( gc == GRABCHAR_CHAR ) {
-			if( num == '\n' ) {
-				break;
-			}
+	if( ( num <= ' ' ) || !font || ( xmax <= xmin ) || ( ymax <= ymin ) ) {
+		return;
+	}
 
-			if( num < ' ' ) {
-				continue;
-			}
+	glyph = FTLIB_GetGlyph( font, num );
+	if( !glyph ) {
+		num = FTLIB_REPLACEMENT_GLYPH;
+		glyph = FTLIB_GetGlyph( font, num );
+	}
 
-			glyph = FTLIB_GetGlyph( font, num );
-			if( !glyph ) {
-				num = FTLIB_REPLACEMENT_GLYPH;
-				glyph = FTLIB_GetGlyph( font, num );
-			}
+	FTLIB_DrawClampGlyph( x, y, num, glyph, xmin, ymin, xmax, ymax, font, color );
+}
 
-			if( !glyph->shader ) {
-				renderString( font, olds );
-			}
+/*
+* FTLIB_DrawClampString
+*/
+void FTLIB_DrawClampString( int x, int y, const char *str, int xmin, int ymin, int xmax, int ymax, qfontface_t *font, vec4_t color, int flags ) {
+	unsigned int i;
+	vec4_t scolor;
+	const qfontlayout_t *layout;
+	const qfontlayoutchar_t *c;
 
-			if( prev_num ) {
-				xoffset += prev_glyph->x_advance;
-				if( hasKerning ) {
-					xoffset += getKerning( font, prev_glyph, glyph );
-				}
-			}
+	if( !str || !font ) {
+		return;
+	}
+	if( ( xmax <= xmin ) || ( ymax <= ymin ) || ( x > xmax ) || ( y > ymax ) ) {
+		return;
+	}
 
-			if( x + xoffset > xmax ) {
-				break;
-			}
+	Vector4Copy( color, scolor );
 
-			FTLIB_DrawClampChar( x + xoffset, y, num, xmin, ymin, xmax, ymax, font, scolor );
+	layout = FTLIB_GetStringLayout( str, font, flags );
+	for( i = 0, c = layout->chars; i < layout->numChars; i++, c++ ) {
+		if( !c->glyph ) {
+			VectorCopy( color_table[c->colorindex], scolor );
+			continue;
+		}
 
-			prev_num = num;
-			prev_glyph = glyph;
-		} else if( gc == GRABCHAR_COLOR ) {
-			assert( ( unsigned )colorindex < MAX_S_COLORS );
-			VectorCopy( color_table[colorindex], scolor );
-		} else if( gc == GRABCHAR_END ) {
+		if( x + c->x > xmax ) {
 			break;
-		} else {
-			assert( 0 );
 		}
+
+		FTLIB_DrawClampGlyph( x + c->x, y, c->num, c->glyph, xmin, ymin, xmax, ymax, font, scolor );
 	}
 }
 
@@ -446,15 +366,11 @@ void FTLIB_DrawClampString( int x, int y, const char *str, int xmin, int ymin, i
 * It can stop when reaching maximum width when a value has been parsed.
 */
 size_t FTLIB_DrawRawString( int x, int y, const char *str, size_t maxwidth, int *width, qfontface_t *font, vec4_t color, int flags ) {
-	unsigned int xoffset = 0;
+	unsigned int i;
+	int xoffset;
 	vec4_t scolor;
-	const char *s, *olds;
-	int gc, colorindex;
-	wchar_t num, prev_num = 0;
-	qglyph_t *glyph, *prev_glyph = NULL;
-	renderString_f renderString;
-	getKerning_f getKerning;
-	bool hasKerning;
+	const qfontlayout_t *layout;
+	const qfontlayoutchar_t *c;
 
 	if( !str || !font ) {
 		return 0;
@@ -462,63 +378,30 @@ size_t FTLIB_DrawRawString( int x, int y, const char *str, size_t maxwidth, int
 
 	Vector4Copy( color, scolor );
 
-	renderString = font->f->renderString;
-	getKerning = font->f->getKerning;
-	hasKerning = ( flags & TEXTDRAWFLAG_KERNING ) && font->hasKerning;
-
-	for( s = str; s; ) {
-		olds = s;
-		gc = FTLIB_GrabChar( &s, &num, &colorindex, flags );
-		if( gc == GRABCHAR_CHAR ) {
-			if( num == '\n' ) {
-				break;
-			}
-
-			if( num < ' ' ) {
-				continue;
-			}
-
-			glyph = FTLIB_GetGlyph( font, num );
-			if( !glyph ) {
-				num = FTLIB_REPLACEMENT_GLYPH;
-				glyph = FTLIB_GetGlyph( font, num );
-			}
-
-			if( !glyph->shader ) {
-				renderString( font, olds );
-			}
-
-			// ignore kerning at this point so the full width of the previous character will always be returned
-			if( maxwidth && ( ( xoffset + glyph->x_advance ) > maxwidth ) ) {
-				s = olds;
-				break;
-			}
+	layout = FTLIB_GetStringLayout( str, font, flags );
+	for( i = 0, c = layout->chars; i < layout->numChars; i++, c++ ) {
+		if( !c->glyph ) {
+			VectorCopy( color_table[c->colorindex], scolor );
+			continue;
+		}
 
-			if( hasKerning && prev_num ) {
-				xoffset += getKerning( font, prev_glyph, glyph );
+		// ignore kerning at this point so the full width of the previous character will always be returned
+		xoffset = c->x - c->kerning;
+		if( maxwidth && ( (size_t)( xoffset + c->glyph->x_advance ) > maxwidth ) ) {
+			if( width ) {
+				*width = xoffset;
 			}
-
-			FTLIB_DrawRawChar( x + xoffset, y, num, font, scolor );
-
-			xoffset += glyph->x_advance;
-
-			prev_num = num;
-			prev_glyph = glyph;
-		} else if( gc == GRABCHAR_COLOR ) {
-			assert( ( unsigned )colorindex < MAX_S_COLORS );
-			VectorCopy( color_table[colorindex], scolor );
-		} else if( gc == GRABCHAR_END ) {
-			break;
-		} else {
-			assert( 0 );
+			return c->offset;
 		}
+
+		FTLIB_DrawRawGlyph( x + c->x, y, c->num, c->glyph, font, scolor );
 	}
 
 	if( width ) {
-		*width = xoffset;
+		*width = layout->width;
 	}
 
-	return ( s - str );
+	return layout->length;
 }
 
 /* FTLIB_DrawMultilineString
@@ -535,7 +418,6 @@ int FTLIB_DrawMultilineString( int x, int y, const char *str, int halign, int ma
 	qglyph_t *glyph, *prev_glyph;
 	int glyph_width;
 	renderString_f renderString;
-	getKerning_f getKerning;
 	bool hasKerning;
 
 	// words
@@ -561,7 +443,6 @@ int FTLIB_DrawMultilineString( int x, int y, const char *str, int halign, int ma
 	halign = halign % 3; // ignore vertical alignment
 
 	renderString = font->f->renderString;
-	getKerning = font->f->getKerning;
 	hasKerning = ( flags & TEXTDRAWFLAG_KERNING ) && font->hasKerning;
 
 	Vector4Copy( color, line_next_color );
@@ -623,7 +504,7 @@ int FTLIB_DrawMultilineString( int x, int y, const char *str, int halign, int ma
 					}
 					space_chars++;
 					if( hasKerning && prev_num ) {
-						space_width += getKerning( font, prev_glyph, glyph );
+						space_width += FTLIB_GetKerning( font, prev_glyph, glyph );
 					}
 					space_width += glyph->x_advance;
 				} else {
@@ -631,7 +512,7 @@ int FTLIB_DrawMultilineString( int x, int y, const char *str, int halign, int ma
 
 					glyph_width = glyph->x_advance;
 					if( hasKerning && prev_num ) {
-						glyph_width += getKerning( font, prev_glyph, glyph );
+						glyph_width += FTLIB_GetKerning( font, prev_glyph, glyph );
 					}
 
 					if( !word_chars ) {
@@ -708,7 +589,7 @@ int FTLIB_DrawMultilineString( int x, int y, const char *str, int halign, int ma
 					}
 
 					if( hasKerning && prev_num ) {
-						line_x += getKerning( font, prev_glyph, glyph );
+						line_x += FTLIB_GetKerning( font, prev_glyph, glyph );
 					}
 
 					FTLIB_DrawRawChar( line_x, y, num, font, line_color );
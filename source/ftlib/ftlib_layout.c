@@ -0,0 +1,391 @@
+/*
+Copyright (C) 2015 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "ftlib_local.h"
+
+// Most strings on the screen, such as HUD labels, scores and menu items, are the
+// same from frame to frame, and are usually measured before being drawn, so the
+// glyphs and positions of their characters are remembered by the contents of the
+// string. Kerning between pairs of glyphs is cached per font as well, because
+// looking it up in the font file is the most expensive part of laying text out.
+
+#define FTLIB_KERNING_CACHE_SIZE    1024        // must be a power of two
+
+#define FTLIB_LAYOUT_CACHE_SIZE     512
+#define FTLIB_LAYOUT_HASH_SIZE      256         // must be a power of two
+#define FTLIB_LAYOUT_MAX_LENGTH     256         // longer lines aren't cached
+
+typedef struct qfontkerning_s {
+	const qglyph_t *g1, *g2;
+	int kerning;
+} qfontkerning_t;
+
+static bool ftlibTextCaches = true;
+
+static qfontlayout_t *layoutHashTable[FTLIB_LAYOUT_HASH_SIZE];
+static qfontlayout_t layoutHead;                // most recently used first
+static unsigned int numLayouts;
+static unsigned int layoutHits, layoutMisses;
+
+// the layout of the last uncached string
+static qfontlayout_t scratchLayout;
+static unsigned int scratchLayoutSize;
+
+/*
+* FTLIB_GetKerning
+*/
+int FTLIB_GetKerning( qfontface_t *font, qglyph_t *g1, qglyph_t *g2 ) {
+	unsigned int hash;
+	qfontkerning_t *entry;
+
+	if( !ftlibTextCaches ) {
+		return font->f->getKerning( font, g1, g2 );
+	}
+
+	if( !font->kerningCache ) {
+		font->kerningCache = FTLIB_Alloc( ftlibPool, FTLIB_KERNING_CACHE_SIZE * sizeof( qfontkerning_t ) );
+	}
+
+	hash = (unsigned int)( (uintptr_t)g1 * 0x9E3779B1u ) ^ (unsigned int)( (uintptr_t)g2 * 0x85EBCA77u );
+	hash ^= hash >> 16;
+	entry = &font->kerningCache[hash & ( FTLIB_KERNING_CACHE_SIZE - 1 )];
+
+	if( entry->g1 != g1 || entry->g2 != g2 ) {
+		entry->g1 = g1;
+		entry->g2 = g2;
+		entry->kerning = font->f->getKerning( font, g1, g2 );
+	}
+
+	return entry->kerning;
+}
+
+/*
+* FTLIB_FreeKerningCache
+*/
+void FTLIB_FreeKerningCache( qfontface_t *font ) {
+	if( font->kerningCache ) {
+		FTLIB_Free( font->kerningCache );
+		font->kerningCache = NULL;
+	}
+}
+
+/*
+* FTLIB_HashString
+*
+* Hashes the line at the start of the string, and gets its length including the newline.
+*/
+static unsigned int FTLIB_HashString( const char *str, const qfontface_t *font, int flags, size_t *length ) {
+	const char *s;
+	unsigned int hash = 2166136261u;
+
+	for( s = str; *s; s++ ) {
+		hash = ( hash ^ (uint8_t)*s ) * 16777619u;
+		if( *s == '\n' ) {
+			s++;
+			break;
+		}
+	}
+
+	*length = s - str;
+
+	hash ^= (unsigned int)( (uintptr_t)font >> 4 ) + flags;
+	hash *= 16777619u;
+	return hash;
+}
+
+/*
+* FTLIB_AddLayoutChar
+*/
+static qfontlayoutchar_t *FTLIB_AddLayoutChar( void ) {
+	qfontlayoutchar_t *c;
+
+	if( scratchLayout.numChars == scratchLayoutSize ) {
+		scratchLayoutSize += 64;
+		if( scratchLayout.chars ) {
+			scratchLayout.chars = FTLIB_Realloc( scratchLayout.chars, scratchLayoutSize * sizeof( qfontlayoutchar_t ) );
+		} else {
+			scratchLayout.chars = FTLIB_Alloc( ftlibPool, scratchLayoutSize * sizeof( qfontlayoutchar_t ) );
+		}
+	}
+
+	c = &scratchLayout.chars[scratchLayout.numChars++];
+	memset( c, 0, sizeof( *c ) );
+	return c;
+}
+
+/*
+* FTLIB_BuildLayout
+*
+* Lays the line at the start of the string out into the scratch layout,
+* rendering the glyphs that aren't in the font images.
+*/
+static qfontlayout_t *FTLIB_BuildLayout( const char *str, qfontface_t *font, int flags ) {
+	const char *s = str, *olds;
+	int gc, colorindex, kerning;
+	int width = 0;
+	wchar_t num, prev_num = 0;
+	qglyph_t *glyph, *prev_glyph = NULL;
+	qfontlayoutchar_t *c;
+
+	scratchLayout.font = font;
+	scratchLayout.flags = flags;
+	scratchLayout.str = NULL;
+	scratchLayout.numChars = 0;
+
+	for( ; ; ) {
+		olds = s;
+		gc = FTLIB_GrabChar( &s, &num, &colorindex, flags );
+		if( gc == GRABCHAR_CHAR ) {
+			if( num == '\n' ) {
+				break;
+			}
+
+			if( num < ' ' ) {
+				continue;
+			}
+
+			glyph = FTLIB_GetGlyph( font, num );
+			if( !glyph ) {
+				num = FTLIB_REPLACEMENT_GLYPH;
+				glyph = FTLIB_GetGlyph( font, num );
+			}
+
+			if( !glyph->shader ) {
+				font->f->renderString( font, olds );
+			}
+
+			kerning = 0;
+			if( ( flags & TEXTDRAWFLAG_KERNING ) && prev_num ) {
+				kerning = FTLIB_GetKerning( font, prev_glyph, glyph );
+			}
+
+			c = FTLIB_AddLayoutChar();
+			c->glyph = glyph;
+			c->num = num;
+			c->kerning = kerning;
+			c->x = width + kerning;
+			c->offset = olds - str;
+
+			width = c->x + glyph->x_advance;
+
+			prev_num = num;
+			prev_glyph = glyph;
+		} else if( gc == GRABCHAR_COLOR ) {
+			assert( ( unsigned )colorindex < MAX_S_COLORS );
+			c = FTLIB_AddLayoutChar();
+			c->colorindex = colorindex;
+			c->x = width;
+			c->offset = olds - str;
+		} else if( gc == GRABCHAR_END ) {
+			break;
+		} else {
+			assert( 0 );
+		}
+	}
+
+	scratchLayout.width = width;
+	scratchLayout.length = s - str;
+	return &scratchLayout;
+}
+
+/*
+* FTLIB_UnlinkLayout
+*/
+static void FTLIB_UnlinkLayout( qfontlayout_t *layout ) {
+	layout->prev->next = layout->next;
+	layout->next->prev = layout->prev;
+}
+
+/*
+* FTLIB_LinkLayout
+*/
+static void FTLIB_LinkLayout( qfontlayout_t *layout ) {
+	layout->prev = &layoutHead;
+	layout->next = layoutHead.next;
+	layout->next->prev = layout;
+	layoutHead.next = layout;
+}
+
+/*
+* FTLIB_FreeLayout
+*/
+static void FTLIB_FreeLayout( qfontlayout_t *layout ) {
+	qfontlayout_t **prev;
+
+	for( prev = &layoutHashTable[layout->hash & ( FTLIB_LAYOUT_HASH_SIZE - 1 )]; *prev; prev = &( *prev )->hashNext ) {
+		if( *prev == layout ) {
+			*prev = layout->hashNext;
+			break;
+		}
+	}
+
+	FTLIB_UnlinkLayout( layout );
+	FTLIB_Free( layout );
+	numLayouts--;
+}
+
+/*
+* FTLIB_CacheLayout
+*/
+static qfontlayout_t *FTLIB_CacheLayout( const qfontlayout_t *src, const char *str, unsigned int hash ) {
+	qfontlayout_t *layout;
+	size_t charsSize = src->numChars * sizeof( qfontlayoutchar_t );
+
+	if( numLayouts >= FTLIB_LAYOUT_CACHE_SIZE ) {
+		FTLIB_FreeLayout( layoutHead.prev );
+	}
+
+	layout = FTLIB_Alloc( ftlibPool, sizeof( *layout ) + charsSize + src->length + 1 );
+	*layout = *src;
+	layout->hash = hash;
+	layout->chars = ( qfontlayoutchar_t * )( ( uint8_t * )layout + sizeof( *layout ) );
+	memcpy( layout->chars, src->chars, charsSize );
+	layout->str = ( char * )layout->chars + charsSize;
+	memcpy( layout->str, str, src->length );
+
+	layout->hashNext = layoutHashTable[hash & ( FTLIB_LAYOUT_HASH_SIZE - 1 )];
+	layoutHashTable[hash & ( FTLIB_LAYOUT_HASH_SIZE - 1 )] = layout;
+	FTLIB_LinkLayout( layout );
+	numLayouts++;
+
+	return layout;
+}
+
+/*
+* FTLIB_GetStringLayout
+*
+* Gets the layout of the string until a newline or its end. The layout is only valid
+* until the next call, and until the fonts are freed if it's cached.
+*/
+const qfontlayout_t *FTLIB_GetStringLayout( const char *str, qfontface_t *font, int flags ) {
+	size_t length;
+	unsigned int hash;
+	qfontlayout_t *layout;
+
+	flags &= TEXTDRAWFLAG_NO_COLORS | ( font->hasKerning ? TEXTDRAWFLAG_KERNING : 0 );
+
+	if( !ftlibTextCaches ) {
+		return FTLIB_BuildLayout( str, font, flags );
+	}
+
+	if( !layoutHead.next ) {
+		layoutHead.prev = layoutHead.next = &layoutHead;
+	}
+
+	hash = FTLIB_HashString( str, font, flags, &length );
+	if( length > FTLIB_LAYOUT_MAX_LENGTH ) {
+		return FTLIB_BuildLayout( str, font, flags );
+	}
+
+	for( layout = layoutHashTable[hash & ( FTLIB_LAYOUT_HASH_SIZE - 1 )]; layout; layout = layout->hashNext ) {
+		if( layout->hash == hash && layout->font == font && layout->flags == flags &&
+			layout->length == length && !memcmp( layout->str, str, length ) ) {
+			FTLIB_UnlinkLayout( layout );
+			FTLIB_LinkLayout( layout );
+			layoutHits++;
+			return layout;
+		}
+	}
+
+	layoutMisses++;
+
+	layout = FTLIB_BuildLayout( str, font, flags );
+	if( layout->length != length ) {
+		return layout;
+	}
+
+	return FTLIB_CacheLayout( layout, str, hash );
+}
+
+/*
+* FTLIB_ClearLayoutCache
+*/
+void FTLIB_ClearLayoutCache( void ) {
+	if( layoutHead.next ) {
+		while( layoutHead.next != &layoutHead ) {
+			FTLIB_FreeLayout( layoutHead.next );
+		}
+	}
+
+	if( scratchLayout.chars ) {
+		FTLIB_Free( scratchLayout.chars );
+	}
+	memset( &scratchLayout, 0, sizeof( scratchLayout ) );
+	scratchLayoutSize = 0;
+}
+
+/*
+* FTLIB_TextBenchmark_f
+*
+* Measures the time it takes to lay out typical HUD strings, without and with the caches.
+*/
+void FTLIB_TextBenchmark_f( void ) {
+	static const char * const strings[] = {
+		"100", "200", "^7FPS: ^3125", "^2Alpha ^7vs ^1Beta",
+		"Player ^1fragged ^7Someone", "You have taken the lead",
+		"Press ^3F3 ^7to ready up", "^5Rocket Launcher ^7(12)",
+		"Waiting for players", "Connected to 127.0.0.1:44400",
+	};
+	const int numStrings = sizeof( strings ) / sizeof( strings[0] );
+	int i, j, pass, iterations;
+	qfontface_t *font;
+	uint64_t start, time[2];
+	size_t maxwidth, check[2];
+
+	if( trap_Cmd_Argc() < 3 ) {
+		Com_Printf( "Usage: %s <family> <size> [iterations]\n", trap_Cmd_Argv( 0 ) );
+		return;
+	}
+
+	font = FTLIB_RegisterFont( trap_Cmd_Argv( 1 ), NULL, QFONT_STYLE_NONE, atoi( trap_Cmd_Argv( 2 ) ) );
+	if( !font ) {
+		return;
+	}
+
+	iterations = trap_Cmd_Argc() > 3 ? max( atoi( trap_Cmd_Argv( 3 ) ), 1 ) : 10000;
+	maxwidth = font->size * 8;
+
+	for( pass = 0; pass < 2; pass++ ) {
+		ftlibTextCaches = pass != 0;
+		FTLIB_ClearLayoutCache();
+		FTLIB_FreeKerningCache( font );
+		layoutHits = layoutMisses = 0;
+
+		check[pass] = 0;
+		start = trap_Microseconds();
+		for( i = 0; i < iterations; i++ ) {
+			for( j = 0; j < numStrings; j++ ) {
+				check[pass] += FTLIB_strWidth( strings[j], font, 0, TEXTDRAWFLAG_KERNING );
+				check[pass] += FTLIB_StrlenForWidth( strings[j], font, maxwidth, TEXTDRAWFLAG_KERNING );
+			}
+		}
+		time[pass] = trap_Microseconds() - start;
+	}
+
+	ftlibTextCaches = true;
+
+	Com_Printf( "%i strings, %i iterations\n", numStrings, iterations );
+	Com_Printf( "uncached: %.3f us per string\n", (double)time[0] / ( iterations * numStrings ) );
+	Com_Printf( "cached: %.3f us per string, %u hits, %u misses\n", (double)time[1] / ( iterations * numStrings ),
+				layoutHits, layoutMisses );
+	if( check[0] != check[1] ) {
+		Com_Printf( S_COLOR_YELLOW "Warning: Cached and uncached layouts differ\n" );
+	}
+}
@@ -56,15 +56,31 @@ typedef struct shader_s shader_t;
 struct qglyph_s;
 struct qfontface_s;
 struct qfontfamily_s;
+struct qfontshelf_s;
+struct qfontkerning_s;
 
-typedef struct {
+typedef struct qglyph_s {
 	unsigned short width, height;
 	unsigned short x_advance;
 	short x_offset, y_offset;
 	struct shader_s *shader;
 	float s1, t1, s2, t2;
+
+	// atlas space, glyphs without a shelf are never evicted
+	struct qfontshelf_s *shelf;
+	struct qglyph_s *nextInShelf;
 } qglyph_t;
 
+// a row of glyphs in one of the font images
+typedef struct qfontshelf_s {
+	unsigned int image;
+	unsigned int x, y;              // next free column, top of the shelf
+	unsigned int height;
+	unsigned int lastUsed;          // frame number
+	qglyph_t *glyphs;
+	struct qfontshelf_s *next;
+} qfontshelf_t;
+
 typedef void ( *renderString_f )( struct qfontface_s *qfont, const char *str );
 typedef int ( *getKerning_f )( struct qfontface_s *qfont,  qglyph_t *g1, qglyph_t *g2 );
 
@@ -103,6 +119,14 @@ typedef struct qfontface_s {
 	unsigned int shaderWidth;
 	unsigned int shaderHeight;
 
+	// glyph atlas, rows of glyphs are packed from the top of each image
+	qfontshelf_t *shelves;
+	unsigned int *shaderUsedHeights;
+	unsigned int numEvictions;
+
+	// cached kerning between pairs of glyphs
+	struct qfontkerning_s *kerningCache;
+
 	// glyphs
 	size_t glyphSize;
 	void *glyphs[256]; // 256 dynamically allocated blocks of 256 glyphs, each is a { qglyph_t; userdata } struct.
@@ -116,6 +140,31 @@ typedef struct qfontface_s {
 	struct qfontface_s *next;
 } qfontface_t;
 
+// a character of a laid out string, or a color change if glyph is NULL
+typedef struct {
+	qglyph_t *glyph;
+	wchar_t num;
+	int colorindex;
+	int x;                          // from the start of the string, including kerning
+	int kerning;                    // from the previous character
+	unsigned int offset;            // of the character in the string
+} qfontlayoutchar_t;
+
+// a line of text laid out until a newline or the end of the string
+typedef struct qfontlayout_s {
+	qfontface_t *font;
+	int flags;
+	unsigned int hash;
+	char *str;
+	size_t length;                  // bytes read, including the newline
+	int width;
+	unsigned int numChars;
+	qfontlayoutchar_t *chars;
+
+	struct qfontlayout_s *hashNext;
+	struct qfontlayout_s *prev, *next;
+} qfontlayout_t;
+
 typedef struct qfontfamily_funcs_s {
 	// method which the loader needs to call to load specific font face
 	qfontface_t *( *loadFace )( struct qfontfamily_s *family, unsigned int size );
@@ -144,6 +193,8 @@ typedef struct qfontfamily_s {
 	struct qfontfamily_s *next;
 } qfontfamily_t;
 
+extern unsigned int ftlibFrameNum;
+
 void Com_DPrintf( const char *format, ... );
 
 int FTLIB_API( void );
@@ -163,15 +214,31 @@ void FTLIB_FreeFonts( bool verbose );
 void FTLIB_PrintFontList( void );
 qglyph_t *FTLIB_GetGlyph( qfontface_t *font, wchar_t num );
 const char *FTLIB_FontShaderName( qfontface_t *qfont, unsigned int shaderNum );
+void FTLIB_BeginFrame( void );
+
+// ftlib_atlas.c
+void FTLIB_InitAtlas( void );
+unsigned int FTLIB_AddAtlasImage( qfontface_t *qfont );
+void FTLIB_AllocGlyphRect( qfontface_t *qfont, qglyph_t *glyph, unsigned int width, unsigned int height, unsigned int *x, unsigned int *y );
+void FTLIB_FreeAtlas( qfontface_t *qfont );
+
+// ftlib_layout.c
+int FTLIB_GetKerning( qfontface_t *font, qglyph_t *g1, qglyph_t *g2 );
+void FTLIB_FreeKerningCache( qfontface_t *font );
+void FTLIB_ClearLayoutCache( void );
+const qfontlayout_t *FTLIB_GetStringLayout( const char *str, qfontface_t *font, int flags );
+void FTLIB_TextBenchmark_f( void );
 
 // ftlib_draw.c
 size_t FTLIB_FontSize( qfontface_t *font );
 size_t FTLIB_FontHeight( qfontface_t *font );
+int FTLIB_GrabChar( const char **pstr, wchar_t *wc, int *colorindex, int flags );
 size_t FTLIB_strWidth( const char *str, qfontface_t *font, size_t maxlen, int flags );
 size_t FTLIB_StrlenForWidth( const char *str, qfontface_t *font, size_t maxwidth, int flags );
 int FTLIB_FontUnderline( qfontface_t *font, int *thickness );
 size_t FTLIB_FontAdvance( qfontface_t *font );
 size_t FTLIB_FontXHeight( qfontface_t *font );
+unsigned int FTLIB_FontAtlasGeneration( qfontface_t *font );
 void FTLIB_DrawClampChar( int x, int y, wchar_t num, int xmin, int ymin, int xmax, int ymax, qfontface_t *font, vec4_t color );
 void FTLIB_DrawRawChar( int x, int y, wchar_t num, qfontface_t *font, vec4_t color );
 void FTLIB_DrawClampString( int x, int y, const char *str, int xmin, int ymin, int xmax, int ymax, qfontface_t *font, vec4_t color, int flags );
@@ -38,6 +38,7 @@ bool FTLIB_Init( bool verbose ) {
 	FTLIB_InitSubsystems( verbose );
 
 	trap_Cmd_AddCommand( "fontlist", &FTLIB_PrintFontList );
+	trap_Cmd_AddCommand( "fontbenchmark", &FTLIB_TextBenchmark_f );
 
 	return true;
 }
@@ -51,6 +52,7 @@ void FTLIB_Shutdown( bool verbose ) {
 	FTLIB_FreePool( &ftlibPool );
 
 	trap_Cmd_RemoveCommand( "fontlist" );
+	trap_Cmd_RemoveCommand( "fontbenchmark" );
 }
 
 /*
@@ -23,7 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // ftlib_public.h - font provider subsystem
 
-#define FTLIB_API_VERSION           11
+#define FTLIB_API_VERSION           12
 
 //===============================================================
 
@@ -125,6 +125,7 @@ typedef struct {
 	void ( *TouchFont )( struct qfontface_s *qfont );
 	void ( *TouchAllFonts )( void );
 	void ( *FreeFonts )( bool verbose );
+	void ( *BeginFrame )( void );
 
 	// drawing functions
 	size_t ( *FontSize )( struct qfontface_s *font );
@@ -134,6 +135,7 @@ typedef struct {
 	int ( *FontUnderline )( struct qfontface_s *font, int *thickness );
 	size_t ( *FontAdvance )( struct qfontface_s *font );
 	size_t ( *FontXHeight )( struct qfontface_s *font );
+	unsigned int ( *FontAtlasGeneration )( struct qfontface_s *font );
 	void ( *DrawClampChar )( int x, int y, wchar_t num, int xmin, int ymin, int xmax, int ymax, struct qfontface_s *font, vec4_t color );
 	void ( *DrawRawChar )( int x, int y, wchar_t num, struct qfontface_s *font, vec4_t color );
 	void ( *DrawClampString )( int x, int y, const char *str, int xmin, int ymin, int xmax, int ymax, struct qfontface_s *font, vec4_t color, int flags );
@@ -42,6 +42,7 @@ QF_DLL_EXPORT ftlib_export_t *GetFTLibAPI( ftlib_import_t *import ) {
 	globals.TouchFont = &FTLIB_TouchFont;
 	globals.TouchAllFonts = &FTLIB_TouchAllFonts;
 	globals.FreeFonts = &FTLIB_FreeFonts;
+	globals.BeginFrame = &FTLIB_BeginFrame;
 
 	globals.FontSize = &FTLIB_FontSize;
 	globals.FontHeight = &FTLIB_FontHeight;
@@ -50,6 +51,7 @@ QF_DLL_EXPORT ftlib_export_t *GetFTLibAPI( ftlib_import_t *import ) {
 	globals.FontUnderline = &FTLIB_FontUnderline;
 	globals.FontAdvance = &FTLIB_FontAdvance;
 	globals.FontXHeight = &FTLIB_FontXHeight;
+	globals.FontAtlasGeneration = &FTLIB_FontAtlasGeneration;
 	globals.DrawClampChar = &FTLIB_DrawClampChar;
 	globals.DrawRawChar = &FTLIB_DrawRawChar;
 	globals.DrawClampString = &FTLIB_DrawClampString;
@@ -27,9 +27,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 //
 //==========================================
 
-static short int alist[MAX_NODES];  //list contains all studied nodes, Open and Closed together
-static int alist_numNodes;
-
 enum
 {
 	NOLIST,
@@ -47,18 +44,26 @@ typedef struct
 
 } astarnode_t;
 
-astarnode_t astarnodes[MAX_NODES];
+// all the search state lives here, so searches running on different
+// threads don't step on each other
+typedef struct astarcontext_s
+{
+	short int alist[MAX_NODES];  //list contains all studied nodes, Open and Closed together
+	int alist_numNodes;
 
-struct astarpath_s *Apath;
-//==========================================
-//
-//
-//==========================================
-static short int originNode;
-static short int goalNode;
-static short int currentNode;
+	astarnode_t astarnodes[MAX_NODES];
+
+	struct astarpath_s *Apath;
+
+	short int originNode;
+	short int goalNode;
+	short int currentNode;
+
+	int ValidLinksMask;
+} astarcontext_t;
+
+static astarcontext_t astar;
 
-static int ValidLinksMask;
 #define DEFAULT_MOVETYPES_MASK ( LINK_MOVE|LINK_STAIRS|LINK_FALL|LINK_WATER|LINK_WATERJUMP|LINK_JUMPPAD|LINK_PLATFORM|LINK_TELEPORT );
 //==========================================
 //
@@ -66,27 +71,37 @@ static int ValidLinksMask;
 //
 //==========================================
 
-int AStar_nodeIsInClosed( int node )
+static int AStar_NodeIsInClosed( astarcontext_t *ctx, int node )
 {
-	if( astarnodes[node].list == CLOSEDLIST )
+	if( ctx->astarnodes[node].list == CLOSEDLIST )
 		return 1;
 
 	return 0;
 }
 
-int AStar_nodeIsInOpen( int node )
+static int AStar_NodeIsInOpen( astarcontext_t *ctx, int node )
 {
-	if( astarnodes[node].list == OPENLIST )
+	if( ctx->astarnodes[node].list == OPENLIST )
 		return 1;
 
 	return 0;
 }
 
-static void AStar_InitLists( void )
+int AStar_nodeIsInClosed( int node )
+{
+	return AStar_NodeIsInClosed( &astar, node );
+}
+
+int AStar_nodeIsInOpen( int node )
+{
+	return AStar_NodeIsInOpen( &astar, node );
+}
+
+static void AStar_InitLists( astarcontext_t *ctx )
 {
-	memset( astarnodes, 0, sizeof( astarnodes ) ); //jabot092
-	if( Apath ) Apath->numNodes = 0;
-	alist_numNodes = 0;
+	memset( ctx->astarnodes, 0, sizeof( ctx->astarnodes ) ); //jabot092
+	if( ctx->Apath ) ctx->Apath->numNodes = 0;
+	ctx->alist_numNodes = 0;
 }
 
 static int AStar_PLinkDistance( int n1, int n2 )
@@ -108,7 +123,7 @@ static int AStar_PLinkDistance( int n1, int n2 )
 	return -1;
 }
 
-static int  Astar_HDist_ManhatanGuess( int node )
+static int  Astar_HDist_ManhatanGuess( astarcontext_t *ctx, int node )
 {
 	vec3_t DistVec;
 	int i;
@@ -124,34 +139,35 @@ static int  Astar_HDist_ManhatanGuess( int node )
 
 	for( i = 0; i < 3; i++ )
 	{
-		DistVec[i] = fabs( nodes[goalNode].origin[i] - nodes[node].origin[i] );
+		DistVec[i] = fabs( nodes[ctx->goalNode].origin[i] - nodes[node].origin[i] );
 	}
 
 	HDist = (int)( DistVec[0] + DistVec[1] + DistVec[2] );
 	return HDist;
 }
 
-static void AStar_PutInClosed( int node )
+static void AStar_PutInClosed( astarcontext_t *ctx, int node )
 {
-	if( !astarnodes[node].list )
+	if( !ctx->astarnodes[node].list )
 	{
-		alist[alist_numNodes] = node;
-		alist_numNodes++;
+		ctx->alist[ctx->alist_numNodes] = node;
+		ctx->alist_numNodes++;
 	}
 
-	astarnodes[node].list = CLOSEDLIST;
+	ctx->astarnodes[node].list = CLOSEDLIST;
 }
 
-static void AStar_PutAdjacentsInOpen( int node )
+static void AStar_PutAdjacentsInOpen( astarcontext_t *ctx, int node )
 {
 	int i;
+	astarnode_t *astarnodes = ctx->astarnodes;
 
 	for( i = 0; i < pLinks[node].numLinks; i++ )
 	{
 		int addnode;
 
 		//ignore invalid links
-		if( !( ValidLinksMask & pLinks[node].moveType[i] ) )
+		if( !( ctx->ValidLinksMask & pLinks[node].moveType[i] ) )
 			continue;
 
 		addnode = pLinks[node].nodes[i];
@@ -161,11 +177,11 @@ static void AStar_PutAdjacentsInOpen( int node )
 			continue;
 
 		//ignore if it's already in closed list
-		if( AStar_nodeIsInClosed( addnode ) )
+		if( AStar_NodeIsInClosed( ctx, addnode ) )
 			continue;
 
 		//if it's already inside open list
-		if( AStar_nodeIsInOpen( addnode ) )
+		if( AStar_NodeIsInOpen( ctx, addnode ) )
 		{
 			int plinkDist;
 
@@ -200,27 +216,28 @@ static void AStar_PutAdjacentsInOpen( int node )
 			//put in global list
 			if( !astarnodes[addnode].list )
 			{
-				alist[alist_numNodes] = addnode;
-				alist_numNodes++;
+				ctx->alist[ctx->alist_numNodes] = addnode;
+				ctx->alist_numNodes++;
 			}
 
 			astarnodes[addnode].parent = node;
 			astarnodes[addnode].G = astarnodes[node].G + plinkDist;
-			astarnodes[addnode].H = Astar_HDist_ManhatanGuess( addnode );
+			astarnodes[addnode].H = Astar_HDist_ManhatanGuess( ctx, addnode );
 			astarnodes[addnode].list = OPENLIST;
 		}
 	}
 }
 
-static int AStar_FindInOpen_BestF( void )
+static int AStar_FindInOpen_BestF( astarcontext_t *ctx )
 {
 	int i;
 	int bestF = -1;
 	int best = -1;
+	astarnode_t *astarnodes = ctx->astarnodes;
 
-	for( i = 0; i < alist_numNodes; i++ )
+	for( i = 0; i < ctx->alist_numNodes; i++ )
 	{
-		int node = alist[i];
+		int node = ctx->alist[i];
 
 		if( astarnodes[node].list != OPENLIST )
 			continue;
@@ -235,74 +252,97 @@ static int AStar_FindInOpen_BestF( void )
 	return best;
 }
 
-static void AStar_ListsToPath( void )
+static void AStar_ListsToPath( astarcontext_t *ctx )
 {
 	int count = 0;
-	int cur = goalNode;
+	int cur = ctx->goalNode;
 	short int *pnode;
 
-	Apath->numNodes = 0;
-	pnode = Apath->nodes;
-	while( cur != originNode )
+	ctx->Apath->numNodes = 0;
+	pnode = ctx->Apath->nodes;
+	while( cur != ctx->originNode )
 	{
 		*pnode = cur;
 		pnode++;
-		cur = astarnodes[cur].parent;
+		cur = ctx->astarnodes[cur].parent;
 		count++;
 	}
 
-	Apath->totalDistance = astarnodes[goalNode].G;
-	Apath->numNodes = count-1;
+	ctx->Apath->totalDistance = ctx->astarnodes[ctx->goalNode].G;
+	ctx->Apath->numNodes = count-1;
 }
 
-static int AStar_FillLists( void )
+static int AStar_FillLists( astarcontext_t *ctx )
 {
 	//put current node inside closed list
-	AStar_PutInClosed( currentNode );
+	AStar_PutInClosed( ctx, ctx->currentNode );
 
 	//put adjacent nodes inside open list
-	AStar_PutAdjacentsInOpen( currentNode );
+	AStar_PutAdjacentsInOpen( ctx, ctx->currentNode );
 
 	//find best adjacent and make it our current
-	currentNode = AStar_FindInOpen_BestF();
+	ctx->currentNode = AStar_FindInOpen_BestF( ctx );
 
-	return ( currentNode != -1 ); //if -1 path is blocked
+	return ( ctx->currentNode != -1 ); //if -1 path is blocked
 }
 
-int AStar_ResolvePath( int n1, int n2, int movetypes )
+static int AStar_ResolvePathInContext( astarcontext_t *ctx, int n1, int n2, int movetypes )
 {
-	ValidLinksMask = movetypes;
-	if( !ValidLinksMask )
-		ValidLinksMask = DEFAULT_MOVETYPES_MASK;
+	ctx->ValidLinksMask = movetypes;
+	if( !ctx->ValidLinksMask )
+		ctx->ValidLinksMask = DEFAULT_MOVETYPES_MASK;
 
-	AStar_InitLists();
+	AStar_InitLists( ctx );
 
-	originNode = n1;
-	goalNode = n2;
-	currentNode = originNode;
+	ctx->originNode = n1;
+	ctx->goalNode = n2;
+	ctx->currentNode = ctx->originNode;
 
-	while( !AStar_nodeIsInOpen( goalNode ) )
+	while( !AStar_NodeIsInOpen( ctx, ctx->goalNode ) )
 	{
-		if( !AStar_FillLists() )
+		if( !AStar_FillLists( ctx ) )
 			return 0; //failed
 	}
 
-	AStar_ListsToPath();
+	AStar_ListsToPath( ctx );
 
 	return 1;
 }
 
-int AStar_GetPath( int origin, int goal, int movetypes, struct astarpath_s *path )
+int AStar_ResolvePath( int n1, int n2, int movetypes )
+{
+	return AStar_ResolvePathInContext( &astar, n1, n2, movetypes );
+}
+
+//==========================================
+// AStar_AllocContext
+// private search state for callers running off the main thread,
+// freed with the level
+//==========================================
+struct astarcontext_s *AStar_AllocContext( void )
 {
-	Apath = path;
+	return ( astarcontext_t * )G_LevelMalloc( sizeof( astarcontext_t ) );
+}
+
+int AStar_GetPathInContext( struct astarcontext_s *ctx, int origin, int goal, int movetypes, struct astarpath_s *path )
+{
+	if( !ctx )
+		ctx = &astar;
+
+	ctx->Apath = path;
 
 	if( goal < 0 )
 		return 0;
 
-	if( !AStar_ResolvePath( origin, goal, movetypes ) )
+	if( !AStar_ResolvePathInContext( ctx, origin, goal, movetypes ) )
 		return 0;
 
 	path->originNode = origin;
 	path->goalNode = goal;
 	return 1;
 }
+
+int AStar_GetPath( int origin, int goal, int movetypes, struct astarpath_s *path )
+{
+	return AStar_GetPathInContext( &astar, origin, goal, movetypes, path );
+}
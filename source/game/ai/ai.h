@@ -49,6 +49,9 @@ void		AI_AddNavigatableEntity( edict_t *ent, int node );
 void		AI_RemoveGoalEntity( edict_t *ent );
 void		AI_InitEntitiesData( void );
 void        AI_Think( edict_t *self );
+void        AI_ThinkBots( void );
+bool        AI_UsesThinkPhase( const edict_t *ent );
+void        AI_ApplyThink( edict_t *self );
 void        G_FreeAI( edict_t *ent );
 void        G_SpawnAI( edict_t *ent );
 ai_type		AI_GetType( const ai_handle_t *ai );
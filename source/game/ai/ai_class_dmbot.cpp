@@ -1645,7 +1645,7 @@ static void BOT_DMclass_GhostingFrame( edict_t *self )
 	if( level.time > self->deathTimeStamp + 3000 )
 		ucmd.buttons = BUTTON_ATTACK;
 
-	ClientThink( self, &ucmd, 0 );
+	AI_QueueUsercmd( self, &ucmd );
 }
 
 
@@ -1714,10 +1714,22 @@ static void BOT_DMclass_RunFrame( edict_t *self )
 	ucmd.msec = game.frametime;
 	ucmd.serverTimeStamp = game.serverTime;
 
-	ClientThink( self, &ucmd, 0 );
+	AI_QueueUsercmd( self, &ucmd );
 	self->nextThink = level.time + 1;
+}
+
+//==========================================
+// BOT_DMclass_ApplyFrame
+// Run the usercmd queued by the think phase
+//==========================================
+static void BOT_DMclass_ApplyFrame( edict_t *self )
+{
+	bool ghosting = G_ISGHOSTING( self );
+
+	ClientThink( self, &self->ai->ucmd, 0 );
 
-	BOT_DMclass_VSAYmessages( self );
+	if( !ghosting )
+		BOT_DMclass_VSAYmessages( self );
 }
 
 
@@ -1730,7 +1742,7 @@ void BOT_DMclass_InitPersistant( edict_t *self )
 	gsitem_t *item;
 	int i, w;
 
-	self->classname = "dmbot";
+	G_SetClassname( self, "dmbot" );
 
 	if( self->r.client->netname[0] )
 		self->ai->pers.netname = self->r.client->netname;
@@ -1739,6 +1751,7 @@ void BOT_DMclass_InitPersistant( edict_t *self )
 
 	//set 'class' functions
 	self->ai->pers.RunFrame = BOT_DMclass_RunFrame;
+	self->ai->pers.ApplyFrame = BOT_DMclass_ApplyFrame;
 	self->ai->pers.UpdateStatus = BOT_DMclass_UpdateStatus;
 	self->ai->pers.blockedTimeout = BOT_DMClass_BlockedTimeout;
 
@@ -88,7 +88,9 @@ bool AI_VisibleOrigins( vec3_t spot1, vec3_t spot2 )
 int AI_findNodeInRadius( int from, vec3_t org, float rad, bool ignoreHeight )
 {
 	vec3_t eorg;
-	int j;
+	int i, j, node, numCandidates;
+	int found = -1;
+	int candidates[MAX_NODES];
 
 	if( from < 0 )
 		return -1;
@@ -96,13 +98,18 @@ int AI_findNodeInRadius( int from, vec3_t org, float rad, bool ignoreHeight )
 		return -1;
 	else if( !nav.num_nodes )
 		return -1;
-	else
-		from++;
 
-	for(; from < nav.num_nodes; from++ )
+	// the grid is not ordered, so look for the lowest node index past 'from'
+	numCandidates = AI_NodeGridGather( org, rad, candidates );
+
+	for( i = 0; i < numCandidates; i++ )
 	{
+		node = candidates[i];
+		if( node <= from || ( found != -1 && node > found ) )
+			continue;
+
 		for( j = 0; j < 3; j++ )
-			eorg[j] = org[j] - nodes[from].origin[j];
+			eorg[j] = org[j] - nodes[node].origin[j];
 
 		if( ignoreHeight )
 			eorg[2] = 0;
@@ -110,10 +117,10 @@ int AI_findNodeInRadius( int from, vec3_t org, float rad, bool ignoreHeight )
 		if( VectorLengthFast( eorg ) > rad )
 			continue;
 
-		return from;
+		found = node;
 	}
 
-	return -1;
+	return found;
 }
 
 
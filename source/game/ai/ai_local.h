@@ -75,6 +75,8 @@ extern cvar_t *sv_botpersonality;
 #define	NAV_FILE_VERSION 10
 #define NAV_FILE_EXTENSION "nav"
 #define NAV_FILE_FOLDER "navigation"
+#define NAV_LINKS_FILE_VERSION 1
+#define NAV_LINKS_FILE_EXTENSION "lnk"  // server links cache, stored next to the nav file
 
 #define	AI_STEPSIZE	STEPSIZE    // 18
 #define AI_JUMPABLE_HEIGHT		50
@@ -159,6 +161,25 @@ typedef struct nav_path_s
 
 } nav_path_t;
 
+// uniform grid over node origins (XY plane), hashed into a fixed bucket table
+#define NODEGRID_CELL_SIZE NODE_DENSITY
+#define NODEGRID_HASH_SIZE 1024
+#define NODEGRID_MAX_QUERY_CELLS 256 // bigger queries fall back to a linear scan
+
+typedef struct
+{
+	int numNodes;                       // nodes [0, numNodes) are linked into the grid
+	int buckets[NODEGRID_HASH_SIZE];    // first node + 1 of each bucket, 0 when empty
+	int next[MAX_NODES];                // next node + 1 in the same bucket
+	int cell[MAX_NODES][2];
+} nav_nodegrid_t;
+
+typedef struct
+{
+	int node;
+	float dist;
+} nav_nodedist_t;
+
 extern nav_plink_t pLinks[MAX_NODES];      // pLinks array
 extern nav_node_t nodes[MAX_NODES];        // nodes array
 
@@ -178,6 +199,8 @@ typedef struct
 
 	int num_navigableEnts;
 	nav_ents_t navigableEnts[MAX_GOALENTS]; // plats, etc
+
+	nav_nodegrid_t grid;
 } ai_navigation_t;
 
 #define FOREACH_GOALENT(goalEnt) for( goalEnt = nav.goalEntsHeadnode.prev; goalEnt != &nav.goalEntsHeadnode; goalEnt = goalEnt->prev )
@@ -250,6 +273,7 @@ typedef struct
 	//class based functions
 	void ( *UpdateStatus )( edict_t *ent );
 	void ( *RunFrame )( edict_t *ent );
+	void ( *ApplyFrame )( edict_t *ent );
 	void ( *blockedTimeout )( edict_t *ent );
 
 	ai_character cha;
@@ -303,6 +327,15 @@ typedef struct ai_handle_s
 	float speed_yaw, speed_pitch;
 	bool is_bunnyhop;
 
+	// usercmd produced by the think phase, executed in the client phase
+	usercmd_t ucmd;
+	bool ucmdPending;
+
+	// long range goal being weighed by the think phase
+	struct nav_ents_s *lrGoalEnt;
+	float lrGoalWeight;
+	int lrGoalSeed;
+
 	int asFactored, asRefCount;
 
 } ai_handle_t;
@@ -323,6 +356,7 @@ void AI_ClearGoal( edict_t *self );
 void	    AI_ResetNavigation( edict_t *ent );
 void	    AI_CategorizePosition( edict_t *ent );
 void AI_UpdateStatus( edict_t *self );
+void AI_QueueUsercmd( edict_t *self, usercmd_t *ucmd );
 
 
 // ai_items.c
@@ -343,6 +377,7 @@ bool    AI_IsStep( edict_t *ent );
 // ai_navigation.c
 //----------------------------------------------------------
 int	    AI_FindCost( int from, int to, int movetypes );
+int	    AI_FindCostInContext( struct astarcontext_s *astar, int from, int to, int movetypes );
 int	    AI_FindClosestReachableNode( vec3_t origin, edict_t *passent, int range, unsigned int flagsmask );
 int	    AI_FindClosestNode( vec3_t origin, float mindist, int range, unsigned int flagsmask );
 void	    AI_SetGoal( edict_t *self, int goal_node );
@@ -361,6 +396,12 @@ int	    AI_FlagsForNode( vec3_t origin, edict_t *passent );
 bool    AI_LoadPLKFile( char *mapname );
 void AI_DeleteNode( int node );
 
+// ai_nodegrid.c
+//----------------------------------------------------------
+void AI_InvalidateNodeGrid( void );
+int AI_NodeGridGather( vec3_t origin, float radius, int *list );
+int AI_SortedNodesInRange( vec3_t origin, float mindist, float range, unsigned int flagsmask, nav_nodedist_t *list );
+
 
 // ai_tools.c
 //----------------------------------------------------------
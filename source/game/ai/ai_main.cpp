@@ -23,6 +23,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 cvar_t *sv_botpersonality;
 
+// A* states for weighing long range goals in parallel, one per batch of bots
+#define AI_MAX_THINK_CONTEXTS	16
+static struct astarcontext_s *ai_thinkContexts[AI_MAX_THINK_CONTEXTS];
+
 ai_weapon_t AIWeapons[WEAP_TOTAL];
 const size_t ai_handle_size = sizeof( ai_handle_t );
 
@@ -44,6 +48,9 @@ void AI_InitLevel( void )
 
 	nav.debugMode = false;
 
+	// the A* states of the think phase lived in the previous level's pool
+	memset( ai_thinkContexts, 0, sizeof( ai_thinkContexts ) );
+
 	AI_InitNavigationData( false );
 
 	// count bots
@@ -295,37 +302,58 @@ void AI_ResetNavigation( edict_t *self )
 	AI_ClearGoal( self );
 }
 
+#define WEIGHT_MAXDISTANCE_FACTOR 20000.0f
+#define COST_INFLUENCE	0.5f
+
 //==========================================
-// AI_PickLongRangeGoal
-//
-// Evaluate the best long range goal and send the bot on
-// its way. This is a good time waster, so use it sparingly.
-// Do not call it for every think cycle.
-//
-// jal: I don't think there is any problem by calling it,
-// now that we have stored the costs at the nav.costs table (I don't do it anyway)
+// AI_UpdateGoalEntNodes
+// refresh the nodes of goal entities which move around.
+// Needs traces, so it's run once before the goals are weighted.
 //==========================================
-void AI_PickLongRangeGoal( edict_t *self )
+static void AI_UpdateGoalEntNodes( void )
+{
+	nav_ents_t *goalEnt;
+
+	FOREACH_GOALENT( goalEnt )
+	{
+		if( !goalEnt->ent )
+			continue;
+
+		if( !goalEnt->ent->r.inuse )
+		{
+			goalEnt->node = NODE_INVALID;
+			continue;
+		}
+
+		if( goalEnt->ent->r.client )
+		{
+			if( G_ISGHOSTING( goalEnt->ent ) || ( goalEnt->ent->flags & FL_NOTARGET ) || ( ( goalEnt->ent->flags & FL_BUSY ) && ( level.gametype.forceTeamHumans == level.gametype.forceTeamBots ) ) )
+				goalEnt->node = NODE_INVALID;
+			else
+				goalEnt->node = AI_FindClosestReachableNode( goalEnt->ent->s.origin, goalEnt->ent, NODE_DENSITY, NODE_ALL );
+		}
+	}
+}
+
+//==========================================
+// AI_BeginLongRangeGoal
+// clear the goal and find the node the bot is at.
+// Returns true if the goals have to be weighted.
+//==========================================
+static bool AI_BeginLongRangeGoal( edict_t *self )
 {
-#define WEIGHT_MAXDISTANCE_FACTOR 20000.0f
-#define COST_INFLUENCE	0.5f
-	int i;
-	float weight, bestWeight = 0.0;
 	int current_node;
-	float cost;
-	float dist;
-	nav_ents_t *goalEnt, *bestGoalEnt = NULL;
 
 	AI_ClearGoal( self );
 
 	if( G_ISGHOSTING( self ) )
-		return;
+		return false;
 
 	if( self->ai->longRangeGoalTimeout > level.time )
-		return;
+		return false;
 
 	if( !self->r.client->ps.pmove.stats[PM_STAT_MAXSPEED] ) {
-		return;
+		return false;
 	}
 
 	self->ai->longRangeGoalTimeout = level.time + AI_LONG_RANGE_GOAL_DELAY + brandom( 0, 1000 );
@@ -340,31 +368,35 @@ void AI_PickLongRangeGoal( edict_t *self )
 			G_PrintChasersf( self, "%s: LRGOAL: Closest node not found. Tries:%i\n", self->ai->pers.netname, self->ai->nearest_node_tries );
 
 		self->ai->nearest_node_tries++; // extend search radius with each try
-		return;
+		return false;
 	}
 
 	self->ai->nearest_node_tries = 0;
 
+	self->ai->lrGoalSeed = rand();
+	return true;
+}
+
+//==========================================
+// AI_WeighLongRangeGoals
+// Pick the best goal entity for the bot from the path costs.
+// Doesn't trace nor touch anything but the bot's ai handle,
+// so it can run for several bots at once.
+//==========================================
+static void AI_WeighLongRangeGoals( edict_t *self, struct astarcontext_s *astar )
+{
+	int i;
+	float weight, bestWeight = 0.0;
+	float cost;
+	float dist;
+	nav_ents_t *goalEnt, *bestGoalEnt = NULL;
+
 	// Run the list of potential goal entities
 	FOREACH_GOALENT( goalEnt )
 	{
 		i = goalEnt->id;
-		if( !goalEnt->ent )
-			continue;
-
-		if( !goalEnt->ent->r.inuse )
-		{
-			goalEnt->node = NODE_INVALID;
+		if( !goalEnt->ent || !goalEnt->ent->r.inuse )
 			continue;
-		}
-
-		if( goalEnt->ent->r.client )
-		{
-			if( G_ISGHOSTING( goalEnt->ent ) || ( goalEnt->ent->flags & FL_NOTARGET ) || ( ( goalEnt->ent->flags & FL_BUSY ) && ( level.gametype.forceTeamHumans == level.gametype.forceTeamBots ) ) )
-				goalEnt->node = NODE_INVALID;
-			else
-				goalEnt->node = AI_FindClosestReachableNode( goalEnt->ent->s.origin, goalEnt->ent, NODE_DENSITY, NODE_ALL );
-		}
 
 		if( goalEnt->ent->item )
 		{
@@ -385,11 +417,11 @@ void AI_PickLongRangeGoal( edict_t *self )
 		if( dist > WEIGHT_MAXDISTANCE_FACTOR * weight/* || dist < AI_GOAL_SR_RADIUS*/ )
 			continue;
 
-		cost = AI_FindCost( current_node, goalEnt->node, self->ai->status.moveTypesMask );
+		cost = AI_FindCostInContext( astar, self->ai->current_node, goalEnt->node, self->ai->status.moveTypesMask );
 		if( cost == NODE_INVALID )
 			continue;
 
-		cost -= brandom( 0, 2000 ); // allow random variations
+		cost -= Q_brandom( &self->ai->lrGoalSeed, 0, 2000 ); // allow random variations
 		clamp_low( cost, 1 );
 		weight = ( 1000 * weight ) / ( cost * COST_INFLUENCE ); // Check against cost of getting there
 
@@ -400,22 +432,56 @@ void AI_PickLongRangeGoal( edict_t *self )
 		}
 	}
 
+	self->ai->lrGoalEnt = bestGoalEnt;
+	self->ai->lrGoalWeight = bestWeight;
+}
+
+//==========================================
+// AI_FinishLongRangeGoal
+// send the bot on its way to the goal picked by AI_WeighLongRangeGoals
+//==========================================
+static void AI_FinishLongRangeGoal( edict_t *self )
+{
+	nav_ents_t *bestGoalEnt = self->ai->lrGoalEnt;
+
+	self->ai->lrGoalEnt = NULL;
+
 	if( bestGoalEnt )
 	{
 		self->ai->goalEnt = bestGoalEnt;
 		AI_SetGoal( self, bestGoalEnt->node );
 
 		if( self->ai->goalEnt != NULL && nav.debugMode && bot_showlrgoal->integer )
-			G_PrintChasersf( self, "%s: selected a %s at node %d for LR goal. (weight %f)\n", self->ai->pers.netname, self->ai->goalEnt->ent->classname, self->ai->goalEnt->node, bestWeight );
+			G_PrintChasersf( self, "%s: selected a %s at node %d for LR goal. (weight %f)\n", self->ai->pers.netname, self->ai->goalEnt->ent->classname, self->ai->goalEnt->node, self->ai->lrGoalWeight );
 
 		return;
 	}
 
 	if( nav.debugMode && bot_showlrgoal->integer )
 		G_PrintChasersf( self, "%s: did not find a LR goal.\n", self->ai->pers.netname );
+}
 
 #undef WEIGHT_MAXDISTANCE_FACTOR
 #undef COST_INFLUENCE
+
+//==========================================
+// AI_PickLongRangeGoal
+//
+// Evaluate the best long range goal and send the bot on
+// its way. This is a good time waster, so use it sparingly.
+// Do not call it for every think cycle.
+//
+// jal: I don't think there is any problem by calling it,
+// now that we have stored the costs at the nav.costs table (I don't do it anyway)
+//==========================================
+void AI_PickLongRangeGoal( edict_t *self )
+{
+	if( !AI_BeginLongRangeGoal( self ) )
+		return;
+
+	AI_UpdateGoalEntNodes();
+	AI_WeighLongRangeGoals( self, NULL );
+	AI_FinishLongRangeGoal( self );
 }
 
 //==========================================
@@ -563,18 +629,29 @@ void AI_UpdateStatus( edict_t *self )
 }
 
 //==========================================
-// AI_Think
-// think funtion for AIs
+// AI_QueueUsercmd
+// store the usercmd produced by the think phase until the client phase runs it
 //==========================================
-void AI_Think( edict_t *self )
+void AI_QueueUsercmd( edict_t *self, usercmd_t *ucmd )
+{
+	self->ai->ucmd = *ucmd;
+	self->ai->ucmdPending = true;
+}
+
+//==========================================
+// AI_ThinkBegin
+// first half of the think, up to the long range goal.
+// Returns false if the bot is done thinking for this frame.
+//==========================================
+static bool AI_ThinkBegin( edict_t *self )
 {
 	if( !self->ai || self->ai->type == AI_INACTIVE )
-		return;
+		return false;
 
 	if( level.spawnedTimeStamp + 5000 > game.realtime || !level.canSpawnEntities )
 	{
 		self->nextThink = level.time + game.snapFrameTime;
-		return;
+		return false;
 	}
 
 	// check for being blocked
@@ -589,7 +666,7 @@ void AI_Think( edict_t *self )
 		if( self->ai->blocked_timeout < level.time )
 		{
 			self->ai->pers.blockedTimeout( self );
-			return;
+			return false;
 		}
 	}
 
@@ -600,9 +677,15 @@ void AI_Think( edict_t *self )
 	if( AI_NodeHasTimedOut( self ) )
 		AI_ClearGoal( self );
 
-	if( self->ai->goal_node == NODE_INVALID )
-		AI_PickLongRangeGoal( self );
+	return true;
+}
 
+//==========================================
+// AI_ThinkEnd
+// second half of the think, once the long range goal is set
+//==========================================
+static void AI_ThinkEnd( edict_t *self )
+{
 	//if( self == level.think_client_entity )
 	AI_PickShortRangeGoal( self );
 
@@ -629,3 +712,124 @@ void AI_Think( edict_t *self )
 	}
 }
 
+//==========================================
+// AI_Think
+// think funtion for AIs
+//==========================================
+void AI_Think( edict_t *self )
+{
+	if( !AI_ThinkBegin( self ) )
+		return;
+
+	if( self->ai->goal_node == NODE_INVALID )
+		AI_PickLongRangeGoal( self );
+
+	AI_ThinkEnd( self );
+}
+
+//==========================================
+// AI_UsesThinkPhase
+// bots thinking in AI_ThinkBots rather than from their own think function
+//==========================================
+bool AI_UsesThinkPhase( const edict_t *ent )
+{
+	return ( ent->r.svflags & SVF_FAKECLIENT ) && !ent->think && AI_GetType( ent->ai ) == AI_ISBOT;
+}
+
+typedef struct
+{
+	edict_t **bots;
+	int numBots;
+	int batchSize;
+} ai_weighjob_t;
+
+//==========================================
+// AI_WeighLongRangeGoalsJob
+// each batch of bots is weighed with its own A* state
+//==========================================
+static void AI_WeighLongRangeGoalsJob( unsigned first, unsigned items, void *arg )
+{
+	unsigned batch;
+	int i, end;
+	ai_weighjob_t *job = ( ai_weighjob_t * )arg;
+
+	for( batch = first; batch < first + items; batch++ )
+	{
+		end = ( batch + 1 ) * job->batchSize;
+		if( end > job->numBots )
+			end = job->numBots;
+		for( i = batch * job->batchSize; i < end; i++ )
+			AI_WeighLongRangeGoals( job->bots[i], ai_thinkContexts[batch] );
+	}
+}
+
+//==========================================
+// AI_ThinkBots
+// Think phase: perception and planning for all bots, in a fixed order,
+// before any client runs its usercmds this frame. The produced usercmds
+// are executed by AI_ApplyThink from G_ClientThink.
+// Tracing isn't thread safe, so only the path costs of the long range
+// goals are weighed in parallel, everything else runs serially.
+//==========================================
+void AI_ThinkBots( void )
+{
+	int i, numBots, numGoalBots, numBatches;
+	edict_t *ent;
+	edict_t *bots[MAX_CLIENTS], *goalBots[MAX_CLIENTS];
+	ai_weighjob_t job;
+
+	numBots = numGoalBots = 0;
+	for( ent = game.edicts + 1; PLAYERNUM( ent ) < gs.maxclients; ent++ )
+	{
+		if( !ent->r.inuse || !G_ClientCanThink( ent ) || !AI_UsesThinkPhase( ent ) )
+			continue;
+		if( !AI_ThinkBegin( ent ) )
+			continue;
+
+		bots[numBots++] = ent;
+		if( ent->ai->goal_node == NODE_INVALID && AI_BeginLongRangeGoal( ent ) )
+			goalBots[numGoalBots++] = ent;
+	}
+
+	if( numGoalBots )
+	{
+		AI_UpdateGoalEntNodes();
+
+		numBatches = trap_Jobs_NumWorkers() + 1;
+		if( numBatches > AI_MAX_THINK_CONTEXTS )
+			numBatches = AI_MAX_THINK_CONTEXTS;
+		if( numBatches > numGoalBots )
+			numBatches = numGoalBots;
+		job.bots = goalBots;
+		job.numBots = numGoalBots;
+		job.batchSize = ( numGoalBots + numBatches - 1 ) / numBatches;
+		numBatches = ( numGoalBots + job.batchSize - 1 ) / job.batchSize;
+
+		for( i = 0; i < numBatches; i++ )
+		{
+			if( !ai_thinkContexts[i] )
+				ai_thinkContexts[i] = AStar_AllocContext();
+		}
+
+		trap_Jobs_ParallelFor( AI_WeighLongRangeGoalsJob, &job, numBatches, 1 );
+
+		for( i = 0; i < numGoalBots; i++ )
+			AI_FinishLongRangeGoal( goalBots[i] );
+	}
+
+	for( i = 0; i < numBots; i++ )
+		AI_ThinkEnd( bots[i] );
+}
+
+//==========================================
+// AI_ApplyThink
+// Apply phase: run the usercmd queued by the think phase, if any
+//==========================================
+void AI_ApplyThink( edict_t *self )
+{
+	if( !self->ai || !self->ai->ucmdPending )
+		return;
+
+	self->ai->ucmdPending = false;
+	self->ai->pers.ApplyFrame( self );
+}
@@ -29,23 +29,34 @@ in NO WAY supported by Steve Yeager.
 ai_navigation_t	nav;
 
 int AI_FindCost( int from, int to, int movetypes )
+{
+	return AI_FindCostInContext( NULL, from, to, movetypes );
+}
+
+/*
+* AI_FindCostInContext
+* Same as AI_FindCost, but searches with the given A* state so it can be used off the main thread
+*/
+int AI_FindCostInContext( struct astarcontext_s *astar, int from, int to, int movetypes )
 {
 	astarpath_t path;
 
-	if( !AStar_GetPath( from, to, movetypes, &path ) )
+	if( !AStar_GetPathInContext( astar, from, to, movetypes, &path ) )
 		return -1;
 
 	return path.totalDistance;
 }
 
+/*
+* AI_FindClosestReachableNode
+* Candidates are tested nearest first, so we can stop tracing at the first visible one
+*/
 int AI_FindClosestReachableNode( vec3_t origin, edict_t *passent, int range, unsigned int flagsmask )
 {
-	int i;
-	float closest;
-	float dist;
-	int node = -1;
+	int i, numCandidates;
 	trace_t	tr;
 	vec3_t maxs, mins;
+	nav_nodedist_t candidates[MAX_NODES];
 
 	VectorSet( mins, -8, -8, -8 );
 	VectorSet( maxs, 8, 8, 8 );
@@ -57,53 +68,29 @@ int AI_FindClosestReachableNode( vec3_t origin, edict_t *passent, int range, uns
 		VectorCopy( vec3_origin, mins );
 	}
 
-	closest = range;
+	numCandidates = AI_SortedNodesInRange( origin, -1, range, flagsmask, candidates );
 
-	for( i = 0; i < nav.num_nodes; i++ )
+	for( i = 0; i < numCandidates; i++ )
 	{
-		if( flagsmask == NODE_ALL || nodes[i].flags & flagsmask )
-		{
-			dist = DistanceFast( nodes[i].origin, origin );
-
-			if( dist < closest )
-			{
-				// make sure it is visible
-				G_Trace( &tr, origin, mins, maxs, nodes[i].origin, passent, MASK_NODESOLID );
-				if( tr.fraction == 1.0 )
-				{
-					node = i;
-					closest = dist;
-				}
-			}
-		}
+		// make sure it is visible
+		G_Trace( &tr, origin, mins, maxs, nodes[candidates[i].node].origin, passent, MASK_NODESOLID );
+		if( tr.fraction == 1.0 )
+			return candidates[i].node;
 	}
-	return node;
+
+	return NODE_INVALID;
 }
 
 int AI_FindClosestNode( vec3_t origin, float mindist, int range, unsigned int flagsmask )
 {
-	int i;
-	float closest;
-	float dist;
-	int node = NODE_INVALID;
+	nav_nodedist_t candidates[MAX_NODES];
 
 	if( mindist > range ) return -1;
 
-	closest = range;
+	if( !AI_SortedNodesInRange( origin, mindist, range, flagsmask, candidates ) )
+		return NODE_INVALID;
 
-	for( i = 0; i < nav.num_nodes; i++ )
-	{
-		if( flagsmask == NODE_ALL || nodes[i].flags & flagsmask )
-		{
-			dist = DistanceFast( nodes[i].origin, origin );
-			if( dist > mindist && dist < closest )
-			{
-				node = i;
-				closest = dist;
-			}
-		}
-	}
-	return node;
+	return candidates[0].node;
 }
 
 void AI_ClearGoal( edict_t *self )
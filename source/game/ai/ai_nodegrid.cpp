@@ -0,0 +1,170 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "../g_local.h"
+#include "ai_local.h"
+
+/*
+* Spatial index over navigation nodes.
+*
+* Nodes are only ever appended to the end of the nodes array, except when
+* deleted in edit mode, so the grid links new nodes in lazily on the next
+* query and is fully rebuilt after an invalidation.
+*/
+
+#define NODEGRID_CELL( x ) ( (int)floor( ( x ) / NODEGRID_CELL_SIZE ) )
+
+static inline int AI_NodeGridHash( int cx, int cy )
+{
+	return (int)( ( ( (unsigned)cx * 73856093u ) ^ ( (unsigned)cy * 19349663u ) ) & ( NODEGRID_HASH_SIZE - 1 ) );
+}
+
+/*
+* AI_InvalidateNodeGrid
+* Must be called whenever existing nodes are removed or moved.
+*/
+void AI_InvalidateNodeGrid( void )
+{
+	memset( nav.grid.buckets, 0, sizeof( nav.grid.buckets ) );
+	nav.grid.numNodes = 0;
+}
+
+/*
+* AI_UpdateNodeGrid
+*/
+static void AI_UpdateNodeGrid( void )
+{
+	int i, hash;
+	nav_nodegrid_t *grid = &nav.grid;
+
+	if( grid->numNodes > nav.num_nodes )
+		AI_InvalidateNodeGrid();
+
+	for( i = grid->numNodes; i < nav.num_nodes; i++ )
+	{
+		grid->cell[i][0] = NODEGRID_CELL( nodes[i].origin[0] );
+		grid->cell[i][1] = NODEGRID_CELL( nodes[i].origin[1] );
+
+		hash = AI_NodeGridHash( grid->cell[i][0], grid->cell[i][1] );
+		grid->next[i] = grid->buckets[hash];
+		grid->buckets[hash] = i + 1;
+	}
+
+	grid->numNodes = nav.num_nodes;
+}
+
+/*
+* AI_NodeGridGather
+* Fills the list with every node whose cell overlaps the XY square of the
+* given radius around the origin. Nodes are not distance checked. The list
+* must have room for MAX_NODES entries.
+*/
+int AI_NodeGridGather( vec3_t origin, float radius, int *list )
+{
+	int i, cx, cy, hash;
+	int mins[2], maxs[2];
+	int maxCells;
+	int count = 0;
+	const nav_nodegrid_t *grid = &nav.grid;
+
+	AI_UpdateNodeGrid();
+
+	// leave some slack for the approximated distances used by the callers
+	radius += 1.0f;
+
+	for( i = 0; i < 2; i++ )
+	{
+		mins[i] = NODEGRID_CELL( origin[i] - radius );
+		maxs[i] = NODEGRID_CELL( origin[i] + radius );
+	}
+
+	// when the query covers more cells than there are nodes, a plain scan is cheaper
+	maxCells = nav.num_nodes < NODEGRID_MAX_QUERY_CELLS ? nav.num_nodes : NODEGRID_MAX_QUERY_CELLS;
+	if( ( maxs[0] - mins[0] + 1 ) * ( maxs[1] - mins[1] + 1 ) > maxCells )
+	{
+		for( i = 0; i < nav.num_nodes; i++ )
+			list[count++] = i;
+		return count;
+	}
+
+	for( cx = mins[0]; cx <= maxs[0]; cx++ )
+	{
+		for( cy = mins[1]; cy <= maxs[1]; cy++ )
+		{
+			hash = AI_NodeGridHash( cx, cy );
+			for( i = grid->buckets[hash] - 1; i >= 0; i = grid->next[i] - 1 )
+			{
+				// different cells may share the bucket
+				if( grid->cell[i][0] != cx || grid->cell[i][1] != cy )
+					continue;
+				list[count++] = i;
+			}
+		}
+	}
+
+	return count;
+}
+
+static int AI_CompareNodeDist( const void *a, const void *b )
+{
+	const nav_nodedist_t *n1 = ( const nav_nodedist_t * )a;
+	const nav_nodedist_t *n2 = ( const nav_nodedist_t * )b;
+
+	if( n1->dist < n2->dist )
+		return -1;
+	if( n1->dist > n2->dist )
+		return 1;
+	return n1->node - n2->node;
+}
+
+/*
+* AI_SortedNodesInRange
+* Fills the list with the nodes matching the flags mask which are farther than
+* mindist and closer than range, nearest first. The list must have room for
+* MAX_NODES entries.
+*/
+int AI_SortedNodesInRange( vec3_t origin, float mindist, float range, unsigned int flagsmask, nav_nodedist_t *list )
+{
+	int i, node, numCandidates;
+	int count = 0;
+	float dist;
+	int candidates[MAX_NODES];
+
+	numCandidates = AI_NodeGridGather( origin, range, candidates );
+
+	for( i = 0; i < numCandidates; i++ )
+	{
+		node = candidates[i];
+		if( flagsmask != NODE_ALL && !( nodes[node].flags & flagsmask ) )
+			continue;
+
+		dist = DistanceFast( nodes[node].origin, origin );
+		if( dist > mindist && dist < range )
+		{
+			list[count].node = node;
+			list[count].dist = dist;
+			count++;
+		}
+	}
+
+	qsort( list, count, sizeof( *list ), AI_CompareNodeDist );
+
+	return count;
+}
@@ -93,7 +93,7 @@ static void AI_JumpadGuess_ShowPoint( vec3_t origin, char *modelname )
 	ent->s.modelindex = trap_ModelIndex( modelname );
 	ent->nextThink = level.time + 20000000;
 	ent->think = G_FreeEdict;
-	ent->classname = "checkent";
+	G_SetClassname( ent, "checkent" );
 	ent->r.svflags &= ~SVF_NOCLIENT;
 
 	GClip_LinkEntity( ent );
@@ -1113,20 +1113,115 @@ bool AI_LoadPLKFile( char *mapname )
 	{
 		trap_FS_FCloseFile( filenum );
 		G_Printf( "AI_LoadPLKFile: Too many nodes\n" );
+		nav.num_nodes = 0;
 		return false;
 	}
 
-	//read nodes
-	trap_FS_Read( nodes, sizeof( nav_node_t ) * nav.num_nodes, filenum );
+	//read nodes and plinks
+	if( nav.num_nodes < 0
+		|| trap_FS_Read( nodes, sizeof( nav_node_t ) * nav.num_nodes, filenum ) != (int)( sizeof( nav_node_t ) * nav.num_nodes )
+		|| trap_FS_Read( pLinks, sizeof( nav_plink_t ) * nav.num_nodes, filenum ) != (int)( sizeof( nav_plink_t ) * nav.num_nodes ) )
+	{
+		trap_FS_FCloseFile( filenum );
+		G_Printf( "AI_LoadPLKFile: Truncated file\n" );
+		nav.num_nodes = 0;
+		return false;
+	}
 
-	//read plinks
-	trap_FS_Read( pLinks, sizeof( nav_plink_t ) * nav.num_nodes, filenum );
+	trap_FS_FCloseFile( filenum );
+
+	return true;
+}
+
+/*
+* AI_NavigationLinksKey
+* hash of everything the server links are computed from: the bsp checksum
+* and the nodes and links present before the server linking passes
+*/
+static unsigned int AI_NavigationLinksKey( void )
+{
+	const char *checksum = trap_GetConfigString( CS_MAPCHECKSUM );
+	unsigned int hash = 2166136261u;
+	const uint8_t *p;
+	size_t i;
+
+	// FNV-1a
+	for( p = ( const uint8_t * )checksum; *p; p++ )
+		hash = ( hash ^ *p ) * 16777619u;
+	for( p = ( const uint8_t * )nodes, i = 0; i < sizeof( nav_node_t ) * nav.num_nodes; i++ )
+		hash = ( hash ^ p[i] ) * 16777619u;
+	for( p = ( const uint8_t * )pLinks, i = 0; i < sizeof( nav_plink_t ) * nav.num_nodes; i++ )
+		hash = ( hash ^ p[i] ) * 16777619u;
+
+	return hash;
+}
+
+/*
+* AI_LoadLinksCache
+* load the result of the server linking passes if it was computed for this exact map and nodes
+*/
+static bool AI_LoadLinksCache( char *mapname, unsigned int key )
+{
+	char filename[MAX_QPATH];
+	int header[3];
+	int length, read;
+	int filenum;
+	nav_plink_t *cached;
+
+	Q_snprintfz( filename, sizeof( filename ), "%s/%s.%s", NAV_FILE_FOLDER, mapname, NAV_LINKS_FILE_EXTENSION );
+
+	length = trap_FS_FOpenFile( filename, &filenum, FS_READ );
+	if( length == -1 )
+		return false;
+
+	if( length != (int)( sizeof( header ) + sizeof( nav_plink_t ) * nav.num_nodes )
+		|| trap_FS_Read( header, sizeof( header ), filenum ) != sizeof( header )
+		|| header[0] != NAV_LINKS_FILE_VERSION || (unsigned int)header[1] != key || header[2] != nav.num_nodes )
+	{
+		trap_FS_FCloseFile( filenum );
+		return false;
+	}
 
+	// read into a copy, so the links are still there to relink if the file is short
+	cached = ( nav_plink_t * )G_Malloc( sizeof( nav_plink_t ) * nav.num_nodes );
+	read = trap_FS_Read( cached, sizeof( nav_plink_t ) * nav.num_nodes, filenum );
 	trap_FS_FCloseFile( filenum );
 
+	if( read != (int)( sizeof( nav_plink_t ) * nav.num_nodes ) )
+	{
+		G_Free( cached );
+		return false;
+	}
+
+	memcpy( pLinks, cached, sizeof( nav_plink_t ) * nav.num_nodes );
+	G_Free( cached );
+
 	return true;
 }
 
+/*
+* AI_SaveLinksCache
+*/
+static void AI_SaveLinksCache( char *mapname, unsigned int key )
+{
+	char filename[MAX_QPATH];
+	int header[3];
+	int filenum;
+
+	Q_snprintfz( filename, sizeof( filename ), "%s/%s.%s", NAV_FILE_FOLDER, mapname, NAV_LINKS_FILE_EXTENSION );
+
+	if( trap_FS_FOpenFile( filename, &filenum, FS_WRITE ) == -1 )
+		return;
+
+	header[0] = NAV_LINKS_FILE_VERSION;
+	header[1] = (int)key;
+	header[2] = nav.num_nodes;
+
+	trap_FS_Write( header, sizeof( header ), filenum );
+	trap_FS_Write( pLinks, sizeof( nav_plink_t ) * nav.num_nodes, filenum );
+	trap_FS_FCloseFile( filenum );
+}
+
 /*
 * AI_SaveNavigation
 */
@@ -1161,6 +1256,7 @@ void AI_SaveNavigation( void )
 void AI_InitEntitiesData( void )
 {
 	int newlinks, newjumplinks;
+	unsigned int linksKey;
 	edict_t *ent;
 
 	if( !nav.num_nodes )
@@ -1177,16 +1273,31 @@ void AI_InitEntitiesData( void )
 	for( ent = game.edicts + 1; PLAYERNUM( ent ) < gs.maxclients; ent++ )
 		AI_AddGoalEntity( ent );
 
-	// link all newly added nodes
-	newlinks = AI_LinkServerNodes( nav.serverNodesStart );
-	newjumplinks = AI_LinkCloseNodes_JumpPass( nav.serverNodesStart );
-
-	if( developer->integer )
+	// link all newly added nodes, unless we already did it for this map
+	linksKey = AI_NavigationLinksKey();
+	if( AI_LoadLinksCache( level.mapname, linksKey ) )
+	{
+		if( developer->integer )
+		{
+			G_Printf( "       : added nodes:%i.\n", nav.num_nodes - nav.serverNodesStart );
+			G_Printf( "       : total nodes:%i.\n", nav.num_nodes );
+			G_Printf( "       : loaded cached links.\n" );
+		}
+	}
+	else
 	{
-		G_Printf( "       : added nodes:%i.\n", nav.num_nodes - nav.serverNodesStart );
-		G_Printf( "       : total nodes:%i.\n", nav.num_nodes );
-		G_Printf( "       : added links:%i.\n", newlinks );
-		G_Printf( "       : added jump links:%i.\n", newjumplinks );
+		newlinks = AI_LinkServerNodes( nav.serverNodesStart );
+		newjumplinks = AI_LinkCloseNodes_JumpPass( nav.serverNodesStart );
+
+		AI_SaveLinksCache( level.mapname, linksKey );
+
+		if( developer->integer )
+		{
+			G_Printf( "       : added nodes:%i.\n", nav.num_nodes - nav.serverNodesStart );
+			G_Printf( "       : total nodes:%i.\n", nav.num_nodes );
+			G_Printf( "       : added links:%i.\n", newlinks );
+			G_Printf( "       : added jump links:%i.\n", newjumplinks );
+		}
 	}
 
 	G_Printf( "       : AI Navigation Initialized.\n" );
@@ -1363,7 +1363,7 @@ static asstring_t *objectGameEntity_getTargetname( edict_t *self ) {
 }
 
 static void objectGameEntity_setTargetname( asstring_t *targetname, edict_t *self ) {
-	self->targetname = G_RegisterLevelString( targetname->buffer );
+	G_SetTargetname( self, G_RegisterLevelString( targetname->buffer ) );
 }
 
 static asstring_t *objectGameEntity_getTarget( edict_t *self ) {
@@ -1383,7 +1383,7 @@ static asstring_t *objectGameEntity_getSoundName( edict_t *self ) {
 }
 
 static void objectGameEntity_setClassname( asstring_t *classname, edict_t *self ) {
-	self->classname = G_RegisterLevelString( classname->buffer );
+	G_SetClassname( self, G_RegisterLevelString( classname->buffer ) );
 }
 
 static void objectGameEntity_setMap( asstring_t *map, edict_t *self ) {
@@ -1727,7 +1727,7 @@ static edict_t *asFunc_G_Spawn( asstring_t *classname ) {
 	ent = G_Spawn();
 
 	if( classname && classname->len ) {
-		ent->classname = G_RegisterLevelString( classname->buffer );
+		G_SetClassname( ent, G_RegisterLevelString( classname->buffer ) );
 	}
 
 	ent->scriptSpawned = true;
@@ -2169,15 +2169,13 @@ static CScriptArrayInterface *asFunc_G_FindInRadius( asvec3_t *org, float radius
 	return arr;
 }
 
-static CScriptArrayInterface *asFunc_G_FindByClassname( asstring_t *str ) {
-	const char *classname = str->buffer;
-
+static CScriptArrayInterface *asFunc_G_FindByField( asstring_t *str, size_t fieldofs ) {
 	asIObjectType *ot = asEntityArrayType();
 	CScriptArrayInterface *arr = game.asExport->asCreateArrayCpp( 0, ot );
 
 	int count = 0;
 	edict_t *ent = NULL;
-	while( ( ent = G_Find( ent, FOFS( classname ), classname ) ) != NULL ) {
+	while( ( ent = G_Find( ent, fieldofs, str->buffer ) ) != NULL ) {
 		arr->Resize( count + 1 );
 		*( (edict_t **)arr->At( count ) ) = ent;
 		count++;
@@ -2186,6 +2184,22 @@ static CScriptArrayInterface *asFunc_G_FindByClassname( asstring_t *str ) {
 	return arr;
 }
 
+static CScriptArrayInterface *asFunc_G_FindByClassname( asstring_t *str ) {
+	return asFunc_G_FindByField( str, FOFS( classname ) );
+}
+
+static CScriptArrayInterface *asFunc_G_FindByTargetname( asstring_t *str ) {
+	return asFunc_G_FindByField( str, FOFS( targetname ) );
+}
+
+static edict_t *asFunc_G_FindEntityWithClassname( edict_t *from, asstring_t *str ) {
+	return G_Find( from, FOFS( classname ), str->buffer );
+}
+
+static edict_t *asFunc_G_FindEntityWithTargetname( edict_t *from, asstring_t *str ) {
+	return G_Find( from, FOFS( targetname ), str->buffer );
+}
+
 static void asFunc_PositionedSound( asvec3_t *origin, int channel, int soundindex, float attenuation ) {
 	if( !origin ) {
 		return;
@@ -2332,6 +2346,9 @@ static const gs_asglobfuncs_t asGameGlobFuncs[] =
 	{ "Item @G_GetItemByClassname( const String &in name )", asFUNCTION( asFunc_GS_FindItemByClassname ), NULL },
 	{ "array<Entity @> @G_FindInRadius( const Vec3 &in, float radius )", asFUNCTION( asFunc_G_FindInRadius ), NULL },
 	{ "array<Entity @> @G_FindByClassname( const String &in )", asFUNCTION( asFunc_G_FindByClassname ), NULL },
+	{ "array<Entity @> @G_FindByTargetname( const String &in )", asFUNCTION( asFunc_G_FindByTargetname ), NULL },
+	{ "Entity @G_FindEntityWithClassname( Entity @from, const String &in )", asFUNCTION( asFunc_G_FindEntityWithClassname ), NULL },
+	{ "Entity @G_FindEntityWithTargetname( Entity @from, const String &in )", asFUNCTION( asFunc_G_FindEntityWithTargetname ), NULL },
 
 	// misc management utils
 	{ "void G_RemoveProjectiles( Entity @ )", asFUNCTION( asFunc_G_Match_RemoveProjectiles ), NULL },
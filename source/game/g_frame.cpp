@@ -656,6 +656,10 @@ static void G_RunClients( void ) {
 		step = 1;
 	}
 
+	// bots decide what to do before anyone moves, so their view of the world
+	// doesn't depend on the order clients are run in
+	AI_ThinkBots();
+
 	for( ; i < gs.maxclients && i >= 0; i += step ) {
 		ent = game.edicts + 1 + i;
 		if( !ent->r.inuse ) {
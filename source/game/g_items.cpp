@@ -466,7 +466,7 @@ edict_t *Drop_Item( edict_t *ent, const gsitem_t *item ) {
 	}
 
 	dropped = G_Spawn();
-	dropped->classname = item->classname;
+	G_SetClassname( dropped, item->classname );
 	dropped->item = item;
 	dropped->spawnflags = DROPPED_ITEM;
 	VectorCopy( item_box_mins, dropped->r.mins );
@@ -144,6 +144,55 @@ typedef enum {
 	MOVETYPE_STEP
 } movetype_t;
 
+// queues of free edicts above the clients, see G_Spawn
+enum {
+	FREEEDICTS_REUSABLE,    // can be reused right away
+	FREEEDICTS_RECENT,      // freed recently, sorted by freetime
+
+	FREEEDICTS_QUEUES
+};
+
+typedef struct {
+	int prev;               // previous edict number in the same queue, -1 at the head
+	int next;               // next edict number in the same queue, -1 at the tail
+	int queue;              // FREEEDICTS_* queue the edict is in, -1 if none
+} g_freeedict_t;
+
+typedef struct {
+	int head, tail;
+} g_freeedictqueue_t;
+
+// hash indices of entities by classname and targetname, see G_SetClassname
+#define ENTNAMES_HASH_SIZE 256
+
+enum {
+	ENTNAMES_CLASSNAME,
+	ENTNAMES_TARGETNAME,
+
+	ENTNAMES_FIELDS
+};
+
+typedef struct {
+	int prev, next;         // entity numbers + 1 of the neighbours in the hash chain, 0 at the ends
+	unsigned int hashkey;
+	bool linked;
+} g_entnamelink_t;
+
+typedef struct {
+	int head[ENTNAMES_HASH_SIZE];   // entity number + 1, chains are sorted by entity number
+	int tail[ENTNAMES_HASH_SIZE];
+	g_entnamelink_t *links;         // [maxentities]
+} g_entnameindex_t;
+
+typedef struct {
+	unsigned int spawns;
+	unsigned int frees;
+	unsigned int reusedFree;      // reused from the reusable queue
+	unsigned int reusedRecent;    // reused once the delay expired
+	unsigned int reusedEarly;     // reused before the delay expired because we ran out of edicts
+	unsigned int allocated;       // grew game.numentities
+} g_edictstats_t;
+
 //
 // this structure is left intact through an entire game
 // it should be initialized at dll load time, and read/written to
@@ -163,6 +212,12 @@ typedef struct {
 	int maxentities;
 	int numentities;
 
+	g_freeedict_t *freeEdicts;  // [maxentities]
+	g_freeedictqueue_t freeEdictsQueues[FREEEDICTS_QUEUES];
+	g_edictstats_t edictStats;
+
+	g_entnameindex_t entNames[ENTNAMES_FIELDS];
+
 	// cross level triggers
 	int serverflags;
 
@@ -630,6 +685,10 @@ enum {
 bool KillBox( edict_t *ent );
 float LookAtKillerYAW( edict_t *self, edict_t *inflictor, edict_t *attacker );
 edict_t *G_Find( edict_t *from, size_t fieldofs, const char *match );
+void G_SetClassname( edict_t *ent, const char *classname );
+void G_SetTargetname( edict_t *ent, const char *targetname );
+void G_UnlinkEntityNames( edict_t *ent );
+void G_ClearEntityNames( void );
 edict_t *G_PickTarget( const char *targetname );
 void G_UseTargets( edict_t *ent, edict_t *activator );
 void G_SetMovedir( vec3_t angles, vec3_t movedir );
@@ -639,6 +698,8 @@ void G_DropSpawnpointToFloor( edict_t *ent );
 void G_InitEdict( edict_t *e );
 edict_t *G_Spawn( void );
 void G_FreeEdict( edict_t *e );
+void G_ClearFreeEdicts( void );
+void G_PrintEdictStats( void );
 
 void G_LevelInitPool( size_t size );
 void G_LevelFreePool( void );
@@ -929,6 +990,7 @@ void G_ClientRespawn( edict_t *self, bool ghost );
 void G_ClientClearStats( edict_t *ent );
 void G_GhostClient( edict_t *self );
 void ClientThink( edict_t *ent, usercmd_t *cmd, int timeDelta );
+bool G_ClientCanThink( const edict_t *ent );
 void G_ClientThink( edict_t *ent );
 void G_CheckClientRespawnClick( edict_t *ent );
 bool ClientConnect( edict_t *ent, char *userinfo, bool fakeClient );
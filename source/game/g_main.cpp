@@ -228,6 +228,7 @@ static void G_InitGameShared( void ) {
 * only happens when a new game is started or a save game is loaded.
 */
 void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char *demoExtension ) {
+	int i;
 	cvar_t *g_maxentities;
 
 	G_Printf( "==== G_Init ====\n" );
@@ -354,6 +355,11 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 	g_maxentities = trap_Cvar_Get( "sv_maxentities", "1024", CVAR_LATCH );
 	game.maxentities = g_maxentities->integer;
 	game.edicts = ( edict_t * )G_Malloc( game.maxentities * sizeof( game.edicts[0] ) );
+	game.freeEdicts = ( g_freeedict_t * )G_Malloc( game.maxentities * sizeof( game.freeEdicts[0] ) );
+	for( i = 0; i < ENTNAMES_FIELDS; i++ ) {
+		game.entNames[i].links = ( g_entnamelink_t * )G_Malloc( game.maxentities * sizeof( g_entnamelink_t ) );
+	}
+	G_ClearEntityNames();
 
 	// initialize all clients for this game
 	game.clients = ( gclient_t * )G_Malloc( gs.maxclients * sizeof( game.clients[0] ) );
@@ -361,6 +367,7 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 	game.quits = NULL;
 
 	game.numentities = gs.maxclients + 1;
+	G_ClearFreeEdicts();
 
 	trap_LocateEntities( game.edicts, sizeof( game.edicts[0] ), game.numentities, game.maxentities );
 
@@ -415,6 +422,10 @@ void G_Shutdown( void ) {
 	}
 
 	G_Free( game.edicts );
+	G_Free( game.freeEdicts );
+	for( i = 0; i < ENTNAMES_FIELDS; i++ ) {
+		G_Free( game.entNames[i].links );
+	}
 	G_Free( game.clients );
 }
 
@@ -438,7 +449,7 @@ static edict_t *CreateTargetChangeLevel( const char *map ) {
 	edict_t *ent;
 
 	ent = G_Spawn();
-	ent->classname = "target_changelevel";
+	G_SetClassname( ent, "target_changelevel" );
 	Q_strncpyz( level.nextmap, map, sizeof( level.nextmap ) );
 	ent->map = level.nextmap;
 	return ent;
@@ -119,7 +119,7 @@ void ThrowDebris( edict_t *self, int modelindex, float speed, vec3_t origin ) {
 	chunk->nextThink = level.time + 5000 + random() * 5000;
 	chunk->s.frame = 0;
 	chunk->flags = 0;
-	chunk->classname = "debris";
+	G_SetClassname( chunk, "debris" );
 	chunk->takedamage = DAMAGE_YES;
 	chunk->die = debris_die;
 	chunk->r.owner = self;
@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // g_public.h -- game dll information visible to server
 
-#define GAME_API_VERSION    51
+#define GAME_API_VERSION    52
 
 //===============================================================
 
@@ -176,6 +176,15 @@ typedef struct {
 	// can vary in size from one game to another.
 	void ( *LocateEntities )( struct edict_s *edicts, int edict_size, int num_edicts, int max_edicts );
 
+	// multithreading
+	int ( *Jobs_NumWorkers )( void );
+	struct qjob_s *( *Job_Schedule )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+									  unsigned items, unsigned grain, struct qjob_s **deps, unsigned numDeps );
+	void ( *Job_Wait )( struct qjob_s *job );
+	void ( *Job_Release )( struct qjob_s **pjob );
+	void ( *Jobs_ParallelFor )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+								unsigned items, unsigned grain );
+
 	// angelscript api
 	struct angelwrap_api_s *( *asGetAngelExport )( void );
 
@@ -494,6 +494,10 @@ static char *ED_ParseEdict( char *data, edict_t *ent ) {
 	if( !init ) {
 		ent->classname = NULL;
 	}
+
+	// ED_ParseField writes the fields directly, so index them now
+	G_SetClassname( ent, ent->classname );
+	G_SetTargetname( ent, ent->targetname );
 	if( ent->classname && ent->helpmessage ) {
 		ent->mapmessage_index = G_RegisterHelpMessage( ent->helpmessage );
 	}
@@ -709,6 +713,7 @@ static void G_FreeEntities( void ) {
 
 	if( !level.time ) {
 		memset( game.edicts, 0, game.maxentities * sizeof( game.edicts[0] ) );
+		G_ClearEntityNames();
 	} else {
 		G_FreeEdict( world );
 		for( i = gs.maxclients + 1; i < game.maxentities; i++ ) {
@@ -719,6 +724,7 @@ static void G_FreeEntities( void ) {
 	}
 
 	game.numentities = gs.maxclients + 1;
+	G_ClearFreeEdicts();
 }
 
 /*
@@ -789,7 +795,7 @@ static void G_SpawnEntities( void ) {
 			if( item->flags & ITFLAG_PICKABLE ) {
 				if( G_Gametype_CanSpawnItem( item ) ) {
 					// override entity's classname with whatever item specifies
-					ent->classname = item->classname;
+					G_SetClassname( ent, item->classname );
 					PrecacheItem( item );
 					continue;
 				}
@@ -387,6 +387,8 @@ void G_AddServerCommands( void ) {
 	trap_Cmd_AddCommand( "listraces", G_ListRaces_f );
 
 	trap_Cmd_AddCommand( "listlocations", Cmd_ListLocations_f );
+
+	trap_Cmd_AddCommand( "edictstats", G_PrintEdictStats );
 }
 
 /*
@@ -422,4 +424,6 @@ void G_RemoveCommands( void ) {
 	trap_Cmd_RemoveCommand( "listraces" );
 
 	trap_Cmd_RemoveCommand( "listlocations" );
+
+	trap_Cmd_RemoveCommand( "edictstats" );
 }
@@ -284,6 +284,28 @@ static inline void trap_LocateEntities( struct edict_s *edicts, int edict_size,
 	GAME_IMPORT.LocateEntities( edicts, edict_size, num_edicts, max_edicts );
 }
 
+static inline int trap_Jobs_NumWorkers( void ) {
+	return GAME_IMPORT.Jobs_NumWorkers();
+}
+
+static inline struct qjob_s *trap_Job_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+												unsigned items, unsigned grain, struct qjob_s **deps, unsigned numDeps ) {
+	return GAME_IMPORT.Job_Schedule( func, arg, items, grain, deps, numDeps );
+}
+
+static inline void trap_Job_Wait( struct qjob_s *job ) {
+	GAME_IMPORT.Job_Wait( job );
+}
+
+static inline void trap_Job_Release( struct qjob_s **pjob ) {
+	GAME_IMPORT.Job_Release( pjob );
+}
+
+static inline void trap_Jobs_ParallelFor( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+										  unsigned items, unsigned grain ) {
+	GAME_IMPORT.Jobs_ParallelFor( func, arg, items, grain );
+}
+
 static inline struct angelwrap_api_s *trap_asGetAngelExport( void ) {
 	return GAME_IMPORT.asGetAngelExport();
 }
@@ -462,6 +462,166 @@ void G_ProjectSource( vec3_t point, vec3_t distance, vec3_t forward, vec3_t righ
 }
 
 
+/*
+* G_EntityNameHashKey
+*/
+static unsigned int G_EntityNameHashKey( const char *name ) {
+	unsigned int hashkey = 0;
+
+	// case insensitive, like the G_Find comparisons
+	for( ; *name; name++ ) {
+		hashkey = hashkey * 31 + tolower( (unsigned char)*name );
+	}
+	return hashkey;
+}
+
+/*
+* G_UnlinkEntityName
+*/
+static void G_UnlinkEntityName( edict_t *ent, int field ) {
+	g_entnameindex_t *index = &game.entNames[field];
+	g_entnamelink_t *link = &index->links[ENTNUM( ent )];
+	int bucket = link->hashkey & ( ENTNAMES_HASH_SIZE - 1 );
+
+	if( !link->linked ) {
+		return;
+	}
+
+	if( link->prev ) {
+		index->links[link->prev - 1].next = link->next;
+	} else {
+		index->head[bucket] = link->next;
+	}
+	if( link->next ) {
+		index->links[link->next - 1].prev = link->prev;
+	} else {
+		index->tail[bucket] = link->prev;
+	}
+
+	memset( link, 0, sizeof( *link ) );
+}
+
+/*
+* G_LinkEntityName
+*/
+static void G_LinkEntityName( edict_t *ent, int field, const char *name ) {
+	g_entnameindex_t *index = &game.entNames[field];
+	g_entnamelink_t *link = &index->links[ENTNUM( ent )];
+	int bucket, num, prev;
+
+	link->hashkey = G_EntityNameHashKey( name );
+	link->linked = true;
+	bucket = link->hashkey & ( ENTNAMES_HASH_SIZE - 1 );
+
+	// keep the chain sorted by entity number, new entities usually go last
+	num = ENTNUM( ent ) + 1;
+	for( prev = index->tail[bucket]; prev > num; prev = index->links[prev - 1].prev ) ;
+
+	link->prev = prev;
+	if( prev ) {
+		link->next = index->links[prev - 1].next;
+		index->links[prev - 1].next = num;
+	} else {
+		link->next = index->head[bucket];
+		index->head[bucket] = num;
+	}
+	if( link->next ) {
+		index->links[link->next - 1].prev = num;
+	} else {
+		index->tail[bucket] = num;
+	}
+}
+
+/*
+* G_SetClassname
+*
+* Entity classnames and targetnames must be set through these so G_Find can use the hash indices
+*/
+void G_SetClassname( edict_t *ent, const char *classname ) {
+	G_UnlinkEntityName( ent, ENTNAMES_CLASSNAME );
+	ent->classname = classname;
+	if( classname ) {
+		G_LinkEntityName( ent, ENTNAMES_CLASSNAME, classname );
+	}
+}
+
+/*
+* G_SetTargetname
+*/
+void G_SetTargetname( edict_t *ent, const char *targetname ) {
+	G_UnlinkEntityName( ent, ENTNAMES_TARGETNAME );
+	ent->targetname = targetname;
+	if( targetname ) {
+		G_LinkEntityName( ent, ENTNAMES_TARGETNAME, targetname );
+	}
+}
+
+/*
+* G_UnlinkEntityNames
+*/
+void G_UnlinkEntityNames( edict_t *ent ) {
+	int i;
+
+	for( i = 0; i < ENTNAMES_FIELDS; i++ ) {
+		G_UnlinkEntityName( ent, i );
+	}
+}
+
+/*
+* G_ClearEntityNames
+*
+* For when all edicts are wiped at once
+*/
+void G_ClearEntityNames( void ) {
+	int i;
+
+	for( i = 0; i < ENTNAMES_FIELDS; i++ ) {
+		memset( game.entNames[i].head, 0, sizeof( game.entNames[i].head ) );
+		memset( game.entNames[i].tail, 0, sizeof( game.entNames[i].tail ) );
+		memset( game.entNames[i].links, 0, game.maxentities * sizeof( g_entnamelink_t ) );
+	}
+}
+
+/*
+* G_FindIndexed
+*/
+static edict_t *G_FindIndexed( edict_t *from, int field, size_t fieldofs, const char *match ) {
+	const g_entnameindex_t *index = &game.entNames[field];
+	unsigned int hashkey = G_EntityNameHashKey( match );
+	int num;
+	const char *s;
+	edict_t *ent;
+
+	if( from && index->links[ENTNUM( from )].linked && index->links[ENTNUM( from )].hashkey == hashkey ) {
+		// still in the same chain, carry on from there
+		num = index->links[ENTNUM( from )].next;
+	} else {
+		// from was renamed or freed, or it's a new search
+		num = index->head[hashkey & ( ENTNAMES_HASH_SIZE - 1 )];
+		if( from ) {
+			while( num && num - 1 <= ENTNUM( from ) )
+				num = index->links[num - 1].next;
+		}
+	}
+
+	for( ; num; num = index->links[num - 1].next ) {
+		if( index->links[num - 1].hashkey != hashkey ) {
+			continue;
+		}
+
+		ent = &game.edicts[num - 1];
+		if( !ent->r.inuse ) {
+			continue;
+		}
+		s = *(char **) ( (uint8_t *)ent + fieldofs );
+		if( s && !Q_stricmp( s, match ) ) {
+			return ent;
+		}
+	}
+
+	return NULL;
+}
+
 /*
 * G_Find
 *
@@ -475,6 +635,13 @@ void G_ProjectSource( vec3_t point, vec3_t distance, vec3_t forward, vec3_t righ
 edict_t *G_Find( edict_t *from, size_t fieldofs, const char *match ) {
 	char *s;
 
+	if( fieldofs == FOFS( classname ) ) {
+		return G_FindIndexed( from, ENTNAMES_CLASSNAME, fieldofs, match );
+	}
+	if( fieldofs == FOFS( targetname ) ) {
+		return G_FindIndexed( from, ENTNAMES_TARGETNAME, fieldofs, match );
+	}
+
 	if( !from ) {
 		from = world;
 	} else {
@@ -568,7 +735,7 @@ void G_UseTargets( edict_t *ent, edict_t *activator ) {
 	if( ent->delay ) {
 		// create a temp object to fire at a later time
 		t = G_Spawn();
-		t->classname = "delayed_use";
+		G_SetClassname( t, "delayed_use" );
 		t->nextThink = level.time + 1000 * ent->delay;
 		t->think = Think_Delay;
 		t->activator = activator;
@@ -693,6 +860,129 @@ char *_G_CopyString( const char *in, const char *filename, int fileline ) {
 	return out;
 }
 
+/*
+* G_ClearFreeEdicts
+*
+* Empties the free edicts queues, for when game.numentities is reset
+*/
+void G_ClearFreeEdicts( void ) {
+	int i;
+
+	for( i = 0; i < FREEEDICTS_QUEUES; i++ ) {
+		game.freeEdictsQueues[i].head = game.freeEdictsQueues[i].tail = -1;
+	}
+	for( i = 0; i < game.maxentities; i++ ) {
+		game.freeEdicts[i].prev = game.freeEdicts[i].next = -1;
+		game.freeEdicts[i].queue = -1;
+	}
+}
+
+/*
+* G_UnqueueFreeEdict
+*/
+static void G_UnqueueFreeEdict( int num ) {
+	g_freeedict_t *fe = &game.freeEdicts[num];
+	g_freeedictqueue_t *q;
+
+	if( fe->queue < 0 ) {
+		return;
+	}
+
+	q = &game.freeEdictsQueues[fe->queue];
+	if( fe->prev >= 0 ) {
+		game.freeEdicts[fe->prev].next = fe->next;
+	} else {
+		q->head = fe->next;
+	}
+	if( fe->next >= 0 ) {
+		game.freeEdicts[fe->next].prev = fe->prev;
+	} else {
+		q->tail = fe->prev;
+	}
+
+	fe->prev = fe->next = -1;
+	fe->queue = -1;
+}
+
+/*
+* G_QueueFreeEdict
+*
+* Edicts freed again after being put back in use without going through G_Spawn
+* (body queue, clients) move to the tail, keeping the queue sorted by freetime
+*/
+static void G_QueueFreeEdict( edict_t *ed, int queue ) {
+	int num = ENTNUM( ed );
+	g_freeedict_t *fe = &game.freeEdicts[num];
+	g_freeedictqueue_t *q = &game.freeEdictsQueues[queue];
+
+	G_UnqueueFreeEdict( num );
+
+	fe->prev = q->tail;
+	fe->next = -1;
+	fe->queue = queue;
+	if( q->tail >= 0 ) {
+		game.freeEdicts[q->tail].next = num;
+	} else {
+		q->head = num;
+	}
+	q->tail = num;
+}
+
+/*
+* G_FreeEdictsQueueHead
+*
+* Returns the oldest edict in the queue, skipping those which were put
+* back in use without going through G_Spawn (body queue, clients)
+*/
+static edict_t *G_FreeEdictsQueueHead( int queue, bool dequeue ) {
+	int num;
+	g_freeedictqueue_t *q = &game.freeEdictsQueues[queue];
+
+	while( ( num = q->head ) >= 0 ) {
+		if( !game.edicts[num].r.inuse && !dequeue ) {
+			return &game.edicts[num];
+		}
+
+		G_UnqueueFreeEdict( num );
+
+		if( !game.edicts[num].r.inuse ) {
+			return &game.edicts[num];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+* G_PrintEdictStats
+*/
+void G_PrintEdictStats( void ) {
+	int i, count[FREEEDICTS_QUEUES];
+	int inuse = 0;
+	const g_edictstats_t *stats = &game.edictStats;
+
+	for( i = 0; i < game.numentities; i++ ) {
+		if( game.edicts[i].r.inuse ) {
+			inuse++;
+		}
+	}
+
+	for( i = 0; i < FREEEDICTS_QUEUES; i++ ) {
+		int num;
+
+		count[i] = 0;
+		for( num = game.freeEdictsQueues[i].head; num >= 0; num = game.freeEdicts[num].next ) {
+			count[i]++;
+		}
+	}
+
+	G_Printf( "edicts: %i in use, %i allocated, %i max\n", inuse, game.numentities, game.maxentities );
+	G_Printf( "free queues: %i reusable, %i recently freed\n", count[FREEEDICTS_REUSABLE], count[FREEEDICTS_RECENT] );
+	G_Printf( "spawns: %u, frees: %u\n", stats->spawns, stats->frees );
+	G_Printf( "reused: %u free, %u recent, %u early; allocated: %u\n",
+			  stats->reusedFree, stats->reusedRecent, stats->reusedEarly, stats->allocated );
+}
+
 /*
 * G_FreeEdict
 *
@@ -702,6 +992,7 @@ void G_FreeEdict( edict_t *ed ) {
 	bool evt = ISEVENTENTITY( &ed->s );
 
 	GClip_UnlinkEntity( ed );   // unlink from world
+	G_UnlinkEntityNames( ed );
 
 	AI_RemoveGoalEntity( ed );
 	G_FreeAI( ed );
@@ -717,6 +1008,18 @@ void G_FreeEdict( edict_t *ed ) {
 	if( !evt && ( level.spawnedTimeStamp != game.realtime ) ) {
 		ed->freetime = game.realtime; // ET_EVENT or ET_SOUND don't need to wait to be reused
 	}
+
+	if( ENTNUM( ed ) > gs.maxclients && ENTNUM( ed ) < game.numentities ) {
+		game.edictStats.frees++;
+
+		// the first couple seconds of server time can involve a lot of
+		// freeing and allocating, so relax the replacement policy
+		if( ed->freetime < level.spawnedTimeStamp + 2000 ) {
+			G_QueueFreeEdict( ed, FREEEDICTS_REUSABLE );
+		} else {
+			G_QueueFreeEdict( ed, FREEEDICTS_RECENT );
+		}
+	}
 }
 
 /*
@@ -724,7 +1027,8 @@ void G_FreeEdict( edict_t *ed ) {
 */
 void G_InitEdict( edict_t *e ) {
 	e->r.inuse = true;
-	e->classname = NULL;
+	G_SetClassname( e, NULL );
+	G_SetTargetname( e, e->targetname );
 	e->gravity = 1.0;
 	e->timeDelta = 0;
 	e->deadflag = DEAD_NO;
@@ -758,43 +1062,45 @@ void G_InitEdict( edict_t *e ) {
 * angles and bad trails.
 */
 edict_t *G_Spawn( void ) {
-	int i;
-	edict_t *e, *freed;
+	edict_t *e;
 
 	if( !level.canSpawnEntities ) {
 		G_Printf( "WARNING: Spawning entity before map entities have been spawned\n" );
 	}
 
-	freed = NULL;
-	e = &game.edicts[gs.maxclients + 1];
-	for( i = gs.maxclients + 1; i < game.numentities; i++, e++ ) {
-		if( e->r.inuse ) {
-			continue;
-		}
+	game.edictStats.spawns++;
 
-		// the first couple seconds of server time can involve a lot of
-		// freeing and allocating, so relax the replacement policy
-		if( e->freetime < level.spawnedTimeStamp + 2000 || game.realtime > e->freetime + 500 ) {
-			G_InitEdict( e );
-			return e;
-		}
+	e = G_FreeEdictsQueueHead( FREEEDICTS_REUSABLE, true );
+	if( e ) {
+		game.edictStats.reusedFree++;
+		G_InitEdict( e );
+		return e;
+	}
 
-		// this is going to be our second chance to spawn an entity in case all free
-		// entities have been freed only recently
-		if( !freed ) {
-			freed = e;
-		}
+	// the recently freed queue is sorted by freetime, so only the head needs checking
+	e = G_FreeEdictsQueueHead( FREEEDICTS_RECENT, false );
+	if( e && game.realtime > e->freetime + 500 ) {
+		G_FreeEdictsQueueHead( FREEEDICTS_RECENT, true );
+		game.edictStats.reusedRecent++;
+		G_InitEdict( e );
+		return e;
 	}
 
-	if( i == game.maxentities ) {
-		if( freed ) {
-			G_InitEdict( freed );
-			return freed;
+	if( game.numentities == game.maxentities ) {
+		// this is going to be our second chance to spawn an entity in case all free
+		// entities have been freed only recently
+		if( e ) {
+			G_FreeEdictsQueueHead( FREEEDICTS_RECENT, true );
+			game.edictStats.reusedEarly++;
+			G_InitEdict( e );
+			return e;
 		}
 		G_Error( "G_Spawn: no free edicts" );
 	}
 
+	e = &game.edicts[game.numentities];
 	game.numentities++;
+	game.edictStats.allocated++;
 
 	trap_LocateEntities( game.edicts, sizeof( game.edicts[0] ), game.numentities, game.maxentities );
 
@@ -2328,7 +2634,7 @@ void G_PlayerNoise( edict_t *who, vec3_t where, int type )
 	if (!who->mynoise)
 	{
 		noise = G_Spawn();
-		noise->classname = "player_noise";
+		G_SetClassname( noise, "player_noise" );
 		VectorSet (noise->r.mins, -8, -8, -8);
 		VectorSet (noise->r.maxs, 8, 8, 8);
 		noise->r.owner = who;
@@ -2336,7 +2642,7 @@ void G_PlayerNoise( edict_t *who, vec3_t where, int type )
 		who->mynoise = noise;
 		
 		noise = G_Spawn();
-		noise->classname = "player_noise";
+		G_SetClassname( noise, "player_noise" );
 		VectorSet (noise->r.mins, -8, -8, -8);
 		VectorSet (noise->r.maxs, 8, 8, 8);
 		noise->r.owner = who;
@@ -252,7 +252,7 @@ static edict_t *W_Fire_LinearProjectile( edict_t *self, vec3_t start, vec3_t dir
 	projectile->touch = W_Touch_Projectile; //generic one. Should be replaced after calling this func
 	projectile->nextThink = level.time + timeout;
 	projectile->think = G_FreeEdict;
-	projectile->classname = NULL; // should be replaced after calling this func.
+	G_SetClassname( projectile, NULL ); // should be replaced after calling this func.
 	projectile->style = 0;
 	projectile->s.sound = 0;
 	projectile->timeStamp = level.time;
@@ -313,7 +313,7 @@ static edict_t *W_Fire_TossProjectile( edict_t *self, vec3_t start, vec3_t dir,
 	projectile->touch = W_Touch_Projectile; //generic one. Should be replaced after calling this func
 	projectile->nextThink = level.time + timeout;
 	projectile->think = G_FreeEdict;
-	projectile->classname = NULL; // should be replaced after calling this func.
+	G_SetClassname( projectile, NULL ); // should be replaced after calling this func.
 	projectile->style = 0;
 	projectile->s.sound = 0;
 	projectile->timeStamp = level.time;
@@ -430,7 +430,7 @@ edict_t *W_Fire_GunbladeBlast( edict_t *self, vec3_t start, vec3_t dir, float da
 	blast->s.type = ET_BLASTER;
 	blast->s.effects |= EF_STRONG_WEAPON;
 	blast->touch = W_Touch_GunbladeBlast;
-	blast->classname = "gunblade_blast";
+	G_SetClassname( blast, "gunblade_blast" );
 	blast->style = mod;
 
 	blast->s.sound = trap_SoundIndex( S_WEAPON_PLASMAGUN_S_FLY );
@@ -635,7 +635,7 @@ edict_t *W_Fire_Grenade( edict_t *self, vec3_t start, vec3_t dir, int speed, flo
 	grenade->touch = W_Touch_Grenade;
 	grenade->use = NULL;
 	grenade->think = W_Grenade_Explode;
-	grenade->classname = "grenade";
+	G_SetClassname( grenade, "grenade" );
 	grenade->enemy = NULL;
 	VectorSet( grenade->avelocity, 300, 300, 300 );
 
@@ -733,7 +733,7 @@ edict_t *W_Fire_Rocket( edict_t *self, vec3_t start, vec3_t dir, int speed, floa
 	rocket->s.attenuation = ATTN_STATIC;
 	rocket->touch = W_Touch_Rocket;
 	rocket->think = G_FreeEdict;
-	rocket->classname = "rocket";
+	G_SetClassname( rocket, "rocket" );
 	rocket->style = mod;
 
 	return rocket;
@@ -859,7 +859,7 @@ edict_t *W_Fire_Plasma( edict_t *self, vec3_t start, vec3_t dir, float damage, f
 
 	plasma = W_Fire_LinearProjectile( self, start, dir, speed, damage, selfDamage, minKnockback, maxKnockback, stun, minDamage, radius, timeout, timeDelta );
 	plasma->s.type = ET_PLASMA;
-	plasma->classname = "plasma";
+	G_SetClassname( plasma, "plasma" );
 	plasma->style = mod;
 
 	plasma->think = W_Think_Plasma;
@@ -1043,7 +1043,7 @@ edict_t *W_Fire_Electrobolt_Weak( edict_t *self, vec3_t start, vec3_t dir, float
 	bolt->s.type = ET_ELECTRO_WEAK; //add particle trail and light
 	bolt->s.ownerNum = ENTNUM( self );
 	bolt->touch = W_Touch_Bolt;
-	bolt->classname = "bolt";
+	G_SetClassname( bolt, "bolt" );
 	bolt->style = mod;
 	bolt->s.effects &= ~EF_STRONG_WEAPON;
 
@@ -113,7 +113,7 @@ void G_InitBodyQueue( void ) {
 	level.body_que = 0;
 	for( i = 0; i < BODY_QUEUE_SIZE; i++ ) {
 		ent = G_Spawn();
-		ent->classname = "bodyque";
+		G_SetClassname( ent, "bodyque" );
 	}
 }
 
@@ -205,7 +205,7 @@ static edict_t *CopyToBodyQue( edict_t *ent, edict_t *attacker, int damage ) {
 
 	//init body edict
 	G_InitEdict( body );
-	body->classname = "body";
+	G_SetClassname( body, "body" );
 	body->health = ent->health;
 	body->mass = ent->mass;
 	body->r.owner = ent->r.owner;
@@ -544,11 +544,11 @@ void G_ClientRespawn( edict_t *self, bool ghost ) {
 
 	if( AI_GetType( self->ai ) == AI_ISBOT ) {
 		self->think = NULL;
-		self->classname = "bot";
+		G_SetClassname( self, "bot" );
 	} else if( self->r.svflags & SVF_FAKECLIENT ) {
-		self->classname = "fakeclient";
+		G_SetClassname( self, "fakeclient" );
 	} else {
-		self->classname = "player";
+		G_SetClassname( self, "player" );
 	}
 
 	VectorCopy( playerbox_stand_mins, self->r.mins );
@@ -1608,15 +1608,23 @@ void ClientThink( edict_t *ent, usercmd_t *ucmd, int timeDelta ) {
 }
 
 /*
-* G_ClientThink
-* Client frame think, and call to execute its usercommands thinking
+* G_ClientCanThink
+* Whether the client is in the game and runs its usercommands this frame
 */
-void G_ClientThink( edict_t *ent ) {
+bool G_ClientCanThink( const edict_t *ent ) {
 	if( !ent || !ent->r.client ) {
-		return;
+		return false;
 	}
 
-	if( trap_GetClientState( PLAYERNUM( ent ) ) < CS_SPAWNED ) {
+	return trap_GetClientState( PLAYERNUM( ent ) ) >= CS_SPAWNED;
+}
+
+/*
+* G_ClientThink
+* Client frame think, and call to execute its usercommands thinking
+*/
+void G_ClientThink( edict_t *ent ) {
+	if( !G_ClientCanThink( ent ) ) {
 		return;
 	}
 
@@ -1638,11 +1646,9 @@ void G_ClientThink( edict_t *ent ) {
 		}
 	}
 
-	// run bots thinking with the rest of clients
-	if( ent->r.svflags & SVF_FAKECLIENT ) {
-		if( !ent->think && AI_GetType( ent->ai ) == AI_ISBOT ) {
-			AI_Think( ent );
-		}
+	// run the usercmds bots produced in the think phase with the rest of clients
+	if( AI_UsesThinkPhase( ent ) ) {
+		AI_ApplyThink( ent );
 	}
 
 	trap_ExecuteClientThinks( PLAYERNUM( ent ) );
@@ -61,7 +61,7 @@ void G_PlayerTrail_Init (void)
 	for (n = 0; n < TRAIL_LENGTH; n++)
 	{
 		trail[n] = G_Spawn();
-		trail[n]->classname = "player_trail";
+		G_SetClassname( trail[n], "player_trail" );
 	}
 
 	trail_head = 0;
@@ -761,6 +761,8 @@ void Qcommon_Init( int argc, char **argv ) {
 
 	Sys_Init();
 
+	QJobs_Init();
+
 	NET_Init();
 	Netchan_Init();
 
@@ -916,6 +918,8 @@ void Qcommon_Shutdown( void ) {
 	}
 	isdown = true;
 
+	QJobs_Shutdown();
+
 	Com_ScriptModule_Shutdown();
 	CM_Shutdown();
 	Netchan_Shutdown();
@@ -0,0 +1,624 @@
+/*
+Copyright (C) 2013 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// demostream.c -- compressed demo files
+
+#include "qcommon.h"
+#include "compression.h"
+
+// A chunked demo starts with a header, followed by independently compressed chunks
+// of the demo messages stream:
+//
+// [int32 magic] [int32 version]
+// [int32 compressed size] [int32 size] [int32 method] [data] ...
+//
+// The uncompressed stream is exactly what a plain demo file holds, so offsets in it,
+// such as those in the keyframe index, are the same in both formats. Chunks are
+// compressed by the job system while recording, and are read ahead and decompressed
+// in the background during playback. Writes that fit into a chunk aren't split, so
+// a recording that was interrupted is readable up to the last complete chunk, which
+// ends on a complete demo message.
+//
+// Appending to a chunked demo overwrites whatever follows the last complete chunk.
+// Until the new data covers all of it, an end chunk with a size of 0 is kept right
+// after the last chunk written, so stale bytes are never taken for a chunk.
+//
+// Streams written at level 0 are plain demos that older clients can play.
+
+#define DEMOSTREAM_MAGIC            ( 'Q' | ( 'D' << 8 ) | ( 'Z' << 16 ) | ( 'C' << 24 ) )
+#define DEMOSTREAM_VERSION          1
+#define DEMOSTREAM_HEADER_SIZE      8
+#define DEMOSTREAM_CHUNK_HEADER_SIZE    12
+#define DEMOSTREAM_CHUNK_SIZE       ( 128 * 1024 )
+#define DEMOSTREAM_NUM_BUFFERS      4   // the chunk being read and the ones read ahead
+
+#define DEMOSTREAM_METHOD_STORE     0
+#define DEMOSTREAM_METHOD_DEFLATE   1
+#define DEMOSTREAM_METHOD_END       2   // no data, marks the end of the stream
+
+typedef struct {
+	int offset;                     // of the data in the file
+	int start;                      // in the uncompressed stream
+	int compressedSize, size;
+	int method;
+} demochunk_t;
+
+typedef struct {
+	int chunk;                      // -1 if empty
+
+	uint8_t *data;
+	size_t size;
+	uint8_t *compressed;
+	size_t compressedSize;
+	int method, level;
+	bool failed;
+
+	qjob_t *job;
+} demostreambuf_t;
+
+typedef struct demostream_s {
+	int file;
+	bool writing;
+	bool chunked;
+	int level;
+
+	int position;                   // in the uncompressed stream
+
+	// reading
+	int numChunks, maxChunks;
+	demochunk_t *chunks;
+	int nextChunkOffset;            // where the header of the next chunk is expected
+	int fileLength;
+	bool allChunks;
+
+	// appending, the offset up to which the file holds stale data
+	int staleEnd;
+
+	// while reading, chunk n is in buffer n % DEMOSTREAM_NUM_BUFFERS
+	// while writing, the chunk being filled and the one being compressed
+	demostreambuf_t buffers[DEMOSTREAM_NUM_BUFFERS];
+	int writeBuffer;
+} demostream_t;
+
+/*
+* DemoStream_AllocBuffer
+*/
+static void DemoStream_AllocBuffer( demostreambuf_t *buf ) {
+	if( !buf->data ) {
+		buf->data = Mem_ZoneMalloc( DEMOSTREAM_CHUNK_SIZE );
+		buf->compressed = Mem_ZoneMalloc( mz_compressBound( DEMOSTREAM_CHUNK_SIZE ) );
+	}
+}
+
+/*
+* DemoStream_CompressJob
+*/
+static void DemoStream_CompressJob( unsigned first, unsigned items, void *arg ) {
+	demostreambuf_t *buf = arg;
+	mz_ulong size = mz_compressBound( buf->size );
+
+	buf->method = DEMOSTREAM_METHOD_STORE;
+	buf->compressedSize = buf->size;
+
+	if( mz_compress2( buf->compressed, &size, buf->data, buf->size, buf->level ) == MZ_OK && size < buf->size ) {
+		buf->method = DEMOSTREAM_METHOD_DEFLATE;
+		buf->compressedSize = size;
+	}
+}
+
+/*
+* DemoStream_DecompressJob
+*/
+static void DemoStream_DecompressJob( unsigned first, unsigned items, void *arg ) {
+	demostreambuf_t *buf = arg;
+	mz_ulong size = buf->size;
+
+	if( mz_uncompress( buf->data, &size, buf->compressed, buf->compressedSize ) != MZ_OK || size != buf->size ) {
+		buf->failed = true;
+	}
+}
+
+/*
+* DemoStream_WriteEnd
+*
+* Writes an end chunk at the current position without moving past it.
+*/
+static void DemoStream_WriteEnd( demostream_t *s ) {
+	int header[3];
+	int offset = FS_Tell( s->file );
+
+	if( offset >= s->staleEnd ) {
+		s->staleEnd = 0;
+		return;
+	}
+
+	header[0] = header[1] = 0;
+	header[2] = LittleLong( DEMOSTREAM_METHOD_END );
+	FS_Write( header, sizeof( header ), s->file );
+	FS_Seek( s->file, offset, FS_SEEK_SET );
+}
+
+/*
+* DemoStream_FinishBuffer
+*
+* Waits for the buffer's job, and writes the chunk out if it was compressed for writing.
+*/
+static void DemoStream_FinishBuffer( demostream_t *s, demostreambuf_t *buf ) {
+	int header[3];
+
+	if( buf->job ) {
+		QJob_Wait( buf->job );
+		QJob_Release( &buf->job );
+	}
+
+	if( !s->writing || !buf->size ) {
+		return;
+	}
+
+	header[0] = LittleLong( (int)buf->compressedSize );
+	header[1] = LittleLong( (int)buf->size );
+	header[2] = LittleLong( buf->method );
+	FS_Write( header, sizeof( header ), s->file );
+
+	if( buf->method == DEMOSTREAM_METHOD_STORE ) {
+		FS_Write( buf->data, buf->size, s->file );
+	} else {
+		FS_Write( buf->compressed, buf->compressedSize, s->file );
+	}
+
+	if( s->staleEnd ) {
+		DemoStream_WriteEnd( s );
+	}
+
+	buf->size = 0;
+}
+
+/*
+* DemoStream_EndChunk
+*
+* Compresses the chunk being filled in the background, or writes it out uncompressed
+* right away if store is set. Chunks are written in order.
+*/
+static void DemoStream_EndChunk( demostream_t *s, bool store ) {
+	demostreambuf_t *buf = &s->buffers[s->writeBuffer];
+
+	if( !buf->size ) {
+		return;
+	}
+
+	s->writeBuffer ^= 1;
+	DemoStream_FinishBuffer( s, &s->buffers[s->writeBuffer] );
+
+	if( store || s->level <= 0 ) {
+		buf->method = DEMOSTREAM_METHOD_STORE;
+		buf->compressedSize = buf->size;
+		DemoStream_FinishBuffer( s, buf );
+		return;
+	}
+
+	buf->level = s->level;
+	buf->job = QJob_ScheduleBackground( DemoStream_CompressJob, buf, 1, 1, NULL, 0 );
+}
+
+/*
+* DemoStream_ReadChunkHeader
+*
+* Finds the next chunk, returns false at the end of the file or at the first invalid chunk.
+*/
+static bool DemoStream_ReadChunkHeader( demostream_t *s ) {
+	int header[3];
+	demochunk_t *chunk;
+
+	if( s->allChunks ) {
+		return false;
+	}
+
+	if( FS_Seek( s->file, s->nextChunkOffset, FS_SEEK_SET ) < 0 ||
+		FS_Read( header, sizeof( header ), s->file ) != sizeof( header ) ) {
+		s->allChunks = true;
+		return false;
+	}
+
+	if( s->numChunks == s->maxChunks ) {
+		s->maxChunks = max( s->maxChunks * 2, 64 );
+		if( s->chunks ) {
+			s->chunks = Mem_Realloc( s->chunks, s->maxChunks * sizeof( demochunk_t ) );
+		} else {
+			s->chunks = Mem_ZoneMalloc( s->maxChunks * sizeof( demochunk_t ) );
+		}
+	}
+
+	chunk = &s->chunks[s->numChunks];
+	chunk->offset = s->nextChunkOffset + DEMOSTREAM_CHUNK_HEADER_SIZE;
+	chunk->start = s->numChunks ? chunk[-1].start + chunk[-1].size : 0;
+	chunk->compressedSize = LittleLong( header[0] );
+	chunk->size = LittleLong( header[1] );
+	chunk->method = LittleLong( header[2] );
+
+	if( chunk->method == DEMOSTREAM_METHOD_END ) {
+		s->allChunks = true;
+		return false;
+	}
+
+	if( chunk->size <= 0 || chunk->size > DEMOSTREAM_CHUNK_SIZE || chunk->compressedSize <= 0 ||
+		chunk->compressedSize > s->fileLength - chunk->offset ||
+		( chunk->method == DEMOSTREAM_METHOD_STORE && chunk->compressedSize != chunk->size ) ||
+		( chunk->method == DEMOSTREAM_METHOD_DEFLATE && chunk->compressedSize > (int)mz_compressBound( chunk->size ) ) ||
+		( chunk->method != DEMOSTREAM_METHOD_STORE && chunk->method != DEMOSTREAM_METHOD_DEFLATE ) ) {
+		s->allChunks = true;
+		return false;
+	}
+
+	s->numChunks++;
+	s->nextChunkOffset = chunk->offset + chunk->compressedSize;
+	return true;
+}
+
+/*
+* DemoStream_Length
+*/
+static int DemoStream_Length( const demostream_t *s ) {
+	const demochunk_t *last;
+
+	if( !s->numChunks ) {
+		return 0;
+	}
+	last = &s->chunks[s->numChunks - 1];
+	return last->start + last->size;
+}
+
+/*
+* DemoStream_FindChunk
+*
+* Returns the chunk with the stream offset, or -1 if it's past the end.
+*/
+static int DemoStream_FindChunk( demostream_t *s, int offset ) {
+	int first, last, mid;
+
+	while( offset >= DemoStream_Length( s ) ) {
+		if( !DemoStream_ReadChunkHeader( s ) ) {
+			return -1;
+		}
+	}
+
+	first = 0;
+	last = s->numChunks - 1;
+	while( first < last ) {
+		mid = ( first + last + 1 ) / 2;
+		if( s->chunks[mid].start <= offset ) {
+			first = mid;
+		} else {
+			last = mid - 1;
+		}
+	}
+
+	return first;
+}
+
+/*
+* DemoStream_LoadChunk
+*
+* Reads the chunk into its buffer and starts decompressing it, unless it's already there.
+*/
+static demostreambuf_t *DemoStream_LoadChunk( demostream_t *s, int num ) {
+	const demochunk_t *chunk = &s->chunks[num];
+	demostreambuf_t *buf = &s->buffers[num % DEMOSTREAM_NUM_BUFFERS];
+
+	if( buf->chunk == num ) {
+		return buf;
+	}
+
+	DemoStream_FinishBuffer( s, buf );
+	DemoStream_AllocBuffer( buf );
+
+	buf->chunk = num;
+	buf->size = chunk->size;
+	buf->compressedSize = chunk->compressedSize;
+	buf->method = chunk->method;
+	buf->failed = false;
+
+	if( FS_Seek( s->file, chunk->offset, FS_SEEK_SET ) < 0 ) {
+		buf->failed = true;
+	} else if( chunk->method == DEMOSTREAM_METHOD_STORE ) {
+		buf->failed = FS_Read( buf->data, buf->size, s->file ) != (int)buf->size;
+	} else if( FS_Read( buf->compressed, buf->compressedSize, s->file ) != (int)buf->compressedSize ) {
+		buf->failed = true;
+	} else {
+		buf->job = QJob_ScheduleBackground( DemoStream_DecompressJob, buf, 1, 1, NULL, 0 );
+	}
+
+	return buf;
+}
+
+/*
+* DemoStream_ReadAhead
+*/
+static void DemoStream_ReadAhead( demostream_t *s, int num ) {
+	int i;
+
+	for( i = num + 1; i < num + DEMOSTREAM_NUM_BUFFERS; i++ ) {
+		if( i >= s->numChunks && !DemoStream_ReadChunkHeader( s ) ) {
+			break;
+		}
+		DemoStream_LoadChunk( s, i );
+	}
+}
+
+/*
+* DemoStream_Open
+*
+* Takes ownership of a file opened for reading, writing, or reading and updating
+* in FS_APPEND mode. New files are chunked if level is 1 to 9, appending follows
+* the format of the existing file.
+*/
+demostream_t *DemoStream_Open( int file, int mode, int level ) {
+	int header[2];
+	demostream_t *s;
+
+	if( !file ) {
+		return NULL;
+	}
+
+	s = Mem_ZoneMalloc( sizeof( *s ) );
+	s->file = file;
+	s->writing = mode != FS_READ;
+	s->level = Q_bound( 0, level, 9 );
+	s->buffers[0].chunk = s->buffers[1].chunk = s->buffers[2].chunk = s->buffers[3].chunk = -1;
+
+	if( mode == FS_WRITE ) {
+		if( s->level > 0 ) {
+			s->chunked = true;
+			header[0] = LittleLong( DEMOSTREAM_MAGIC );
+			header[1] = LittleLong( DEMOSTREAM_VERSION );
+			FS_Write( header, sizeof( header ), file );
+		}
+		return s;
+	}
+
+	FS_Seek( file, 0, FS_SEEK_END );
+	s->fileLength = FS_Tell( file );
+	FS_Seek( file, 0, FS_SEEK_SET );
+
+	if( FS_Read( header, sizeof( header ), file ) == sizeof( header ) &&
+		LittleLong( header[0] ) == DEMOSTREAM_MAGIC && LittleLong( header[1] ) == DEMOSTREAM_VERSION ) {
+		s->chunked = true;
+		s->nextChunkOffset = DEMOSTREAM_HEADER_SIZE;
+	} else {
+		FS_Seek( file, 0, FS_SEEK_SET );
+	}
+
+	if( mode == FS_APPEND ) {
+		if( s->chunked ) {
+			// continue after the last complete chunk
+			while( DemoStream_ReadChunkHeader( s ) );
+			FS_Seek( file, s->nextChunkOffset, FS_SEEK_SET );
+			s->position = DemoStream_Length( s );
+
+			// a truncated chunk may follow, cut it off
+			s->staleEnd = s->fileLength;
+			DemoStream_WriteEnd( s );
+		} else {
+			FS_Seek( file, 0, FS_SEEK_END );
+		}
+	}
+
+	return s;
+}
+
+/*
+* DemoStream_Close
+*/
+void DemoStream_Close( demostream_t **ps ) {
+	int i;
+	demostream_t *s = *ps;
+
+	if( !s ) {
+		return;
+	}
+
+	if( s->writing ) {
+		DemoStream_Flush( s, false );
+	}
+
+	for( i = 0; i < DEMOSTREAM_NUM_BUFFERS; i++ ) {
+		demostreambuf_t *buf = &s->buffers[i];
+
+		if( buf->job ) {
+			QJob_Wait( buf->job );
+			QJob_Release( &buf->job );
+		}
+		if( buf->data ) {
+			Mem_ZoneFree( buf->data );
+			Mem_ZoneFree( buf->compressed );
+		}
+	}
+
+	if( s->chunks ) {
+		Mem_ZoneFree( s->chunks );
+	}
+
+	FS_FCloseFile( s->file );
+	Mem_ZoneFree( s );
+	*ps = NULL;
+}
+
+/*
+* DemoStream_Read
+*/
+int DemoStream_Read( demostream_t *s, void *buffer, size_t len ) {
+	int num, total = 0;
+	size_t n;
+	const demochunk_t *chunk;
+	demostreambuf_t *buf;
+
+	if( !s->chunked ) {
+		return FS_Read( buffer, len, s->file );
+	}
+
+	while( len > 0 ) {
+		num = DemoStream_FindChunk( s, s->position );
+		if( num < 0 ) {
+			break;
+		}
+
+		chunk = &s->chunks[num];
+		buf = DemoStream_LoadChunk( s, num );
+
+		// the first chunk is all that's read when listing the demos
+		if( num > 0 ) {
+			DemoStream_ReadAhead( s, num );
+		}
+
+		if( buf->job ) {
+			QJob_Wait( buf->job );
+			QJob_Release( &buf->job );
+		}
+		if( buf->failed ) {
+			Com_Printf( "Error reading demo file: bad chunk at %i\n", chunk->offset );
+			break;
+		}
+
+		n = min( len, (size_t)( chunk->start + chunk->size - s->position ) );
+		memcpy( (uint8_t *)buffer + total, buf->data + s->position - chunk->start, n );
+		s->position += n;
+		total += n;
+		len -= n;
+	}
+
+	return total;
+}
+
+/*
+* DemoStream_Write
+*/
+int DemoStream_Write( demostream_t *s, const void *buffer, size_t len ) {
+	size_t n, total = 0;
+	demostreambuf_t *buf;
+
+	if( !s->chunked ) {
+		return FS_Write( buffer, len, s->file );
+	}
+
+	if( s->buffers[s->writeBuffer].size + len > DEMOSTREAM_CHUNK_SIZE && len <= DEMOSTREAM_CHUNK_SIZE ) {
+		DemoStream_EndChunk( s, false );
+	}
+
+	while( len > 0 ) {
+		buf = &s->buffers[s->writeBuffer];
+		DemoStream_AllocBuffer( buf );
+
+		n = min( len, DEMOSTREAM_CHUNK_SIZE - buf->size );
+		memcpy( buf->data + buf->size, (const uint8_t *)buffer + total, n );
+		buf->size += n;
+		s->position += n;
+		total += n;
+		len -= n;
+
+		if( buf->size == DEMOSTREAM_CHUNK_SIZE ) {
+			DemoStream_EndChunk( s, false );
+		}
+	}
+
+	return total;
+}
+
+/*
+* DemoStream_Tell
+*/
+int DemoStream_Tell( demostream_t *s ) {
+	if( !s->chunked ) {
+		return FS_Tell( s->file );
+	}
+	return s->position;
+}
+
+/*
+* DemoStream_Seek
+*
+* Only streams that are read can be seeked. Returns 0 on success, -1 otherwise.
+*/
+int DemoStream_Seek( demostream_t *s, int offset, int whence ) {
+	if( !s->chunked ) {
+		return FS_Seek( s->file, offset, whence );
+	}
+
+	if( s->writing ) {
+		return -1;
+	}
+
+	if( whence == FS_SEEK_CUR ) {
+		offset += s->position;
+	} else if( whence == FS_SEEK_END ) {
+		while( DemoStream_ReadChunkHeader( s ) );
+		offset += DemoStream_Length( s );
+	} else if( whence != FS_SEEK_SET ) {
+		return -1;
+	}
+
+	if( offset < 0 ) {
+		return -1;
+	}
+	if( offset > DemoStream_Length( s ) && DemoStream_FindChunk( s, offset - 1 ) < 0 ) {
+		return -1;
+	}
+
+	s->position = offset;
+	return 0;
+}
+
+/*
+* DemoStream_Flush
+*
+* Writes out everything written so far. With store set, the data is written
+* uncompressed, so it can be updated in place later, see DemoStream_Rewrite.
+*/
+int DemoStream_Flush( demostream_t *s, bool store ) {
+	if( s->chunked && s->writing ) {
+		DemoStream_EndChunk( s, store );
+		DemoStream_FinishBuffer( s, &s->buffers[s->writeBuffer ^ 1] );
+	}
+	return FS_Flush( s->file );
+}
+
+/*
+* DemoStream_Rewrite
+*
+* Overwrites the start of a demo file opened for reading and updating. For chunked
+* demos, the data has to fit into the first chunk, which must have been stored.
+*/
+bool DemoStream_Rewrite( int file, const void *data, size_t size ) {
+	int header[2], chunk[3];
+
+	if( FS_Seek( file, 0, FS_SEEK_SET ) < 0 ) {
+		return false;
+	}
+
+	if( FS_Read( header, sizeof( header ), file ) == sizeof( header ) &&
+		LittleLong( header[0] ) == DEMOSTREAM_MAGIC && LittleLong( header[1] ) == DEMOSTREAM_VERSION ) {
+		if( FS_Read( chunk, sizeof( chunk ), file ) != sizeof( chunk ) ||
+			LittleLong( chunk[2] ) != DEMOSTREAM_METHOD_STORE || LittleLong( chunk[1] ) < (int)size ) {
+			return false;
+		}
+		FS_Seek( file, DEMOSTREAM_HEADER_SIZE + DEMOSTREAM_CHUNK_HEADER_SIZE, FS_SEEK_SET );
+	} else {
+		FS_Seek( file, 0, FS_SEEK_SET );
+	}
+
+	return FS_Write( data, size, file ) == (int)size;
+}
@@ -969,7 +969,10 @@ int FS_FOpenAbsoluteFile( const char *filename, int *filenum, int mode ) {
 		return -1;
 	}
 
-	end = ( mode == FS_WRITE || FS_FileLength( f, false ) );
+	end = 0;
+	if( mode == FS_APPEND || mode == FS_READ || update ) {
+		end = FS_FileLength( f, false );
+	}
 
 	*filenum = FS_OpenFileHandle();
 	file = &fs_filehandles[*filenum - 1];
@@ -0,0 +1,705 @@
+/*
+Copyright (C) 2013 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "qcommon.h"
+#include "sys_threads.h"
+
+/*
+* Work-stealing job scheduler.
+*
+* Every worker thread owns a task queue: it pushes and pops tasks at the tail
+* while idle threads steal from the head. Threads which are not workers push
+* into a separate shared queue. Tasks carry a range of items and are split in
+* halves by whichever thread picks them up until they are no larger than the
+* job grain, so the work spreads out across the idle threads on its own.
+*
+* Background jobs (streaming, compression) go into a queue of their own which
+* workers only look at when there's nothing else to do. Threads waiting on a
+* job never pick up background tasks other than those of the awaited job, so
+* a frame-time wait can't get stuck in a long unrelated task.
+*/
+
+#define QJOBS_MAX_WORKERS       32
+#define QJOBS_QUEUE_SIZE        256
+
+typedef struct qjobedge_s {
+	struct qjob_s *job;
+	struct qjobedge_s *next;
+} qjobedge_t;
+
+struct qjob_s {
+	void ( *func )( unsigned first, unsigned items, void *arg );
+	void *arg;
+	unsigned items;
+	unsigned grain;
+	volatile int remaining;     // items which haven't been processed yet
+	volatile int pendingDeps;   // unfinished dependencies, plus one while scheduling
+	volatile int refcount;      // one for the caller and one for the scheduler
+	volatile int done;
+	bool background;
+	qjobedge_t *dependents;     // protected by the graph mutex
+};
+
+typedef struct {
+	qjob_t *job;
+	unsigned first;
+	unsigned items;
+} qjobtask_t;
+
+typedef struct {
+	qmutex_t *mutex;
+	qjobtask_t *tasks;
+	unsigned size;
+	volatile unsigned head;
+	volatile unsigned tail;
+} qjobqueue_t;
+
+static struct {
+	bool initialized;
+	int numWorkers;
+	volatile int quit;
+	volatile int pendingTasks;
+	volatile int numSleeping;
+	qthread_t *threads[QJOBS_MAX_WORKERS];
+	qjobqueue_t queues[QJOBS_MAX_WORKERS + 1]; // the last one is shared by non-worker threads
+	qjobqueue_t background;
+	qmutex_t *graphMutex;
+	qmutex_t *idleMutex;
+	qcondvar_t *idleCond;
+} jobs;
+
+static cvar_t *com_jobthreads;
+
+static void QJobs_Benchmark_f( void );
+
+/*
+* QJobs_InitQueue
+*/
+static void QJobs_InitQueue( qjobqueue_t *queue ) {
+	queue->mutex = QMutex_Create();
+	queue->size = QJOBS_QUEUE_SIZE;
+	queue->tasks = Q_malloc( queue->size * sizeof( *queue->tasks ) );
+	queue->head = queue->tail = 0;
+}
+
+/*
+* QJobs_DestroyQueue
+*/
+static void QJobs_DestroyQueue( qjobqueue_t *queue ) {
+	QMutex_Destroy( &queue->mutex );
+	Q_free( queue->tasks );
+	memset( queue, 0, sizeof( *queue ) );
+}
+
+/*
+* QJobs_WakeWorker
+*/
+static void QJobs_WakeWorker( void ) {
+	if( QAtomic_Add( &jobs.numSleeping, 0 ) <= 0 ) {
+		return;
+	}
+
+	QMutex_Lock( jobs.idleMutex );
+	QCondVar_Wake( jobs.idleCond );
+	QMutex_Unlock( jobs.idleMutex );
+}
+
+/*
+* QJobs_PushTask
+*/
+static void QJobs_PushTask( qjobqueue_t *queue, const qjobtask_t *task ) {
+	unsigned i, count;
+	qjobtask_t *tasks;
+
+	QMutex_Lock( queue->mutex );
+
+	count = queue->tail - queue->head;
+	if( count == queue->size ) {
+		tasks = Q_malloc( queue->size * 2 * sizeof( *tasks ) );
+		for( i = 0; i < count; i++ ) {
+			tasks[i] = queue->tasks[( queue->head + i ) & ( queue->size - 1 )];
+		}
+		Q_free( queue->tasks );
+
+		queue->tasks = tasks;
+		queue->size *= 2;
+		queue->head = 0;
+		queue->tail = count;
+	}
+
+	queue->tasks[queue->tail & ( queue->size - 1 )] = *task;
+	queue->tail++;
+
+	QMutex_Unlock( queue->mutex );
+
+	QAtomic_Add( &jobs.pendingTasks, 1 );
+
+	QJobs_WakeWorker();
+}
+
+/*
+* QJobs_PopTask
+*
+* Takes the most recently pushed task, used by the owner of the queue.
+*/
+static bool QJobs_PopTask( qjobqueue_t *queue, qjobtask_t *task ) {
+	bool res = false;
+
+	if( queue->head == queue->tail ) {
+		return false;
+	}
+
+	QMutex_Lock( queue->mutex );
+	if( queue->head != queue->tail ) {
+		queue->tail--;
+		*task = queue->tasks[queue->tail & ( queue->size - 1 )];
+		res = true;
+	}
+	QMutex_Unlock( queue->mutex );
+
+	return res;
+}
+
+/*
+* QJobs_StealTask
+*
+* Takes the oldest task, which is also the largest one for split ranges.
+*/
+static bool QJobs_StealTask( qjobqueue_t *queue, qjobtask_t *task ) {
+	bool res = false;
+
+	if( queue->head == queue->tail ) {
+		return false;
+	}
+
+	QMutex_Lock( queue->mutex );
+	if( queue->head != queue->tail ) {
+		*task = queue->tasks[queue->head & ( queue->size - 1 )];
+		queue->head++;
+		res = true;
+	}
+	QMutex_Unlock( queue->mutex );
+
+	return res;
+}
+
+/*
+* QJobs_TakeJobTask
+*
+* Takes the oldest task of the given job, wherever it is in the queue.
+*/
+static bool QJobs_TakeJobTask( qjobqueue_t *queue, const qjob_t *job, qjobtask_t *task ) {
+	unsigned i;
+	bool res = false;
+
+	if( queue->head == queue->tail ) {
+		return false;
+	}
+
+	QMutex_Lock( queue->mutex );
+	for( i = queue->head; i != queue->tail; i++ ) {
+		if( queue->tasks[i & ( queue->size - 1 )].job != job ) {
+			continue;
+		}
+
+		*task = queue->tasks[i & ( queue->size - 1 )];
+		for( ; i + 1 != queue->tail; i++ ) {
+			queue->tasks[i & ( queue->size - 1 )] = queue->tasks[( i + 1 ) & ( queue->size - 1 )];
+		}
+		queue->tail--;
+		res = true;
+		break;
+	}
+	QMutex_Unlock( queue->mutex );
+
+	return res;
+}
+
+/*
+* QJobs_Unref
+*/
+static void QJobs_Unref( qjob_t *job ) {
+	if( QAtomic_Add( &job->refcount, -1 ) == 1 ) {
+		Q_free( job );
+	}
+}
+
+static void QJobs_ReleaseDependency( qjob_t *job );
+
+/*
+* QJobs_CompleteJob
+*/
+static void QJobs_CompleteJob( qjob_t *job ) {
+	qjobedge_t *edge, *next;
+
+	QMutex_Lock( jobs.graphMutex );
+	edge = job->dependents;
+	job->dependents = NULL;
+	QAtomic_CAS( &job->done, 0, 1 );
+	QMutex_Unlock( jobs.graphMutex );
+
+	for( ; edge; edge = next ) {
+		next = edge->next;
+		QJobs_ReleaseDependency( edge->job );
+		Q_free( edge );
+	}
+
+	QJobs_Unref( job );
+}
+
+/*
+* QJobs_ReleaseDependency
+*
+* Queues the job once all of its dependencies have completed.
+*/
+static void QJobs_ReleaseDependency( qjob_t *job ) {
+	qjobtask_t task;
+
+	if( QAtomic_Add( &job->pendingDeps, -1 ) != 1 ) {
+		return;
+	}
+
+	if( !job->items ) {
+		QJobs_CompleteJob( job );
+		return;
+	}
+
+	task.job = job;
+	task.first = 0;
+	task.items = job->items;
+	QJobs_PushTask( job->background ? &jobs.background : &jobs.queues[jobs.numWorkers], &task );
+}
+
+/*
+* QJobs_ExecuteTask
+*/
+static void QJobs_ExecuteTask( int self, qjobtask_t *task ) {
+	unsigned half;
+	qjobtask_t split;
+	qjob_t *job = task->job;
+	qjobqueue_t *queue = &jobs.queues[self >= 0 ? self : jobs.numWorkers];
+
+	if( job->background ) {
+		queue = &jobs.background;
+	}
+
+	// keep the upper halves around for other threads to steal
+	while( jobs.numWorkers > 0 && task->items > job->grain ) {
+		half = task->items / 2;
+
+		split.job = job;
+		split.first = task->first + half;
+		split.items = task->items - half;
+		QJobs_PushTask( queue, &split );
+
+		task->items = half;
+	}
+
+	job->func( task->first, task->items, job->arg );
+
+	if( QAtomic_Add( &job->remaining, -(int)task->items ) == (int)task->items ) {
+		QJobs_CompleteJob( job );
+	}
+}
+
+/*
+* QJobs_RunTask
+*
+* Runs a single task from the own queue of the worker, the shared queue
+* or any other worker queue, then from the background queue if allowed.
+* Returns false if there was nothing to do.
+*/
+static bool QJobs_RunTask( int self, bool background ) {
+	int i, victim;
+	bool found = false;
+	qjobtask_t task;
+
+	if( self >= 0 ) {
+		found = QJobs_PopTask( &jobs.queues[self], &task );
+	}
+	if( !found ) {
+		found = QJobs_StealTask( &jobs.queues[jobs.numWorkers], &task );
+	}
+	for( i = 0; !found && i < jobs.numWorkers; i++ ) {
+		victim = ( self + 1 + i ) % jobs.numWorkers;
+		if( victim != self ) {
+			found = QJobs_StealTask( &jobs.queues[victim], &task );
+		}
+	}
+	if( !found && background ) {
+		found = QJobs_StealTask( &jobs.background, &task );
+	}
+
+	if( !found ) {
+		return false;
+	}
+
+	QAtomic_Add( &jobs.pendingTasks, -1 );
+
+	QJobs_ExecuteTask( self, &task );
+	return true;
+}
+
+/*
+* QJobs_WorkerProc
+*/
+static void *QJobs_WorkerProc( void *param ) {
+	int self = (qjobqueue_t *)param - jobs.queues;
+
+	while( !jobs.quit ) {
+		if( QJobs_RunTask( self, true ) ) {
+			continue;
+		}
+
+		// sleep until QJobs_WakeWorker is called: the task count is raised before
+		// it checks for sleepers, so a task pushed after this check can't be missed
+		QMutex_Lock( jobs.idleMutex );
+		QAtomic_Add( &jobs.numSleeping, 1 );
+		if( !jobs.quit && QAtomic_Add( &jobs.pendingTasks, 0 ) <= 0 ) {
+			QCondVar_Wait( jobs.idleCond, jobs.idleMutex, Q_THREADS_WAIT_INFINITE );
+		}
+		QAtomic_Add( &jobs.numSleeping, -1 );
+		QMutex_Unlock( jobs.idleMutex );
+	}
+
+	return NULL;
+}
+
+/*
+* QJobs_Init
+*/
+void QJobs_Init( void ) {
+	int i, numWorkers;
+
+	if( jobs.initialized ) {
+		return;
+	}
+
+	com_jobthreads = Cvar_Get( "com_jobthreads", "-1", CVAR_ARCHIVE | CVAR_LATCH );
+
+	// the thread which waits on a job helps running it, so leave a core for it
+	numWorkers = com_jobthreads->integer;
+	if( numWorkers < 0 ) {
+		numWorkers = Sys_GetNumberOfProcessors() - 1;
+		if( numWorkers < 1 ) {
+			numWorkers = 1;
+		}
+	}
+	clamp_high( numWorkers, QJOBS_MAX_WORKERS );
+
+	memset( &jobs, 0, sizeof( jobs ) );
+	jobs.numWorkers = numWorkers;
+	jobs.graphMutex = QMutex_Create();
+	jobs.idleMutex = QMutex_Create();
+	jobs.idleCond = QCondVar_Create();
+
+	for( i = 0; i <= numWorkers; i++ ) {
+		QJobs_InitQueue( &jobs.queues[i] );
+	}
+	QJobs_InitQueue( &jobs.background );
+	for( i = 0; i < numWorkers; i++ ) {
+		jobs.threads[i] = QThread_Create( QJobs_WorkerProc, &jobs.queues[i] );
+	}
+
+	jobs.initialized = true;
+
+	Cmd_AddCommand( "jobs_bench", QJobs_Benchmark_f );
+
+	Com_Printf( "Job scheduler initialized with %i worker thread%s\n", numWorkers, numWorkers == 1 ? "" : "s" );
+}
+
+/*
+* QJobs_Shutdown
+*/
+void QJobs_Shutdown( void ) {
+	int i;
+
+	if( !jobs.initialized ) {
+		return;
+	}
+
+	Cmd_RemoveCommand( "jobs_bench" );
+
+	// finish whatever has been left behind
+	while( QJobs_RunTask( -1, true ) )
+		;
+
+	QMutex_Lock( jobs.idleMutex );
+	jobs.quit = 1;
+	QMutex_Unlock( jobs.idleMutex );
+
+	for( i = 0; i < jobs.numWorkers; i++ ) {
+		QMutex_Lock( jobs.idleMutex );
+		QCondVar_Wake( jobs.idleCond );
+		QMutex_Unlock( jobs.idleMutex );
+	}
+
+	for( i = 0; i < jobs.numWorkers; i++ ) {
+		QThread_Join( jobs.threads[i] );
+		jobs.threads[i] = NULL;
+	}
+
+	for( i = 0; i <= jobs.numWorkers; i++ ) {
+		QJobs_DestroyQueue( &jobs.queues[i] );
+	}
+	QJobs_DestroyQueue( &jobs.background );
+
+	QCondVar_Destroy( &jobs.idleCond );
+	QMutex_Destroy( &jobs.idleMutex );
+	QMutex_Destroy( &jobs.graphMutex );
+
+	jobs.initialized = false;
+}
+
+/*
+* QJobs_NumWorkers
+*/
+int QJobs_NumWorkers( void ) {
+	return jobs.numWorkers;
+}
+
+/*
+* QJobs_Schedule
+*/
+static qjob_t *QJobs_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+							   unsigned items, unsigned grain, qjob_t **deps, unsigned numDeps, bool background ) {
+	unsigned i;
+	qjob_t *dep;
+	qjobedge_t *edge;
+	qjob_t *job;
+
+	assert( jobs.initialized );
+	assert( items <= INT_MAX );
+
+	job = Q_malloc( sizeof( *job ) );
+	memset( job, 0, sizeof( *job ) );
+	job->func = func;
+	job->arg = arg;
+	job->items = items;
+	job->grain = grain ? grain : 1;
+	job->remaining = items;
+	job->pendingDeps = 1;
+	job->refcount = 2;
+	job->background = background;
+
+	if( numDeps ) {
+		QMutex_Lock( jobs.graphMutex );
+		for( i = 0; i < numDeps; i++ ) {
+			dep = deps[i];
+			if( !dep || dep->done ) {
+				continue;
+			}
+
+			edge = Q_malloc( sizeof( *edge ) );
+			edge->job = job;
+			edge->next = dep->dependents;
+			dep->dependents = edge;
+			QAtomic_Add( &job->pendingDeps, 1 );
+		}
+		QMutex_Unlock( jobs.graphMutex );
+	}
+
+	QJobs_ReleaseDependency( job );
+
+	return job;
+}
+
+/*
+* QJob_Schedule
+*
+* Schedules the function to be called for the [0, items) range, split into
+* chunks no larger than grain items, once all the dependencies have completed.
+* The returned handle must be released with QJob_Release.
+*/
+qjob_t *QJob_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+					   unsigned items, unsigned grain, qjob_t **deps, unsigned numDeps ) {
+	return QJobs_Schedule( func, arg, items, grain, deps, numDeps, false );
+}
+
+/*
+* QJob_ScheduleBackground
+*
+* Like QJob_Schedule, for long running work nobody is going to wait on
+* during a frame. Workers only run it when they have nothing else to do.
+*/
+qjob_t *QJob_ScheduleBackground( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+								 unsigned items, unsigned grain, qjob_t **deps, unsigned numDeps ) {
+	return QJobs_Schedule( func, arg, items, grain, deps, numDeps, true );
+}
+
+/*
+* QJob_Wait
+*
+* Blocks until the job has completed, running pending tasks on the calling
+* thread in the meantime. Background tasks are only run if they belong to the
+* awaited job, or if there are no workers to run them.
+*/
+void QJob_Wait( qjob_t *job ) {
+	bool found;
+	qjobtask_t task;
+
+	if( !job ) {
+		return;
+	}
+
+	while( !QAtomic_CAS( &job->done, 1, 1 ) ) {
+		found = QJobs_RunTask( -1, jobs.numWorkers == 0 );
+
+		if( !found && job->background && QJobs_TakeJobTask( &jobs.background, job, &task ) ) {
+			QAtomic_Add( &jobs.pendingTasks, -1 );
+			QJobs_ExecuteTask( -1, &task );
+			found = true;
+		}
+
+		if( !found ) {
+			QThread_Yield();
+		}
+	}
+}
+
+/*
+* QJob_Done
+*
+* Returns true if the job has completed, never blocks.
+*/
+bool QJob_Done( qjob_t *job ) {
+	if( !job ) {
+		return true;
+	}
+	return QAtomic_CAS( &job->done, 1, 1 );
+}
+
+/*
+* QJob_Release
+*/
+void QJob_Release( qjob_t **pjob ) {
+	qjob_t *job;
+
+	assert( pjob != NULL );
+	if( !pjob ) {
+		return;
+	}
+
+	job = *pjob;
+	*pjob = NULL;
+
+	if( job ) {
+		QJobs_Unref( job );
+	}
+}
+
+/*
+* QJobs_ParallelFor
+*/
+void QJobs_ParallelFor( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+						unsigned items, unsigned grain ) {
+	qjob_t *job;
+
+	if( !items ) {
+		return;
+	}
+
+	job = QJob_Schedule( func, arg, items, grain, NULL, 0 );
+	QJob_Wait( job );
+	QJob_Release( &job );
+}
+
+// ============================================================================
+
+#define QJOBS_BENCH_CHAIN   256
+
+typedef struct {
+	float *out;
+	volatile int counter;
+} qjobbench_t;
+
+/*
+* QJobs_BenchWork
+*/
+static void QJobs_BenchWork( unsigned first, unsigned items, void *arg ) {
+	unsigned i;
+	qjobbench_t *bench = arg;
+
+	for( i = first; i < first + items; i++ ) {
+		bench->out[i] = sqrt( (float)i ) * sin( (float)i ) + cos( (float)i );
+	}
+}
+
+/*
+* QJobs_BenchEmpty
+*/
+static void QJobs_BenchEmpty( unsigned first, unsigned items, void *arg ) {
+	qjobbench_t *bench = arg;
+
+	QAtomic_Add( &bench->counter, items );
+}
+
+/*
+* QJobs_Benchmark_f
+*/
+static void QJobs_Benchmark_f( void ) {
+	int i;
+	unsigned numItems, grain;
+	uint64_t start, serial;
+	qjobbench_t bench;
+	qjob_t *chain[QJOBS_BENCH_CHAIN];
+
+	numItems = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 0;
+	if( !numItems ) {
+		numItems = 1 << 20;
+	}
+
+	memset( &bench, 0, sizeof( bench ) );
+	bench.out = Q_malloc( numItems * sizeof( *bench.out ) );
+
+	Com_Printf( "Job scheduler benchmark, %i worker threads, %u items\n", jobs.numWorkers, numItems );
+
+	start = Sys_Microseconds();
+	QJobs_BenchWork( 0, numItems, &bench );
+	serial = Sys_Microseconds() - start;
+	Com_Printf( "serial: %" PRIu64 "us\n", serial );
+
+	for( grain = 64; grain <= numItems && grain <= 65536; grain *= 8 ) {
+		start = Sys_Microseconds();
+		QJobs_ParallelFor( QJobs_BenchWork, &bench, numItems, grain );
+		Com_Printf( "parallel for, grain %u: %" PRIu64 "us\n", grain, Sys_Microseconds() - start );
+	}
+
+	// scheduling overhead: a lot of tiny independent jobs
+	start = Sys_Microseconds();
+	QJobs_ParallelFor( QJobs_BenchEmpty, &bench, numItems, 1 );
+	Com_Printf( "%u empty tasks: %" PRIu64 "us\n", numItems, Sys_Microseconds() - start );
+
+	// dependency latency: each job waits for the previous one
+	bench.counter = 0;
+	start = Sys_Microseconds();
+	for( i = 0; i < QJOBS_BENCH_CHAIN; i++ ) {
+		chain[i] = QJob_Schedule( QJobs_BenchEmpty, &bench, 1, 1, i ? &chain[i - 1] : NULL, i ? 1 : 0 );
+	}
+	QJob_Wait( chain[QJOBS_BENCH_CHAIN - 1] );
+	Com_Printf( "%i chained jobs: %" PRIu64 "us\n", QJOBS_BENCH_CHAIN, Sys_Microseconds() - start );
+
+	for( i = 0; i < QJOBS_BENCH_CHAIN; i++ ) {
+		QJob_Wait( chain[i] );
+		QJob_Release( &chain[i] );
+	}
+
+	Q_free( bench.out );
+}
@@ -18,6 +18,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#if defined( __linux__ ) && !defined( __ANDROID__ )
+#   ifndef _GNU_SOURCE
+#       define _GNU_SOURCE // sendmmsg
+#   endif
+#   define USE_SENDMMSG
+#endif
+
 #include "qcommon.h"
 
 #include "sys_net.h"
@@ -49,6 +56,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #   define MSG_NOSIGNAL 0
 #endif
 
+#define MAX_SEND_BATCH  64
+
 
 typedef struct {
 	uint8_t data[MAX_MSGLEN];
@@ -386,6 +395,71 @@ static bool NET_UDP_SendPacket( const socket_t *socket, const void *data, size_t
 	return true;
 }
 
+/*
+* NET_UDP_SendPacketToAddresses
+*
+* Sends the same datagram to each address, with as few system calls as possible
+*/
+static int NET_UDP_SendPacketToAddresses( const socket_t *socket, const void *data, size_t length, const netadr_t *addresses, int numAddresses ) {
+#ifdef USE_SENDMMSG
+	struct sockaddr_storage addr[MAX_SEND_BATCH];
+	struct mmsghdr msgs[MAX_SEND_BATCH];
+	struct iovec iov;
+	int i, n, ret, sent = 0;
+
+	assert( socket && socket->open && socket->type == SOCKET_UDP );
+	assert( data );
+	assert( length > 0 );
+
+	iov.iov_base = (void *)data;
+	iov.iov_len = length;
+
+	for( i = 0; i < numAddresses; ) {
+		for( n = 0; n < MAX_SEND_BATCH && i + n < numAddresses; n++ ) {
+			if( !AddressToSockaddress( &addresses[i + n], &addr[n] ) ) {
+				break;
+			}
+
+			memset( &msgs[n], 0, sizeof( msgs[n] ) );
+			msgs[n].msg_hdr.msg_name = &addr[n];
+			msgs[n].msg_hdr.msg_namelen = ( addr[n].ss_family == AF_INET6 ? sizeof( struct sockaddr_in6 ) : sizeof( struct sockaddr_in ) );
+			msgs[n].msg_hdr.msg_iov = &iov;
+			msgs[n].msg_hdr.msg_iovlen = 1;
+		}
+
+		if( !n ) {
+			// skip the bad address, fakeclients don't need to be sent anything
+			if( addresses[i].type == NA_NOTRANSMIT ) {
+				sent++;
+			}
+			i++;
+			continue;
+		}
+
+		ret = sendmmsg( socket->handle, msgs, n, 0 );
+		if( ret == SOCKET_ERROR ) {
+			NET_SetErrorStringFromLastError( "sendmmsg" );
+			break;
+		}
+
+		i += ret;
+		sent += ret;
+	}
+
+	return sent;
+#else
+	int i, sent = 0;
+
+	for( i = 0; i < numAddresses; i++ ) {
+		if( addresses[i].type == NA_NOTRANSMIT || NET_UDP_SendPacket( socket, data, length, &addresses[i] ) ) {
+			sent++;
+		}
+	}
+
+	return sent;
+#endif
+}
+
 /*
 * NET_IP_OpenSocket
 */
@@ -1027,6 +1101,33 @@ bool NET_SendPacket( const socket_t *socket, const void *data, size_t length, co
 	}
 }
 
+/*
+* NET_SendPacketToAddresses
+*
+* Returns the number of addresses the packet was sent to
+*/
+int NET_SendPacketToAddresses( const socket_t *socket, const void *data, size_t length, const netadr_t *addresses, int numAddresses ) {
+	int i, sent;
+
+	assert( socket->open );
+
+	if( !socket->open ) {
+		return 0;
+	}
+
+	if( socket->type == SOCKET_UDP ) {
+		return NET_UDP_SendPacketToAddresses( socket, data, length, addresses, numAddresses );
+	}
+
+	for( i = 0, sent = 0; i < numAddresses; i++ ) {
+		if( NET_SendPacket( socket, data, length, &addresses[i] ) ) {
+			sent++;
+		}
+	}
+
+	return sent;
+}
+
 /*
 * NET_Send
 */
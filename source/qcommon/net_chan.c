@@ -107,6 +107,27 @@ void Netchan_OutOfBand( const socket_t *socket, const netadr_t *address, size_t
 	}
 }
 
+/*
+* Netchan_OutOfBandToAddresses
+*
+* Sends the same out-of-band datagram to multiple addresses
+*/
+void Netchan_OutOfBandToAddresses( const socket_t *socket, const netadr_t *addresses, int numAddresses, size_t length, const uint8_t *data ) {
+	msg_t send;
+	uint8_t send_buf[MAX_PACKETLEN];
+
+	// write the packet header
+	MSG_Init( &send, send_buf, sizeof( send_buf ) );
+
+	MSG_WriteInt32( &send, -1 ); // -1 sequence means out of band
+	MSG_WriteData( &send, data, length );
+
+	// send the datagrams
+	if( NET_SendPacketToAddresses( socket, send.data, send.cursize, addresses, numAddresses ) < numAddresses ) {
+		Com_Printf( "NET_SendPacketToAddresses: Error: %s\n", NET_ErrorString() );
+	}
+}
+
 /*
 * Netchan_OutOfBandPrint
 *
@@ -136,6 +136,10 @@ void Com_FreePureList( purelist_t **purelist );
 //============================================================================
 
 #define SNAP_MAX_DEMO_META_DATA_SIZE    4 * 1024
+#define SNAP_DEMO_KEYFRAME_INTERVAL     5000    // msecs between the non-delta frames recorded for seeking
+
+struct demoindex_s;
+struct demostream_s;
 
 void SNAP_ParseBaseline( msg_t *msg, entity_state_t *baselines );
 void SNAP_SkipFrame( msg_t *msg, struct snapshot_s *header );
@@ -152,17 +156,36 @@ void SNAP_BuildClientFrameSnap( struct cmodel_state_s *cms, struct ginfo_s *gi,
 
 void SNAP_FreeClientFrames( struct client_s *client );
 
-void SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset );
-int SNAP_ReadDemoMessage( int demofile, msg_t *msg );
-void SNAP_BeginDemoRecording( int demofile, unsigned int spawncount, unsigned int snapFrameTime,
+void SNAP_RecordDemoMessage( struct demostream_s *demofile, msg_t *msg, int offset );
+int SNAP_ReadDemoMessage( struct demostream_s *demofile, msg_t *msg );
+void SNAP_BeginDemoRecording( struct demostream_s *demofile, unsigned int spawncount, unsigned int snapFrameTime,
 							  const char *sv_name, unsigned int sv_bitflags, purelist_t *purelist,
 							  char *configstrings, entity_state_t *baselines );
-void SNAP_StopDemoRecording( int demofile );
+void SNAP_StopDemoRecording( struct demostream_s *demofile, const struct demoindex_s *index );
 void SNAP_WriteDemoMetaData( const char *filename, const char *meta_data, size_t meta_data_realsize );
 size_t SNAP_ClearDemoMeta( char *meta_data, size_t meta_data_max_size );
 size_t SNAP_SetDemoMetaKeyValue( char *meta_data, size_t meta_data_max_size, size_t meta_data_realsize,
 								 const char *key, const char *value );
-size_t SNAP_ReadDemoMetaData( int demofile, char *meta_data, size_t meta_data_size );
+size_t SNAP_ReadDemoMetaData( struct demostream_s *demofile, char *meta_data, size_t meta_data_size );
+struct demoindex_s *SNAP_CreateDemoIndex( void );
+void SNAP_FreeDemoIndex( struct demoindex_s *index );
+int SNAP_NumDemoKeyframes( const struct demoindex_s *index );
+bool SNAP_DemoKeyframeDue( const struct demoindex_s *index, int64_t serverTime );
+void SNAP_AddDemoKeyframe( struct demoindex_s *index, int offset, int64_t serverTime, const char *configstrings );
+int SNAP_FindDemoKeyframe( const struct demoindex_s *index, int64_t serverTime, int64_t *keyframeTime, char *configstrings );
+void SNAP_WriteDemoIndex( struct demostream_s *demofile, const struct demoindex_s *index );
+struct demoindex_s *SNAP_ReadDemoIndex( struct demostream_s *demofile );
+struct demoindex_s *SNAP_BuildDemoIndex( struct demostream_s *demofile, int *end );
+
+// demostream.c
+struct demostream_s *DemoStream_Open( int file, int mode, int level );
+void DemoStream_Close( struct demostream_s **ps );
+int DemoStream_Read( struct demostream_s *s, void *buffer, size_t len );
+int DemoStream_Write( struct demostream_s *s, const void *buffer, size_t len );
+int DemoStream_Tell( struct demostream_s *s );
+int DemoStream_Seek( struct demostream_s *s, int offset, int whence );
+int DemoStream_Flush( struct demostream_s *s, bool store );
+bool DemoStream_Rewrite( int file, const void *data, size_t size );
 
 //============================================================================
 
@@ -476,6 +499,7 @@ int         NET_Accept( const socket_t *socket, socket_t *newsocket, netadr_t *a
 
 int         NET_GetPacket( const socket_t *socket, netadr_t *address, msg_t *message );
 bool        NET_SendPacket( const socket_t *socket, const void *data, size_t length, const netadr_t *address );
+int         NET_SendPacketToAddresses( const socket_t *socket, const void *data, size_t length, const netadr_t *addresses, int numAddresses );
 
 int         NET_Get( const socket_t *socket, netadr_t *address, void *data, size_t length );
 int         NET_Send( const socket_t *socket, const void *data, size_t length, const netadr_t *address );
@@ -558,6 +582,7 @@ bool Netchan_TransmitNextFragment( netchan_t *chan );
 int Netchan_CompressMessage( msg_t *msg );
 int Netchan_DecompressMessage( msg_t *msg );
 void Netchan_OutOfBand( const socket_t *socket, const netadr_t *address, size_t length, const uint8_t *data );
+void Netchan_OutOfBandToAddresses( const socket_t *socket, const netadr_t *addresses, int numAddresses, size_t length, const uint8_t *data );
 
 #ifndef _MSC_VER
 void Netchan_OutOfBandPrint( const socket_t *socket, const netadr_t *address, const char *format, ... ) __attribute__( ( format( printf, 3, 4 ) ) );
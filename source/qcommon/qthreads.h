@@ -35,6 +35,9 @@ typedef struct qcondvar_s qcondvar_t;
 struct qbufPipe_s;
 typedef struct qbufPipe_s qbufPipe_t;
 
+struct qjob_s;
+typedef struct qjob_s qjob_t;
+
 qmutex_t *QMutex_Create( void );
 void QMutex_Destroy( qmutex_t **pmutex );
 void QMutex_Lock( qmutex_t *mutex );
@@ -63,4 +66,17 @@ void QBufPipe_Wait( qbufPipe_t *queue, int ( *read )( qbufPipe_t *, unsigned( **
 int QAtomic_Add( volatile int *value, int add );
 bool QAtomic_CAS( volatile int *value, int oldval, int newval );
 
+void QJobs_Init( void );
+void QJobs_Shutdown( void );
+int QJobs_NumWorkers( void );
+qjob_t *QJob_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+					   unsigned items, unsigned grain, qjob_t **deps, unsigned numDeps );
+qjob_t *QJob_ScheduleBackground( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+								 unsigned items, unsigned grain, qjob_t **deps, unsigned numDeps );
+void QJob_Wait( qjob_t *job );
+bool QJob_Done( qjob_t *job );
+void QJob_Release( qjob_t **pjob );
+void QJobs_ParallelFor( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+						unsigned items, unsigned grain );
+
 #endif // Q_THREADS_H
@@ -19,6 +19,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "qcommon.h"
+#include "snap_read.h"
 
 #define DEMO_SAFEWRITE( demofile,msg,force ) \
 	if( force || ( msg )->cursize > ( msg )->maxsize / 2 ) \
@@ -27,14 +28,47 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 		MSG_Clear( msg ); \
 	}
 
+// The keyframe index is written after the end of demo marker, so older clients
+// never read it. It lists the non-delta frames that recorders emit every
+// SNAP_DEMO_KEYFRAME_INTERVAL msecs, with the configstrings that changed since
+// the previous keyframe, so a player can seek to any of them without replaying
+// the demo from the start. The index ends with a fixed size footer:
+//
+// [int32 numKeyframes] [int32 index start] [int32 version] [int32 magic]
+
+#define DEMO_INDEX_MAGIC            ( 'Q' | ( 'D' << 8 ) | ( 'I' << 16 ) | ( 'X' << 24 ) )
+#define DEMO_INDEX_VERSION          1
+#define DEMO_INDEX_FOOTER_SIZE      16
+#define DEMO_INDEX_MAX_SIZE         ( 64 * 1024 * 1024 )
+
+typedef struct {
+	int64_t serverTime;
+	int offset;                     // of the demo message with the non-delta frame
+	int numConfigstrings;
+	size_t csOffset, csSize;        // configstring changes in data
+} demokeyframe_t;
+
+typedef struct demoindex_s {
+	int numKeyframes, maxKeyframes;
+	demokeyframe_t *keyframes;
+
+	// [int16 index] [string] for each changed configstring, as written to the file
+	size_t dataSize, maxDataSize;
+	uint8_t *data;
+
+	// recording: configstrings as of the last keyframe
+	char *configstrings;
+} demoindex_t;
+
 static char dummy_meta_data[SNAP_MAX_DEMO_META_DATA_SIZE];
+static uint8_t demo_msg_buffer[4 + MAX_MSGLEN];
 
 /*
 * SNAP_RecordDemoMessage
 *
 * Writes given message to demofile
 */
-void SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset ) {
+void SNAP_RecordDemoMessage( struct demostream_s *demofile, msg_t *msg, int offset ) {
 	int len;
 
 	if( !demofile ) {
@@ -43,21 +77,23 @@ void SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset ) {
 
 	// now write the entire message to the file, prefixed by length
 	len = LittleLong( msg->cursize ) - offset;
-	if( len <= 0 ) {
+	if( len <= 0 || len > MAX_MSGLEN ) {
 		return;
 	}
 
-	FS_Write( &len, 4, demofile );
-	FS_Write( msg->data + offset, len, demofile );
+	// in a single write, so compressed chunks end on message boundaries
+	memcpy( demo_msg_buffer, &len, 4 );
+	memcpy( demo_msg_buffer + 4, msg->data + offset, len );
+	DemoStream_Write( demofile, demo_msg_buffer, len + 4 );
 }
 
 /*
 * SNAP_ReadDemoMessage
 */
-int SNAP_ReadDemoMessage( int demofile, msg_t *msg ) {
+int SNAP_ReadDemoMessage( struct demostream_s *demofile, msg_t *msg ) {
 	int read = 0, msglen = -1;
 
-	read += FS_Read( &msglen, 4, demofile );
+	read += DemoStream_Read( demofile, &msglen, 4 );
 
 	msglen = LittleLong( msglen );
 	if( msglen == -1 ) {
@@ -71,7 +107,7 @@ int SNAP_ReadDemoMessage( int demofile, msg_t *msg ) {
 		Com_Error( ERR_DROP, "Error reading demo file: msglen > msg->maxsize" );
 	}
 
-	read = FS_Read( msg->data, msglen, demofile );
+	read = DemoStream_Read( demofile, msg->data, msglen );
 	if( read != msglen ) {
 		Com_Error( ERR_DROP, "Error reading demo file: End of file" );
 	}
@@ -126,19 +162,22 @@ static void SNAP_DemoMetaDataMessage( msg_t *msg, const char *meta_data, size_t
 
 /*
 * SNAP_RecordDemoMetaDataMessage
+*
+* The meta data message is kept uncompressed on its own, so it can be rewritten
+* when the recording stops.
 */
-static void SNAP_RecordDemoMetaDataMessage( int demofile, msg_t *msg ) {
-	FS_Flush( demofile );
+static void SNAP_RecordDemoMetaDataMessage( struct demostream_s *demofile, msg_t *msg ) {
+	DemoStream_Flush( demofile, false );
 
 	DEMO_SAFEWRITE( demofile, msg, true );
 
-	FS_Flush( demofile );
+	DemoStream_Flush( demofile, true );
 }
 
 /*
 * SNAP_BeginDemoRecording
 */
-void SNAP_BeginDemoRecording( int demofile, unsigned int spawncount, unsigned int snapFrameTime,
+void SNAP_BeginDemoRecording( struct demostream_s *demofile, unsigned int spawncount, unsigned int snapFrameTime,
 							  const char *sv_name, unsigned int sv_bitflags, purelist_t *purelist, char *configstrings,
 							  entity_state_t *baselines ) {
 	unsigned int i;
@@ -295,31 +334,533 @@ done:
 	return meta_data_realsize;
 }
 
+/*
+* SNAP_CreateDemoIndex
+*/
+demoindex_t *SNAP_CreateDemoIndex( void ) {
+	demoindex_t *index;
+
+	index = Mem_ZoneMalloc( sizeof( *index ) );
+	index->configstrings = Mem_ZoneMalloc( MAX_CONFIGSTRINGS * MAX_CONFIGSTRING_CHARS );
+	return index;
+}
+
+/*
+* SNAP_FreeDemoIndex
+*/
+void SNAP_FreeDemoIndex( demoindex_t *index ) {
+	if( !index ) {
+		return;
+	}
+
+	if( index->keyframes ) {
+		Mem_ZoneFree( index->keyframes );
+	}
+	if( index->data ) {
+		Mem_ZoneFree( index->data );
+	}
+	if( index->configstrings ) {
+		Mem_ZoneFree( index->configstrings );
+	}
+	Mem_ZoneFree( index );
+}
+
+/*
+* SNAP_DemoIndexData
+*
+* Makes room for size more bytes of configstring changes.
+*/
+static uint8_t *SNAP_DemoIndexData( demoindex_t *index, size_t size ) {
+	uint8_t *data;
+
+	if( index->dataSize + size > index->maxDataSize ) {
+		index->maxDataSize = max( index->maxDataSize * 2, index->dataSize + size + 4096 );
+		if( index->data ) {
+			index->data = Mem_Realloc( index->data, index->maxDataSize );
+		} else {
+			index->data = Mem_ZoneMalloc( index->maxDataSize );
+		}
+	}
+
+	data = index->data + index->dataSize;
+	index->dataSize += size;
+	return data;
+}
+
+/*
+* SNAP_NewDemoKeyframe
+*/
+static demokeyframe_t *SNAP_NewDemoKeyframe( demoindex_t *index ) {
+	demokeyframe_t *keyframe;
+
+	if( index->numKeyframes == index->maxKeyframes ) {
+		index->maxKeyframes = max( index->maxKeyframes * 2, 64 );
+		if( index->keyframes ) {
+			index->keyframes = Mem_Realloc( index->keyframes, index->maxKeyframes * sizeof( demokeyframe_t ) );
+		} else {
+			index->keyframes = Mem_ZoneMalloc( index->maxKeyframes * sizeof( demokeyframe_t ) );
+		}
+	}
+
+	keyframe = &index->keyframes[index->numKeyframes++];
+	memset( keyframe, 0, sizeof( *keyframe ) );
+	return keyframe;
+}
+
+/*
+* SNAP_NumDemoKeyframes
+*/
+int SNAP_NumDemoKeyframes( const demoindex_t *index ) {
+	return index ? index->numKeyframes : 0;
+}
+
+/*
+* SNAP_DemoKeyframeDue
+*
+* Whether the recorder should write a non-delta frame for the index.
+*/
+bool SNAP_DemoKeyframeDue( const demoindex_t *index, int64_t serverTime ) {
+	if( !index ) {
+		return false;
+	}
+	if( !index->numKeyframes ) {
+		return true;
+	}
+	return serverTime >= index->keyframes[index->numKeyframes - 1].serverTime + SNAP_DEMO_KEYFRAME_INTERVAL;
+}
+
+/*
+* SNAP_AddDemoKeyframe
+*
+* Adds the non-delta frame in the demo message at offset to the index.
+* The configstrings must be the ones the client has after parsing that message.
+*/
+void SNAP_AddDemoKeyframe( demoindex_t *index, int offset, int64_t serverTime, const char *configstrings ) {
+	int i;
+	size_t len;
+	short num;
+	uint8_t *data;
+	demokeyframe_t *keyframe;
+
+	if( !index ) {
+		return;
+	}
+
+	keyframe = SNAP_NewDemoKeyframe( index );
+	keyframe->serverTime = serverTime;
+	keyframe->offset = offset;
+	keyframe->csOffset = index->dataSize;
+
+	for( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		const char *cs = configstrings + i * MAX_CONFIGSTRING_CHARS;
+		char *indexcs = index->configstrings + i * MAX_CONFIGSTRING_CHARS;
+
+		if( !strncmp( cs, indexcs, MAX_CONFIGSTRING_CHARS ) ) {
+			continue;
+		}
+
+		Q_strncpyz( indexcs, cs, MAX_CONFIGSTRING_CHARS );
+		len = strlen( indexcs ) + 1;
+
+		num = LittleShort( i );
+		data = SNAP_DemoIndexData( index, sizeof( num ) + len );
+		memcpy( data, &num, sizeof( num ) );
+		memcpy( data + sizeof( num ), indexcs, len );
+		keyframe->numConfigstrings++;
+	}
+
+	keyframe->csSize = index->dataSize - keyframe->csOffset;
+}
+
+/*
+* SNAP_FindDemoKeyframe
+*
+* Returns the offset of the last keyframe before serverTime, or -1 if there's none.
+* Fills configstrings with the ones the client has after reading the keyframe.
+*/
+int SNAP_FindDemoKeyframe( const demoindex_t *index, int64_t serverTime, int64_t *keyframeTime, char *configstrings ) {
+	int i, j, first, last, mid;
+	msg_t msg;
+	const demokeyframe_t *keyframe;
+
+	if( !index || !index->numKeyframes || index->keyframes[0].serverTime >= serverTime ) {
+		return -1;
+	}
+
+	// binary search for the last keyframe that's earlier than serverTime
+	first = 0;
+	last = index->numKeyframes - 1;
+	while( first < last ) {
+		mid = ( first + last + 1 ) / 2;
+		if( index->keyframes[mid].serverTime < serverTime ) {
+			first = mid;
+		} else {
+			last = mid - 1;
+		}
+	}
+
+	keyframe = &index->keyframes[first];
+	if( keyframeTime ) {
+		*keyframeTime = keyframe->serverTime;
+	}
+
+	if( configstrings ) {
+		memset( configstrings, 0, MAX_CONFIGSTRINGS * MAX_CONFIGSTRING_CHARS );
+
+		for( i = 0; i <= first; i++ ) {
+			const demokeyframe_t *k = &index->keyframes[i];
+
+			MSG_Init( &msg, index->data + k->csOffset, k->csSize );
+			msg.cursize = k->csSize;
+
+			for( j = 0; j < k->numConfigstrings; j++ ) {
+				int num = MSG_ReadInt16( &msg );
+				const char *cs = MSG_ReadString( &msg );
+				Q_strncpyz( configstrings + num * MAX_CONFIGSTRING_CHARS, cs, MAX_CONFIGSTRING_CHARS );
+			}
+		}
+	}
+
+	return keyframe->offset;
+}
+
+/*
+* SNAP_WriteDemoIndex
+*
+* Writes the keyframe index at the current position, which should be right after the end of demo marker.
+*/
+void SNAP_WriteDemoIndex( struct demostream_s *demofile, const demoindex_t *index ) {
+	int i, start;
+	msg_t msg;
+	uint8_t msg_buffer[32];
+	const demokeyframe_t *keyframe;
+
+	if( !index || !index->numKeyframes ) {
+		return;
+	}
+
+	start = DemoStream_Tell( demofile );
+
+	for( i = 0; i < index->numKeyframes; i++ ) {
+		keyframe = &index->keyframes[i];
+
+		MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
+		MSG_WriteInt64( &msg, keyframe->serverTime );
+		MSG_WriteInt32( &msg, keyframe->offset );
+		MSG_WriteInt32( &msg, keyframe->numConfigstrings );
+		DemoStream_Write( demofile, msg.data, msg.cursize );
+
+		if( keyframe->csSize ) {
+			DemoStream_Write( demofile, index->data + keyframe->csOffset, keyframe->csSize );
+		}
+	}
+
+	MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
+	MSG_WriteInt32( &msg, index->numKeyframes );
+	MSG_WriteInt32( &msg, start );
+	MSG_WriteInt32( &msg, DEMO_INDEX_VERSION );
+	MSG_WriteInt32( &msg, DEMO_INDEX_MAGIC );
+	DemoStream_Write( demofile, msg.data, msg.cursize );
+}
+
+/*
+* SNAP_ReadDemoIndex
+*
+* Returns NULL if the demo has no valid index. The file position is undefined afterwards.
+*/
+demoindex_t *SNAP_ReadDemoIndex( struct demostream_s *demofile ) {
+	int i, j, length, start, numKeyframes, marker;
+	size_t size;
+	msg_t msg;
+	uint8_t footer[DEMO_INDEX_FOOTER_SIZE];
+	demoindex_t *index;
+	demokeyframe_t *keyframe;
+
+	if( DemoStream_Seek( demofile, 0, FS_SEEK_END ) < 0 ) {
+		return NULL;
+	}
+	length = DemoStream_Tell( demofile );
+	if( length < DEMO_INDEX_FOOTER_SIZE + 4 ) {
+		return NULL;
+	}
+
+	DemoStream_Seek( demofile, length - DEMO_INDEX_FOOTER_SIZE, FS_SEEK_SET );
+	if( DemoStream_Read( demofile, footer, sizeof( footer ) ) != sizeof( footer ) ) {
+		return NULL;
+	}
+
+	MSG_Init( &msg, footer, sizeof( footer ) );
+	msg.cursize = sizeof( footer );
+	numKeyframes = MSG_ReadInt32( &msg );
+	start = MSG_ReadInt32( &msg );
+	if( MSG_ReadInt32( &msg ) != DEMO_INDEX_VERSION || MSG_ReadInt32( &msg ) != DEMO_INDEX_MAGIC ) {
+		return NULL;
+	}
+
+	size = length - DEMO_INDEX_FOOTER_SIZE - start;
+	if( numKeyframes <= 0 || start < 4 || start > length - DEMO_INDEX_FOOTER_SIZE || size > DEMO_INDEX_MAX_SIZE ) {
+		return NULL;
+	}
+
+	// the index must follow the end of demo marker
+	DemoStream_Seek( demofile, start - 4, FS_SEEK_SET );
+	if( DemoStream_Read( demofile, &marker, 4 ) != 4 || LittleLong( marker ) != -1 ) {
+		return NULL;
+	}
+
+	index = Mem_ZoneMalloc( sizeof( *index ) );
+	index->data = Mem_ZoneMalloc( size + 1 );
+	index->dataSize = index->maxDataSize = size;
+	if( DemoStream_Read( demofile, index->data, size ) != (int)size ) {
+		SNAP_FreeDemoIndex( index );
+		return NULL;
+	}
+
+	MSG_Init( &msg, index->data, size );
+	msg.cursize = size;
+
+	for( i = 0; i < numKeyframes; i++ ) {
+		keyframe = SNAP_NewDemoKeyframe( index );
+		keyframe->serverTime = MSG_ReadInt64( &msg );
+		keyframe->offset = MSG_ReadInt32( &msg );
+		keyframe->numConfigstrings = MSG_ReadInt32( &msg );
+		keyframe->csOffset = msg.readcount;
+
+		if( msg.readcount > msg.cursize || keyframe->offset < 0 || keyframe->offset >= start || keyframe->numConfigstrings < 0 ||
+			( i && keyframe->serverTime < keyframe[-1].serverTime ) ) {
+			break;
+		}
+
+		for( j = 0; j < keyframe->numConfigstrings; j++ ) {
+			int num = MSG_ReadInt16( &msg );
+			MSG_ReadString( &msg );
+			if( num < 0 || num >= MAX_CONFIGSTRINGS || msg.readcount > msg.cursize ) {
+				break;
+			}
+		}
+		if( j < keyframe->numConfigstrings ) {
+			break;
+		}
+
+		keyframe->csSize = msg.readcount - keyframe->csOffset;
+	}
+
+	if( i < numKeyframes ) {
+		Com_Printf( "Invalid demo keyframe index\n" );
+		SNAP_FreeDemoIndex( index );
+		return NULL;
+	}
+
+	return index;
+}
+
+/*
+* SNAP_DemoIndexConfigstrings
+*
+* Applies a "cs <index> <string> ..." server command.
+*/
+static void SNAP_DemoIndexConfigstrings( const char *command, char *configstrings ) {
+	int num;
+	const char *token;
+
+	token = COM_Parse( &command );
+	if( strcmp( token, "cs" ) ) {
+		return;
+	}
+
+	while( true ) {
+		token = COM_Parse( &command );
+		if( !command ) {
+			break;
+		}
+		num = atoi( token );
+
+		token = COM_Parse( &command );
+		if( !command ) {
+			break;
+		}
+		if( num >= 0 && num < MAX_CONFIGSTRINGS ) {
+			Q_strncpyz( configstrings + num * MAX_CONFIGSTRING_CHARS, token, MAX_CONFIGSTRING_CHARS );
+		}
+	}
+}
+
+/*
+* SNAP_BuildDemoIndex
+*
+* Scans a whole demo for non-delta frames, for demos recorded without an index.
+* Keyframes are only as frequent as the non-delta frames the demo happens to have.
+* Sets end to the offset of the end of demo marker, or of the end of the last
+* complete message if there's none. Returns NULL if the demo can't be parsed.
+*/
+demoindex_t *SNAP_BuildDemoIndex( struct demostream_s *demofile, int *end ) {
+	int i, len, skip, offset, cmd, cmdNum, lastCmdNum;
+	int64_t keyframeTime;
+	bool keyframe;
+	msg_t msg;
+	static uint8_t msg_buffer[MAX_MSGLEN];
+	static snapshot_t frame;
+	char *configstrings;
+	demoindex_t *index;
+
+	index = SNAP_CreateDemoIndex();
+	configstrings = Mem_ZoneMalloc( MAX_CONFIGSTRINGS * MAX_CONFIGSTRING_CHARS );
+	lastCmdNum = 0;
+
+	DemoStream_Seek( demofile, 0, FS_SEEK_SET );
+
+	while( true ) {
+		offset = *end = DemoStream_Tell( demofile );
+
+		if( DemoStream_Read( demofile, &len, 4 ) != 4 ) {
+			break;
+		}
+		len = LittleLong( len );
+		if( len == -1 ) {
+			break;
+		}
+		if( len < 0 || len > MAX_MSGLEN || DemoStream_Read( demofile, msg_buffer, len ) != len ) {
+			break;
+		}
+
+		MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
+		msg.cursize = len;
+		keyframe = false;
+		keyframeTime = 0;
+
+		while( msg.readcount < msg.cursize ) {
+			cmd = MSG_ReadUint8( &msg );
+			switch( cmd ) {
+				case svc_nop:
+					break;
+
+				case svc_servercmd:
+					cmdNum = MSG_ReadInt32( &msg );
+					if( cmdNum <= lastCmdNum ) {
+						MSG_ReadString( &msg );
+						break;
+					}
+					lastCmdNum = cmdNum;
+				// fall through
+				case svc_servercs:
+					SNAP_DemoIndexConfigstrings( MSG_ReadString( &msg ), configstrings );
+					break;
+
+				case svc_serverdata:
+					// as written by SNAP_BeginDemoRecording
+					MSG_ReadInt32( &msg ); // protocol
+					MSG_ReadInt32( &msg ); // spawncount
+					MSG_ReadInt16( &msg ); // snapFrameTime
+					MSG_ReadString( &msg ); // base game directory
+					MSG_ReadString( &msg ); // game directory
+					MSG_ReadInt16( &msg ); // playernum
+					MSG_ReadString( &msg ); // level name
+					if( MSG_ReadUint8( &msg ) & SV_BITFLAGS_HTTP ) {
+						Com_Printf( "Unexpected HTTP server in the demo server data\n" );
+						goto error;
+					}
+					for( i = MSG_ReadInt16( &msg ); i > 0; i-- ) {
+						MSG_ReadString( &msg );
+						MSG_ReadInt32( &msg );
+					}
+					break;
+
+				case svc_spawnbaseline:
+					SNAP_ParseBaseline( &msg, NULL );
+					break;
+
+				case svc_clcack:
+					MSG_ReadUintBase128( &msg );
+					MSG_ReadUintBase128( &msg );
+					break;
+
+				case svc_frame:
+					SNAP_SkipFrame( &msg, &frame );
+					if( !frame.delta && SNAP_DemoKeyframeDue( index, frame.serverTime ) ) {
+						keyframe = true;
+						keyframeTime = frame.serverTime;
+					}
+					break;
+
+				case svc_demoinfo:
+					skip = MSG_ReadInt32( &msg );
+					if( skip < 0 || !MSG_SkipData( &msg, skip ) ) {
+						msg.readcount = msg.cursize + 1;
+					}
+					break;
+
+				case svc_extension:
+					MSG_ReadUint8( &msg ); // extension id
+					MSG_ReadUint8( &msg ); // version number
+					skip = MSG_ReadInt16( &msg );
+					if( skip < 0 || !MSG_SkipData( &msg, skip ) ) {
+						msg.readcount = msg.cursize + 1;
+					}
+					break;
+
+				default:
+					Com_Printf( "Unexpected command %i in the demo message at %i\n", cmd, offset );
+					goto error;
+			}
+		}
+
+		if( msg.readcount > msg.cursize ) {
+			Com_Printf( "Bad demo message at %i\n", offset );
+			goto error;
+		}
+
+		if( keyframe ) {
+			SNAP_AddDemoKeyframe( index, offset, keyframeTime, configstrings );
+		}
+	}
+
+	Mem_ZoneFree( configstrings );
+	return index;
+
+error:
+	Mem_ZoneFree( configstrings );
+	SNAP_FreeDemoIndex( index );
+	return NULL;
+}
+
 /*
 * SNAP_StopDemoRecording
+*
+* Writes the end of demo marker, followed by the keyframe index if there's one.
 */
-void SNAP_StopDemoRecording( int demofile ) {
+void SNAP_StopDemoRecording( struct demostream_s *demofile, const demoindex_t *index ) {
 	int i;
 
 	// finishup
 	i = LittleLong( -1 );
-	FS_Write( &i, 4, demofile );
+	DemoStream_Write( demofile, &i, 4 );
+
+	SNAP_WriteDemoIndex( demofile, index );
 }
 
 /*
 * SNAP_WriteDemoMetaData
 */
 void SNAP_WriteDemoMetaData( const char *filename, const char *meta_data, size_t meta_data_realsize ) {
-	int filenum;
+	int filenum, len;
 	msg_t msg;
 	uint8_t msg_buffer[MAX_MSGLEN];
 
+	// the message is the same size as the one written when the recording started
 	MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
+	MSG_WriteInt32( &msg, 0 );
 
 	SNAP_DemoMetaDataMessage( &msg, meta_data, meta_data_realsize );
 
+	len = msg.cursize - 4;
+	msg.cursize = 0;
+	MSG_WriteInt32( &msg, len );
+	msg.cursize = len + 4;
+
 	if( FS_FOpenFile( filename, &filenum, FS_READ | FS_UPDATE ) != -1 ) {
-		SNAP_RecordDemoMetaDataMessage( filenum, &msg );
+		if( !DemoStream_Rewrite( filenum, msg.data, msg.cursize ) ) {
+			Com_Printf( "Failed to write the meta data of %s\n", filename );
+		}
 		FS_FCloseFile( filenum );
 	}
 }
@@ -329,7 +870,7 @@ void SNAP_WriteDemoMetaData( const char *filename, const char *meta_data, size_t
 *
 * Reads null-terminated meta information from a demo file into a string
 */
-size_t SNAP_ReadDemoMetaData( int demofile, char *meta_data, size_t meta_data_size ) {
+size_t SNAP_ReadDemoMetaData( struct demostream_s *demofile, char *meta_data, size_t meta_data_size ) {
 	char demoinfo;
 	int meta_data_ofs;
 	unsigned int meta_data_realsize, meta_data_fullsize;
@@ -339,34 +880,34 @@ size_t SNAP_ReadDemoMetaData( int demofile, char *meta_data, size_t meta_data_si
 	}
 
 	// fseek to zero byte, skipping initial msg length
-	if( FS_Seek( demofile, 0 + sizeof( int ), FS_SEEK_SET ) < 0 ) {
+	if( DemoStream_Seek( demofile, 0 + sizeof( int ), FS_SEEK_SET ) < 0 ) {
 		return 0;
 	}
 
 	// read svc_demoinfo
-	FS_Read( &demoinfo, 1, demofile );
+	DemoStream_Read( demofile, &demoinfo, 1 );
 	if( demoinfo != svc_demoinfo ) {
 		return 0;
 	}
 
 	// skip demoinfo length
-	FS_Seek( demofile, sizeof( int ), FS_SEEK_CUR );
+	DemoStream_Seek( demofile, sizeof( int ), FS_SEEK_CUR );
 
 	// read meta data offset
-	FS_Read( ( void * )&meta_data_ofs, sizeof( int ), demofile );
+	DemoStream_Read( demofile, ( void * )&meta_data_ofs, sizeof( int ) );
 	meta_data_ofs = LittleLong( meta_data_ofs );
 
-	if( FS_Seek( demofile, meta_data_ofs, FS_SEEK_CUR ) < 0 ) {
+	if( DemoStream_Seek( demofile, meta_data_ofs, FS_SEEK_CUR ) < 0 ) {
 		return 0;
 	}
 
-	FS_Read( ( void * )&meta_data_realsize, sizeof( int ), demofile );
-	FS_Read( ( void * )&meta_data_fullsize, sizeof( int ), demofile );
+	DemoStream_Read( demofile, ( void * )&meta_data_realsize, sizeof( int ) );
+	DemoStream_Read( demofile, ( void * )&meta_data_fullsize, sizeof( int ) );
 
 	meta_data_realsize = LittleLong( meta_data_realsize );
 	meta_data_fullsize = LittleLong( meta_data_fullsize );
 
-	FS_Read( ( void * )meta_data, min( meta_data_size, meta_data_realsize ), demofile );
+	DemoStream_Read( demofile, ( void * )meta_data, min( meta_data_size, meta_data_realsize ) );
 	meta_data[min( meta_data_realsize, meta_data_size - 1 )] = '\0'; // termination \0
 
 	return meta_data_realsize;
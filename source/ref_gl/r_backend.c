@@ -94,6 +94,8 @@ void RB_BeginRegistration( void ) {
 */
 void RB_EndRegistration( void ) {
 	RB_BindVBO( 0, 0 );
+
+	RP_UpdatePrecacheList();
 }
 
 /*
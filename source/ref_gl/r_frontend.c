@@ -25,25 +25,53 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 static ref_frontend_t rrf;
 static ref_cmdbuf_t *RF_GetNextAdapterFrame( ref_frontendAdapter_t *adapter );
 
+/*
+ * RF_AtomicLoad
+ *
+ * Reads a counter owned by the other side of the frame ring, with a full barrier so that
+ * everything written before the counter was advanced is visible as well.
+ */
+static inline int RF_AtomicLoad( volatile int *value )
+{
+	return ri.Atomic_Add( value, 0 );
+}
+
 /*
  * RF_AdapterFrame
  *
- * Handles polling for the next frame at fixed time intervals, yielding in between.
- * If vsync is enabled, only yields if got nothing to do.
+ * Runs the inter-frame commands and then the oldest queued frame. If there's no frame
+ * to process, waits for the frontend, unless running uncapped.
  */
 static void RF_AdapterFrame( ref_frontendAdapter_t *adapter )
 {
+	ref_frontend_t *fe = adapter->owner;
 	ref_cmdbuf_t *frame;
+	ref_frametimes_t *times;
+	uint64_t waitStart;
 
-	if( adapter->noWait )
-		adapter->cmdPipe->RunCmds( adapter->cmdPipe );
-	else
-		adapter->cmdPipe->WaitForCmds( adapter->cmdPipe, Q_THREADS_WAIT_INFINITE );
+	adapter->cmdPipe->RunCmds( adapter->cmdPipe );
 
 	frame = RF_GetNextAdapterFrame( adapter );
-	if( frame ) {
-		frame->RunCmds( frame );
+	if( !frame ) {
+		waitStart = ri.Sys_Microseconds();
+		if( !adapter->noWait ) {
+			adapter->cmdPipe->WaitForCmds( adapter->cmdPipe, Q_THREADS_WAIT_INFINITE );
+		}
+		adapter->stall += ri.Sys_Microseconds() - waitStart;
+		return;
 	}
+
+	times = &fe->frameTimes[adapter->framesDone % fe->numFrames];
+	times->consumerStall = adapter->stall;
+	times->start = ri.Sys_Microseconds();
+
+	frame->RunCmds( frame );
+
+	times->finish = ri.Sys_Microseconds();
+	adapter->stall = 0;
+
+	// hand the slot back to the frontend along with the timestamps
+	ri.Atomic_Add( &adapter->framesDone, 1 );
 }
 
 /*
@@ -71,10 +99,16 @@ static void *RF_AdapterThreadProc( void *param )
  */
 static void RF_AdapterWait( ref_frontendAdapter_t *adapter )
 {
+	ref_frontend_t *fe = adapter->owner;
+
 	if( adapter->thread == NULL ) {
 		return;
 	}
 
+	while( RF_AtomicLoad( &adapter->framesDone ) != fe->framesQueued ) {
+		ri.Thread_Yield();
+	}
+
 	adapter->cmdPipe->FinishCmds( adapter->cmdPipe );
 }
 
@@ -95,7 +129,6 @@ static void RF_AdapterShutdown( ref_frontendAdapter_t *adapter )
 	if( adapter->thread ) {
 		adapter->shutdown = true;
 		ri.Thread_Join( adapter->thread );
-		ri.Mutex_Destroy( &adapter->frameLock );
 	}
 
 	RF_DestroyCmdPipe( &adapter->cmdPipe );
@@ -122,8 +155,6 @@ static bool RF_AdapterInit( ref_frontendAdapter_t *adapter )
 	adapter->cmdPipe = RF_CreateCmdPipe( !multiThreading );
 
 	if( multiThreading ) {
-		adapter->frameLock = ri.Mutex_Create();
-
 		GLimp_EnableMultithreadedRendering( true );
 
 		if( !GLimp_SharedContext_Create( &adapter->GLcontext, NULL ) ) {
@@ -146,19 +177,93 @@ static bool RF_AdapterInit( ref_frontendAdapter_t *adapter )
 	return true;
 }
 
+/*
+ * RF_GetNextAdapterFrame
+ *
+ * Returns the oldest frame queued by the frontend or NULL if there's none.
+ */
 static ref_cmdbuf_t *RF_GetNextAdapterFrame( ref_frontendAdapter_t *adapter )
 {
-	ref_cmdbuf_t *result = NULL;
 	ref_frontend_t *fe = adapter->owner;
 
-	ri.Mutex_Lock( adapter->frameLock );
-	if( adapter->frameNum != fe->lastFrameNum ) {
-		adapter->frameNum = fe->lastFrameNum;
-		result = fe->frames[adapter->frameNum];
+	if( RF_AtomicLoad( &fe->framesQueued ) == adapter->framesDone ) {
+		return NULL;
 	}
-	ri.Mutex_Unlock( adapter->frameLock );
+	return fe->frames[adapter->framesDone % fe->numFrames];
+}
+
+/*
+ * RF_RetireFrames
+ *
+ * Collects the timestamps of the frames the backend has finished processing.
+ */
+static void RF_RetireFrames( void )
+{
+	int framesDone = RF_AtomicLoad( &rrf.adapter.framesDone );
+	const ref_frametimes_t *times;
+
+	for( ; rrf.framesRetired != framesDone; rrf.framesRetired++ ) {
+		times = &rrf.frameTimes[rrf.framesRetired % rrf.numFrames];
 
-	return result;
+		rrf.stats.queued = times->queued;
+		rrf.stats.producerStall = times->producerStall;
+		rrf.stats.consumerStall = times->consumerStall;
+		rrf.stats.frontendTime = times->submit - times->begin;
+		rrf.stats.backendTime = times->finish - times->start;
+		rrf.stats.latency = times->finish - times->submit;
+	}
+}
+
+/*
+ * RF_AcquireFrame
+ *
+ * Fences the frontend until there are less than r_maxqueuedframes frames in flight
+ * and makes the next slot of the ring the current frame.
+ */
+static void RF_AcquireFrame( void )
+{
+	int depth;
+	uint64_t waitStart;
+	ref_frametimes_t *times;
+
+	depth = Q_bound( 1, r_maxqueuedframes->integer, rrf.numFrames );
+
+	waitStart = ri.Sys_Microseconds();
+	while( rrf.framesQueued - RF_AtomicLoad( &rrf.adapter.framesDone ) >= depth ) {
+		ri.Thread_Yield();
+	}
+
+	RF_RetireFrames();
+
+	rrf.queueDepth = depth;
+	rrf.frame = rrf.frames[rrf.framesQueued % rrf.numFrames];
+
+	times = &rrf.frameTimes[rrf.framesQueued % rrf.numFrames];
+	times->begin = ri.Sys_Microseconds();
+	times->producerStall = times->begin - waitStart;
+}
+
+/*
+ * RF_SubmitFrame
+ */
+static void RF_SubmitFrame( void )
+{
+	ref_frametimes_t *times = &rrf.frameTimes[rrf.framesQueued % rrf.numFrames];
+
+	times->submit = ri.Sys_Microseconds();
+	times->queued = rrf.framesQueued - RF_AtomicLoad( &rrf.adapter.framesDone ) + 1;
+
+	if( rrf.adapter.thread ) {
+		ri.Atomic_Add( &rrf.framesQueued, 1 );
+		return;
+	}
+
+	// the frame has been executed as it was built
+	times->start = times->begin;
+	times->finish = times->submit;
+	times->consumerStall = 0;
+	rrf.framesQueued++;
+	rrf.adapter.framesDone++;
 }
 
 rserr_t RF_Init( const char *applicationName, const char *screenshotPrefix, int startupColor, int iconResource,
@@ -192,30 +297,31 @@ rserr_t RF_SetMode( int x, int y, int width, int height, bool fullScreen, bool s
 		return err;
 	}
 
-	rrf.frameNum = rrf.lastFrameNum = 0;
+	rrf.framesQueued = rrf.framesRetired = 0;
+	memset( rrf.frameTimes, 0, sizeof( rrf.frameTimes ) );
+	memset( &rrf.stats, 0, sizeof( rrf.stats ) );
+
+	rrf.adapter.owner = (void *)&rrf;
+	if( RF_AdapterInit( &rrf.adapter ) != true ) {
+		return rserr_unknown;
+	}
 
 	if( !rrf.frame ) {
 		if( rrf.adapter.thread ) {
 			int i;
-			for( i = 0; i < 3; i++ )
+			rrf.numFrames = RF_MAX_QUEUED_FRAMES;
+			for( i = 0; i < rrf.numFrames; i++ )
 				rrf.frames[i] = RF_CreateCmdBuf( false );
 		} else {
-			rrf.frame = RF_CreateCmdBuf( true );
+			rrf.numFrames = 1;
+			rrf.frames[0] = RF_CreateCmdBuf( true );
 		}
 	}
 
-	if( rrf.adapter.thread ) {
-		rrf.frame = rrf.frames[0];
-	}
-
+	rrf.frame = rrf.frames[0];
 	rrf.frame->Clear( rrf.frame );
 	memset( rrf.customColors, 0, sizeof( rrf.customColors ) );
 
-	rrf.adapter.owner = (void *)&rrf;
-	if( RF_AdapterInit( &rrf.adapter ) != true ) {
-		return rserr_unknown;
-	}
-
 	return rserr_ok;
 }
 
@@ -241,15 +347,12 @@ void RF_AppActivate( bool active, bool minimize, bool destroy )
 
 void RF_Shutdown( bool verbose )
 {
+	int i;
+
 	RF_AdapterShutdown( &rrf.adapter );
 
-	if( rrf.adapter.thread ) {
-		int i;
-		for( i = 0; i < 3; i++ )
-			RF_DestroyCmdBuf( &rrf.frames[i] );
-	} else {
-		RF_DestroyCmdBuf( &rrf.frame );
-	}
+	for( i = 0; i < rrf.numFrames; i++ )
+		RF_DestroyCmdBuf( &rrf.frames[i] );
 	memset( &rrf, 0, sizeof( rrf ) );
 
 	R_Shutdown( verbose );
@@ -302,20 +405,8 @@ void RF_BeginFrame( float cameraSeparation, bool forceClear, bool forceVsync, bo
 
 	rrf.adapter.noWait = uncappedFPS;
 
-	// take the frame the backend is not busy processing
-	if( rrf.adapter.thread ) {
-		ri.Mutex_Lock( rrf.adapter.frameLock );
-		if( rrf.lastFrameNum == rrf.adapter.frameNum ) {
-			rrf.frameNum = ( rrf.adapter.frameNum + 1 ) % 3;
-		} else {
-			rrf.frameNum = 3 - ( rrf.adapter.frameNum + rrf.lastFrameNum );
-		}
-		if( rrf.frameNum == 3 ) {
-			rrf.frameNum = 1;
-		}
-		rrf.frame = rrf.frames[rrf.frameNum];
-		ri.Mutex_Unlock( rrf.adapter.frameLock );
-	}
+	// take the next free slot of the ring, waiting for the backend if it's full
+	RF_AcquireFrame();
 
 	rrf.frame->Clear( rrf.frame );
 	rrf.cameraSeparation = cameraSeparation;
@@ -334,11 +425,7 @@ void RF_EndFrame( void )
 
 	rrf.frame->EndFrame( rrf.frame );
 
-	if( rrf.adapter.thread ) {
-		ri.Mutex_Lock( rrf.adapter.frameLock );
-		rrf.lastFrameNum = rrf.frameNum;
-		ri.Mutex_Unlock( rrf.adapter.frameLock );
-	}
+	RF_SubmitFrame();
 
 	rrf.adapter.cmdPipe->Fence( rrf.adapter.cmdPipe );
 }
@@ -511,9 +598,22 @@ bool RF_RenderingEnabled( void )
 
 const char *RF_GetSpeedsMessage( char *out, size_t size )
 {
+	char frameMsg[256];
+	const ref_framestats_t *stats = &rrf.stats;
+
 	ri.Mutex_Lock( rf.speedsMsgLock );
 	Q_strncpyz( out, rf.speedsMsg, size );
 	ri.Mutex_Unlock( rf.speedsMsgLock );
+
+	if( r_speeds->integer ) {
+		Q_snprintfz( frameMsg, sizeof( frameMsg ),
+					 "frames queued\\depth: %i\\%i  stall front\\back: %.2f\\%.2fms\n"
+					 "frame front\\back\\latency: %.2f\\%.2f\\%.2fms\n",
+					 stats->queued, rrf.queueDepth, stats->producerStall / 1000.0, stats->consumerStall / 1000.0,
+					 stats->frontendTime / 1000.0, stats->backendTime / 1000.0, stats->latency / 1000.0 );
+		Q_strncatz( out, frameMsg, size );
+	}
+
 	return out;
 }
 
@@ -24,25 +24,56 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "r_local.h"
 #include "r_cmdque.h"
 
+#define RF_MAX_QUEUED_FRAMES    4
+
+// timestamps of a single frame, in microseconds
+typedef struct {
+	uint64_t        begin;              // frontend started building the frame
+	uint64_t        submit;             // frame queued for the backend
+	uint64_t        start;              // backend started processing the frame
+	uint64_t        finish;             // backend finished processing the frame
+	unsigned        producerStall;      // time the frontend waited for the slot
+	unsigned        consumerStall;      // time the backend waited for the frame
+	int             queued;             // frames in flight when the frame was submitted
+} ref_frametimes_t;
+
+// frame pacing statistics of the last retired frame, in microseconds
+typedef struct {
+	int             queued;             // frames in flight when the frame was submitted
+	unsigned        producerStall;      // time the frontend waited for a free slot
+	unsigned        consumerStall;      // time the backend waited for the frame
+	unsigned        frontendTime;       // begin to submit
+	unsigned        backendTime;        // start to finish
+	unsigned        latency;            // submit to finish
+} ref_framestats_t;
+
 // sync-to-async frontend adapter
 typedef struct {
 	void            *owner;             // pointer to parent ref_frontend_t
 	void            *GLcontext;
-	unsigned        frameNum;
 	qthread_t       *thread;
-	qmutex_t        *frameLock;
 	ref_cmdpipe_t   *cmdPipe;
+	volatile int    framesDone;         // frames processed by the backend, only written by the adapter
+	unsigned        stall;              // time spent waiting for the next frame so far
 	volatile bool   shutdown;
 	volatile bool   noWait;
 } ref_frontendAdapter_t;
 
+// frames are handed over to the adapter through a single-producer single-consumer
+// ring: the frontend only advances framesQueued and the adapter only advances
+// framesDone, so no locking is needed
 typedef struct {
-	unsigned frameNum;                  // wrapped
-	unsigned lastFrameNum;
+	volatile int    framesQueued;       // frames submitted by the frontend, only written by the frontend
+	int             framesRetired;      // frames whose timestamps have been collected
+	int             numFrames;          // ring size
+	int             queueDepth;         // maximum number of frames in flight
 
-	ref_cmdbuf_t    *frames[3];         // triple-buffered
+	ref_cmdbuf_t    *frames[RF_MAX_QUEUED_FRAMES];
+	ref_frametimes_t frameTimes[RF_MAX_QUEUED_FRAMES];
 	ref_cmdbuf_t    *frame;             // current frontend frame
 
+	ref_framestats_t stats;
+
 	void            *auxGLContext;
 
 	ref_frontendAdapter_t adapter;
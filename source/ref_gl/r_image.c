@@ -420,15 +420,16 @@ static uint8_t *_R_AllocImageBufferCb( void *ptr, size_t size, const char *filen
 }
 
 /*
- * R_ReadImageFromDisk
+ * R_DecodeImageFromDisk
+ *
+ * Decodes the image into memory returned by the allocbuf callback.
  */
-static int R_ReadImageFromDisk(
-	int ctx, char *pathname, size_t pathname_size, uint8_t **pic, int *width, int *height, int *flags, int side )
+static int R_DecodeImageFromDisk( char *pathname, size_t pathname_size, uint8_t **pic, int *width, int *height,
+	int *flags, uint8_t *( *allocbuf )( void *, size_t, const char *, int ), void *uptr )
 {
 	const char *extension;
 	int samples;
 	r_imginfo_t imginfo;
-	loaderCbInfo_t cbinfo = { ctx, side };
 
 	*pic = NULL;
 
@@ -444,17 +445,17 @@ static int R_ReadImageFromDisk(
 	COM_ReplaceExtension( pathname, extension, pathname_size );
 
 	if( !Q_stricmp( extension, ".jpg" ) ) {
-		imginfo = LoadJPG( pathname, _R_AllocImageBufferCb, (void *)&cbinfo );
+		imginfo = LoadJPG( pathname, allocbuf, uptr );
 	} else if( !Q_stricmp( extension, ".tga" ) ) {
-		imginfo = LoadTGA( pathname, _R_AllocImageBufferCb, (void *)&cbinfo );
+		imginfo = LoadTGA( pathname, allocbuf, uptr );
 	} else if( !Q_stricmp( extension, ".png" ) ) {
-		imginfo = LoadPNG( pathname, _R_AllocImageBufferCb, (void *)&cbinfo );
+		imginfo = LoadPNG( pathname, allocbuf, uptr );
 	} else if( !Q_stricmp( extension, ".pcx" ) ) {
-		imginfo = LoadPCX( pathname, _R_AllocImageBufferCb, (void *)&cbinfo );
+		imginfo = LoadPCX( pathname, allocbuf, uptr );
 	} else if( !Q_stricmp( extension, ".wal" ) ) {
-		imginfo = LoadWAL( pathname, _R_AllocImageBufferCb, (void *)&cbinfo );
+		imginfo = LoadWAL( pathname, allocbuf, uptr );
 	} else if( !Q_stricmp( extension, ".svg" ) ) {
-		imginfo = LoadSVG( pathname, *width, *height, _R_AllocImageBufferCb, (void *)&cbinfo );
+		imginfo = LoadSVG( pathname, *width, *height, allocbuf, uptr );
 	} else {
 		return 0;
 	}
@@ -482,6 +483,18 @@ static int R_ReadImageFromDisk(
 	return samples;
 }
 
+/*
+ * R_ReadImageFromDisk
+ */
+static int R_ReadImageFromDisk(
+	int ctx, char *pathname, size_t pathname_size, uint8_t **pic, int *width, int *height, int *flags, int side )
+{
+	loaderCbInfo_t cbinfo = { ctx, side };
+
+	return R_DecodeImageFromDisk(
+		pathname, pathname_size, pic, width, height, flags, _R_AllocImageBufferCb, (void *)&cbinfo );
+}
+
 /*
  * R_ScaledImageSize
  */
@@ -621,25 +634,185 @@ static void R_CutImage(
 }
 
 /*
- * R_ResampleTexture
+==============================================================================
+
+IMAGE FILTERING
+
+The 8-bit resampling and mipmapping filters work on ranges of output rows so
+that large images can be split between the workers of the job pool. The 2x2
+box filter used for mipmapping has SSE2 and NEON versions for RGBA images,
+which produce exactly the same results as the generic one.
+
+==============================================================================
+*/
+
+#define IMAGE_FILTER_PARALLEL_MIN_PIXELS    0x40000
+#define IMAGE_FILTER_JOB_PIXELS             0x4000
+
+#if ( defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 ) ) && !defined ( C_ONLY )
+# include <emmintrin.h>
+# define IMAGE_SIMD
+#elif ( defined ( __ARM_NEON__ ) || defined ( __ARM_NEON ) ) && !defined ( C_ONLY )
+# include <arm_neon.h>
+# define IMAGE_SIMD
+#endif
+
+typedef struct {
+	const uint8_t *in;
+	uint8_t *out;
+	int inwidth, inheight;
+	int outwidth, outheight;
+	int samples, alignment;
+	const unsigned *p1, *p2;
+} imageFilter_t;
+
+/*
+ * R_ResampleRows
  */
-static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, int outwidth,
-	int outheight, int samples, int alignment )
+static void R_ResampleRows( const imageFilter_t *f, int first, int count )
 {
 	int i, j, k;
-	int inwidthS, outwidthS;
-	unsigned int frac, fracstep;
+	const int samples = f->samples;
+	const int inwidthS = Q_ALIGN( f->inwidth * samples, f->alignment );
+	const int outwidthS = Q_ALIGN( f->outwidth * samples, f->alignment );
 	const uint8_t *inrow, *inrow2, *pix1, *pix2, *pix3, *pix4;
-	unsigned *p1, *p2;
-	uint8_t *opix;
+	uint8_t *out = f->out + first * outwidthS, *opix;
+
+	for( i = first; i < first + count; i++, out += outwidthS ) {
+		inrow = f->in + inwidthS * (int)( ( i + 0.25 ) * f->inheight / f->outheight );
+		inrow2 = f->in + inwidthS * (int)( ( i + 0.75 ) * f->inheight / f->outheight );
+		for( j = 0; j < f->outwidth; j++ ) {
+			pix1 = inrow + f->p1[j];
+			pix2 = inrow + f->p2[j];
+			pix3 = inrow2 + f->p1[j];
+			pix4 = inrow2 + f->p2[j];
+			opix = out + j * samples;
 
-	if( inwidth == outwidth && inheight == outheight ) {
-		memcpy( out, in, inheight * Q_ALIGN( inwidth * samples, alignment ) );
+			for( k = 0; k < samples; k++ )
+				opix[k] = ( pix1[k] + pix2[k] + pix3[k] + pix4[k] ) >> 2;
+		}
+	}
+}
+
+#ifdef IMAGE_SIMD
+/*
+ * R_BoxFilterRGBA
+ *
+ * Averages 2x2 RGBA blocks of two rows into count pixels, two at a time.
+ * Returns the number of pixels written. The output may alias the first row.
+ */
+static int R_BoxFilterRGBA( const uint8_t *row, const uint8_t *next, uint8_t *out, int count )
+{
+	int i;
+# if defined ( __ARM_NEON__ ) || defined ( __ARM_NEON )
+	for( i = 0; i + 2 <= count; i += 2, row += 16, next += 16, out += 8 ) {
+		uint8x16_t a = vld1q_u8( row ), b = vld1q_u8( next );
+		uint16x8_t lo = vaddl_u8( vget_low_u8( a ), vget_low_u8( b ) );
+		uint16x8_t hi = vaddl_u8( vget_high_u8( a ), vget_high_u8( b ) );
+		uint16x4_t s0 = vadd_u16( vget_low_u16( lo ), vget_high_u16( lo ) );
+		uint16x4_t s1 = vadd_u16( vget_low_u16( hi ), vget_high_u16( hi ) );
+		vst1_u8( out, vshrn_n_u16( vcombine_u16( s0, s1 ), 2 ) );
+	}
+# else
+	const __m128i zero = _mm_setzero_si128();
+
+	for( i = 0; i + 2 <= count; i += 2, row += 16, next += 16, out += 8 ) {
+		__m128i a = _mm_loadu_si128( (const __m128i *)row );
+		__m128i b = _mm_loadu_si128( (const __m128i *)next );
+		__m128i lo = _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+		__m128i hi = _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+		__m128i sum = _mm_add_epi16( _mm_unpacklo_epi64( lo, hi ), _mm_unpackhi_epi64( lo, hi ) );
+		sum = _mm_srli_epi16( sum, 2 );
+		_mm_storel_epi64( (__m128i *)out, _mm_packus_epi16( sum, sum ) );
+	}
+# endif
+	return i;
+}
+#endif
+
+/*
+ * R_MipMapRows
+ *
+ * The output may alias the input as long as the rows are processed in order.
+ */
+static void R_MipMapRows( const imageFilter_t *f, int first, int count )
+{
+	int i, j, k;
+	const int width = f->inwidth, height = f->inheight, samples = f->samples;
+	const int instride = Q_ALIGN( width * samples, f->alignment );
+	const int outstride = Q_ALIGN( f->outwidth * samples, f->alignment );
+	const uint8_t *in, *next;
+	uint8_t *out;
+	int inofs;
+
+	for( i = first; i < first + count; i++ ) {
+		in = f->in + i * 2 * instride;
+		next = ( ( ( i << 1 ) + 1 ) < height ) ? ( in + instride ) : in;
+		out = f->out + i * outstride;
+		j = 0;
+
+#ifdef IMAGE_SIMD
+		if( samples == 4 && width > 1 ) {
+			j = R_BoxFilterRGBA( in, next, out, f->outwidth );
+			out += j * 4;
+		}
+#endif
+
+		for( inofs = j * samples * 2; j < f->outwidth; j++, inofs += samples ) {
+			if( ( ( j << 1 ) + 1 ) < width ) {
+				for( k = 0; k < samples; ++k, ++inofs )
+					*( out++ ) = ( in[inofs] + in[inofs + samples] + next[inofs] + next[inofs + samples] ) >> 2;
+			} else {
+				for( k = 0; k < samples; ++k, ++inofs )
+					*( out++ ) = ( in[inofs] + next[inofs] ) >> 1;
+			}
+		}
+	}
+}
+
+/*
+ * R_ResampleRowsJob
+ */
+static void R_ResampleRowsJob( unsigned first, unsigned items, void *arg )
+{
+	R_ResampleRows( arg, first, items );
+}
+
+/*
+ * R_MipMapRowsJob
+ */
+static void R_MipMapRowsJob( unsigned first, unsigned items, void *arg )
+{
+	R_MipMapRows( arg, first, items );
+}
+
+/*
+ * R_FilterImage
+ *
+ * Runs the row filter over the whole output image, in parallel when the image is
+ * large enough. The input and output must not overlap in the parallel case.
+ */
+static void R_FilterImage(
+	void ( *job )( unsigned, unsigned, void * ), imageFilter_t *f, bool parallel )
+{
+	if( parallel && f->outwidth * f->outheight >= IMAGE_FILTER_PARALLEL_MIN_PIXELS && ri.Jobs_NumWorkers() > 0 ) {
+		ri.Jobs_ParallelFor( job, f, f->outheight, max( IMAGE_FILTER_JOB_PIXELS / f->outwidth, 1 ) );
 		return;
 	}
+	job( 0, f->outheight, f );
+}
 
-	p1 = (unsigned *)R_PrepareImageBuffer( ctx, TEXTURE_LINE_BUF, outwidth * sizeof( *p1 ) * 2 );
-	p2 = p1 + outwidth;
+/*
+ * R_SetupResampleFilter
+ *
+ * The line buffer must have room for 2 * outwidth entries.
+ */
+static void R_SetupResampleFilter( imageFilter_t *f, const uint8_t *in, int inwidth, int inheight, uint8_t *out,
+	int outwidth, int outheight, int samples, int alignment, unsigned *p1 )
+{
+	int i;
+	unsigned *p2 = p1 + outwidth;
+	unsigned int frac, fracstep;
 
 	fracstep = inwidth * 0x10000 / outwidth;
 
@@ -655,22 +828,53 @@ static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inhe
 		frac += fracstep;
 	}
 
-	inwidthS = Q_ALIGN( inwidth * samples, alignment );
-	outwidthS = Q_ALIGN( outwidth * samples, alignment );
-	for( i = 0; i < outheight; i++, out += outwidthS ) {
-		inrow = in + inwidthS * (int)( ( i + 0.25 ) * inheight / outheight );
-		inrow2 = in + inwidthS * (int)( ( i + 0.75 ) * inheight / outheight );
-		for( j = 0; j < outwidth; j++ ) {
-			pix1 = inrow + p1[j];
-			pix2 = inrow + p2[j];
-			pix3 = inrow2 + p1[j];
-			pix4 = inrow2 + p2[j];
-			opix = out + j * samples;
+	f->in = in;
+	f->out = out;
+	f->inwidth = inwidth;
+	f->inheight = inheight;
+	f->outwidth = outwidth;
+	f->outheight = outheight;
+	f->samples = samples;
+	f->alignment = alignment;
+	f->p1 = p1;
+	f->p2 = p2;
+}
 
-			for( k = 0; k < samples; k++ )
-				opix[k] = ( pix1[k] + pix2[k] + pix3[k] + pix4[k] ) >> 2;
-		}
+/*
+ * R_SetupMipMapFilter
+ */
+static void R_SetupMipMapFilter( imageFilter_t *f, const uint8_t *in, int width, int height, uint8_t *out, int samples,
+	int alignment )
+{
+	memset( f, 0, sizeof( *f ) );
+	f->in = in;
+	f->out = out;
+	f->inwidth = width;
+	f->inheight = height;
+	f->outwidth = max( width >> 1, 1 );
+	f->outheight = max( height >> 1, 1 );
+	f->samples = samples;
+	f->alignment = alignment;
+}
+
+/*
+ * R_ResampleTexture
+ */
+static void R_ResampleTexture( int ctx, const uint8_t *in, int inwidth, int inheight, uint8_t *out, int outwidth,
+	int outheight, int samples, int alignment )
+{
+	unsigned *p1;
+	imageFilter_t f;
+
+	if( inwidth == outwidth && inheight == outheight ) {
+		memcpy( out, in, inheight * Q_ALIGN( inwidth * samples, alignment ) );
+		return;
 	}
+
+	p1 = (unsigned *)R_PrepareImageBuffer( ctx, TEXTURE_LINE_BUF, outwidth * sizeof( *p1 ) * 2 );
+
+	R_SetupResampleFilter( &f, in, inwidth, inheight, out, outwidth, outheight, samples, alignment, p1 );
+	R_ResampleRows( &f, 0, outheight );
 }
 
 /*
@@ -738,35 +942,10 @@ static void R_ResampleTexture16( int ctx, const unsigned short *in, int inwidth,
  */
 static void R_MipMap( uint8_t *in, int width, int height, int samples, int alignment )
 {
-	int i, j, k;
-	int instride = Q_ALIGN( width * samples, alignment );
-	int outwidth, outheight, outpadding;
-	uint8_t *out = in;
-	uint8_t *next;
-	int inofs;
-
-	outwidth = width >> 1;
-	outheight = height >> 1;
-	if( !outwidth ) {
-		outwidth = 1;
-	}
-	if( !outheight ) {
-		outheight = 1;
-	}
-	outpadding = Q_ALIGN( outwidth * samples, alignment ) - outwidth * samples;
+	imageFilter_t f;
 
-	for( i = 0; i < outheight; i++, in += instride * 2, out += outpadding ) {
-		next = ( ( ( i << 1 ) + 1 ) < height ) ? ( in + instride ) : in;
-		for( j = 0, inofs = 0; j < outwidth; j++, inofs += samples ) {
-			if( ( ( j << 1 ) + 1 ) < width ) {
-				for( k = 0; k < samples; ++k, ++inofs )
-					*( out++ ) = ( in[inofs] + in[inofs + samples] + next[inofs] + next[inofs + samples] ) >> 2;
-			} else {
-				for( k = 0; k < samples; ++k, ++inofs )
-					*( out++ ) = ( in[inofs] + next[inofs] ) >> 1;
-			}
-		}
-	}
+	R_SetupMipMapFilter( &f, in, width, height, in, samples, alignment );
+	R_MipMapRows( &f, 0, f.outheight );
 }
 
 /*
@@ -1840,8 +2019,761 @@ static int LoadMipTex( uint8_t **pic, int width, int height, int flags )
 	}
 }
 
+/*
+==============================================================================
+
+IMAGE PREPARATION
+
+Everything but the upload of 2D images loaded from disk is done on the job
+pool: the image is decoded, cut or flipped, resampled and its whole mipmap
+chain is built into private memory, so that the GL thread only has to pass
+the levels to qglTexImage2D. The async loader schedules the preparation as
+soon as the image is requested and picks the result up on its own context.
+
+==============================================================================
+*/
+
+#define IMAGE_PREP_BUFFERS      4   // initial size of the buffers array, grown on demand
+#define MAX_IMAGE_PREP_MIPS     16
+
+#define IMAGE_CACHE_DIR         "cache/textures"
+#define IMAGE_CACHE_KEY         "qfusion.source"
+
+typedef struct {
+	char pathname[1024];
+	int flags;
+	int minmipsize;
+	int width, height, samples;
+	int uploadWidth, uploadHeight;
+	int numMips;
+	int alignment;
+	uint8_t *mips[MAX_IMAGE_PREP_MIPS];
+	int numBuffers, maxBuffers;
+	uint8_t **buffers;
+	char extension[8];
+	bool ktx;
+	bool parallel;          // filter on the job pool, never set when already running in a job
+	uint64_t decodeTime, filterTime;
+	struct qjob_s *job;
+} imagePrep_t;
+
+static imagePrep_t *r_imagePreps[MAX_GLIMAGES];
+
+/*
+ * R_AllocPrepBuffer
+ */
+static uint8_t *R_AllocPrepBuffer( imagePrep_t *prep, size_t size )
+{
+	uint8_t *buf, **buffers;
+
+	if( prep->numBuffers == prep->maxBuffers ) {
+		prep->maxBuffers = prep->maxBuffers ? prep->maxBuffers * 2 : IMAGE_PREP_BUFFERS;
+		buffers = R_MallocExt( r_imagesPool, prep->maxBuffers * sizeof( *buffers ), 0, 0 );
+		if( prep->buffers ) {
+			memcpy( buffers, prep->buffers, prep->numBuffers * sizeof( *buffers ) );
+			R_Free( prep->buffers );
+		}
+		prep->buffers = buffers;
+	}
+
+	buf = R_MallocExt( r_imagesPool, size, 16, 0 );
+	prep->buffers[prep->numBuffers++] = buf;
+	return buf;
+}
+
+/*
+ * R_AllocPrepBufferCb
+ */
+static uint8_t *R_AllocPrepBufferCb( void *ptr, size_t size, const char *filename, int linenum )
+{
+	return R_AllocPrepBuffer( ptr, size );
+}
+
+/*
+ * R_FreePrepBuffers
+ */
+static void R_FreePrepBuffers( imagePrep_t *prep )
+{
+	int i;
+
+	for( i = 0; i < prep->numBuffers; i++ )
+		R_Free( prep->buffers[i] );
+	prep->numBuffers = 0;
+	prep->numMips = 0;
+}
+
+/*
+ * R_AllocPreparedImage
+ */
+static imagePrep_t *R_AllocPreparedImage( const char *name, int flags, int minmipsize, int width, int height )
+{
+	imagePrep_t *prep;
+
+	prep = R_MallocExt( r_imagesPool, sizeof( *prep ), 0, 1 );
+	Q_strncpyz( prep->pathname, name, sizeof( prep->pathname ) );
+	prep->flags = flags;
+	prep->minmipsize = minmipsize;
+	prep->width = width;
+	prep->height = height;
+	prep->parallel = true;
+	return prep;
+}
+
+/*
+ * R_FreePreparedImage
+ */
+static void R_FreePreparedImage( imagePrep_t *prep )
+{
+	if( prep->job ) {
+		ri.Job_Wait( prep->job );
+		ri.Job_Release( &prep->job );
+	}
+	R_FreePrepBuffers( prep );
+	if( prep->buffers ) {
+		R_Free( prep->buffers );
+	}
+	R_Free( prep );
+}
+
+typedef struct {
+	char path[1024];
+	int size;
+	unsigned mtime;
+	unsigned checksum;      // 0 until R_ImageSourceChecksum is called
+} imageSource_t;
+
+/*
+ * R_FindImageSource
+ *
+ * Finds the source file of the image, pathname has no extension.
+ * Returns false if there's no source file.
+ */
+static bool R_FindImageSource( const char *pathname, imageSource_t *source, char *extension, size_t extension_size )
+{
+	const char *ext;
+
+	Q_snprintfz( source->path, sizeof( source->path ), "%s.tga", pathname );
+	ext = ri.FS_FirstExtension( source->path, IMAGE_EXTENSIONS, NUM_IMAGE_EXTENSIONS - 1 ); // last is KTX
+	if( !ext ) {
+		return false;
+	}
+	COM_ReplaceExtension( source->path, ext, sizeof( source->path ) );
+
+	source->size = ri.FS_FOpenFile( source->path, NULL, FS_READ );
+	if( source->size < 0 ) {
+		return false;
+	}
+	source->mtime = (unsigned)ri.FS_FileMTime( source->path );
+	source->checksum = 0;
+
+	Q_strncpyz( extension, ext, extension_size );
+	return true;
+}
+
+/*
+ * R_ImageSourceChecksum
+ *
+ * Hashes the source file found by R_FindImageSource, only the first time it's called.
+ * Returns 0 if the file can't be read.
+ */
+static unsigned R_ImageSourceChecksum( imageSource_t *source )
+{
+	int length;
+	uint8_t *buffer;
+
+	if( source->checksum ) {
+		return source->checksum;
+	}
+
+	length = R_LoadFile( source->path, (void **)&buffer );
+	if( !buffer ) {
+		return 0;
+	}
+
+	source->checksum = COM_SuperFastHash( buffer, length );
+	R_FreeFile( buffer );
+
+	if( !source->checksum ) {
+		source->checksum = 1;
+	}
+	return source->checksum;
+}
+
+/*
+ * R_CachedImageFileName
+ *
+ * Must be called before the image is decoded since decoding may change the flags.
+ */
+static void R_CachedImageFileName( const imagePrep_t *prep, char *path, size_t size )
+{
+	Q_snprintfz( path, size, "%s/%s_%x_%i.ktx", IMAGE_CACHE_DIR, prep->pathname, prep->flags & ~IT_SYNC,
+		prep->minmipsize );
+}
+
+/*
+ * R_LoadCachedImage
+ *
+ * Fills the levels of the image from its cache file, which must have been made from
+ * the same source file and still match the current picmip settings. The source is only
+ * hashed if its size or modification time differs from the ones stored in the cache.
+ */
+static bool R_LoadCachedImage( imagePrep_t *prep, const char *path, imageSource_t *source, const char *extension )
+{
+	int i, file, length, samples, numValues;
+	int width, height, flags, w, h;
+	int scaledWidth, scaledHeight, numMips;
+	int storedSize;
+	unsigned storedChecksum, storedFlags, storedMTime;
+	size_t size;
+	uint8_t *buffer, *data, *end;
+	ktx_header_t *header;
+
+	length = ri.FS_FOpenFile( path, &file, FS_READ | FS_CACHE );
+	if( !file ) {
+		return false;
+	}
+	if( length <= (int)sizeof( *header ) ) {
+		ri.FS_FCloseFile( file );
+		return false;
+	}
+
+	buffer = R_AllocPrepBuffer( prep, length + 1 );
+	length = ri.FS_Read( buffer, length, file );
+	ri.FS_FCloseFile( file );
+	buffer[length] = 0;
+
+	end = buffer + length;
+	header = (ktx_header_t *)buffer;
+	data = buffer + sizeof( *header );
+
+	if( length <= (int)sizeof( *header ) || memcmp( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 ) ||
+		header->endianness != 0x04030201 || header->type != GL_UNSIGNED_BYTE || header->numberOfFaces != 1 ||
+		header->bytesOfKeyValueData <= (int)sizeof( int ) || header->bytesOfKeyValueData > end - data ) {
+		goto error;
+	}
+
+	// the first key/value pair identifies the source of the image
+	if( strcmp( (char *)data + sizeof( int ), IMAGE_CACHE_KEY ) ) {
+		goto error;
+	}
+	numValues = sscanf( (char *)data + sizeof( int ) + sizeof( IMAGE_CACHE_KEY ), "%x %i %i %x %i %u",
+		&storedChecksum, &width, &height, &storedFlags, &storedSize, &storedMTime );
+	if( numValues < 4 ) {
+		goto error;
+	}
+	if( numValues < 6 || storedSize != source->size || storedMTime != source->mtime ) {
+		if( storedChecksum != R_ImageSourceChecksum( source ) ) {
+			goto error;
+		}
+	}
+	flags = (int)storedFlags;
+	if( ( flags & IT_BGRA ) && !glConfig.ext.bgra ) {
+		goto error;
+	}
+
+	switch( header->baseInternalFormat ) {
+		case GL_RGBA:
+		case GL_BGRA_EXT:
+			samples = 4;
+			break;
+		case GL_RGB:
+		case GL_BGR_EXT:
+			samples = 3;
+			break;
+		case GL_LUMINANCE_ALPHA:
+			samples = 2;
+			break;
+		case GL_LUMINANCE:
+		case GL_ALPHA:
+			samples = 1;
+			break;
+		default:
+			goto error;
+	}
+
+	R_ScaledImageSize( width, height, &scaledWidth, &scaledHeight, flags, 1, prep->minmipsize, false );
+	numMips = ( flags & IT_NOMIPMAP ) ? 1 : R_MipCount( scaledWidth, scaledHeight, prep->minmipsize );
+	clamp_high( numMips, MAX_IMAGE_PREP_MIPS );
+
+	if( header->pixelWidth != scaledWidth || header->pixelHeight != scaledHeight ||
+		header->numberOfMipmapLevels != numMips ) {
+		goto error;
+	}
+
+	data += header->bytesOfKeyValueData;
+	for( i = 0, w = scaledWidth, h = scaledHeight; i < numMips; i++ ) {
+		size = Q_ALIGN( w * samples, 4 ) * h;
+		if( end - data < (int)sizeof( int ) || *(int *)data != (int)size || (size_t)( end - data ) - sizeof( int ) < size ) {
+			goto error;
+		}
+
+		prep->mips[i] = data + sizeof( int );
+		data += sizeof( int ) + size;
+
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+	}
+
+	prep->flags = flags;
+	prep->width = width;
+	prep->height = height;
+	prep->samples = samples;
+	prep->uploadWidth = scaledWidth;
+	prep->uploadHeight = scaledHeight;
+	prep->numMips = numMips;
+	prep->alignment = 4;
+	Q_strncpyz( prep->extension, extension, sizeof( prep->extension ) );
+	return true;
+
+error:
+	ri.Com_DPrintf( "Ignoring texture cache %s: version or source mismatch\n", path );
+	R_FreePrepBuffers( prep );
+	return false;
+}
+
+/*
+ * R_StoreCachedImage
+ *
+ * Writes the levels of the prepared image to an uncompressed KTX file in the cache directory.
+ */
+static void R_StoreCachedImage( const imagePrep_t *prep, const char *path, const imageSource_t *source )
+{
+	int i, y, file;
+	int w, h, samples = prep->samples;
+	int rowSize, alignedRowSize;
+	int format;
+	size_t kvSize, size;
+	char value[96];
+	uint8_t *buffer, *data;
+	ktx_header_t *header;
+
+	switch( samples ) {
+		case 4:
+			format = ( prep->flags & IT_BGRA ) ? GL_BGRA_EXT : GL_RGBA;
+			break;
+		case 3:
+			format = ( prep->flags & IT_BGRA ) ? GL_BGR_EXT : GL_RGB;
+			break;
+		case 2:
+			format = GL_LUMINANCE_ALPHA;
+			break;
+		default:
+			format = ( prep->flags & IT_ALPHAMASK ) ? GL_ALPHA : GL_LUMINANCE;
+			break;
+	}
+
+	Q_snprintfz( value, sizeof( value ), "%x %i %i %x %i %u", source->checksum, prep->width, prep->height,
+		prep->flags, source->size, source->mtime );
+
+	kvSize = sizeof( int ) + Q_ALIGN( sizeof( IMAGE_CACHE_KEY ) + strlen( value ) + 1, 4 );
+	size = sizeof( *header ) + kvSize;
+	for( i = 0, w = prep->uploadWidth, h = prep->uploadHeight; i < prep->numMips; i++ ) {
+		size += sizeof( int ) + Q_ALIGN( w * samples, 4 ) * h;
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+	}
+
+	buffer = R_MallocExt( r_imagesPool, size, 0, 1 );
+
+	header = (ktx_header_t *)buffer;
+	memcpy( header->identifier, "\xABKTX 11\xBB\r\n\x1A\n", 12 );
+	header->endianness = 0x04030201;
+	header->type = GL_UNSIGNED_BYTE;
+	header->typeSize = 1;
+	header->format = format;
+	header->internalFormat = format;
+	header->baseInternalFormat = format;
+	header->pixelWidth = prep->uploadWidth;
+	header->pixelHeight = prep->uploadHeight;
+	header->numberOfFaces = 1;
+	header->numberOfMipmapLevels = prep->numMips;
+	header->bytesOfKeyValueData = kvSize;
+
+	data = buffer + sizeof( *header );
+	*(int *)data = sizeof( IMAGE_CACHE_KEY ) + strlen( value ) + 1;
+	memcpy( data + sizeof( int ), IMAGE_CACHE_KEY, sizeof( IMAGE_CACHE_KEY ) );
+	memcpy( data + sizeof( int ) + sizeof( IMAGE_CACHE_KEY ), value, strlen( value ) + 1 );
+	data += kvSize;
+
+	for( i = 0, w = prep->uploadWidth, h = prep->uploadHeight; i < prep->numMips; i++ ) {
+		rowSize = Q_ALIGN( w * samples, prep->alignment );
+		alignedRowSize = Q_ALIGN( w * samples, 4 );
+
+		*(int *)data = alignedRowSize * h;
+		data += sizeof( int );
+		for( y = 0; y < h; y++, data += alignedRowSize )
+			memcpy( data, prep->mips[i] + y * rowSize, w * samples );
+
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+	}
+
+	if( ri.FS_FOpenFile( path, &file, FS_WRITE | FS_CACHE ) != -1 ) {
+		ri.FS_Write( buffer, size, file );
+		ri.FS_FCloseFile( file );
+	}
+
+	R_Free( buffer );
+}
+
+/*
+ * R_PrepareImage
+ *
+ * Reads the image from disk and builds the levels to upload, never touches GL.
+ * Leaves samples at 0 if the image is missing or, when checkKTX is set, has a
+ * KTX version, which has to be loaded by the GL thread. With r_texturecache,
+ * the levels are read from the texture cache if the source is unchanged and
+ * stored there otherwise.
+ */
+static void R_PrepareImage( imagePrep_t *prep, bool checkKTX )
+{
+	int i, w, h;
+	int flags = prep->flags, samples;
+	int width = prep->width, height = prep->height;
+	int scaledWidth, scaledHeight;
+	size_t len = strlen( prep->pathname ), size;
+	char pathname[1024];
+	uint8_t *pic, *mip;
+	uint64_t start;
+	imageFilter_t f;
+	bool cacheable = false;
+	imageSource_t source;
+	char cachePath[1024];
+
+	prep->samples = 0;
+	prep->alignment = 1;
+	prep->ktx = false;
+	if( len >= sizeof( pathname ) - 7 ) {
+		return;
+	}
+
+	memcpy( pathname, prep->pathname, len + 1 );
+
+	if( checkKTX ) {
+		Q_strncatz( pathname, ".ktx", sizeof( pathname ) );
+		if( ri.FS_FOpenFile( pathname, NULL, FS_READ ) != -1 ) {
+			prep->ktx = true;
+			return;
+		}
+		pathname[len] = 0;
+	}
+
+	start = ri.Sys_Microseconds();
+
+	// svg images are rendered at the requested size and aren't worth caching
+	if( r_texturecache->integer && width <= 1 && height <= 1 ) {
+		R_CachedImageFileName( prep, cachePath, sizeof( cachePath ) );
+		cacheable = R_FindImageSource( prep->pathname, &source, prep->extension, sizeof( prep->extension ) );
+		if( cacheable && R_LoadCachedImage( prep, cachePath, &source, prep->extension ) ) {
+			prep->decodeTime = ri.Sys_Microseconds() - start;
+			prep->filterTime = 0;
+			return;
+		}
+	}
+
+	Q_strncatz( pathname, ".tga", sizeof( pathname ) );
+	samples = R_DecodeImageFromDisk(
+		pathname, sizeof( pathname ), &pic, &width, &height, &flags, R_AllocPrepBufferCb, prep );
+	if( !samples || !pic ) {
+		R_FreePrepBuffers( prep );
+		return;
+	}
+	Q_strncpyz( prep->extension, &pathname[len], sizeof( prep->extension ) );
+
+	prep->decodeTime = ri.Sys_Microseconds() - start;
+	start = ri.Sys_Microseconds();
+
+	if( flags & ( IT_LEFTHALF | IT_RIGHTHALF ) ) {
+		uint8_t *temp;
+
+		width /= 2;
+		temp = R_AllocPrepBuffer( prep, width * height * samples );
+		R_CutImage( pic, width * 2, height, temp, ( flags & IT_LEFTHALF ) ? 0 : width, 0, width, height, samples );
+		pic = temp;
+	}
+
+	if( flags & ( IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL ) ) {
+		uint8_t *temp = R_AllocPrepBuffer( prep, width * height * samples );
+		R_FlipTexture( pic, temp, width, height, samples, ( flags & IT_FLIPX ) ? true : false,
+			( flags & IT_FLIPY ) ? true : false, ( flags & IT_FLIPDIAGONAL ) ? true : false );
+		pic = temp;
+	}
+
+	R_ScaledImageSize( width, height, &scaledWidth, &scaledHeight, flags, 1, prep->minmipsize, false );
+
+	prep->numMips = ( flags & IT_NOMIPMAP ) ? 1 : R_MipCount( scaledWidth, scaledHeight, prep->minmipsize );
+	clamp_high( prep->numMips, MAX_IMAGE_PREP_MIPS );
+
+	// all levels but the first go to a single allocation
+	size = 0;
+	for( i = 1, w = scaledWidth, h = scaledHeight; i < prep->numMips; i++ ) {
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+		size += w * h * samples;
+	}
+	if( ( scaledWidth != width ) || ( scaledHeight != height ) ) {
+		size += scaledWidth * scaledHeight * samples;
+	}
+
+	mip = size ? R_AllocPrepBuffer( prep, size ) : NULL;
+
+	if( ( scaledWidth != width ) || ( scaledHeight != height ) ) {
+		unsigned *lines = R_Malloc( scaledWidth * sizeof( *lines ) * 2 );
+
+		R_SetupResampleFilter( &f, pic, width, height, mip, scaledWidth, scaledHeight, samples, 1, lines );
+		R_FilterImage( R_ResampleRowsJob, &f, prep->parallel );
+
+		R_Free( lines );
+
+		prep->mips[0] = mip;
+		mip += scaledWidth * scaledHeight * samples;
+	} else {
+		prep->mips[0] = pic;
+	}
+
+	for( i = 1, w = scaledWidth, h = scaledHeight; i < prep->numMips; i++ ) {
+		R_SetupMipMapFilter( &f, prep->mips[i - 1], w, h, mip, samples, 1 );
+		R_FilterImage( R_MipMapRowsJob, &f, prep->parallel );
+
+		w = f.outwidth;
+		h = f.outheight;
+		prep->mips[i] = mip;
+		mip += w * h * samples;
+	}
+
+	prep->filterTime = ri.Sys_Microseconds() - start;
+
+	prep->flags = flags;
+	prep->width = width;
+	prep->height = height;
+	prep->samples = samples;
+	prep->uploadWidth = scaledWidth;
+	prep->uploadHeight = scaledHeight;
+
+	if( cacheable && R_ImageSourceChecksum( &source ) ) {
+		R_StoreCachedImage( prep, cachePath, &source );
+	}
+}
+
+/*
+ * R_PrepareImageJob
+ */
+static void R_PrepareImageJob( unsigned first, unsigned items, void *arg )
+{
+	imagePrep_t *prep = arg;
+
+	// waiting on a nested parallel for from a worker could run more prepare
+	// jobs on its stack, so filter right here
+	prep->parallel = false;
+	R_PrepareImage( prep, true );
+}
+
+/*
+ * R_UploadPreparedImage
+ */
+static void R_UploadPreparedImage( int ctx, image_t *image, const imagePrep_t *prep )
+{
+	int i, w, h;
+	int comp, format, type, target;
+
+	image->width = prep->width;
+	image->height = prep->height;
+	image->samples = prep->samples;
+	image->upload_width = prep->uploadWidth;
+	image->upload_height = prep->uploadHeight;
+
+	R_BindImage( image );
+
+	R_TextureTarget( prep->flags, &target );
+	R_TextureFormat( prep->flags, prep->samples, &comp, &format, &type );
+	R_SetupTexParameters( prep->flags, prep->uploadWidth, prep->uploadHeight, image->minmipsize );
+
+	R_UnpackAlignment( ctx, prep->alignment );
+
+	for( i = 0, w = prep->uploadWidth, h = prep->uploadHeight; i < prep->numMips; i++ ) {
+		qglTexImage2D( target, i, comp, w, h, 0, format, type, prep->mips[i] );
+		w = max( w >> 1, 1 );
+		h = max( h >> 1, 1 );
+	}
+
+	image->error = qglGetError();
+	Q_strncpyz( image->extension, prep->extension, sizeof( image->extension ) );
+}
+
+/*
+ * R_SchedulePreparedImage
+ *
+ * Starts preparing the image on the job pool, to be picked up by R_LoadImageFromDisk.
+ * Decoding is a background job, so frame-time waits on the pool never get stuck in it.
+ */
+static void R_SchedulePreparedImage( image_t *image )
+{
+	imagePrep_t *prep;
+	int pic = image - r_images;
+
+	if( ( image->flags & IT_CUBEMAP ) || r_imagePreps[pic] || ri.Jobs_NumWorkers() <= 0 ) {
+		return;
+	}
+
+	prep = R_AllocPreparedImage( image->name, image->flags, image->minmipsize, image->width, image->height );
+	prep->job = ri.Job_ScheduleBackground( R_PrepareImageJob, prep, 1, 1, NULL, 0 );
+	r_imagePreps[pic] = prep;
+}
+
+/*
+ * R_LoadPreparedImage
+ */
+static bool R_LoadPreparedImage( int ctx, image_t *image )
+{
+	int pic = image - r_images;
+	imagePrep_t *prep = r_imagePreps[pic];
+	bool loaded = false;
+
+	if( prep ) {
+		r_imagePreps[pic] = NULL;
+		ri.Job_Wait( prep->job );
+		ri.Job_Release( &prep->job );
+	} else {
+		prep = R_AllocPreparedImage( image->name, image->flags, image->minmipsize, image->width, image->height );
+		R_PrepareImage( prep, true );
+	}
+
+	if( prep->ktx ) {
+		char pathname[1024];
+
+		Q_snprintfz( pathname, sizeof( pathname ), "%s.ktx", image->name );
+		if( R_LoadKTX( ctx, image, pathname ) ) {
+			R_FreePreparedImage( prep );
+			return true;
+		}
+
+		R_PrepareImage( prep, false );
+	}
+
+	if( prep->samples ) {
+		R_UploadPreparedImage( ctx, image, prep );
+
+		// Update IT_LOADFLAGS that may be set by R_DecodeImageFromDisk.
+		image->flags = prep->flags;
+		R_DeferDataSync();
+		loaded = true;
+	} else {
+		ri.Com_DPrintf( S_COLOR_YELLOW "Missing image: %s\n", image->name );
+	}
+
+	R_FreePreparedImage( prep );
+
+	return loaded;
+}
+
+/*
+ * R_PrepareImagesJob
+ */
+static void R_PrepareImagesJob( unsigned first, unsigned items, void *arg )
+{
+	unsigned i;
+	imagePrep_t **preps = arg;
+
+	for( i = first; i < first + items; i++ )
+		R_PrepareImage( preps[i], false );
+}
+
+/*
+ * R_ImageBenchmark_f
+ *
+ * Decodes and builds the mipmap chains of all images in a directory, first one
+ * by one on the calling thread and then on the job pool. Doesn't touch GL.
+ */
+void R_ImageBenchmark_f( void )
+{
+	int i, j, k, n, numFiles, numImages, pass;
+	const char *dir, *fileptr;
+	char filenames[1024], name[1024];
+	const char *extensions[] = { ".tga", ".jpg", ".png" };
+	imagePrep_t **preps;
+	uint64_t start, total, decodeTime, filterTime, texels;
+	const int maxImages = 1024;
+
+	if( ri.Cmd_Argc() < 2 ) {
+		Com_Printf( "Usage: %s <directory>\n", ri.Cmd_Argv( 0 ) );
+		return;
+	}
+
+	dir = ri.Cmd_Argv( 1 );
+	preps = R_Malloc( maxImages * sizeof( *preps ) );
+	numImages = 0;
+
+	for( i = 0; i < (int)( sizeof( extensions ) / sizeof( extensions[0] ) ); i++ ) {
+		numFiles = ri.FS_GetFileList( dir, extensions[i], NULL, 0, 0, 0 );
+
+		for( j = 0; j < numFiles && numImages < maxImages; j += k ) {
+			if( ( k = ri.FS_GetFileList( dir, extensions[i], filenames, sizeof( filenames ), j, numFiles ) ) == 0 ) {
+				k = 1; // advance by one file
+				continue;
+			}
+
+			fileptr = filenames;
+			for( n = 0; n < k && numImages < maxImages; n++ ) {
+				Q_snprintfz( name, sizeof( name ), "%s/%s", dir, fileptr );
+				COM_StripExtension( name );
+				preps[numImages++] = R_AllocPreparedImage( name, 0, 1, 1, 1 );
+
+				fileptr += strlen( fileptr ) + 1;
+				if( !*fileptr ) {
+					break;
+				}
+			}
+		}
+	}
+
+	if( !numImages ) {
+		Com_Printf( "No images found in %s\n", dir );
+		R_Free( preps );
+		return;
+	}
+
+	Com_Printf( "Preparing %i images, %i workers\n", numImages, ri.Jobs_NumWorkers() );
+
+	for( pass = 0; pass < 2; pass++ ) {
+		for( i = 0; i < numImages; i++ ) {
+			R_FreePrepBuffers( preps[i] );
+			preps[i]->parallel = false;
+		}
+
+		start = ri.Sys_Microseconds();
+		if( pass == 0 ) {
+			R_PrepareImagesJob( 0, numImages, preps );
+		} else {
+			ri.Jobs_ParallelFor( R_PrepareImagesJob, preps, numImages, 1 );
+		}
+		total = ri.Sys_Microseconds() - start;
+
+		decodeTime = filterTime = texels = 0;
+		for( i = 0; i < numImages; i++ ) {
+			const imagePrep_t *prep = preps[i];
+
+			if( !prep->samples ) {
+				continue;
+			}
+			decodeTime += prep->decodeTime;
+			filterTime += prep->filterTime;
+			texels += (uint64_t)prep->width * prep->height;
+		}
+
+		Com_Printf( "%s: %" PRIu64 "us total, %" PRIu64 "us decoding, %" PRIu64 "us filtering, %.1f Mtexels/s\n",
+			pass == 0 ? "serial" : "job pool", total, decodeTime, filterTime,
+			total ? (double)texels / (double)total : 0.0 );
+	}
+
+	for( i = 0; i < numImages; i++ )
+		R_FreePreparedImage( preps[i] );
+	R_Free( preps );
+}
+
 /*
  * R_LoadImageFromDisk
+ *
+ * Cubemaps are loaded here, everything else goes through R_LoadPreparedImage.
  */
 static bool R_LoadImageFromDisk( int ctx, image_t *image )
 {
@@ -1851,6 +2783,34 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 	size_t pathsize = sizeof( pathname );
 	int width = image->width, height = image->height, samples = image->samples;
 	bool loaded = false;
+	int i, j, k;
+	uint8_t *pic[6];
+	struct cubemapSufAndFlip {
+		char *suf;
+		int flags;
+	} cubemapSides[2][6] = {
+		{
+			{ "px", 0 },
+			{ "nx", 0 },
+			{ "py", 0 },
+			{ "ny", 0 },
+			{ "pz", 0 },
+			{ "nz", 0 },
+		},
+		{
+			{ "rt", IT_FLIPX | IT_FLIPDIAGONAL },
+			{ "lf", IT_FLIPY | IT_FLIPDIAGONAL },
+			{ "ft", IT_FLIPX | IT_FLIPY },
+			{ "bk", 0 },
+			{ "up", IT_FLIPX | IT_FLIPDIAGONAL },
+			{ "dn", IT_FLIPX | IT_FLIPDIAGONAL },
+		},
+	};
+	int lastSize = 0;
+
+	if( !( flags & IT_CUBEMAP ) ) {
+		return R_LoadPreparedImage( ctx, image );
+	}
 
 	if( len >= pathsize - 7 ) {
 		return false;
@@ -1864,114 +2824,65 @@ static bool R_LoadImageFromDisk( int ctx, image_t *image )
 	}
 	pathname[len] = 0;
 
-	if( flags & IT_CUBEMAP ) {
-		int i, j, k;
-		uint8_t *pic[6];
-		struct cubemapSufAndFlip {
-			char *suf;
-			int flags;
-		} cubemapSides[2][6] = {
-			{
-				{ "px", 0 },
-				{ "nx", 0 },
-				{ "py", 0 },
-				{ "ny", 0 },
-				{ "pz", 0 },
-				{ "nz", 0 },
-			},
-			{
-				{ "rt", IT_FLIPX | IT_FLIPDIAGONAL },
-				{ "lf", IT_FLIPY | IT_FLIPDIAGONAL },
-				{ "ft", IT_FLIPX | IT_FLIPY },
-				{ "bk", 0 },
-				{ "up", IT_FLIPX | IT_FLIPDIAGONAL },
-				{ "dn", IT_FLIPX | IT_FLIPDIAGONAL },
-			},
-		};
-		int lastSize = 0;
-
-		for( k = 0; k < 2; k++ ) {
-			pathname[len] = '_';
-
-			for( i = 0; i < 2; i++ ) {
-				for( j = 0; j < 6; j++ ) {
-					int cbflags = cubemapSides[i][j].flags;
-
-					pathname[len + k + 0] = cubemapSides[i][j].suf[0];
-					pathname[len + k + 1] = cubemapSides[i][j].suf[1];
-					pathname[len + k + 2] = 0;
-
-					Q_strncatz( pathname, ".tga", pathsize );
-					samples = R_ReadImageFromDisk( ctx, pathname, pathsize, &( pic[j] ), &width, &height, &flags, j );
-					if( samples != 0 ) {
-						if( width != height ) {
-							ri.Com_DPrintf( S_COLOR_YELLOW "Not square cubemap image %s\n", pathname );
-							break;
-						}
-						if( !j ) {
-							lastSize = width;
-						} else if( lastSize != width ) {
-							ri.Com_DPrintf( S_COLOR_YELLOW "Different cubemap image size: %s\n", pathname );
-							break;
-						}
-						if( cbflags & ( IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL ) ) {
-							uint8_t *temp =
-								R_PrepareImageBuffer( ctx, TEXTURE_FLIPPING_BUF0 + j, width * height * samples );
-							R_FlipTexture( pic[j], temp, width, height, samples, ( cbflags & IT_FLIPX ) ? true : false,
-								( cbflags & IT_FLIPY ) ? true : false, ( cbflags & IT_FLIPDIAGONAL ) ? true : false );
-							pic[j] = temp;
-						}
-						continue;
+	for( k = 0; k < 2; k++ ) {
+		pathname[len] = '_';
+
+		for( i = 0; i < 2; i++ ) {
+			for( j = 0; j < 6; j++ ) {
+				int cbflags = cubemapSides[i][j].flags;
+
+				pathname[len + k + 0] = cubemapSides[i][j].suf[0];
+				pathname[len + k + 1] = cubemapSides[i][j].suf[1];
+				pathname[len + k + 2] = 0;
+
+				Q_strncatz( pathname, ".tga", pathsize );
+				samples = R_ReadImageFromDisk( ctx, pathname, pathsize, &( pic[j] ), &width, &height, &flags, j );
+				if( samples != 0 ) {
+					if( width != height ) {
+						ri.Com_DPrintf( S_COLOR_YELLOW "Not square cubemap image %s\n", pathname );
+						break;
 					}
-					break;
-				}
-				if( j == 6 ) {
-					break;
+					if( !j ) {
+						lastSize = width;
+					} else if( lastSize != width ) {
+						ri.Com_DPrintf( S_COLOR_YELLOW "Different cubemap image size: %s\n", pathname );
+						break;
+					}
+					if( cbflags & ( IT_FLIPX | IT_FLIPY | IT_FLIPDIAGONAL ) ) {
+						uint8_t *temp =
+							R_PrepareImageBuffer( ctx, TEXTURE_FLIPPING_BUF0 + j, width * height * samples );
+						R_FlipTexture( pic[j], temp, width, height, samples, ( cbflags & IT_FLIPX ) ? true : false,
+							( cbflags & IT_FLIPY ) ? true : false, ( cbflags & IT_FLIPDIAGONAL ) ? true : false );
+						pic[j] = temp;
+					}
+					continue;
 				}
+				break;
 			}
-			if( i != 2 ) {
+			if( j == 6 ) {
 				break;
 			}
 		}
-
-		if( k != 2 ) {
-			image->width = width;
-			image->height = height;
-			image->samples = samples;
-
-			R_BindImage( image );
-
-			R_Upload32( ctx, pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width,
-				&image->upload_height, samples, false, false );
-
-			image->error = qglGetError();
-			Q_strncpyz( image->extension, &pathname[len + k + 2], sizeof( image->extension ) );
-			loaded = true;
-		} else {
-			ri.Com_DPrintf( S_COLOR_YELLOW "Missing image: %s\n", image->name );
+		if( i != 2 ) {
+			break;
 		}
-	} else {
-		uint8_t *pic = NULL;
-
-		Q_strncatz( pathname, ".tga", pathsize );
-		samples = R_ReadImageFromDisk( ctx, pathname, pathsize, &pic, &width, &height, &flags, 0 );
+	}
 
-		if( samples != 0 ) {
-			image->width = width;
-			image->height = height;
-			image->samples = samples;
+	if( k != 2 ) {
+		image->width = width;
+		image->height = height;
+		image->samples = samples;
 
-			R_BindImage( image );
+		R_BindImage( image );
 
-			R_Upload32( ctx, &pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width,
-				&image->upload_height, samples, false, false );
+		R_Upload32( ctx, pic, 0, 0, 0, width, height, flags, image->minmipsize, &image->upload_width,
+			&image->upload_height, samples, false, false );
 
-			image->error = qglGetError();
-			Q_strncpyz( image->extension, &pathname[len], sizeof( image->extension ) );
-			loaded = true;
-		} else {
-			ri.Com_DPrintf( S_COLOR_YELLOW "Missing image: %s\n", image->name );
-		}
+		image->error = qglGetError();
+		Q_strncpyz( image->extension, &pathname[len + k + 2], sizeof( image->extension ) );
+		loaded = true;
+	} else {
+		ri.Com_DPrintf( S_COLOR_YELLOW "Missing image: %s\n", image->name );
 	}
 
 	if( loaded ) {
@@ -3224,6 +4135,13 @@ void R_ShutdownImages( void )
 		R_ShutdownImageLoader( i );
 	}
 
+	for( i = 0; i < MAX_GLIMAGES; i++ ) {
+		if( r_imagePreps[i] ) {
+			R_FreePreparedImage( r_imagePreps[i] );
+			r_imagePreps[i] = NULL;
+		}
+	}
+
 	R_ReleaseBuiltinImages();
 
 	for( i = 0, image = r_images; i < MAX_GLIMAGES; i++, image++ ) {
@@ -3413,6 +4331,8 @@ static bool R_LoadAsyncImageFromDisk( image_t *image )
 	R_UnbindImage( image );
 	qglFinish();
 
+	R_SchedulePreparedImage( image );
+
 	R_IssueLoadPicLoaderCmd( id, pic );
 	return true;
 }
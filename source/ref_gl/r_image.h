@@ -113,6 +113,7 @@ image_t *R_GetPortalTexture( int viewportWidth, int viewportHeight, int flags, u
 image_t *R_GetShadowmapAtlasTexture( void );
 void R_InitDrawFlatTexture( void );
 void R_FreeImageBuffers( void );
+void R_ImageBenchmark_f( void );
 
 void R_PrintImageList( const char *pattern, bool ( *filter )( const char *filter, const char *value ) );
 void R_ScreenShot( const char *filename, int x, int y, int width, int height, int quality,
@@ -20,158 +20,98 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "r_local.h"
 
-typedef unsigned (*queueCmdHandler_t)( const void * );
-
-enum {
-	CMD_JOB_TAKE,
-	CMD_JOB_QUIT,
+/*
+* Renderer jobs are run by the engine job scheduler. Job arguments are copied
+* into a local array so that the callers may pass pointers to stack variables.
+*/
 
-	NUM_JOB_CMDS
-};
+#define MAX_RENDER_JOBS     256
 
 typedef struct {
-	int id;
-	unsigned first;
-	unsigned items;
 	jobfunc_t job;
 	jobarg_t job_arg;
-} jobTakeCmd_t;
+	struct qjob_s *handle;
+} rjob_t;
 
-static qbufPipe_t *job_queue[NUM_JOB_THREADS] = { NULL };
-static qthread_t *job_thread[NUM_JOB_THREADS] = { NULL };
-static unsigned job_count;
+static rjob_t r_jobs[MAX_RENDER_JOBS];
+static unsigned r_numJobs;
+
+/*
+* RJ_RunJob
+*/
+static void RJ_RunJob( unsigned first, unsigned items, void *arg ) {
+	rjob_t *rjob = arg;
 
-static void RJ_IssueJobTakeCmd( unsigned thread, jobfunc_t job, jobarg_t *arg, unsigned first, unsigned stride );
-static void RJ_IssueJobQuitCmd( unsigned thread );
-static void *R_JobThreadProc( void *param );
+	rjob->job( first, items, &rjob->job_arg );
+}
 
 /*
 * RJ_Init
 */
 void RJ_Init( void ) {
-	int i;
-
-	job_count = 0;
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		job_queue[i] = ri.BufPipe_Create( 0x4000, 1 );
-		job_thread[i] = ri.Thread_Create( R_JobThreadProc, job_queue[i] );
-	}
+	r_numJobs = 0;
 }
 
 /*
 * RJ_ScheduleJob
 */
 void RJ_ScheduleJob( jobfunc_t job, jobarg_t *arg, unsigned items ) {
-	unsigned first;
-	const unsigned block = ( items + NUM_JOB_THREADS - 1 ) / NUM_JOB_THREADS;
-
-	for( first = 0; first < items; ) {
-		unsigned last = first + block;
-		if( last > items ) {
-			last = items;
-		}
-
-		RJ_IssueJobTakeCmd( job_count % NUM_JOB_THREADS, job, arg, first, last - first );
-		job_count++;
+	unsigned grain;
+	rjob_t *rjob;
 
-		first += last - first;
+	if( !items ) {
+		return;
 	}
-}
-
-/*
-* RJ_FinishJobs
-*/
-void RJ_FinishJobs( void ) {
-	int i;
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ )
-		ri.BufPipe_Finish( job_queue[i] );
-}
-
-/*
-* RJ_Shutdown
-*/
-void RJ_Shutdown( void ) {
-	int i;
 
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		RJ_IssueJobQuitCmd( i );
+	if( r_numJobs == MAX_RENDER_JOBS ) {
+		RJ_FinishJobs();
 	}
 
-	RJ_FinishJobs();
-
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		ri.Thread_Join( job_thread[i] );
-		job_thread[i] = NULL;
-	}
+	rjob = &r_jobs[r_numJobs++];
+	rjob->job = job;
+	rjob->job_arg = *arg;
 
-	for( i = 0; i < NUM_JOB_THREADS; i++ ) {
-		ri.BufPipe_Destroy( &job_queue[i] );
+	// a few chunks per thread so that stealing can even out the load
+	grain = items / ( ( ri.Jobs_NumWorkers() + 1 ) * 4 );
+	if( !grain ) {
+		grain = 1;
 	}
 
-	job_count = 0;
-}
-
-/*
-* RJ_IssueJobTakeCmd
-*/
-static void RJ_IssueJobTakeCmd( unsigned thread, jobfunc_t job, jobarg_t *arg, unsigned first, unsigned items ) {
-	jobTakeCmd_t cmd;
-	cmd.id = CMD_JOB_TAKE;
-	cmd.job = job;
-	cmd.job_arg = *arg;
-	cmd.first = first;
-	cmd.items = items;
-	ri.BufPipe_WriteCmd( job_queue[thread], &cmd, sizeof( cmd ) );
-}
-
-/*
- * RJ_IssueJobQuitCmd
- */
-static void RJ_IssueJobQuitCmd( unsigned thread ) {
-	int cmd = CMD_JOB_QUIT;
-	ri.BufPipe_WriteCmd( job_queue[thread], &cmd, sizeof( cmd ) );
+	rjob->handle = ri.Job_Schedule( RJ_RunJob, rjob, items, grain, NULL, 0 );
 }
 
 /*
-* R_HandleJobTakeCmd
+* RJ_ParallelFor
+*
+* Runs the job over all items and returns once all of them have been processed.
 */
-static unsigned R_HandleJobTakeCmd( void *pcmd ) {
-	jobTakeCmd_t *cmd = pcmd;
+void RJ_ParallelFor( jobfunc_t job, jobarg_t *arg, unsigned items, unsigned grain ) {
+	rjob_t rjob;
 
-	cmd->job( cmd->first, cmd->items, &cmd->job_arg );
+	rjob.job = job;
+	rjob.job_arg = *arg;
+	rjob.handle = NULL;
 
-	return sizeof( *cmd );
+	ri.Jobs_ParallelFor( RJ_RunJob, &rjob, items, grain );
 }
 
 /*
-* R_HandleJobQuitCmd
+* RJ_FinishJobs
 */
-static unsigned R_HandleJobQuitCmd( void *pcmd ) {
-	return 0;
-}
+void RJ_FinishJobs( void ) {
+	unsigned i;
 
-/*
-* R_JobCmdsWaiter
-*/
-static int R_JobCmdsWaiter( qbufPipe_t *queue, queueCmdHandler_t *cmdHandlers, bool timeout ) {
-	return ri.BufPipe_ReadCmds( queue, (void *)cmdHandlers );
+	for( i = 0; i < r_numJobs; i++ ) {
+		ri.Job_Wait( r_jobs[i].handle );
+		ri.Job_Release( &r_jobs[i].handle );
+	}
+
+	r_numJobs = 0;
 }
 
 /*
-* R_JobThreadProc
+* RJ_Shutdown
 */
-static void *R_JobThreadProc( void *param ) {
-	qbufPipe_t *cmdQueue = param;
-	queueCmdHandler_t cmdHandlers[NUM_JOB_CMDS] =
-	{
-		(queueCmdHandler_t)R_HandleJobTakeCmd,
-		(queueCmdHandler_t)R_HandleJobQuitCmd,
-
-	};
-
-	ri.BufPipe_Wait( cmdQueue, R_JobCmdsWaiter, (void*)cmdHandlers, Q_THREADS_WAIT_INFINITE );
-
-	return NULL;
+void RJ_Shutdown( void ) {
+	RJ_FinishJobs();
 }
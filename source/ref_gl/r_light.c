@@ -1003,6 +1003,16 @@ static void R_AllocLightWorldVis( r_lightWorldVis_t *vis, mbrushmodel_t *bm ) {
 	}
 }
 
+/*
+* R_FreeLightWorldVis
+*/
+static void R_FreeLightWorldVis( r_lightWorldVis_t *vis ) {
+	R_Free( vis->visLeafs );
+	R_Free( vis->surfMasks );
+	R_Free( vis->drawSurfPvs );
+	memset( vis, 0, sizeof( *vis ) );
+}
+
 /*
 * R_RtLightMalloc
 */
@@ -1222,7 +1232,8 @@ static void R_CompileRtLightVisInfo( rtlight_t *l, mbrushmodel_t *bm, r_lightWor
 	memcpy( l->visLeafs, vis->visLeafs + 1, sizeof( int ) * lcount );
 
 	// drawSurf, numVisSurfs, (surf, receivermask, castermask)[numVisSurfs]
-	l->surfaceInfo = R_RtLightMalloc( l, sizeof( unsigned ) * (1 + dscount*2 + scount*3) );
+	l->surfaceInfoSize = 1 + dscount*2 + scount*3;
+	l->surfaceInfo = R_RtLightMalloc( l, sizeof( unsigned ) * l->surfaceInfoSize );
 
 	nds = 0;
 	rscount = sscount = 0;
@@ -1273,12 +1284,14 @@ static void R_CompileRtLightVisInfo( rtlight_t *l, mbrushmodel_t *bm, r_lightWor
 }
 
 /*
-* R_GetRtLightVisInfo
+* R_GetRtLightVisInfo_
+*
+* Only touches the light and the given scratch buffers, so it's safe
+* to call from worker threads for distinct lights.
 */
-void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
+static void R_GetRtLightVisInfo_( mbrushmodel_t *bm, rtlight_t *l, r_lightWorldVis_t *vis ) {
 	unsigned i;
 	mleaf_t *leaf;
-	r_lightWorldVis_t *vis = &r_lightWorldVis;
 
 	l->area = -1;
 	l->cluster = CLUSTER_INVALID;
@@ -1289,7 +1302,7 @@ void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
 		l->area = leaf->area;
 	}
 
-	R_AllocLightWorldVis( &r_lightWorldVis, bm );
+	R_AllocLightWorldVis( vis, bm );
 
 	R_GetRtLightLeafVisInfo( l, bm->nodes, bm, vis );
 
@@ -1330,6 +1343,446 @@ void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
 	}
 }
 
+/*
+* R_GetRtLightVisInfo
+*/
+void R_GetRtLightVisInfo( mbrushmodel_t *bm, rtlight_t *l ) {
+	R_GetRtLightVisInfo_( bm, l, &r_lightWorldVis );
+}
+
+/*
+=============================================================================
+
+WORLD LIGHTS COMPILATION
+
+Visibility of static world lights is compiled by worker threads after the map
+has been loaded and persisted in a cache file keyed by the map checksum and
+light parameters. Shadow batches need the GL context so they are compiled on
+the render thread, a few lights per frame. Lights render without shadows until
+their batches are ready.
+
+=============================================================================
+*/
+
+#define RTLIGHTS_VIS_CACHE_VERSION  1
+#define RTLIGHTS_VIS_JOB_GRAIN      4
+#define RTLIGHTS_COMPILE_MSEC       4
+
+typedef struct rtLightsVisCompile_s {
+	model_t *model;
+	unsigned numLights;
+	unsigned *lights;               // indices of world lights missing from the cache
+	struct qjob_s *job;
+} rtLightsVisCompile_t;
+
+/*
+* R_RtLightVisCacheKey
+*/
+static unsigned R_RtLightVisCacheKey( const rtlight_t *l ) {
+	unsigned i;
+	unsigned key = 2166136261u;
+	const uint8_t *p;
+	float params[3 + 9 + 1];
+
+	VectorCopy( l->origin, params );
+	Matrix3_Copy( l->axis, params + 3 );
+	params[12] = l->intensity;
+
+	for( p = ( const uint8_t * )params, i = 0; i < sizeof( params ); i++ ) {
+		key = ( key ^ p[i] ) * 16777619;
+	}
+	key = ( key ^ ( l->shadow ? 1 : 0 ) ) * 16777619;
+
+	return key;
+}
+
+/*
+* R_RtLightVisCacheFileName
+*/
+static void R_RtLightVisCacheFileName( const model_t *mod, char *path, size_t size ) {
+	Q_snprintfz( path, size, "cache/%s", mod->name );
+	COM_ReplaceExtension( path, ".rtvis", size );
+}
+
+/*
+* R_SurfaceInfoSize
+*
+* Returns the number of words used by the surface info list or 0 if
+* the list doesn't fit into maxSize words or references bogus surfaces.
+*/
+static unsigned R_SurfaceInfoSize( const mbrushmodel_t *bm, const unsigned *surfaceInfo, unsigned maxSize ) {
+	unsigned i, j, n, nds;
+	const unsigned *p = surfaceInfo, *end = surfaceInfo + maxSize;
+
+	if( p >= end ) {
+		return 0;
+	}
+
+	nds = *p++;
+	for( i = 0; i < nds; i++ ) {
+		if( end - p < 2 || p[0] >= bm->numDrawSurfaces ) {
+			return 0;
+		}
+
+		n = p[1];
+		p += 2;
+		if( (size_t)( end - p ) / 3 < n ) {
+			return 0;
+		}
+
+		for( j = 0; j < n; j++, p += 3 ) {
+			if( p[0] >= bm->numsurfaces ) {
+				return 0;
+			}
+		}
+	}
+
+	return p - surfaceInfo;
+}
+
+/*
+* R_LoadRtLightsVisCache
+*
+* Restores vis info of world lights from the cache file. Returns the number of lights
+* that have been found in the cache, these are marked as ready.
+*
+* File format:
+* version checksum numleafs numsurfaces numdrawsurfaces numrecords
+* key cluster area worldmins[3] worldmaxs[3] numleafs infosize numreceive numshadow leafs[] info[]
+* ..
+*/
+static unsigned R_LoadRtLightsVisCache( model_t *mod ) {
+	unsigned i, j, k;
+	unsigned numRecords, numLoaded;
+	unsigned *buffer, *p, *end, **records;
+	int length;
+	char path[MAX_QPATH];
+	mbrushmodel_t *bm = ( mbrushmodel_t * )mod->extradata;
+
+	R_RtLightVisCacheFileName( mod, path, sizeof( path ) );
+
+	length = R_LoadCacheFile( path, ( void ** )&buffer );
+	if( !buffer ) {
+		return 0;
+	}
+
+	p = buffer;
+	end = buffer + length / sizeof( unsigned );
+
+	if( end - p < 6 || p[0] != RTLIGHTS_VIS_CACHE_VERSION || p[1] != bm->checksum 
+		|| p[2] != bm->numleafs || p[3] != bm->numsurfaces || p[4] != bm->numDrawSurfaces ) {
+		ri.Com_DPrintf( "Ignoring rtlights vis cache %s: version or map mismatch\n", path );
+		R_FreeFile( buffer );
+		return 0;
+	}
+
+	numRecords = p[5];
+	p += 6;
+
+	// index the records so that lights don't have to be stored in the same order
+	records = R_Malloc( sizeof( *records ) * ( numRecords + 1 ) );
+	for( i = 0; i < numRecords; i++ ) {
+		unsigned numLeafs, infoSize;
+
+		if( end - p < 13 ) {
+			break;
+		}
+
+		numLeafs = p[9];
+		infoSize = p[10];
+		if( (size_t)( end - p - 13 ) < (size_t)numLeafs + infoSize ) {
+			break;
+		}
+		for( j = 0; j < numLeafs; j++ ) {
+			if( p[13 + j] >= bm->numleafs ) {
+				break;
+			}
+		}
+		if( j < numLeafs || R_SurfaceInfoSize( bm, p + 13 + numLeafs, infoSize ) != infoSize ) {
+			break;
+		}
+
+		records[i] = p;
+		p += 13 + numLeafs + infoSize;
+	}
+
+	if( i < numRecords ) {
+		ri.Com_DPrintf( S_COLOR_YELLOW "Ignoring rtlights vis cache %s: file is corrupt\n", path );
+		R_Free( records );
+		R_FreeFile( buffer );
+		return 0;
+	}
+
+	numLoaded = 0;
+	for( i = 0, k = 0; i < bm->numRtLights; i++ ) {
+		unsigned key;
+		unsigned numLeafs, infoSize;
+		rtlight_t *l = bm->rtLights + i;
+
+		if( l->directional || !numRecords ) {
+			continue;
+		}
+
+		key = R_RtLightVisCacheKey( l );
+
+		// lights are usually stored in the same order
+		for( j = 0; j < numRecords; j++, k = ( k + 1 ) % numRecords ) {
+			if( records[k][0] == key ) {
+				break;
+			}
+		}
+		if( j == numRecords ) {
+			continue;
+		}
+
+		p = records[k];
+		k = ( k + 1 ) % numRecords;
+
+		l->cluster = (int)p[1];
+		l->area = (int)p[2];
+		memcpy( l->worldmins, p + 3, sizeof( vec3_t ) );
+		memcpy( l->worldmaxs, p + 6, sizeof( vec3_t ) );
+
+		numLeafs = p[9];
+		infoSize = p[10];
+		l->numReceiveSurfaces = p[11];
+		l->numShadowSurfaces = p[12];
+
+		l->numVisLeafs = numLeafs;
+		l->visLeafs = R_RtLightMalloc( l, sizeof( unsigned ) * ( numLeafs + 1 ) );
+		memcpy( l->visLeafs, p + 13, sizeof( unsigned ) * numLeafs );
+
+		l->surfaceInfoSize = infoSize;
+		l->surfaceInfo = R_RtLightMalloc( l, sizeof( unsigned ) * infoSize );
+		memcpy( l->surfaceInfo, p + 13 + numLeafs, sizeof( unsigned ) * infoSize );
+
+		l->visPending = false;
+		numLoaded++;
+	}
+
+	R_Free( records );
+	R_FreeFile( buffer );
+
+	return numLoaded;
+}
+
+/*
+* R_StoreRtLightsVisCache
+*/
+static void R_StoreRtLightsVisCache( model_t *mod ) {
+	unsigned i;
+	unsigned numRecords;
+	unsigned header[6];
+	int handle;
+	char path[MAX_QPATH];
+	mbrushmodel_t *bm = ( mbrushmodel_t * )mod->extradata;
+
+	numRecords = 0;
+	for( i = 0; i < bm->numRtLights; i++ ) {
+		const rtlight_t *l = bm->rtLights + i;
+		if( !l->directional && l->surfaceInfo ) {
+			numRecords++;
+		}
+	}
+
+	R_RtLightVisCacheFileName( mod, path, sizeof( path ) );
+
+	if( ri.FS_FOpenFile( path, &handle, FS_WRITE | FS_CACHE ) == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "Could not open %s for writing.\n", path );
+		return;
+	}
+
+	header[0] = RTLIGHTS_VIS_CACHE_VERSION;
+	header[1] = bm->checksum;
+	header[2] = bm->numleafs;
+	header[3] = bm->numsurfaces;
+	header[4] = bm->numDrawSurfaces;
+	header[5] = numRecords;
+	ri.FS_Write( header, sizeof( header ), handle );
+
+	for( i = 0; i < bm->numRtLights; i++ ) {
+		unsigned record[13];
+		const rtlight_t *l = bm->rtLights + i;
+
+		if( l->directional || !l->surfaceInfo ) {
+			continue;
+		}
+
+		record[0] = R_RtLightVisCacheKey( l );
+		record[1] = (unsigned)l->cluster;
+		record[2] = (unsigned)l->area;
+		memcpy( record + 3, l->worldmins, sizeof( vec3_t ) );
+		memcpy( record + 6, l->worldmaxs, sizeof( vec3_t ) );
+		record[9] = l->numVisLeafs;
+		record[10] = R_SurfaceInfoSize( bm, l->surfaceInfo, l->surfaceInfoSize );
+		record[11] = l->numReceiveSurfaces;
+		record[12] = l->numShadowSurfaces;
+
+		ri.FS_Write( record, sizeof( record ), handle );
+		ri.FS_Write( l->visLeafs, sizeof( unsigned ) * l->numVisLeafs, handle );
+		ri.FS_Write( l->surfaceInfo, sizeof( unsigned ) * record[10], handle );
+	}
+
+	ri.FS_FCloseFile( handle );
+}
+
+/*
+* R_CompileRtLightsVisJob
+*/
+static void R_CompileRtLightsVisJob( unsigned first, unsigned items, void *arg ) {
+	unsigned i;
+	rtLightsVisCompile_t *vc = arg;
+	mbrushmodel_t *bm = ( mbrushmodel_t * )vc->model->extradata;
+	r_lightWorldVis_t vis;
+
+	memset( &vis, 0, sizeof( vis ) );
+
+	for( i = first; i < first + items; i++ ) {
+		R_GetRtLightVisInfo_( bm, bm->rtLights + vc->lights[i], &vis );
+	}
+
+	R_FreeLightWorldVis( &vis );
+}
+
+/*
+* R_CompileWorldRtLightsVis
+*
+* Called after world lights have been loaded. Lights that are missing from
+* the cache file are compiled in the background.
+*/
+void R_CompileWorldRtLightsVis( model_t *mod ) {
+	unsigned i;
+	unsigned numPending;
+	rtLightsVisCompile_t *vc;
+	mbrushmodel_t *bm;
+
+	if( !mod || !( bm = ( mbrushmodel_t * )mod->extradata ) || !bm->numRtLights ) {
+		return;
+	}
+
+	R_FinishWorldRtLightsVis( mod, true );
+
+	for( i = 0; i < bm->numRtLights; i++ ) {
+		bm->rtLights[i].visPending = true;
+	}
+
+	R_LoadRtLightsVisCache( mod );
+
+	vc = R_Malloc( sizeof( *vc ) + sizeof( unsigned ) * bm->numRtLights );
+	vc->model = mod;
+	vc->lights = ( unsigned * )( vc + 1 );
+
+	numPending = 0;
+	for( i = 0; i < bm->numRtLights; i++ ) {
+		if( bm->rtLights[i].visPending ) {
+			vc->lights[numPending++] = i;
+		}
+	}
+
+	if( !numPending ) {
+		R_Free( vc );
+		return;
+	}
+
+	ri.Com_DPrintf( "Compiling visibility for %u of %u world lights\n", numPending, bm->numRtLights );
+
+	vc->numLights = numPending;
+	vc->job = ri.Job_Schedule( &R_CompileRtLightsVisJob, vc, numPending, RTLIGHTS_VIS_JOB_GRAIN, NULL, 0 );
+	bm->rtLightsVis = vc;
+}
+
+/*
+* R_FinishWorldRtLightsVis
+*
+* Marks lights as ready and updates the cache file once the background compilation
+* has completed. Unless wait is true, returns immediately if it's still in progress.
+*/
+void R_FinishWorldRtLightsVis( model_t *mod, bool wait ) {
+	unsigned i;
+	rtLightsVisCompile_t *vc;
+	mbrushmodel_t *bm;
+
+	if( !mod || !( bm = ( mbrushmodel_t * )mod->extradata ) || !bm->rtLightsVis ) {
+		return;
+	}
+
+	vc = bm->rtLightsVis;
+	if( wait ) {
+		ri.Job_Wait( vc->job );
+	} else if( !ri.Job_Done( vc->job ) ) {
+		return;
+	}
+
+	ri.Job_Release( &vc->job );
+
+	for( i = 0; i < vc->numLights; i++ ) {
+		bm->rtLights[vc->lights[i]].visPending = false;
+	}
+
+	R_StoreRtLightsVisCache( mod );
+
+	R_Free( vc );
+	bm->rtLightsVis = NULL;
+}
+
+/*
+* R_BeginCompileWorldRtLights
+*
+* Queues shadow batches of all world lights for compilation.
+*/
+void R_BeginCompileWorldRtLights( model_t *mod ) {
+	unsigned i;
+	bool compile = r_lighting_realtime_world->integer && r_lighting_realtime_world_shadows->integer;
+	mbrushmodel_t *bm;
+
+	if( !mod || !( bm = ( mbrushmodel_t * )mod->extradata ) ) {
+		return;
+	}
+
+	for( i = 0; i < bm->numRtLights; i++ ) {
+		bm->rtLights[i].shadowPending = compile && bm->rtLights[i].shadow;
+	}
+	for( i = 0; i < bm->numRtSkyLights; i++ ) {
+		bm->rtSkyLights[i].shadowPending = compile && bm->rtSkyLights[i].shadow;
+	}
+}
+
+/*
+* R_CompileWorldRtLights
+*
+* Compiles pending shadow batches, spending at most a few milliseconds per frame.
+*/
+void R_CompileWorldRtLights( model_t *mod ) {
+	unsigned i, j;
+	int64_t start = ri.Sys_Milliseconds();
+	mbrushmodel_t *bm;
+
+	if( !mod || !( bm = ( mbrushmodel_t * )mod->extradata ) ) {
+		return;
+	}
+
+	R_FinishWorldRtLightsVis( mod, false );
+
+	for( i = 0; i < 2; i++ ) {
+		unsigned numLights = i ? bm->numRtLights : bm->numRtSkyLights;
+		rtlight_t *lights = i ? bm->rtLights : bm->rtSkyLights;
+
+		for( j = 0; j < numLights; j++ ) {
+			rtlight_t *l = lights + j;
+
+			if( !l->shadowPending || l->visPending ) {
+				continue;
+			}
+			if( ri.Sys_Milliseconds() - start >= RTLIGHTS_COMPILE_MSEC ) {
+				return;
+			}
+
+			R_CompileRtLight( l );
+			l->shadowPending = false;
+		}
+	}
+}
+
 /*
 * R_SetRtLightColor
 */
@@ -1578,6 +2031,11 @@ unsigned R_CullRtLights( unsigned numLights, rtlight_t *lights, unsigned clipFla
 			continue;
 		}
 
+		if( l->visPending ) {
+			// no world vis info yet
+			continue;
+		}
+
 		if( !l->radius ) {
 			continue;
 		}
@@ -1670,7 +2128,7 @@ unsigned R_CullRtLights( unsigned numLights, rtlight_t *lights, unsigned clipFla
 
 		if( l->world ) {
 			rf.stats.c_world_lights++;
-			if( l->shadow ) {
+			if( l->shadow && !l->shadowPending ) {
 				rf.stats.c_world_light_shadows++;
 			}
 		} else {
@@ -1856,6 +2314,7 @@ void R_UncompileRtLight( rtlight_t *l ) {
 	l->cluster = CLUSTER_UNKNOWN;
 	l->visLeafs = NULL;
 	l->surfaceInfo = NULL;
+	l->surfaceInfoSize = 0;
 }
 
 /*
@@ -83,6 +83,8 @@ typedef struct rtlight_s {
 	bool directional;
 	bool sky;
 	bool cascaded;
+	bool visPending;		// world vis info is being compiled in the background
+	bool shadowPending;		// shadow batches haven't been compiled yet, render unshadowed
 
 	// frame data
 	unsigned sceneFrame;
@@ -144,6 +146,7 @@ typedef struct rtlight_s {
 
 	unsigned *visLeafs;
 	unsigned *surfaceInfo;
+	unsigned surfaceInfoSize;           // allocated length of surfaceInfo in words
 
 	struct model_s *worldModel;
 	void *compiledSurf[6];
@@ -189,6 +192,11 @@ void		R_CompileRtLight( rtlight_t *l );
 void		R_UncompileRtLight( rtlight_t *l );
 void		R_TouchRtLight( rtlight_t *l );
 
+void		R_CompileWorldRtLightsVis( model_t *mod );
+void		R_FinishWorldRtLightsVis( model_t *mod, bool wait );
+void		R_BeginCompileWorldRtLights( model_t *mod );
+void		R_CompileWorldRtLights( model_t *mod );
+
 void		R_RenderDebugLightVolumes( void );
 
 #endif // R_LIGHT_H
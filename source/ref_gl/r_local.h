@@ -340,6 +340,8 @@ typedef struct {
 		unsigned int c_world_lights, c_dynamic_lights;
 		unsigned int c_world_light_shadows, c_dynamic_light_shadows;
 		unsigned int c_ents_total, c_ents_bmodels;
+		unsigned int c_skm_poses, c_skm_poses_cached;
+		unsigned int c_skm_skins, c_skm_skins_cached;
 		unsigned int t_cull_world_nodes, t_cull_world_surfs;
 		unsigned int t_cull_rtlights;
 		unsigned int t_world_node, t_light_node;
@@ -477,6 +479,7 @@ extern cvar_t *r_gamma;
 extern cvar_t *r_texturemode;
 extern cvar_t *r_texturefilter;
 extern cvar_t *r_texturecompression;
+extern cvar_t *r_texturecache;
 extern cvar_t *r_mode;
 extern cvar_t *r_nobind;
 extern cvar_t *r_picmip;
@@ -488,6 +491,7 @@ extern cvar_t *r_screenshot_format;
 extern cvar_t *r_screenshot_jpeg_quality;
 extern cvar_t *r_swapinterval;
 extern cvar_t *r_swapinterval_min;
+extern cvar_t *r_maxqueuedframes;
 
 extern cvar_t *r_temp1;
 
@@ -752,6 +756,7 @@ void R_ReserveDrawListWorldSurfaces( drawList_t *list );
 void R_InitDrawLists( void );
 
 void R_SortDrawList( drawList_t *list );
+void R_DrawSortBenchmark_f( void );
 void R_DrawSurfaces( drawList_t *list );
 void R_DrawPortalSurfaces( drawList_t *list );
 void R_DrawSkySurfaces( drawList_t *list );
@@ -842,6 +847,9 @@ void        R_SkeletalGetBonePose( const model_t *mod, int bonenum, int frame, b
 int         R_SkeletalGetNumBones( const model_t *mod, int *numFrames );
 bool        R_SkeletalModelLerpTag( orientation_t *orient, const mskmodel_t *skmodel, int oldframenum, int framenum, float lerpfrac, const char *name );
 void		R_ClearSkeletalCache( void );
+void		R_ResetSkeletalCache( void );
+void		R_FreeSkeletalCache( void );
+void        R_SkeletalSelfTest_f( void );
 
 //
 // r_vbo.c
@@ -1699,6 +1699,7 @@ const char *R_WriteSpeedsMessage( char *out, size_t size ) {
 							 "polys\\ents: %5u\\%5u  draw: %5u\n"
 							 "world\\dynamic: lights %3u\\%3u  shadows %3u\\%3u\n"
 							 "ents total: %5u bmodels: %5u\n"
+							 "skeletal poses\\cached: %4u\\%4u  skins\\cached: %4u\\%4u\n"
 							 "frame cache: %.3fMB\n"
 							 "%s",
 							 (int)(1000.0 / rf.frameTime.average),
@@ -1708,6 +1709,7 @@ const char *R_WriteSpeedsMessage( char *out, size_t size ) {
 							 rf.stats.t_add_polys, rf.stats.t_add_entities, rf.stats.t_draw_meshes,
 							 rf.stats.c_world_lights, rf.stats.c_dynamic_lights, rf.stats.c_world_light_shadows, rf.stats.c_dynamic_light_shadows,
 							 rf.stats.c_ents_total, rf.stats.c_ents_bmodels,
+							 rf.stats.c_skm_poses, rf.stats.c_skm_poses_cached, rf.stats.c_skm_skins, rf.stats.c_skm_skins_cached,
 							 R_FrameCache_TotalSize() / 1048576.0,
 							 backend_msg
 							);
@@ -1882,6 +1884,8 @@ void R_BeginFrame( float cameraSeparation, bool forceClear, int swapInterval ) {
 
 	memset( &rf.stats, 0, sizeof( rf.stats ) );
 
+	R_ResetSkeletalCache();
+
 	// update fps meter
 	rf.frameTime.count++;
 	rf.frameTime.time = time;
@@ -287,7 +287,7 @@ portalSurface_t *R_GetDrawListSurfPortal( void *psds ) {
 /*
 * R_DrawSurfCompare
 *
-* Comparison callback function for R_SortDrawList
+* Comparison callback function for qsort, only used to benchmark the radix sort
 */
 static int R_DrawSurfCompare( const sortedDrawSurf_t *sbs1, const sortedDrawSurf_t *sbs2 ) {
 	if( sbs1->distKey > sbs2->distKey ) {
@@ -315,18 +315,316 @@ static int R_DrawSurfCompare( const sortedDrawSurf_t *sbs1, const sortedDrawSurf
 }
 
 /*
-* R_SortDrawList
+=============================================================
+
+RADIX SORT
+
+=============================================================
+*/
+
+// the draw surfaces are ordered by the 32-bit distance key first and then by
+// the 48-bit sort key, sorting 8 bits per pass starting with the sort key
+#define DRAWSORT_RADIX_BITS         8
+#define DRAWSORT_RADIX_SIZE         ( 1 << DRAWSORT_RADIX_BITS )
+#define DRAWSORT_SORTKEY_PASSES     6
+#define DRAWSORT_NUM_PASSES         ( DRAWSORT_SORTKEY_PASSES + 4 )
+
+#define DRAWSORT_PARALLEL_MIN_ITEMS 8192
+#define DRAWSORT_MAX_CHUNKS         32
+
+typedef struct {
+	uint64_t sortKey;
+	unsigned distKey;
+	unsigned index;
+} drawSortItem_t;
+
+typedef struct {
+	int pass;
+	unsigned numItems;
+	unsigned numChunks;
+	unsigned chunkSize;
+	const drawSortItem_t *src;
+	drawSortItem_t *dst;
+	unsigned counts[DRAWSORT_MAX_CHUNKS][DRAWSORT_RADIX_SIZE];
+} drawSortJob_t;
+
+static drawSortJob_t r_drawSortJob;
+
+/*
+* R_DrawSortDigit
+*/
+static inline unsigned R_DrawSortDigit( const drawSortItem_t *item, int pass ) {
+	if( pass < DRAWSORT_SORTKEY_PASSES ) {
+		return ( item->sortKey >> ( pass * DRAWSORT_RADIX_BITS ) ) & ( DRAWSORT_RADIX_SIZE - 1 );
+	}
+	return ( item->distKey >> ( ( pass - DRAWSORT_SORTKEY_PASSES ) * DRAWSORT_RADIX_BITS ) ) & ( DRAWSORT_RADIX_SIZE - 1 );
+}
+
+/*
+* R_RadixSortDrawItems
+*
+* Returns either items or temp, whichever ends up holding the sorted array.
+*/
+static drawSortItem_t *R_RadixSortDrawItems( drawSortItem_t *items, drawSortItem_t *temp, unsigned numItems ) {
+	int pass;
+	unsigned i, b, sum, count;
+	unsigned counts[DRAWSORT_NUM_PASSES][DRAWSORT_RADIX_SIZE];
+	drawSortItem_t *src = items, *dst = temp, *swap;
+
+	memset( counts, 0, sizeof( counts ) );
+
+	for( i = 0; i < numItems; i++ ) {
+		for( pass = 0; pass < DRAWSORT_NUM_PASSES; pass++ ) {
+			counts[pass][R_DrawSortDigit( &items[i], pass )]++;
+		}
+	}
+
+	for( pass = 0; pass < DRAWSORT_NUM_PASSES; pass++ ) {
+		unsigned *c = counts[pass];
+
+		// all items share the same digit, nothing to do for this pass
+		if( c[R_DrawSortDigit( &src[0], pass )] == numItems ) {
+			continue;
+		}
+
+		for( b = 0, sum = 0; b < DRAWSORT_RADIX_SIZE; b++ ) {
+			count = c[b];
+			c[b] = sum;
+			sum += count;
+		}
+
+		for( i = 0; i < numItems; i++ ) {
+			dst[c[R_DrawSortDigit( &src[i], pass )]++] = src[i];
+		}
+
+		swap = src, src = dst, dst = swap;
+	}
+
+	return src;
+}
+
+/*
+* R_DrawSortCountJob
+*/
+static void R_DrawSortCountJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned c, i, end;
+	drawSortJob_t *job = ja->parg;
+
+	for( c = first; c < first + items; c++ ) {
+		unsigned *counts = job->counts[c];
+
+		memset( counts, 0, sizeof( job->counts[c] ) );
+
+		end = min( ( c + 1 ) * job->chunkSize, job->numItems );
+		for( i = c * job->chunkSize; i < end; i++ ) {
+			counts[R_DrawSortDigit( &job->src[i], job->pass )]++;
+		}
+	}
+}
+
+/*
+* R_DrawSortScatterJob
+*/
+static void R_DrawSortScatterJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned c, i, end;
+	drawSortJob_t *job = ja->parg;
+
+	for( c = first; c < first + items; c++ ) {
+		unsigned *offsets = job->counts[c];
+
+		end = min( ( c + 1 ) * job->chunkSize, job->numItems );
+		for( i = c * job->chunkSize; i < end; i++ ) {
+			job->dst[offsets[R_DrawSortDigit( &job->src[i], job->pass )]++] = job->src[i];
+		}
+	}
+}
+
+/*
+* R_RadixSortDrawItemsParallel
+*
+* Every pass counts digits and scatters the items per chunk on the job threads.
+* Chunks are scattered to consecutive slots of each bucket, keeping the sort stable.
+*/
+static drawSortItem_t *R_RadixSortDrawItemsParallel( drawSortItem_t *items, drawSortItem_t *temp, unsigned numItems ) {
+	int pass;
+	unsigned b, c, sum, count;
+	jobarg_t ja;
+	drawSortJob_t *job = &r_drawSortJob;
+	drawSortItem_t *src = items, *dst = temp, *swap;
+
+	job->numItems = numItems;
+	job->numChunks = min( ( ri.Jobs_NumWorkers() + 1 ) * 2, DRAWSORT_MAX_CHUNKS );
+	job->chunkSize = ( numItems + job->numChunks - 1 ) / job->numChunks;
+	job->numChunks = ( numItems + job->chunkSize - 1 ) / job->chunkSize;
+
+	memset( &ja, 0, sizeof( ja ) );
+	ja.parg = job;
+
+	for( pass = 0; pass < DRAWSORT_NUM_PASSES; pass++ ) {
+		job->pass = pass;
+		job->src = src;
+		job->dst = dst;
+
+		RJ_ParallelFor( R_DrawSortCountJob, &ja, job->numChunks, 1 );
+
+		// all items share the same digit, nothing to do for this pass
+		b = R_DrawSortDigit( &src[0], pass );
+		for( c = 0, count = 0; c < job->numChunks; c++ ) {
+			count += job->counts[c][b];
+		}
+		if( count == numItems ) {
+			continue;
+		}
+
+		// turn the counts into the first output slot for each chunk and bucket
+		for( b = 0, sum = 0; b < DRAWSORT_RADIX_SIZE; b++ ) {
+			for( c = 0; c < job->numChunks; c++ ) {
+				count = job->counts[c][b];
+				job->counts[c][b] = sum;
+				sum += count;
+			}
+		}
+
+		RJ_ParallelFor( R_DrawSortScatterJob, &ja, job->numChunks, 1 );
+
+		swap = src, src = dst, dst = swap;
+	}
+
+	return src;
+}
+
+/*
+* R_SortDrawSurfs
 *
-* Regular quicksort. Note that for all kinds of transparent meshes
-* you probably want to set distance or draw order to prevent flickering
-* due to quicksort's unstable nature.
+* Stable radix sort, surfaces with equal keys are kept in the order they were added.
+*/
+static void R_SortDrawSurfs( sortedDrawSurf_t *drawSurfs, unsigned numDrawSurfs, bool parallel ) {
+	unsigned i;
+	void *cachemark;
+	drawSortItem_t *items, *temp, *sorted;
+	sortedDrawSurf_t *unsorted;
+
+	if( numDrawSurfs < 2 ) {
+		return;
+	}
+
+	cachemark = R_FrameCache_SetMark();
+
+	items = R_FrameCache_Alloc( numDrawSurfs * sizeof( *items ) );
+	temp = R_FrameCache_Alloc( numDrawSurfs * sizeof( *temp ) );
+	unsorted = R_FrameCache_Alloc( numDrawSurfs * sizeof( *unsorted ) );
+
+	for( i = 0; i < numDrawSurfs; i++ ) {
+		items[i].sortKey = drawSurfs[i].sortKey;
+		items[i].distKey = drawSurfs[i].distKey;
+		items[i].index = i;
+	}
+
+	if( parallel ) {
+		sorted = R_RadixSortDrawItemsParallel( items, temp, numDrawSurfs );
+	} else {
+		sorted = R_RadixSortDrawItems( items, temp, numDrawSurfs );
+	}
+
+	memcpy( unsorted, drawSurfs, numDrawSurfs * sizeof( *unsorted ) );
+	for( i = 0; i < numDrawSurfs; i++ ) {
+		drawSurfs[i] = unsorted[sorted[i].index];
+	}
+
+	R_FrameCache_FreeToMark( cachemark );
+}
+
+/*
+* R_SortDrawList
 */
 void R_SortDrawList( drawList_t *list ) {
+	bool parallel;
+
 	if( r_draworder->integer ) {
 		return;
 	}
-	qsort( list->drawSurfs, list->numDrawSurfs, sizeof( sortedDrawSurf_t ),
-		   ( int ( * )( const void *, const void * ) )R_DrawSurfCompare );
+
+	parallel = list->numDrawSurfs >= DRAWSORT_PARALLEL_MIN_ITEMS && ri.Jobs_NumWorkers() > 0;
+
+	R_SortDrawSurfs( list->drawSurfs, list->numDrawSurfs, parallel );
+}
+
+/*
+* R_DrawSortBenchmark_f
+*
+* Sorts a shuffled copy of the last frame's world draw list, optionally
+* replicated a number of times, with qsort and the radix sorts.
+*/
+void R_DrawSortBenchmark_f( void ) {
+	int i, method, copies;
+	unsigned j, n, seed;
+	uint64_t start, total;
+	sortedDrawSurf_t *input, *work, *reference, tmp;
+	const unsigned numSurfs = r_worldlist.numDrawSurfs;
+	const int iterations = 10;
+	const char *names[] = { "qsort", "radix", "parallel radix" };
+
+	if( !numSurfs ) {
+		Com_Printf( "No draw surfaces, render a frame first\n" );
+		return;
+	}
+
+	copies = ri.Cmd_Argc() > 1 ? atoi( ri.Cmd_Argv( 1 ) ) : 1;
+	clamp_low( copies, 1 );
+	clamp_high( copies, 256 );
+
+	n = numSurfs * copies;
+	input = R_Malloc( n * sizeof( *input ) );
+	work = R_Malloc( n * sizeof( *work ) );
+	reference = R_Malloc( n * sizeof( *reference ) );
+
+	for( i = 0; i < copies; i++ ) {
+		memcpy( input + i * numSurfs, r_worldlist.drawSurfs, numSurfs * sizeof( *input ) );
+	}
+
+	// the list has already been sorted, shuffle it
+	for( j = n - 1, seed = 1; j > 0; j-- ) {
+		unsigned k;
+
+		seed = seed * 1103515245 + 12345;
+		k = ( seed >> 8 ) % ( j + 1 );
+		tmp = input[j], input[j] = input[k], input[k] = tmp;
+	}
+
+	Com_Printf( "Sorting %u draw surfaces, %i iterations\n", n, iterations );
+
+	for( method = 0; method < 3; method++ ) {
+		total = 0;
+
+		for( i = 0; i < iterations; i++ ) {
+			memcpy( work, input, n * sizeof( *work ) );
+
+			start = ri.Sys_Microseconds();
+			if( method == 0 ) {
+				qsort( work, n, sizeof( *work ), ( int ( * )( const void *, const void * ) )R_DrawSurfCompare );
+			} else {
+				R_SortDrawSurfs( work, n, method == 2 );
+			}
+			total += ri.Sys_Microseconds() - start;
+		}
+
+		if( method == 0 ) {
+			memcpy( reference, work, n * sizeof( *reference ) );
+		} else {
+			for( j = 0; j < n; j++ ) {
+				if( work[j].distKey != reference[j].distKey || work[j].sortKey != reference[j].sortKey ) {
+					Com_Printf( S_COLOR_RED "%s: mismatch at %u\n", names[method], j );
+					break;
+				}
+			}
+		}
+
+		Com_Printf( "%s: %" PRIu64 "us\n", names[method], total / iterations );
+	}
+
+	R_Free( reference );
+	R_Free( work );
+	R_Free( input );
 }
 
 static const drawSurf_cb r_drawSurfCb[ST_MAX_TYPES] =
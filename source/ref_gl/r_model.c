@@ -824,6 +824,10 @@ void R_InitModels( void ) {
 * Mod_Free
 */
 static void Mod_Free( model_t *model ) {
+	if( model->type == mod_brush ) {
+		R_FinishWorldRtLightsVis( model, true );
+	}
+
 	R_FreePool( &model->mempool );
 	memset( model, 0, sizeof( *model ) );
 	model->type = mod_free;
@@ -848,6 +852,9 @@ void R_FreeUnusedModels( void ) {
 		Mod_Free( mod );
 	}
 
+	// cached bone transforms may reference freed models
+	R_ResetSkeletalCache();
+
 	// check whether the world model has been freed
 	if( rsh.worldModel && rsh.worldModel->type == mod_free ) {
 		rsh.worldModel = NULL;
@@ -951,6 +958,21 @@ model_t *Mod_ForHandle( unsigned int elem ) {
 	return mod_known + elem;
 }
 
+/*
+* Mod_Checksum
+*/
+static unsigned Mod_Checksum( const void *data, size_t size ) {
+	size_t i;
+	unsigned checksum = 2166136261u;
+	const uint8_t *p = data;
+
+	for( i = 0; i < size; i++ ) {
+		checksum = ( checksum ^ p[i] ) * 16777619;
+	}
+
+	return checksum;
+}
+
 /*
 * Mod_ForName
 *
@@ -963,6 +985,7 @@ model_t *Mod_ForName( const char *name, bool crash ) {
 	const char *extension;
 	const modelFormatDescr_t *descr;
 	bspFormatDesc_t *bspFormat = NULL;
+	unsigned checksum = 0;
 
 	if( !name[0] ) {
 		ri.Com_Error( ERR_DROP, "Mod_ForName: NULL name" );
@@ -1024,6 +1047,8 @@ model_t *Mod_ForName( const char *name, bool crash ) {
 	if( mod_isworldmodel ) {
 		// we only init map config when loading the map from disk
 		R_InitMapConfig( name );
+
+		checksum = Mod_Checksum( buf, modfilelen );
 	} else if( rsh.worldModel != NULL ) {
 		if( bspFormat != NULL ) {
 			ri.Com_Error( ERR_DROP, "Loaded a brush model after the world" );
@@ -1049,7 +1074,12 @@ model_t *Mod_ForName( const char *name, bool crash ) {
 	}
 
 	if( mod_isworldmodel ) {
+		( ( mbrushmodel_t * )mod->extradata )->checksum = checksum;
+
 		R_LoadWorldRtLights( mod );
+
+		// vis info of world lights is compiled in the background
+		R_CompileWorldRtLightsVis( mod );
 	
 		R_LoadWorldRtSkyLights( mod );
 
@@ -1314,8 +1344,6 @@ static void R_LoadWorldRtLightsFromMap( model_t *model ) {
 			if( cubemap[0] != '\0' ) {
 				l->cubemapFilter = R_FindImage( cubemap, NULL, IT_SRGB | IT_CLAMP | IT_CUBEMAP, 1, IMAGE_TAG_WORLD, NULL );
 			}
-
-			R_GetRtLightVisInfo( bmodel, l );
 		}
 	}
 
@@ -1451,8 +1479,6 @@ static void R_LoadWorldRtLights( model_t *model ) {
 			l->cubemapFilter = R_FindImage( cubemap, NULL, IT_SRGB | IT_CLAMP | IT_CUBEMAP, 1, IMAGE_TAG_WORLD, NULL );
 		}
 
-		R_GetRtLightVisInfo( bmodel, l );
-
 		if( *s == '\r' )
 			s++;
 		if( *s == '\n' )
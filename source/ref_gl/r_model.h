@@ -176,6 +176,9 @@ typedef struct mbrushmodel_s {
 
 	unsigned int numRtLights;
 	struct rtlight_s *rtLights;
+	struct rtLightsVisCompile_s *rtLightsVis;   // background vis compilation of rtLights
+
+	unsigned checksum;                          // of the BSP file, keys cache files
 
 	unsigned int numRtSkyLights;
 	struct rtlight_s *rtSkyLights;
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "r_local.h"
 #include "../qalgo/q_trie.h"
+#include "../qalgo/hash.h"
 
 #define MAX_GLSL_PROGRAMS           1024
 #define GLSL_PROGRAMS_HASH_SIZE     256
@@ -34,6 +35,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define GLSL_CACHE_FILE_NAME            "cache/glsl.cache"
 #define GLSL_BINARY_CACHE_FILE_NAME     "cache/glsl.cache.bin"
+#define GLSL_BINARY_CACHE_VERSION       1
 
 typedef struct {
 	r_glslfeat_t bit;
@@ -55,6 +57,9 @@ typedef struct glsl_program_s {
 
 	int binaryCachePos;
 
+	bool precompiled;           // registered from the precache list
+	bool used;                  // requested by the renderer after being precompiled
+
 	struct loc_s {
 		int ModelViewMatrix,
 			ModelViewProjectionMatrix,
@@ -155,15 +160,46 @@ static unsigned int r_numglslprograms;
 static glsl_program_t r_glslprograms[MAX_GLSL_PROGRAMS];
 static glsl_program_t *r_glslprograms_hash[GLSL_PROGRAM_TYPE_MAXTYPE][GLSL_PROGRAMS_HASH_SIZE];
 
+// hash chain heads are stored with release and loaded with acquire semantics,
+// so a thread which finds a program also sees all of its fields set
+#if defined( _MSC_VER )
+// volatile accesses are acquire/release with the default /volatile:ms
+#define RP_LOAD_ACQUIRE( p )        ( *(glsl_program_t *volatile *)&( p ) )
+#define RP_STORE_RELEASE( p, v )    ( *(glsl_program_t *volatile *)&( p ) = ( v ) )
+#else
+#define RP_LOAD_ACQUIRE( p )        __atomic_load_n( &( p ), __ATOMIC_ACQUIRE )
+#define RP_STORE_RELEASE( p, v )    __atomic_store_n( &( p ), ( v ), __ATOMIC_RELEASE )
+#endif
+
 static int r_glslbincache_storemode;
 
+// programs are looked up without locking, new ones are only ever added to the head
+// of hash chains once fully set up, serialized by the lock
+static qmutex_t *r_glslprograms_lock;
+
+// the precache list is compiled on a shared context in the background
+static qthread_t *r_glslprecompile_thread;
+static void *r_glslprecompile_context, *r_glslprecompile_surface;
+static bool r_glslprecompile_async;
+static volatile bool r_glslprecompile_done;
+static bool r_glslprecache_loaded;
+static bool r_glslprecache_dirty;
+
+static struct {
+	unsigned precompiled;
+	unsigned precompiledUsed;
+	unsigned hitches;
+	uint64_t hitchTime;
+	uint64_t precompileTime;
+} r_glslstats;
+
 static void RP_GetUniformLocations( glsl_program_t *program );
 static void RP_BindAttrbibutesLocations( glsl_program_t *program );
 
 static void *RP_GetProgramBinary( int elem, int *format, unsigned *length );
 static int RP_RegisterProgramBinary( int type, const char *name, const char *deformsKey,
 									 const deformv_t *deforms, int numDeforms, r_glslfeat_t features,
-									 int binaryFormat, unsigned binaryLength, void *binary );
+									 int binaryFormat, unsigned binaryLength, void *binary, bool precache );
 
 /*
 * RP_Init
@@ -177,6 +213,12 @@ void RP_Init( void ) {
 
 	memset( r_glslprograms, 0, sizeof( r_glslprograms ) );
 	memset( r_glslprograms_hash, 0, sizeof( r_glslprograms_hash ) );
+	memset( &r_glslstats, 0, sizeof( r_glslstats ) );
+
+	r_glslprograms_lock = ri.Mutex_Create();
+	r_glslprecompile_done = true;
+	r_glslprecache_loaded = false;
+	r_glslprecache_dirty = false;
 
 	Trie_Create( TRIE_CASE_INSENSITIVE, &glsl_cache_trie );
 
@@ -203,9 +245,9 @@ void RP_Init( void ) {
 }
 
 /*
-* RP_PrecachePrograms
+* RP_LoadPrecacheList
 *
-* Loads the list of known program permutations from disk file.
+* Loads the list of known program permutations from disk file and registers them.
 *
 * Expected file format:
 * application_name\n
@@ -213,8 +255,12 @@ void RP_Init( void ) {
 * program_type1 features_lower_bits1 features_higher_bits1 program_name1 binary_offset
 * ..
 * program_typeN features_lower_bitsN features_higher_bitsN program_nameN binary_offset
+*
+* The binary cache file starts with the GLSL bits version, the GL version hash and
+* the binary cache version, followed by format, length, checksum and data of each
+* binary.
 */
-void RP_PrecachePrograms( void ) {
+static void RP_LoadPrecacheList( void ) {
 	int version;
 	char *buffer = NULL, *data, **ptr;
 	const char *token;
@@ -256,9 +302,13 @@ void RP_PrecachePrograms( void ) {
 
 			ri.FS_Read( &version, sizeof( version ), handleBin );
 			ri.FS_Read( &hash, sizeof( hash ), handleBin );
-
-			if( binaryCacheSize < 8 || version != GLSL_BITS_VERSION || hash != glConfig.versionHash ) {
+			if( binaryCacheSize < 12 || version != GLSL_BITS_VERSION || hash != glConfig.versionHash ) {
 				CLOSE_AND_DROP_BINARY_CACHE();
+			} else {
+				ri.FS_Read( &version, sizeof( version ), handleBin );
+				if( version != GLSL_BINARY_CACHE_VERSION ) {
+					CLOSE_AND_DROP_BINARY_CACHE();
+				}
 			}
 		}
 	}
@@ -287,6 +337,7 @@ void RP_PrecachePrograms( void ) {
 			void *binary = NULL;
 			int binaryFormat = 0;
 			unsigned binaryLength = 0;
+			unsigned binaryChecksum = 0;
 			int binaryPos = 0;
 
 			// read program type
@@ -338,6 +389,7 @@ void RP_PrecachePrograms( void ) {
 					err = !err && ri.FS_Seek( handleBin, binaryPos, FS_SEEK_SET ) < 0;
 					err = !err && ri.FS_Read( &binaryFormat, sizeof( binaryFormat ), handleBin ) != sizeof( binaryFormat );
 					err = !err && ri.FS_Read( &binaryLength, sizeof( binaryLength ), handleBin ) != sizeof( binaryLength );
+					err = !err && ri.FS_Read( &binaryChecksum, sizeof( binaryChecksum ), handleBin ) != sizeof( binaryChecksum );
 					if( err || binaryLength >= binaryCacheSize ) {
 						binaryLength = 0;
 						CLOSE_AND_DROP_BINARY_CACHE();
@@ -345,7 +397,9 @@ void RP_PrecachePrograms( void ) {
 
 					if( binaryLength ) {
 						binary = R_Malloc( binaryLength );
-						if( binary != NULL && ri.FS_Read( binary, binaryLength, handleBin ) != (int)binaryLength ) {
+						if( binary != NULL && ( ri.FS_Read( binary, binaryLength, handleBin ) != (int)binaryLength ||
+							COM_SuperFastHash( binary, binaryLength ) != binaryChecksum ) ) {
+							ri.Com_DPrintf( S_COLOR_YELLOW "Corrupt binary for program %s\n", name );
 							R_Free( binary );
 							binary = NULL;
 							CLOSE_AND_DROP_BINARY_CACHE();
@@ -360,7 +414,7 @@ void RP_PrecachePrograms( void ) {
 				ri.Com_DPrintf( "Loading binary program %s...\n", name );
 
 				elem = RP_RegisterProgramBinary( type, name, NULL, NULL, 0, features,
-												 binaryFormat, binaryLength, binary );
+												 binaryFormat, binaryLength, binary, true );
 
 				if( RP_GetProgramObject( elem ) == 0 ) {
 					// check whether the program actually exists
@@ -386,7 +440,7 @@ void RP_PrecachePrograms( void ) {
 
 			ri.Com_DPrintf( "Loading program %s...\n", name );
 
-			RP_RegisterProgram( type, name, NULL, NULL, 0, features );
+			RP_RegisterProgramBinary( type, name, NULL, NULL, 0, features, 0, 0, NULL, true );
 		}
 	}
 
@@ -399,6 +453,89 @@ void RP_PrecachePrograms( void ) {
 	}
 }
 
+/*
+* RP_PrecompileThreadProc
+*/
+static void *RP_PrecompileThreadProc( void *param ) {
+	uint64_t start = ri.Sys_Microseconds();
+
+	GLimp_MakeCurrent( r_glslprecompile_context, r_glslprecompile_surface );
+
+	RP_LoadPrecacheList();
+
+	// make sure the last programs are complete before the context is released
+	qglFinish();
+	GLimp_MakeCurrent( NULL, NULL );
+
+	r_glslstats.precompileTime = ri.Sys_Microseconds() - start;
+	r_glslprecompile_done = true;
+
+	ri.Com_DPrintf( "Precompiled %u GLSL programs in %.1f ms\n", r_glslstats.precompiled,
+		r_glslstats.precompileTime / 1000.0 );
+
+	return NULL;
+}
+
+/*
+* RP_FinishPrecompile
+*/
+static void RP_FinishPrecompile( void ) {
+	if( !r_glslprecompile_thread ) {
+		return;
+	}
+
+	ri.Thread_Join( r_glslprecompile_thread );
+	r_glslprecompile_thread = NULL;
+
+	GLimp_SharedContext_Destroy( r_glslprecompile_context, r_glslprecompile_surface );
+	r_glslprecompile_context = r_glslprecompile_surface = NULL;
+	r_glslprecompile_async = false;
+}
+
+/*
+* RP_PrecachePrograms
+*
+* Compiles the programs from the precache list, in the background on a shared
+* context if possible, so that the renderer doesn't have to do that the first
+* time a permutation is used. Programs requested by the renderer before they have
+* been precompiled are compiled on the spot as usual.
+*/
+void RP_PrecachePrograms( void ) {
+	r_glslprecache_loaded = true;
+
+	if( glConfig.multithreading &&
+		GLimp_SharedContext_Create( &r_glslprecompile_context, &r_glslprecompile_surface ) ) {
+		r_glslprecompile_async = true;
+		r_glslprecompile_done = false;
+
+		r_glslprecompile_thread = ri.Thread_Create( RP_PrecompileThreadProc, NULL );
+		if( r_glslprecompile_thread ) {
+			return;
+		}
+
+		GLimp_SharedContext_Destroy( r_glslprecompile_context, r_glslprecompile_surface );
+		r_glslprecompile_context = r_glslprecompile_surface = NULL;
+		r_glslprecompile_async = false;
+		r_glslprecompile_done = true;
+	}
+
+	RP_LoadPrecacheList();
+}
+
+/*
+* RP_UpdatePrecacheList
+*
+* Stores the precache list if permutations that weren't in it have been compiled
+* since, so that they are known to the next session even if this one doesn't end
+* gracefully. Does nothing while the list is still being compiled.
+*/
+void RP_UpdatePrecacheList( void ) {
+	if( !r_glslprecache_dirty || !r_glslprecompile_done ) {
+		return;
+	}
+	RP_StorePrecacheList();
+}
+
 
 /*
 * RP_StorePrecacheList
@@ -416,6 +553,8 @@ void RP_StorePrecacheList( void ) {
 		return;
 	}
 
+	RP_FinishPrecompile();
+
 	handle = 0;
 	if( ri.FS_FOpenFile( GLSL_CACHE_FILE_NAME, &handle, FS_WRITE | FS_CACHE ) == -1 ) {
 		Com_Printf( S_COLOR_YELLOW "Could not open %s for writing.\n", GLSL_CACHE_FILE_NAME );
@@ -432,6 +571,9 @@ void RP_StorePrecacheList( void ) {
 
 			dummy = glConfig.versionHash;
 			ri.FS_Write( &dummy, sizeof( dummy ), handleBin );
+
+			dummy = GLSL_BINARY_CACHE_VERSION;
+			ri.FS_Write( &dummy, sizeof( dummy ), handleBin );
 		} else {
 			ri.FS_Seek( handleBin, 0, FS_SEEK_END );
 		}
@@ -472,13 +614,24 @@ void RP_StorePrecacheList( void ) {
 					  program->name, binaryPos );
 
 		if( binary ) {
+			unsigned binaryChecksum = COM_SuperFastHash( binary, binaryLength );
+
 			ri.FS_Write( &binaryFormat, sizeof( binaryFormat ), handleBin );
 			ri.FS_Write( &binaryLength, sizeof( binaryLength ), handleBin );
+			ri.FS_Write( &binaryChecksum, sizeof( binaryChecksum ), handleBin );
 			ri.FS_Write( binary, binaryLength, handleBin );
 			R_Free( binary );
+
+			// only new binaries have to be appended the next time the list is stored
+			program->binaryCachePos = binaryPos;
 		}
 	}
 
+	r_glslprecache_dirty = false;
+	if( handleBin ) {
+		r_glslbincache_storemode = FS_APPEND;
+	}
+
 	ri.FS_FCloseFile( handle );
 	ri.FS_FCloseFile( handleBin );
 
@@ -1536,13 +1689,28 @@ static int R_Features2HashKey( r_glslfeat_t features ) {
 }
 
 /*
-* RP_RegisterProgramBinary
+* RP_FindProgram
 */
-static int RP_RegisterProgramBinary( int type, const char *name, const char *deformsKey,
-									 const deformv_t *deforms, int numDeforms, r_glslfeat_t features,
-									 int binaryFormat, unsigned binaryLength, void *binary ) {
+static glsl_program_t *RP_FindProgram( int type, int hash, const char *deformsKey, r_glslfeat_t features ) {
+	glsl_program_t *program;
+
+	for( program = RP_LOAD_ACQUIRE( r_glslprograms_hash[type][hash] ); program; program = program->hash_next ) {
+		if( ( program->features == features ) && !strcmp( program->deformsKey, deformsKey ) ) {
+			return program;
+		}
+	}
+	return NULL;
+}
+
+/*
+* RP_CompileProgram
+*
+* Must be called with r_glslprograms_lock held.
+*/
+static int RP_CompileProgram( int type, int hash, const char *name, const char *deformsKey,
+							  const deformv_t *deforms, int numDeforms, r_glslfeat_t features,
+							  int binaryFormat, unsigned binaryLength, void *binary, bool shared ) {
 	unsigned int i;
-	int hash;
 	int linked, error = 0;
 	int shaderTypeIdx, wavefuncsIdx, deformvIdx, dualQuatsIdx, instancedIdx, vTransformsIdx;
 	int enableTextureArrayIdx;
@@ -1563,24 +1731,6 @@ static int RP_RegisterProgramBinary( int type, const char *name, const char *def
 	const char *deformv;
 	glslParser_t parser;
 
-	if( type <= GLSL_PROGRAM_TYPE_NONE || type >= GLSL_PROGRAM_TYPE_MAXTYPE ) {
-		return 0;
-	}
-
-	assert( !deforms || deformsKey );
-
-	// default deformsKey to empty string, easier on checking later
-	if( !deforms || !deformsKey ) {
-		deformsKey = "";
-	}
-
-	hash = R_Features2HashKey( features );
-	for( program = r_glslprograms_hash[type][hash]; program; program = program->hash_next ) {
-		if( ( program->features == features ) && !strcmp( program->deformsKey, deformsKey ) ) {
-			return ( ( program - r_glslprograms ) + 1 );
-		}
-	}
-
 	if( r_numglslprograms == MAX_GLSL_PROGRAMS ) {
 		Com_Printf( S_COLOR_YELLOW "RP_RegisterProgram: GLSL programs limit exceeded\n" );
 		return 0;
@@ -1611,7 +1761,7 @@ static int RP_RegisterProgramBinary( int type, const char *name, const char *def
 		}
 	}
 
-	program = r_glslprograms + r_numglslprograms++;
+	program = r_glslprograms + r_numglslprograms;
 	program->object = qglCreateProgram();
 	if( !program->object ) {
 		error = 1;
@@ -1846,26 +1996,101 @@ done:
 	program->name = R_CopyString( name );
 	program->deformsKey = R_CopyString( deformsKey ? deformsKey : "" );
 
-	if( !program->hash_next ) {
-		program->hash_next = r_glslprograms_hash[type][hash];
-		r_glslprograms_hash[type][hash] = program;
-	}
-
 	if( program->object ) {
 		qglUseProgram( program->object );
 		RP_GetUniformLocations( program );
 	}
 
+	// objects created on a shared context are only safe to use in another one
+	// after they have been completed
+	if( shared ) {
+		qglFinish();
+	}
+
+	r_numglslprograms++;
+
+	// the program is looked up without locking so it may only be linked into
+	// the hash once it's complete
+	if( !program->hash_next ) {
+		program->hash_next = r_glslprograms_hash[type][hash];
+		RP_STORE_RELEASE( r_glslprograms_hash[type][hash], program );
+	}
+
 	return ( program - r_glslprograms ) + 1;
 }
 
+/*
+* RP_RegisterProgramBinary
+*/
+static int RP_RegisterProgramBinary( int type, const char *name, const char *deformsKey,
+									 const deformv_t *deforms, int numDeforms, r_glslfeat_t features,
+									 int binaryFormat, unsigned binaryLength, void *binary, bool precache ) {
+	int hash, elem;
+	uint64_t start;
+	glsl_program_t *program;
+
+	if( type <= GLSL_PROGRAM_TYPE_NONE || type >= GLSL_PROGRAM_TYPE_MAXTYPE ) {
+		return 0;
+	}
+
+	assert( !deforms || deformsKey );
+
+	// default deformsKey to empty string, easier on checking later
+	if( !deforms || !deformsKey ) {
+		deformsKey = "";
+	}
+
+	hash = R_Features2HashKey( features );
+	program = RP_FindProgram( type, hash, deformsKey, features );
+	if( program ) {
+		if( !precache && program->precompiled && !program->used ) {
+			program->used = true;
+			r_glslstats.precompiledUsed++;
+		}
+		return ( program - r_glslprograms ) + 1;
+	}
+
+	ri.Mutex_Lock( r_glslprograms_lock );
+
+	// the background compiler might have added it while we were waiting
+	program = RP_FindProgram( type, hash, deformsKey, features );
+	if( program ) {
+		ri.Mutex_Unlock( r_glslprograms_lock );
+		return RP_RegisterProgramBinary( type, name, deformsKey, deforms, numDeforms, features,
+										 binaryFormat, binaryLength, binary, precache );
+	}
+
+	start = ri.Sys_Microseconds();
+
+	elem = RP_CompileProgram( type, hash, name, deformsKey, deforms, numDeforms, features,
+							  binaryFormat, binaryLength, binary, precache && r_glslprecompile_async );
+
+	if( elem ) {
+		program = r_glslprograms + elem - 1;
+		if( precache ) {
+			program->precompiled = true;
+			r_glslstats.precompiled++;
+		} else if( r_glslprecache_loaded ) {
+			// a permutation missing from the precache list has been compiled
+			// while rendering, remember it for the next time
+			r_glslstats.hitches++;
+			r_glslstats.hitchTime += ri.Sys_Microseconds() - start;
+			r_glslprecache_dirty = true;
+		}
+	}
+
+	ri.Mutex_Unlock( r_glslprograms_lock );
+
+	return elem;
+}
+
 /*
 * RP_RegisterProgram
 */
 int RP_RegisterProgram( int type, const char *name, const char *deformsKey,
 						const deformv_t *deforms, int numDeforms, r_glslfeat_t features ) {
 	return RP_RegisterProgramBinary( type, name, deformsKey, deforms, numDeforms,
-									 features, 0, 0, NULL );
+									 features, 0, 0, NULL, false );
 }
 
 /*
@@ -1927,7 +2152,7 @@ void RP_ProgramList_f( void ) {
 	char fullName[1024];
 
 	Com_Printf( "------------------\n" );
-	for( i = 0, program = r_glslprograms; i < MAX_GLSL_PROGRAMS; i++, program++ ) {
+	for( i = 0, program = r_glslprograms; i < (int)r_numglslprograms; i++, program++ ) {
 		if( !program->name ) {
 			break;
 		}
@@ -1942,6 +2167,13 @@ void RP_ProgramList_f( void ) {
 		Com_Printf( "\n" );
 	}
 	Com_Printf( "%i programs total\n", i );
+
+	Com_Printf( "%u precompiled%s, %u of them used\n", r_glslstats.precompiled,
+		r_glslprecompile_done ? "" : " so far", r_glslstats.precompiledUsed );
+	if( r_glslstats.precompileTime ) {
+		Com_Printf( "background precompilation took %.1f ms\n", r_glslstats.precompileTime / 1000.0 );
+	}
+	Com_Printf( "%u compiled while rendering in %.1f ms\n", r_glslstats.hitches, r_glslstats.hitchTime / 1000.0 );
 }
 
 /*
@@ -2674,6 +2906,8 @@ void RP_Shutdown( void ) {
 	unsigned int i;
 	glsl_program_t *program;
 
+	RP_FinishPrecompile();
+
 	qglUseProgram( 0 );
 
 	for( i = 0, program = r_glslprograms; i < r_numglslprograms; i++, program++ ) {
@@ -2683,6 +2917,8 @@ void RP_Shutdown( void ) {
 	Trie_Destroy( glsl_cache_trie );
 	glsl_cache_trie = NULL;
 
+	ri.Mutex_Destroy( &r_glslprograms_lock );
+
 	r_numglslprograms = 0;
 	r_glslprograms_initialized = false;
 }
@@ -166,6 +166,7 @@ void RP_Init( void );
 void RP_Shutdown( void );
 void RP_PrecachePrograms( void );
 void RP_StorePrecacheList( void );
+void RP_UpdatePrecacheList( void );
 
 void RP_ProgramList_f( void );
 
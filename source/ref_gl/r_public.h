@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "../cgame/ref.h"
 
-#define REF_API_VERSION 24
+#define REF_API_VERSION 28
 
 //
 // these are the functions exported by the refresh module
@@ -113,6 +113,8 @@ typedef struct {
 	void ( *Mutex_Destroy )( struct qmutex_s **mutex );
 	void ( *Mutex_Lock )( struct qmutex_s *mutex );
 	void ( *Mutex_Unlock )( struct qmutex_s *mutex );
+	int ( *Atomic_Add )( volatile int *value, int add );
+	bool ( *Atomic_CAS )( volatile int *value, int oldval, int newval );
 
 	struct qbufPipe_s *( *BufPipe_Create )( size_t bufSize, int flags );
 	void ( *BufPipe_Destroy )( struct qbufPipe_s **pqueue );
@@ -121,6 +123,17 @@ typedef struct {
 	int ( *BufPipe_ReadCmds )( struct qbufPipe_s *queue, unsigned( **cmdHandlers )( const void * ) );
 	void ( *BufPipe_Wait )( struct qbufPipe_s *queue, int ( *read )( struct qbufPipe_s *, unsigned( ** )( const void * ), bool ),
 							unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec );
+
+	int ( *Jobs_NumWorkers )( void );
+	struct qjob_s *( *Job_Schedule )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+									  unsigned items, unsigned grain, struct qjob_s **deps, unsigned numDeps );
+	struct qjob_s *( *Job_ScheduleBackground )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+												unsigned items, unsigned grain, struct qjob_s **deps, unsigned numDeps );
+	void ( *Job_Wait )( struct qjob_s *job );
+	bool ( *Job_Done )( struct qjob_s *job );
+	void ( *Job_Release )( struct qjob_s **pjob );
+	void ( *Jobs_ParallelFor )( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+								unsigned items, unsigned grain );
 } ref_import_t;
 
 typedef struct {
@@ -125,6 +125,7 @@ cvar_t *r_gamma;
 cvar_t *r_texturemode;
 cvar_t *r_texturefilter;
 cvar_t *r_texturecompression;
+cvar_t *r_texturecache;
 cvar_t *r_picmip;
 cvar_t *r_skymip;
 cvar_t *r_nobind;
@@ -135,6 +136,7 @@ cvar_t *r_screenshot_format;
 cvar_t *r_screenshot_jpeg_quality;
 cvar_t *r_swapinterval;
 cvar_t *r_swapinterval_min;
+cvar_t *r_maxqueuedframes;
 
 cvar_t *r_temp1;
 
@@ -1184,6 +1186,7 @@ static void R_Register( const char *screenshotsPrefix ) {
 	r_texturemode = ri.Cvar_Get( "r_texturemode", "GL_LINEAR_MIPMAP_LINEAR", CVAR_ARCHIVE );
 	r_texturefilter = ri.Cvar_Get( "r_texturefilter", "4", CVAR_ARCHIVE );
 	r_texturecompression = ri.Cvar_Get( "r_texturecompression", "0", CVAR_ARCHIVE | CVAR_LATCH_VIDEO );
+	r_texturecache = ri.Cvar_Get( "r_texturecache", "0", CVAR_ARCHIVE );
 	r_stencilbits = ri.Cvar_Get( "r_stencilbits", "0", CVAR_ARCHIVE | CVAR_LATCH_VIDEO );
 
 	r_screenshot_format = ri.Cvar_Get( "r_screenshot_format", "jpg", CVAR_ARCHIVE );
@@ -1196,6 +1199,7 @@ static void R_Register( const char *screenshotsPrefix ) {
 	r_swapinterval = ri.Cvar_Get( "r_swapinterval", "0", CVAR_ARCHIVE );
 #endif
 	r_swapinterval_min = ri.Cvar_Get( "r_swapinterval_min", "0", CVAR_READONLY ); // exposes vsync support to UI
+	r_maxqueuedframes = ri.Cvar_Get( "r_maxqueuedframes", "2", CVAR_ARCHIVE );
 
 	r_temp1 = ri.Cvar_Get( "r_temp1", "0", 0 );
 
@@ -1232,6 +1236,9 @@ static void R_Register( const char *screenshotsPrefix ) {
 	ri.Cmd_AddCommand( "gfxinfo", R_GfxInfo_f );
 	ri.Cmd_AddCommand( "glslprogramlist", RP_ProgramList_f );
 	ri.Cmd_AddCommand( "cinlist", R_CinList_f );
+	ri.Cmd_AddCommand( "drawsortbench", R_DrawSortBenchmark_f );
+	ri.Cmd_AddCommand( "skinningtest", R_SkeletalSelfTest_f );
+	ri.Cmd_AddCommand( "imagebench", R_ImageBenchmark_f );
 
 	ri.Cmd_SetCompletionFunc( "shaderdump", R_ShaderDumpCompletion_f );
 }
@@ -1620,6 +1627,9 @@ void R_Shutdown( bool verbose ) {
 	ri.Cmd_RemoveCommand( "shaderlist" );
 	ri.Cmd_RemoveCommand( "glslprogramlist" );
 	ri.Cmd_RemoveCommand( "cinlist" );
+	ri.Cmd_RemoveCommand( "drawsortbench" );
+	ri.Cmd_RemoveCommand( "skinningtest" );
+	ri.Cmd_RemoveCommand( "imagebench" );
 
 	// free shaders, models, etc.
 
@@ -1659,5 +1669,7 @@ void R_Shutdown( bool verbose ) {
 
 	R_FrameCache_Free();
 
+	R_FreeSkeletalCache();
+
 	R_FreePool( &r_mempool );
 }
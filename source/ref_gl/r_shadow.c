@@ -856,7 +856,7 @@ void R_DrawShadows( void ) {
 
 		l = rtLights[i];
 
-		if( !l->shadow ) {
+		if( !l->shadow || l->shadowPending ) {
 			continue;
 		}
 
@@ -908,20 +908,134 @@ static float R_SkeletalModelLerpBBox( const entity_t *e, const model_t *mod, vec
 
 //=======================================================================
 
+/*
+* Whole-frame skeletal cache
+*
+* Bone transforms are keyed by model, frames, lerp fraction and the contents of
+* custom boneposes rather than by entity number, and live until the next
+* R_BeginFrame, so portal, mirror and shadow views and later scenes of the same
+* frame reuse both the bone matrices and the CPU-skinned vertices.
+*/
+
+#define SKM_CACHE_HASH_SIZE         256
+#define SKM_CACHE_MIN_BLOCK_SIZE    0x40000
+
+typedef struct {
+	vec4_t *xyzArray;
+	vec4_t *normalsArray;
+	vec4_t *sVectorsArray;
+} skmcachemesh_t;
+
 typedef struct skmcacheentry_s {
 	bool hwTransform;
-	int entNum;
+	bool customPoses;
 	int framenum, oldframenum;
-	size_t data_size;
+	float backlerp;
+	unsigned int hash;
 	const bonepose_t *boneposes, *oldboneposes;
 	const mskmodel_t *skmodel;
 	uint8_t *data;
+	skmcachemesh_t *meshes;                 // CPU-skinned vertices, filled on first draw
+	struct skmcacheentry_s *hashNext;
 } skmcacheentry_t;
 
-static skmcacheentry_t r_skmcachekeys[MAX_REF_ENTITIES];      // entities linked to cache entries
+typedef struct skmcacheblock_s {
+	size_t size, used;
+	struct skmcacheblock_s *next;
+} skmcacheblock_t;
+
+static skmcacheentry_t *r_skmcachekeys[MAX_REF_ENTITIES];       // entities linked to cache entries
+static skmcacheentry_t *r_skmcachehash[SKM_CACHE_HASH_SIZE];    // cache entries for the whole frame
+static skmcacheblock_t *r_skmcacheblocks;
+static size_t r_skmcachetotalsize;
+
+/*
+* R_SkeletalCache_NewBlock
+*/
+static skmcacheblock_t *R_SkeletalCache_NewBlock( size_t size ) {
+	skmcacheblock_t *block;
+
+	block = R_Malloc( sizeof( skmcacheblock_t ) + size + 16 );
+	block->size = size;
+	block->used = 0;
+	block->next = NULL;
+
+	r_skmcachetotalsize += size;
+	return block;
+}
+
+/*
+* R_SkeletalCache_Alloc
+*/
+static void *R_SkeletalCache_Alloc( size_t size ) {
+	uint8_t *data;
+	skmcacheblock_t *block = r_skmcacheblocks;
+
+	size = ((size + 15) & ~15);
+
+	if( !block || block->used + size > block->size ) {
+		size_t newSize = r_skmcachetotalsize / 2;
+
+		if( newSize < SKM_CACHE_MIN_BLOCK_SIZE ) {
+			newSize = SKM_CACHE_MIN_BLOCK_SIZE;
+		}
+		if( newSize < size ) {
+			newSize = size;
+		}
+
+		block = R_SkeletalCache_NewBlock( newSize );
+		block->next = r_skmcacheblocks;
+		r_skmcacheblocks = block;
+	}
+
+	data = (uint8_t *)(((uintptr_t)(block + 1) + 15) & ~15) + block->used;
+	block->used += size;
+	return data;
+}
+
+/*
+* R_FreeSkeletalCache
+*/
+void R_FreeSkeletalCache( void ) {
+	skmcacheblock_t *block, *next;
+
+	for( block = r_skmcacheblocks; block; block = next ) {
+		next = block->next;
+		R_Free( block );
+	}
+
+	r_skmcacheblocks = NULL;
+	r_skmcachetotalsize = 0;
+
+	memset( r_skmcachehash, 0, sizeof( r_skmcachehash ) );
+	memset( r_skmcachekeys, 0, sizeof( r_skmcachekeys ) );
+}
+
+/*
+* R_ResetSkeletalCache
+*
+* Called at the start of every frame. Drops all entries from the previous frame,
+* coalescing the memory into a single block big enough to hold them.
+*/
+void R_ResetSkeletalCache( void ) {
+	size_t size = r_skmcachetotalsize;
+
+	if( r_skmcacheblocks && r_skmcacheblocks->next ) {
+		R_FreeSkeletalCache();
+		r_skmcacheblocks = R_SkeletalCache_NewBlock( size );
+	}
+	if( r_skmcacheblocks ) {
+		r_skmcacheblocks->used = 0;
+	}
+
+	memset( r_skmcachehash, 0, sizeof( r_skmcachehash ) );
+	memset( r_skmcachekeys, 0, sizeof( r_skmcachekeys ) );
+}
 
 /*
 * R_ClearSkeletalCache
+*
+* Unlinks entities of the previous scene, cached transforms are kept until the end of the frame.
 */
 void R_ClearSkeletalCache( void ) {
 	memset( r_skmcachekeys, 0, sizeof( r_skmcachekeys ) );
@@ -933,42 +1047,130 @@ void R_ClearSkeletalCache( void ) {
 static skmcacheentry_t *R_GetSkeletalCache( int entNum ) {
 	skmcacheentry_t *cache;
 
-	cache = &r_skmcachekeys[entNum];
-	if( !cache->data ) {
+	cache = r_skmcachekeys[entNum];
+	if( !cache || !cache->data ) {
 		return NULL;
 	}
 
 	return cache;
 }
 
+/*
+* R_HashSkeletalCacheKey
+*/
+static unsigned int R_HashSkeletalCacheKey( const mskmodel_t *skmodel, int framenum, int oldframenum, 
+	float backlerp, const bonepose_t *bp, const bonepose_t *oldbp, bool customPoses ) {
+	unsigned int i, n;
+	unsigned int hash;
+	const uint32_t *words;
+	union {
+		float f;
+		uint32_t u;
+	} lerp;
+
+	lerp.f = backlerp;
+	hash = (unsigned int)( (uintptr_t)skmodel >> 4 );
+	hash = hash * 31 + framenum;
+	hash = hash * 31 + oldframenum;
+	hash = hash * 31 + lerp.u;
+
+	if( customPoses ) {
+		// custom poses are supplied by the client, so hash the contents instead of the pointer
+		n = skmodel->numbones * sizeof( bonepose_t ) / sizeof( uint32_t );
+		for( words = ( const uint32_t * )bp, i = 0; i < n; i++ ) {
+			hash = ( hash ^ words[i] ) * 16777619;
+		}
+		if( oldbp != bp ) {
+			for( words = ( const uint32_t * )oldbp, i = 0; i < n; i++ ) {
+				hash = ( hash ^ words[i] ) * 16777619;
+			}
+		}
+	}
+
+	return hash;
+}
+
+/*
+* R_FindSkeletalCache
+*/
+static skmcacheentry_t *R_FindSkeletalCache( unsigned int hash, const mskmodel_t *skmodel, int framenum, int oldframenum, 
+	float backlerp, const bonepose_t *bp, const bonepose_t *oldbp, bool customPoses, bool hwTransform ) {
+	size_t posesSize = sizeof( bonepose_t ) * skmodel->numbones;
+	skmcacheentry_t *cache;
+
+	for( cache = r_skmcachehash[hash & ( SKM_CACHE_HASH_SIZE - 1 )]; cache; cache = cache->hashNext ) {
+		if( cache->hash != hash || cache->skmodel != skmodel || cache->hwTransform != hwTransform ) {
+			continue;
+		}
+		if( cache->framenum != framenum || cache->oldframenum != oldframenum || cache->backlerp != backlerp ) {
+			continue;
+		}
+		if( cache->customPoses != customPoses ) {
+			continue;
+		}
+		if( !customPoses ) {
+			if( cache->boneposes != bp || cache->oldboneposes != oldbp ) {
+				continue;
+			}
+		} else {
+			if( ( cache->boneposes == cache->oldboneposes ) != ( bp == oldbp ) ) {
+				continue;
+			}
+			if( memcmp( cache->boneposes, bp, posesSize ) || memcmp( cache->oldboneposes, oldbp, posesSize ) ) {
+				continue;
+			}
+		}
+		return cache;
+	}
+
+	return NULL;
+}
+
 /*
 * R_AllocSkeletalDataCache
 *
-* Allocates or reuses a memory chunk and links it to entity+LOD num pair. The chunk
-* is then linked to other chunks allocated in the same frame. At the end of the frame
-* all of the entries in the "allocation" list are moved to the "free" list, to be reused in the
-* later function calls.
+* Allocates a whole-frame cache entry for the given key. Custom boneposes are copied
+* as the client is free to overwrite them once the scene has been rendered.
 */
-static skmcacheentry_t *R_AllocSkeletalDataCache( int entNum, const mskmodel_t *skmodel, bool hwTransform ) {
+static skmcacheentry_t *R_AllocSkeletalDataCache( unsigned int hash, const mskmodel_t *skmodel, int framenum, int oldframenum, 
+	float backlerp, const bonepose_t *bp, const bonepose_t *oldbp, bool customPoses, bool hwTransform ) {
 	skmcacheentry_t *cache;
 	size_t size;
-	
-	assert( !r_skmcachekeys[entNum].data );
+	size_t posesSize = sizeof( bonepose_t ) * skmodel->numbones;
+	bonepose_t *poses;
 
 	size = sizeof( dualquat_t ) * skmodel->numbones;
 	if( !hwTransform ) {
 		size += sizeof( mat4_t ) * ( skmodel->numbones + skmodel->numblends );
 	}
 
-	// and link it to the allocation list
-	cache = &r_skmcachekeys[entNum];
-	cache->data = R_FrameCache_Alloc( size );
-	cache->hwTransform = false;
-	cache->entNum = entNum;
-	cache->skmodel = skmodel;
-	cache->boneposes = cache->oldboneposes = NULL;
-	cache->framenum = cache->oldframenum = 0;
+	cache = R_SkeletalCache_Alloc( sizeof( skmcacheentry_t ) );
+	cache->data = R_SkeletalCache_Alloc( size );
 	cache->hwTransform = hwTransform;
+	cache->skmodel = skmodel;
+	cache->framenum = framenum;
+	cache->oldframenum = oldframenum;
+	cache->backlerp = backlerp;
+	cache->hash = hash;
+	cache->meshes = NULL;
+	cache->customPoses = customPoses;
+
+	if( customPoses ) {
+		poses = R_SkeletalCache_Alloc( bp == oldbp ? posesSize : posesSize * 2 );
+		memcpy( poses, bp, posesSize );
+		cache->boneposes = cache->oldboneposes = poses;
+		if( oldbp != bp ) {
+			memcpy( poses + skmodel->numbones, oldbp, posesSize );
+			cache->oldboneposes = poses + skmodel->numbones;
+		}
+	} else {
+		cache->boneposes = bp;
+		cache->oldboneposes = oldbp;
+	}
+
+	// and link it to the hash table
+	cache->hashNext = r_skmcachehash[hash & ( SKM_CACHE_HASH_SIZE - 1 )];
+	r_skmcachehash[hash & ( SKM_CACHE_HASH_SIZE - 1 )] = cache;
 
 	return cache;
 }
@@ -983,9 +1185,37 @@ static skmcacheentry_t *R_AllocSkeletalDataCache( int entNum, const mskmodel_t *
 #endif
 
 /*
-* R_SkeletalBlendPoses
+* SIMD skinning kernels
+*
+* Every vertex is transformed by its own matrix, so the kernels broadcast vertex
+* components against whole matrix columns instead of transposing vertices into
+* SoA, which would require gathering the matrices as well. The loops process
+* four vertices per iteration. The fourth row of blended matrices is never read.
 */
-static void R_SkeletalBlendPoses( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
+#if ( defined ( __SSE__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 1 ) ) && !defined ( C_ONLY )
+# include <xmmintrin.h>
+# define SKM_SIMD
+typedef __m128 skmvec_t;
+# define SKM_Load( p )              _mm_loadu_ps( p )
+# define SKM_Store( p, v )          _mm_storeu_ps( p, v )
+# define SKM_Splat( f )             _mm_set1_ps( f )
+# define SKM_Mul( a, b )            _mm_mul_ps( a, b )
+# define SKM_Add( a, b )            _mm_add_ps( a, b )
+#elif ( defined ( __ARM_NEON__ ) || defined ( __ARM_NEON ) ) && !defined ( C_ONLY )
+# include <arm_neon.h>
+# define SKM_SIMD
+typedef float32x4_t skmvec_t;
+# define SKM_Load( p )              vld1q_f32( p )
+# define SKM_Store( p, v )          vst1q_f32( p, v )
+# define SKM_Splat( f )             vdupq_n_f32( f )
+# define SKM_Mul( a, b )            vmulq_f32( a, b )
+# define SKM_Add( a, b )            vaddq_f32( a, b )
+#endif
+
+/*
+* R_SkeletalBlendPoses_Generic
+*/
+static void R_SkeletalBlendPoses_Generic( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
 	unsigned int i, j, k;
 	float *pose;
 	mskblend_t *blend;
@@ -1016,9 +1246,9 @@ static void R_SkeletalBlendPoses( unsigned int numblends, mskblend_t *blends, un
 }
 
 /*
-* R_SkeletalTransformVerts
+* R_SkeletalTransformVerts_Generic
 */
-static void R_SkeletalTransformVerts( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+static void R_SkeletalTransformVerts_Generic( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
 	const float *pose;
 
 	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
@@ -1032,9 +1262,9 @@ static void R_SkeletalTransformVerts( int numverts, const unsigned int *blends,
 }
 
 /*
-* R_SkeletalTransformNormals
+* R_SkeletalTransformNormals_Generic
 */
-static void R_SkeletalTransformNormals( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+static void R_SkeletalTransformNormals_Generic( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
 	const float *pose;
 
 	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
@@ -1048,9 +1278,9 @@ static void R_SkeletalTransformNormals( int numverts, const unsigned int *blends
 }
 
 /*
-* R_SkeletalTransformNormalsAndSVecs
+* R_SkeletalTransformNormalsAndSVecs_Generic
 */
-static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
+static void R_SkeletalTransformNormalsAndSVecs_Generic( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
 	const float *pose;
 
 	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
@@ -1068,6 +1298,252 @@ static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int
 	}
 }
 
+#ifdef SKM_SIMD
+
+/*
+* R_SkeletalRotateVec
+*/
+static inline skmvec_t R_SkeletalRotateVec( const float *pose, const vec_t *v ) {
+	skmvec_t r;
+
+	r = SKM_Mul( SKM_Load( pose ), SKM_Splat( v[0] ) );
+	r = SKM_Add( r, SKM_Mul( SKM_Load( pose + 4 ), SKM_Splat( v[1] ) ) );
+	r = SKM_Add( r, SKM_Mul( SKM_Load( pose + 8 ), SKM_Splat( v[2] ) ) );
+	return r;
+}
+
+/*
+* R_SkeletalBlendPoses
+*/
+static void R_SkeletalBlendPoses( unsigned int numblends, mskblend_t *blends, unsigned int numbones, mat4_t *relbonepose ) {
+	unsigned int i, k;
+	float *pose;
+	const float *b;
+	skmvec_t f, c0, c1, c2, c3;
+	mskblend_t *blend;
+
+	for( i = 0, blend = blends; i < numblends; i++, blend++ ) {
+		pose = relbonepose[numbones + i];
+
+		b = relbonepose[blend->indices[0]];
+		f = SKM_Splat( blend->weights[0] * ( 1.0f / 255.0f ) );
+
+		c0 = SKM_Mul( f, SKM_Load( b ) );
+		c1 = SKM_Mul( f, SKM_Load( b + 4 ) );
+		c2 = SKM_Mul( f, SKM_Load( b + 8 ) );
+		c3 = SKM_Mul( f, SKM_Load( b + 12 ) );
+
+		for( k = 1; k < SKM_MAX_WEIGHTS && blend->weights[k]; k++ ) {
+			b = relbonepose[blend->indices[k]];
+			f = SKM_Splat( blend->weights[k] * ( 1.0f / 255.0f ) );
+
+			c0 = SKM_Add( c0, SKM_Mul( f, SKM_Load( b ) ) );
+			c1 = SKM_Add( c1, SKM_Mul( f, SKM_Load( b + 4 ) ) );
+			c2 = SKM_Add( c2, SKM_Mul( f, SKM_Load( b + 8 ) ) );
+			c3 = SKM_Add( c3, SKM_Mul( f, SKM_Load( b + 12 ) ) );
+		}
+
+		SKM_Store( pose, c0 );
+		SKM_Store( pose + 4, c1 );
+		SKM_Store( pose + 8, c2 );
+		SKM_Store( pose + 12, c3 );
+	}
+}
+
+#define SKM_TRANSFORM_VERT( i ) \
+	pose = relbonepose[blends[i]]; \
+	SKM_Store( ov + i * 4, SKM_Add( R_SkeletalRotateVec( pose, v + i * 4 ), SKM_Load( pose + 12 ) ) ); \
+	ov[i * 4 + 3] = 1
+
+#define SKM_TRANSFORM_NORMAL( i ) \
+	pose = relbonepose[blends[i]]; \
+	SKM_Store( ov + i * 4, R_SkeletalRotateVec( pose, v + i * 4 ) ); \
+	ov[i * 4 + 3] = 0
+
+#define SKM_TRANSFORM_NORMAL_AND_SVEC( i ) \
+	pose = relbonepose[blends[i]]; \
+	SKM_Store( ov + i * 4, R_SkeletalRotateVec( pose, v + i * 4 ) ); \
+	SKM_Store( osv + i * 4, R_SkeletalRotateVec( pose, sv + i * 4 ) ); \
+	ov[i * 4 + 3] = 0; \
+	osv[i * 4 + 3] = sv[i * 4 + 3]
+
+/*
+* R_SkeletalTransformVerts
+*/
+static void R_SkeletalTransformVerts( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+
+	for( ; numverts >= 4; numverts -= 4, v += 16, ov += 16, blends += 4 ) {
+		SKM_TRANSFORM_VERT( 0 );
+		SKM_TRANSFORM_VERT( 1 );
+		SKM_TRANSFORM_VERT( 2 );
+		SKM_TRANSFORM_VERT( 3 );
+	}
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		SKM_TRANSFORM_VERT( 0 );
+	}
+}
+
+/*
+* R_SkeletalTransformNormals
+*/
+static void R_SkeletalTransformNormals( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov ) {
+	const float *pose;
+
+	for( ; numverts >= 4; numverts -= 4, v += 16, ov += 16, blends += 4 ) {
+		SKM_TRANSFORM_NORMAL( 0 );
+		SKM_TRANSFORM_NORMAL( 1 );
+		SKM_TRANSFORM_NORMAL( 2 );
+		SKM_TRANSFORM_NORMAL( 3 );
+	}
+	for( ; numverts; numverts--, v += 4, ov += 4, blends++ ) {
+		SKM_TRANSFORM_NORMAL( 0 );
+	}
+}
+
+/*
+* R_SkeletalTransformNormalsAndSVecs
+*/
+static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int *blends, mat4_t *relbonepose, const vec_t *v, vec_t *ov, const vec_t *sv, vec_t *osv ) {
+	const float *pose;
+
+	for( ; numverts >= 4; numverts -= 4, v += 16, ov += 16, sv += 16, osv += 16, blends += 4 ) {
+		SKM_TRANSFORM_NORMAL_AND_SVEC( 0 );
+		SKM_TRANSFORM_NORMAL_AND_SVEC( 1 );
+		SKM_TRANSFORM_NORMAL_AND_SVEC( 2 );
+		SKM_TRANSFORM_NORMAL_AND_SVEC( 3 );
+	}
+	for( ; numverts; numverts--, v += 4, ov += 4, sv += 4, osv += 4, blends++ ) {
+		SKM_TRANSFORM_NORMAL_AND_SVEC( 0 );
+	}
+}
+
+#undef SKM_TRANSFORM_VERT
+#undef SKM_TRANSFORM_NORMAL
+#undef SKM_TRANSFORM_NORMAL_AND_SVEC
+
+#else
+
+#define R_SkeletalBlendPoses                R_SkeletalBlendPoses_Generic
+#define R_SkeletalTransformVerts            R_SkeletalTransformVerts_Generic
+#define R_SkeletalTransformNormals          R_SkeletalTransformNormals_Generic
+#define R_SkeletalTransformNormalsAndSVecs  R_SkeletalTransformNormalsAndSVecs_Generic
+
+#endif // SKM_SIMD
+
+#ifdef SKM_SIMD
+
+#define SKM_TEST_BONES      64
+#define SKM_TEST_BLENDS     64
+#define SKM_TEST_VERTS      1021
+
+/*
+* R_SkeletalCompareVecs
+*/
+static float R_SkeletalCompareVecs( int numverts, const vec_t *v1, const vec_t *v2 ) {
+	int i;
+	float d, maxError = 0;
+
+	for( i = 0; i < numverts * 4; i++ ) {
+		d = fabs( v1[i] - v2[i] ) / max( 1.0f, fabs( v1[i] ) );
+		maxError = max( maxError, d );
+	}
+	return maxError;
+}
+
+#endif
+
+/*
+* R_SkeletalSelfTest_f
+*
+* Checks the SIMD skinning kernels against the generic C versions on random data.
+*/
+void R_SkeletalSelfTest_f( void ) {
+#ifdef SKM_SIMD
+	int i, j;
+	float maxError;
+	const float tolerance = 1e-5f;
+	mat4_t *poses1, *poses2;
+	mskblend_t *blends;
+	unsigned int *vertBlends;
+	vec_t *v, *sv, *ov1, *ov2, *osv1, *osv2;
+	bool failed = false;
+
+	poses1 = R_Malloc( sizeof( mat4_t ) * ( SKM_TEST_BONES + SKM_TEST_BLENDS ) );
+	poses2 = R_Malloc( sizeof( mat4_t ) * ( SKM_TEST_BONES + SKM_TEST_BLENDS ) );
+	blends = R_Malloc( sizeof( *blends ) * SKM_TEST_BLENDS );
+	vertBlends = R_Malloc( sizeof( *vertBlends ) * SKM_TEST_VERTS );
+	v = R_Malloc( sizeof( vec4_t ) * SKM_TEST_VERTS * 6 );
+	sv = v + SKM_TEST_VERTS * 4;
+	ov1 = sv + SKM_TEST_VERTS * 4;
+	ov2 = ov1 + SKM_TEST_VERTS * 4;
+	osv1 = ov2 + SKM_TEST_VERTS * 4;
+	osv2 = osv1 + SKM_TEST_VERTS * 4;
+
+	for( i = 0; i < SKM_TEST_BONES; i++ ) {
+		for( j = 0; j < 16; j++ ) {
+			poses1[i][j] = crandom() * ( j >= 12 ? 100.0f : 1.0f );
+		}
+	}
+	for( i = 0; i < SKM_TEST_BLENDS; i++ ) {
+		int left = 255;
+		for( j = 0; j < SKM_MAX_WEIGHTS; j++ ) {
+			blends[i].indices[j] = rand() % SKM_TEST_BONES;
+			blends[i].weights[j] = j == SKM_MAX_WEIGHTS - 1 ? left : rand() % ( left + 1 );
+			left -= blends[i].weights[j];
+		}
+	}
+	for( i = 0; i < SKM_TEST_VERTS; i++ ) {
+		vertBlends[i] = rand() % ( SKM_TEST_BONES + SKM_TEST_BLENDS );
+		for( j = 0; j < 4; j++ ) {
+			v[i * 4 + j] = crandom() * 64.0f;
+			sv[i * 4 + j] = crandom();
+		}
+	}
+	memcpy( poses2, poses1, sizeof( mat4_t ) * SKM_TEST_BONES );
+
+	R_SkeletalBlendPoses_Generic( SKM_TEST_BLENDS, blends, SKM_TEST_BONES, poses1 );
+	R_SkeletalBlendPoses( SKM_TEST_BLENDS, blends, SKM_TEST_BONES, poses2 );
+	for( i = SKM_TEST_BONES, maxError = 0; i < SKM_TEST_BONES + SKM_TEST_BLENDS; i++ ) {
+		for( j = 0; j < 16; j++ ) {
+			if( ( j & 3 ) != 3 ) {
+				maxError = max( maxError, fabs( poses1[i][j] - poses2[i][j] ) / max( 1.0f, fabs( poses1[i][j] ) ) );
+			}
+		}
+	}
+	Com_Printf( "blend poses: %g\n", maxError );
+	failed |= maxError > tolerance;
+
+	R_SkeletalTransformVerts_Generic( SKM_TEST_VERTS, vertBlends, poses1, v, ov1 );
+	R_SkeletalTransformVerts( SKM_TEST_VERTS, vertBlends, poses1, v, ov2 );
+	maxError = R_SkeletalCompareVecs( SKM_TEST_VERTS, ov1, ov2 );
+	Com_Printf( "transform verts: %g\n", maxError );
+	failed |= maxError > tolerance;
+
+	R_SkeletalTransformNormals_Generic( SKM_TEST_VERTS, vertBlends, poses1, v, ov1 );
+	R_SkeletalTransformNormals( SKM_TEST_VERTS, vertBlends, poses1, v, ov2 );
+	maxError = R_SkeletalCompareVecs( SKM_TEST_VERTS, ov1, ov2 );
+	Com_Printf( "transform normals: %g\n", maxError );
+	failed |= maxError > tolerance;
+
+	R_SkeletalTransformNormalsAndSVecs_Generic( SKM_TEST_VERTS, vertBlends, poses1, v, ov1, sv, osv1 );
+	R_SkeletalTransformNormalsAndSVecs( SKM_TEST_VERTS, vertBlends, poses1, v, ov2, sv, osv2 );
+	maxError = max( R_SkeletalCompareVecs( SKM_TEST_VERTS, ov1, ov2 ), R_SkeletalCompareVecs( SKM_TEST_VERTS, osv1, osv2 ) );
+	Com_Printf( "transform normals and svecs: %g\n", maxError );
+	failed |= maxError > tolerance;
+
+	Com_Printf( "%s\n", failed ? S_COLOR_RED "FAILED" : "passed" );
+
+	R_Free( v );
+	R_Free( vertBlends );
+	R_Free( blends );
+	R_Free( poses2 );
+	R_Free( poses1 );
+#else
+	Com_Printf( "SIMD skinning is not available in this build\n" );
+#endif
+}
+
 // set the FP precision back to whatever value it was
 #if defined ( _WIN32 ) && ( _MSC_VER >= 1400 ) && defined( NDEBUG )
 # pragma float_control(pop)
@@ -1080,7 +1556,6 @@ static void R_SkeletalTransformNormalsAndSVecs( int numverts, const unsigned int
 */
 static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *ja ) {
 	unsigned i, j;
-	const entity_t *e;
 	float frontlerp;
 	bonepose_t tempbonepose[256];
 	const bonepose_t *bp, *oldbp, *bonepose, *oldbonepose, *lerpedbonepose;
@@ -1096,17 +1571,16 @@ static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *
 		return;
 	}
 
-	e = R_NUM2ENT( cache->entNum );
 	skmodel = cache->skmodel;
 	bp = cache->boneposes;
 	oldbp = cache->oldboneposes;
-	frontlerp = 1.0 - e->backlerp;
+	frontlerp = 1.0 - cache->backlerp;
 
 	// lerp boneposes and store results in cache
 
 	lerpedbonepose = tempbonepose;
 	if( bp == oldbp || frontlerp == 1 ) {
-		if( e->boneposes ) {
+		if( cache->customPoses ) {
 			// assume that parent transforms have already been applied
 			lerpedbonepose = bp;
 		} else {
@@ -1124,7 +1598,7 @@ static void R_CacheBoneTransformsJob( unsigned first, unsigned items, jobarg_t *
 			}
 		}
 	} else {
-		if( e->boneposes ) {
+		if( cache->customPoses ) {
 			// lerp, assume that parent transforms have already been applied
 			for( i = 0, out = tempbonepose, bonepose = bp, oldbonepose = oldbp, bone = skmodel->bones; i < skmodel->numbones; i++, out++, bonepose++, oldbonepose++, bone++ ) {
 				DualQuat_Lerp( oldbonepose->dualquat, bonepose->dualquat, frontlerp, out->dualquat );
@@ -1197,7 +1671,9 @@ void R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t
 
 	if( cache ) {
 		bonePoseRelativeDQ = ( dualquat_t * )cache->data;
-		bonePoseRelativeMat = ( mat4_t * )( ( uint8_t * )bonePoseRelativeDQ + sizeof( dualquat_t ) * skmodel->numbones );
+		if( !cache->hwTransform ) {
+			bonePoseRelativeMat = ( mat4_t * )( ( uint8_t * )bonePoseRelativeDQ + sizeof( dualquat_t ) * skmodel->numbones );
+		}
 	}
 
 	if( !cache || ( cache->boneposes == cache->oldboneposes && !cache->framenum ) ) {
@@ -1228,23 +1704,52 @@ void R_DrawSkeletalSurf( const entity_t *e, const shader_t *shader, const mfog_t
 	dynamicMesh.numVerts = skmesh->numverts;
 	dynamicMesh.stArray = skmesh->stArray;
 
-	R_GetTransformBufferForMesh( &dynamicMesh, true,
-		 ( vattribs & ( VATTRIB_NORMAL_BIT | VATTRIB_SVECTOR_BIT ) ) ? true : false,
-		 ( vattribs & VATTRIB_SVECTOR_BIT ) ? true : false );
-
 	if( bonePoseRelativeMat ) {
-		R_SkeletalTransformVerts( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
-			  ( vec_t * )skmesh->xyzArray[0], ( vec_t * )( dynamicMesh.xyzArray ) );
+		skmcachemesh_t *cmesh;
+		size_t arraySize = sizeof( vec4_t ) * skmesh->numverts;
 
-		if( vattribs & VATTRIB_SVECTOR_BIT ) {
+		// skin each mesh once per frame, no matter how many views or passes draw it
+		if( !cache->meshes ) {
+			cache->meshes = R_SkeletalCache_Alloc( sizeof( skmcachemesh_t ) * skmodel->nummeshes );
+			memset( cache->meshes, 0, sizeof( skmcachemesh_t ) * skmodel->nummeshes );
+		}
+		cmesh = &cache->meshes[skmesh - skmodel->meshes];
+
+		if( !cmesh->xyzArray ) {
+			cmesh->xyzArray = R_SkeletalCache_Alloc( arraySize );
+			R_SkeletalTransformVerts( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
+				  ( vec_t * )skmesh->xyzArray[0], ( vec_t * )( cmesh->xyzArray ) );
+			rf.stats.c_skm_skins++;
+		} else {
+			rf.stats.c_skm_skins_cached++;
+		}
+
+		if( ( vattribs & VATTRIB_SVECTOR_BIT ) && !cmesh->sVectorsArray ) {
+			if( !cmesh->normalsArray ) {
+				cmesh->normalsArray = R_SkeletalCache_Alloc( arraySize );
+			}
+			cmesh->sVectorsArray = R_SkeletalCache_Alloc( arraySize );
 			R_SkeletalTransformNormalsAndSVecs( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
-					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ),
-					( vec_t * )skmesh->sVectorsArray[0], ( vec_t * )( dynamicMesh.sVectorsArray ) );
-		} else if( vattribs & VATTRIB_NORMAL_BIT ) {
+					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( cmesh->normalsArray ),
+					( vec_t * )skmesh->sVectorsArray[0], ( vec_t * )( cmesh->sVectorsArray ) );
+		} else if( ( vattribs & VATTRIB_NORMAL_BIT ) && !cmesh->normalsArray ) {
+			cmesh->normalsArray = R_SkeletalCache_Alloc( arraySize );
 			R_SkeletalTransformNormals( skmesh->numverts, skmesh->vertexBlends, bonePoseRelativeMat,
-					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( dynamicMesh.normalsArray ) );
+					( vec_t * )skmesh->normalsArray[0], ( vec_t * )( cmesh->normalsArray ) );
+		}
+
+		dynamicMesh.xyzArray = cmesh->xyzArray;
+		if( vattribs & ( VATTRIB_NORMAL_BIT | VATTRIB_SVECTOR_BIT ) ) {
+			dynamicMesh.normalsArray = cmesh->normalsArray;
+		}
+		if( vattribs & VATTRIB_SVECTOR_BIT ) {
+			dynamicMesh.sVectorsArray = cmesh->sVectorsArray;
 		}
 	} else {
+		R_GetTransformBufferForMesh( &dynamicMesh, true,
+			 ( vattribs & ( VATTRIB_NORMAL_BIT | VATTRIB_SVECTOR_BIT ) ) ? true : false,
+			 ( vattribs & VATTRIB_SVECTOR_BIT ) ? true : false );
+
 		memcpy( ( vec_t * )( dynamicMesh.xyzArray ), ( vec_t * )skmesh->xyzArray[0], sizeof( vec4_t ) * skmesh->numverts );
 
 		if( vattribs & VATTRIB_SVECTOR_BIT ) {
@@ -1334,10 +1839,12 @@ void R_SkeletalModelFrameBounds( const model_t *mod, int frame, vec3_t mins, vec
 static void R_AddSkeletalModelCacheJob( const entity_t *e, const model_t *mod ) {
 	int entNum;
 	int framenum, oldframenum;
+	float backlerp;
+	unsigned int hash;
 	const mskmodel_t *skmodel;
 	const bonepose_t *bp, *oldbp;
 	skmcacheentry_t *cache;
-	bool hwTransform;
+	bool hwTransform, customPoses;
 	jobarg_t ja = { 0 };
 
 	entNum = R_ENT2NUM( e );
@@ -1346,23 +1853,18 @@ static void R_AddSkeletalModelCacheJob( const entity_t *e, const model_t *mod )
 		return;
 	}
 
-	cache = R_GetSkeletalCache( entNum );
-	if( cache != NULL ) {
+	if( r_skmcachekeys[entNum] ) {
 		// already cached
 		return;
 	}
 
 	hwTransform = (skmodel->numbones == 0 || glConfig.maxGLSLBones > 0);
-	cache = ( void * )R_AllocSkeletalDataCache( entNum, skmodel, hwTransform );
-	if( !cache ) {
-		// probably out of memory
-		return;
-	}
 
 	framenum = e->frame;
 	oldframenum = e->oldframe;
 	bp = e->boneposes;
 	oldbp = e->oldboneposes;
+	customPoses = false;
 
 	// not sure if it's really needed
 	if( !skmodel->numframes || bp == skmodel->frames[0].boneposes ) {
@@ -1378,6 +1880,7 @@ static void R_AddSkeletalModelCacheJob( const entity_t *e, const model_t *mod )
 		if( !oldbp ) {
 			oldbp = bp;
 		}
+		customPoses = true;
 	} else {
 		if( ( framenum >= (int)skmodel->numframes ) || ( framenum < 0 ) ) {
 #ifndef PUBLIC_BUILD
@@ -1396,15 +1899,28 @@ static void R_AddSkeletalModelCacheJob( const entity_t *e, const model_t *mod )
 		oldbp = skmodel->frames[oldframenum].boneposes;
 	}
 
-	cache->boneposes = bp;
-	cache->oldboneposes = oldbp;
-	cache->framenum = framenum;
-	cache->oldframenum = oldframenum;
+	// the lerp fraction is irrelevant when there's nothing to lerp between
+	backlerp = bp == oldbp ? 0 : e->backlerp;
+
+	hash = R_HashSkeletalCacheKey( skmodel, framenum, oldframenum, backlerp, bp, oldbp, customPoses );
+
+	cache = R_FindSkeletalCache( hash, skmodel, framenum, oldframenum, backlerp, bp, oldbp, customPoses, hwTransform );
+	if( cache ) {
+		// computed for another entity, view or scene earlier in this frame
+		r_skmcachekeys[entNum] = cache;
+		rf.stats.c_skm_poses_cached++;
+		return;
+	}
+
+	cache = R_AllocSkeletalDataCache( hash, skmodel, framenum, oldframenum, backlerp, bp, oldbp, customPoses, hwTransform );
+	r_skmcachekeys[entNum] = cache;
 
 	if( bp == oldbp && !framenum ) {
 		return;
 	}
 
+	rf.stats.c_skm_poses++;
+
 	ja.parg = cache;
 	RJ_ScheduleJob( &R_CacheBoneTransformsJob, &ja, 1 );
 }
@@ -581,20 +581,95 @@ WORLD MODEL
 =============================================================
 */
 
+#define WORLD_CULL_MAX_CHUNKS       64
+#define WORLD_CULL_MIN_CHUNK_SIZE   256
+
+// culling results of a single range of leafs or surfaces, merged
+// on the frontend thread once all ranges have been processed
+typedef struct {
+	unsigned first;
+	unsigned numItems;
+	vec3_t pvsMins, pvsMaxs;
+	unsigned numBrushPolys;
+	bool sky;
+} worldCullChunk_t;
+
+typedef struct {
+	unsigned clipFlags;
+	unsigned numChunks;
+	worldCullChunk_t chunks[WORLD_CULL_MAX_CHUNKS];
+
+	// shadow and light views
+	int maskindex;
+	const drawList_t *parentDrawList;
+	uint8_t *surfVis;
+	const unsigned **drawSurfInfo;
+	uint8_t *drawSurfVis;
+} worldCullJob_t;
+
+/*
+* R_SetupWorldCullJob
+*
+* Splits the items in a few ranges per job thread so that
+* the scheduler can balance the load between threads.
+*/
+static void R_SetupWorldCullJob( worldCullJob_t *job, unsigned numItems, unsigned clipFlags ) {
+	unsigned i;
+	unsigned chunkSize, numChunks;
+	worldCullChunk_t *chunk;
+
+	numChunks = ( ri.Jobs_NumWorkers() + 1 ) * 4;
+	if( numChunks > WORLD_CULL_MAX_CHUNKS ) {
+		numChunks = WORLD_CULL_MAX_CHUNKS;
+	}
+
+	chunkSize = ( numItems + numChunks - 1 ) / numChunks;
+	if( chunkSize < WORLD_CULL_MIN_CHUNK_SIZE ) {
+		chunkSize = WORLD_CULL_MIN_CHUNK_SIZE;
+	}
+
+	job->clipFlags = clipFlags;
+	job->numChunks = ( numItems + chunkSize - 1 ) / chunkSize;
+
+	for( i = 0, chunk = job->chunks; i < job->numChunks; i++, chunk++ ) {
+		chunk->first = i * chunkSize;
+		chunk->numItems = min( chunkSize, numItems - chunk->first );
+		VectorCopy( rn.pvsMins, chunk->pvsMins );
+		VectorCopy( rn.pvsMaxs, chunk->pvsMaxs );
+		chunk->numBrushPolys = 0;
+		chunk->sky = false;
+	}
+}
+
+/*
+* R_RunWorldCullJob
+*/
+static void R_RunWorldCullJob( worldCullJob_t *job, jobfunc_t func ) {
+	jobarg_t ja;
+
+	memset( &ja, 0, sizeof( ja ) );
+	ja.parg = job;
+
+	RJ_ParallelFor( func, &ja, job->numChunks, 1 );
+}
+
 /*
 * R_CullVisLeaves
+*
+* Visibility flags of surfaces shared between leafs may be raised from
+* several threads at once, which is fine as they are only ever set to 1.
 */
-static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned clipFlags ) {
+static void R_CullVisLeaves( worldCullChunk_t *chunk, unsigned clipFlags ) {
 	unsigned i, j;
 	mleaf_t *leaf;
 	const uint8_t *pvs = rn.pvs;
 	const uint8_t *areabits = rn.areabits;
 
-	for( i = 0; i < numLeaves; i++ ) {
+	for( i = 0; i < chunk->numItems; i++ ) {
 		int clipped;
 		unsigned bit, testFlags;
 		cplane_t *clipplane;
-		unsigned l = firstLeaf + i;
+		unsigned l = chunk->first + i;
 
 		leaf = &rsh.worldBrushModel->leafs[l];
 		if( leaf->cluster < 0 || !leaf->numVisSurfaces ) {
@@ -616,8 +691,8 @@ static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned cl
 
 		// add leaf bounds to pvs bounds
 		for( j = 0; j < 3; j++ ) {
-			rn.pvsMins[j] = min( rn.pvsMins[j], leaf->mins[j] );
-			rn.pvsMaxs[j] = max( rn.pvsMaxs[j], leaf->maxs[j] );
+			chunk->pvsMins[j] = min( chunk->pvsMins[j], leaf->mins[j] );
+			chunk->pvsMaxs[j] = max( chunk->pvsMaxs[j], leaf->maxs[j] );
 		}
 
 		// track leaves, which are entirely inside the frustum
@@ -656,16 +731,31 @@ static void R_CullVisLeaves( unsigned firstLeaf, unsigned numLeaves, unsigned cl
 	}
 }
 
+/*
+* R_CullVisLeavesJob
+*/
+static void R_CullVisLeavesJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i;
+	worldCullJob_t *job = ja->parg;
+
+	for( i = first; i < first + items; i++ ) {
+		R_CullVisLeaves( &job->chunks[i], job->clipFlags );
+	}
+}
+
 /*
 * R_CullVisSurfaces
+*
+* Sky surfaces are only flagged in the chunk here, clipping them
+* against the sky box is left to the frontend thread.
 */
-static void R_CullVisSurfaces( unsigned firstSurf, unsigned numSurfs, unsigned clipFlags ) {
+static void R_CullVisSurfaces( worldCullChunk_t *chunk, unsigned clipFlags ) {
 	unsigned i;
 	unsigned end;
 
-	end = firstSurf + numSurfs;
+	end = chunk->first + chunk->numItems;
 
-	for( i = firstSurf; i < end; i++ ) {
+	for( i = chunk->first; i < end; i++ ) {
 		msurface_t *surf = rsh.worldBrushModel->surfaces + i;
 
 		if( !surf->drawSurf ) {
@@ -692,10 +782,52 @@ static void R_CullVisSurfaces( unsigned firstSurf, unsigned numSurfs, unsigned c
 			rn.meshlist->worldDrawSurfVis[surf->drawSurf - 1] = 1;
 
 			if( surf->flags & SURF_SKY ) {
-				R_ClipSkySurface( &rn.skyDrawSurface, surf );
+				chunk->sky = true;
 			}
 
-			rf.stats.c_brush_polys++;
+			chunk->numBrushPolys++;
+		}
+	}
+}
+
+/*
+* R_CullVisSurfacesJob
+*/
+static void R_CullVisSurfacesJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i;
+	worldCullJob_t *job = ja->parg;
+
+	for( i = first; i < first + items; i++ ) {
+		R_CullVisSurfaces( &job->chunks[i], job->clipFlags );
+	}
+}
+
+/*
+* R_MergeWorldCullJob
+*/
+static void R_MergeWorldCullJob( const worldCullJob_t *job ) {
+	unsigned i, j, end;
+	const worldCullChunk_t *chunk;
+	const msurface_t *surf;
+
+	for( i = 0, chunk = job->chunks; i < job->numChunks; i++, chunk++ ) {
+		for( j = 0; j < 3; j++ ) {
+			rn.pvsMins[j] = min( rn.pvsMins[j], chunk->pvsMins[j] );
+			rn.pvsMaxs[j] = max( rn.pvsMaxs[j], chunk->pvsMaxs[j] );
+		}
+
+		rf.stats.c_brush_polys += chunk->numBrushPolys;
+
+		if( !chunk->sky ) {
+			continue;
+		}
+
+		end = chunk->first + chunk->numItems;
+		for( j = chunk->first; j < end; j++ ) {
+			surf = rsh.worldBrushModel->surfaces + j;
+			if( ( surf->flags & SURF_SKY ) && rn.meshlist->worldSurfVis[j] ) {
+				R_ClipSkySurface( &rn.skyDrawSurface, surf );
+			}
 		}
 	}
 }
@@ -794,6 +926,102 @@ static void R_PostCullVisLeaves( void ) {
 	R_SetupViewMatrices( &rn.refdef );
 }
 
+/*
+* R_CullShadowLeavesJob
+*/
+static void R_CullShadowLeavesJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i, j, k, end;
+	worldCullJob_t *job = ja->parg;
+	const worldCullChunk_t *chunk;
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
+	const uint8_t *areabits = rn.areabits;
+
+	for( i = first; i < first + items; i++ ) {
+		chunk = &job->chunks[i];
+		end = chunk->first + chunk->numItems;
+
+		for( j = chunk->first; j < end; j++ ) {
+			int leafNum = rn.rtLightVisLeafs[j];
+			const mleaf_t *leaf = bm->leafs + leafNum;
+
+			// check for door connected areas
+			if( areabits ) {
+				if( leaf->area < 0 || !( areabits[leaf->area >> 3] & ( 1 << ( leaf->area & 7 ) ) ) ) {
+					continue; // not visible
+				}
+			}
+
+			if( rn.renderFlags & RF_LIGHTVIEW ) {
+				if( !job->parentDrawList->worldLeafVis[leafNum] ) {
+					continue;
+				}
+			} else {
+				if( R_CullBox( leaf->mins, leaf->maxs, rn.clipFlags ) ) {
+					continue;
+				}
+			}
+
+			rn.meshlist->worldLeafVis[leafNum] = 1;
+
+			for( k = 0; k < leaf->numVisSurfaces; k++ ) {
+				assert( leaf->visSurfaces[k] < rn.meshlist->numWorldSurfVis );
+				job->surfVis[leaf->visSurfaces[k]] = 1;
+			}
+		}
+	}
+}
+
+/*
+* R_CullShadowSurfacesJob
+*/
+static void R_CullShadowSurfacesJob( unsigned first, unsigned items, jobarg_t *ja ) {
+	unsigned i, j, k, end;
+	worldCullJob_t *job = ja->parg;
+	worldCullChunk_t *chunk;
+	const mbrushmodel_t *bm = rsh.worldBrushModel;
+	const rtlight_t *l = rn.rtLight;
+
+	for( i = first; i < first + items; i++ ) {
+		chunk = &job->chunks[i];
+		end = chunk->first + chunk->numItems;
+
+		for( j = chunk->first; j < end; j++ ) {
+			bool culled = true;
+			const unsigned *p = job->drawSurfInfo[j] + 1;
+			unsigned numSurfaces = *p++;
+
+			for( k = 0; k < numSurfaces; k++, p += 3 ) {
+				unsigned s = p[0];
+				unsigned mask = p[job->maskindex];
+				const msurface_t *surf = bm->surfaces + s;
+
+				if( mask && job->surfVis[s] ) {
+					if( rn.renderFlags & RF_LIGHTVIEW ) {
+						if( !job->parentDrawList->worldSurfVis[s] ) {
+							continue;
+						}
+					} else {
+						if( R_CullBox( surf->mins, surf->maxs, job->clipFlags ) ) {
+							continue;
+						}
+						if( l->sky && (surf->flags & SURF_SKY) ) {
+							if( !BoundsInsideBounds( surf->mins, surf->maxs, l->skymins, l->skymaxs ) ) {
+								continue;
+							}
+						}
+					}
+
+					culled = false;
+					rn.meshlist->worldSurfVis[s] = 1;
+					chunk->numBrushPolys++;
+				}
+			}
+
+			job->drawSurfVis[j] = culled ? 0 : 1;
+		}
+	}
+}
+
 /*
 * R_DrawWorldShadowNode
 */
@@ -804,13 +1032,11 @@ void R_DrawWorldShadowNode( void ) {
 	bool speeds = r_speeds->integer != 0;
 	mbrushmodel_t *bm = rsh.worldBrushModel;
 	rtlight_t *l = rn.rtLight;
-	const uint8_t *areabits = rn.areabits;
 	unsigned *p;
 	unsigned numDrawSurfaces;
-	int maskindex = -1;
 	drawList_t *parentDrawList = NULL;
-	uint8_t *tempSurfVis;
 	void *cachemark;
+	worldCullJob_t cullJob;
 
 	R_ReserveDrawListWorldSurfaces( rn.meshlist );
 
@@ -846,84 +1072,49 @@ void R_DrawWorldShadowNode( void ) {
 		msec = ri.Sys_Milliseconds();
 	}
 
+	memset( &cullJob, 0, sizeof( cullJob ) );
+	cullJob.parentDrawList = parentDrawList;
+
 	if( rn.renderFlags & RF_LIGHTVIEW ) {
-		maskindex = 1;
+		cullJob.maskindex = 1;
 	} else {
-		maskindex = 2;
+		cullJob.maskindex = 2;
 	}
 
 	cachemark = R_FrameCache_SetMark();
 
-	tempSurfVis = R_FrameCache_Alloc( sizeof( *tempSurfVis ) * rsh.worldBrushModel->numsurfaces );
-	memset( (void *)tempSurfVis, 0, sizeof( *tempSurfVis ) * rsh.worldBrushModel->numsurfaces );
+	cullJob.surfVis = R_FrameCache_Alloc( sizeof( *cullJob.surfVis ) * rsh.worldBrushModel->numsurfaces );
+	memset( (void *)cullJob.surfVis, 0, sizeof( *cullJob.surfVis ) * rsh.worldBrushModel->numsurfaces );
 
-	for( i = 0; i < rn.numRtLightVisLeafs; i++ ) {
-		int leafNum = rn.rtLightVisLeafs[i];
-		const mleaf_t *leaf = bm->leafs + leafNum;
+	R_SetupWorldCullJob( &cullJob, rn.numRtLightVisLeafs, clipFlags );
+	R_RunWorldCullJob( &cullJob, R_CullShadowLeavesJob );
 
-		// check for door connected areas
-		if( areabits ) {
-			if( leaf->area < 0 || !( areabits[leaf->area >> 3] & ( 1 << ( leaf->area & 7 ) ) ) ) {
-				continue; // not visible
-			}
-		}
-
-		if( rn.renderFlags & RF_LIGHTVIEW ) {
-			if( !parentDrawList->worldLeafVis[leafNum] ) {
-				continue;
-			}
-		} else {
-			if( R_CullBox( leaf->mins, leaf->maxs, rn.clipFlags ) ) {
-				continue;
-			}
-		}
+	// index the variable length surface lists so that they can be culled in parallel
+	numDrawSurfaces = *p++;
 
-		rn.meshlist->worldLeafVis[leafNum] = 1;
+	cullJob.drawSurfInfo = R_FrameCache_Alloc( sizeof( *cullJob.drawSurfInfo ) * numDrawSurfaces );
+	cullJob.drawSurfVis = R_FrameCache_Alloc( sizeof( *cullJob.drawSurfVis ) * numDrawSurfaces );
 
-		for( j = 0; j < leaf->numVisSurfaces; j++ ) {
-			assert( leaf->visSurfaces[j] < rn.meshlist->numWorldSurfVis );
-			tempSurfVis[leaf->visSurfaces[j]] = 1;
-		}
+	for( i = 0; i < numDrawSurfaces; i++ ) {
+		cullJob.drawSurfInfo[i] = p;
+		p += 2 + p[1] * 3;
 	}
 
-	numDrawSurfaces = *p++;
+	R_SetupWorldCullJob( &cullJob, numDrawSurfaces, clipFlags );
+	R_RunWorldCullJob( &cullJob, R_CullShadowSurfacesJob );
 
-	for( i = 0; i < numDrawSurfaces; i++ ) {
-		bool culled = true;
-		unsigned ds = *p++;
-		unsigned numSurfaces = *p++;
-
-		for( j = 0; j < numSurfaces; j++, p += 3 ) {
-			unsigned s = p[0];
-			unsigned mask = p[maskindex];
-			const msurface_t *surf = bm->surfaces + s;
-
-			if( mask && tempSurfVis[s] ) {
-				if( rn.renderFlags & RF_LIGHTVIEW ) {
-					if( !parentDrawList->worldSurfVis[s] ) {
-						continue;
-					}
-				} else {
-					if( R_CullBox( surf->mins, surf->maxs, clipFlags ) ) {
-						continue;
-					}
-					if( l->sky && (surf->flags & SURF_SKY) ) {
-						if( !BoundsInsideBounds( surf->mins, surf->maxs, l->skymins, l->skymaxs ) ) {
-							continue;
-						}
-					}
-				}
+	for( i = 0; i < cullJob.numChunks; i++ ) {
+		rf.stats.c_brush_polys += cullJob.chunks[i].numBrushPolys;
+	}
 
-				culled = false;
-				rn.meshlist->worldSurfVis[s] = 1;
-				rf.stats.c_brush_polys++;
-			}
+	for( i = 0; i < numDrawSurfaces; i++ ) {
+		if( !cullJob.drawSurfVis[i] ) {
+			continue;
 		}
 
-		if( !culled ) {
-			rn.meshlist->worldDrawSurfVis[ds] = 1;
-			R_AddWorldDrawSurfaceToDrawList( rsc.worldent, ds );
-		}
+		j = cullJob.drawSurfInfo[i][0];
+		rn.meshlist->worldDrawSurfVis[j] = 1;
+		R_AddWorldDrawSurfaceToDrawList( rsc.worldent, j );
 	}
 
 	R_FrameCache_FreeToMark( cachemark );
@@ -942,6 +1133,7 @@ void R_DrawWorldNode( void ) {
 	int64_t msec = 0, msec2 = 0;
 	bool speeds = r_speeds->integer != 0;
 	mbrushmodel_t *bm = rsh.worldBrushModel;
+	worldCullJob_t cullJob;
 
 	R_ReserveDrawListWorldSurfaces( rn.meshlist );
 
@@ -976,7 +1168,9 @@ void R_DrawWorldNode( void ) {
 	}
 
 	if( bm->numleafs <= bm->numsurfaces ) {
-		R_CullVisLeaves( 0, bm->numleafs, clipFlags );
+		R_SetupWorldCullJob( &cullJob, bm->numleafs, clipFlags );
+		R_RunWorldCullJob( &cullJob, R_CullVisLeavesJob );
+		R_MergeWorldCullJob( &cullJob );
 	} else {
 		memset( (void *)rn.meshlist->worldSurfVis, 1, bm->numsurfaces * sizeof( *rn.meshlist->worldSurfVis ) );
 		memset( (void *)rn.meshlist->worldSurfFullVis, 0, bm->numsurfaces * sizeof( *rn.meshlist->worldSurfFullVis ) );
@@ -995,7 +1189,9 @@ void R_DrawWorldNode( void ) {
 		msec2 = ri.Sys_Milliseconds();
 	}
 
-	R_CullVisSurfaces( 0, bm->numModelSurfaces, clipFlags );
+	R_SetupWorldCullJob( &cullJob, bm->numModelSurfaces, clipFlags );
+	R_RunWorldCullJob( &cullJob, R_CullVisSurfacesJob );
+	R_MergeWorldCullJob( &cullJob );
 
 	R_PostCullVisLeaves();
 
@@ -105,6 +105,13 @@ void Sys_Thread_Yield( void ) {
 	Sys_Sleep( 0 );
 }
 
+/*
+* Sys_GetNumberOfProcessors
+*/
+int Sys_GetNumberOfProcessors( void ) {
+	return SDL_GetCPUCount();
+}
+
 /*
 * Sys_Atomic_Add
 */
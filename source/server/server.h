@@ -201,12 +201,13 @@ typedef struct {
 
 // for server side demo recording
 typedef struct {
-	int file;
+	struct demostream_s *file;
 	char *filename;
 	char *tempname;
 	time_t localtime;
 	int64_t basetime, duration;
 	client_t client;                // special client for writing the messages
+	struct demoindex_s *index;      // keyframes for seeking
 	char meta_data[SNAP_MAX_DEMO_META_DATA_SIZE];
 	size_t meta_data_realsize;
 } server_static_demo_t;
@@ -327,6 +328,7 @@ extern cvar_t *sv_lastAutoUpdate;
 extern cvar_t *sv_defaultmap;
 
 extern cvar_t *sv_demodir;
+extern cvar_t *sv_democompression;
 
 extern cvar_t *sv_mm_authkey;
 extern cvar_t *sv_mm_loginonly;
@@ -519,3 +521,10 @@ const char *SV_Web_UpstreamBaseUrl( void );
 bool SV_Web_AddGameClient( const char *session, int clientNum, const netadr_t *netAdr );
 void SV_Web_RemoveGameClient( const char *session );
 void SV_Web_GameFrame( http_game_query_cb cb );
+
+//
+// sv_fakeservers.c
+//
+void SV_FakeServers_Init( void );
+void SV_FakeServers_Shutdown( void );
+void SV_FakeServers_Frame( void );
@@ -73,6 +73,12 @@ void SV_Demo_WriteSnap( void ) {
 
 	MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
 
+	// write a non-delta frame every now and then so players can seek to it
+	if( SNAP_DemoKeyframeDue( svs.demo.index, svs.gametime ) ) {
+		svs.demo.client.nodelta = true;
+		SNAP_AddDemoKeyframe( svs.demo.index, DemoStream_Tell( svs.demo.file ), svs.gametime, sv.configstrings[0] );
+	}
+
 	SV_BuildClientFrameSnap( &svs.demo.client );
 
 	SV_WriteFrameSnapToClient( &svs.demo.client, &msg );
@@ -109,7 +115,7 @@ static void SV_Demo_InitClient( void ) {
 * Begins server demo recording.
 */
 void SV_Demo_Start_f( void ) {
-	int demofilename_size, i;
+	int demofilename_size, i, file;
 
 	if( Cmd_Argc() < 2 ) {
 		Com_Printf( "Usage: serverrecord <demoname>\n" );
@@ -165,7 +171,7 @@ void SV_Demo_Start_f( void ) {
 	Q_snprintfz( svs.demo.tempname, demofilename_size, "%s.rec", svs.demo.filename );
 
 	// open it
-	if( FS_FOpenFile( svs.demo.tempname, &svs.demo.file, FS_WRITE ) == -1 ) {
+	if( FS_FOpenFile( svs.demo.tempname, &file, FS_WRITE ) == -1 ) {
 		Com_Printf( "Error: Couldn't open file: %s\n", svs.demo.tempname );
 		Mem_ZoneFree( svs.demo.filename );
 		svs.demo.filename = NULL;
@@ -174,10 +180,14 @@ void SV_Demo_Start_f( void ) {
 		return;
 	}
 
+	svs.demo.file = DemoStream_Open( file, FS_WRITE, sv_democompression->integer );
+
 	Com_Printf( "Recording server demo: %s\n", svs.demo.filename );
 
 	SV_Demo_InitClient();
 
+	svs.demo.index = SNAP_CreateDemoIndex();
+
 	// write serverdata, configstrings and baselines
 	svs.demo.duration = 0;
 	svs.demo.basetime = svs.gametime;
@@ -204,13 +214,15 @@ static void SV_Demo_Stop( bool cancel, bool silent ) {
 	if( cancel ) {
 		Com_Printf( "Canceled server demo recording: %s\n", svs.demo.filename );
 	} else {
-		SNAP_StopDemoRecording( svs.demo.file );
+		SNAP_StopDemoRecording( svs.demo.file, svs.demo.index );
 
 		Com_Printf( "Stopped server demo recording: %s\n", svs.demo.filename );
 	}
 
-	FS_FCloseFile( svs.demo.file );
-	svs.demo.file = 0;
+	DemoStream_Close( &svs.demo.file );
+
+	SNAP_FreeDemoIndex( svs.demo.index );
+	svs.demo.index = NULL;
 
 	if( cancel ) {
 		if( !FS_RemoveFile( svs.demo.tempname ) ) {
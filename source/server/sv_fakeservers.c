@@ -0,0 +1,336 @@
+/*
+Copyright (C) 2013 Victor Luchits
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// sv_fakeservers.c -- local fake game servers for testing the server browser
+
+#include "server.h"
+
+// Each fake server is an UDP socket on the loopback interface answering info queries,
+// and the socket on the base port answers getservers queries with all of them like a
+// master server would, so a client with masterservers set to 127.0.0.1:<base port>
+// gets the whole list. Queries may be dropped at random and above a rate to emulate
+// loss and a congested link, and replies may be delayed. The number of queries seen
+// per second and per frame shows how the client paces and batches them.
+
+#define FAKE_SERVERS_PORT               ( PORT_SERVER + 1000 )
+#define MAX_FAKE_SERVERS                4096
+#define FAKE_SERVERS_PER_PACKET         180     // addresses in a getservers response packet
+#define MAX_FAKE_SERVER_DELAYED         8192    // replies waiting for the latency to pass
+
+typedef struct {
+	int64_t time;
+	int server;
+	netadr_t address;
+} fakereply_t;
+
+static struct {
+	int numServers;
+	socket_t master;
+	socket_t *servers;
+
+	int loss;                           // percentage of queries dropped at random
+	int rate;                           // queries answered per second, 0 for no limit
+	int latency;                        // msecs before a reply is sent
+	double credit;
+	int64_t lastTime;
+
+	fakereply_t delayed[MAX_FAKE_SERVER_DELAYED];
+	int delayedHead, numDelayed;
+
+	int64_t startTime;
+	int64_t secondTime;
+	unsigned int queries, answered, dropped, lists;
+	unsigned int secondQueries, maxQueriesPerSecond, maxQueriesPerFrame;
+} fakeServers;
+
+/*
+* SV_FakeServers_Stop
+*/
+static void SV_FakeServers_Stop( void ) {
+	int i;
+
+	if( !fakeServers.servers ) {
+		return;
+	}
+
+	for( i = 0; i < fakeServers.numServers; i++ ) {
+		if( fakeServers.servers[i].open ) {
+			NET_CloseSocket( &fakeServers.servers[i] );
+		}
+	}
+	if( fakeServers.master.open ) {
+		NET_CloseSocket( &fakeServers.master );
+	}
+
+	Mem_Free( fakeServers.servers );
+	fakeServers.servers = NULL;
+	fakeServers.numServers = 0;
+}
+
+/*
+* SV_FakeServers_PrintStats
+*/
+static void SV_FakeServers_PrintStats( void ) {
+	int64_t msecs = Sys_Milliseconds() - fakeServers.startTime;
+
+	Com_Printf( "%i fake servers on 127.0.0.1:%i-%i, master on 127.0.0.1:%i\n", fakeServers.numServers,
+				FAKE_SERVERS_PORT + 1, FAKE_SERVERS_PORT + fakeServers.numServers, FAKE_SERVERS_PORT );
+	Com_Printf( "Loss: %i%%, rate limit: %i/s, latency: %i msecs\n", fakeServers.loss, fakeServers.rate, fakeServers.latency );
+	Com_Printf( "%u server lists sent, %u queries in %.1f seconds: %u answered, %u dropped\n",
+				fakeServers.lists, fakeServers.queries, msecs * 0.001, fakeServers.answered, fakeServers.dropped );
+	Com_Printf( "Peak queries: %u per second, %u per frame\n", fakeServers.maxQueriesPerSecond, fakeServers.maxQueriesPerFrame );
+}
+
+/*
+* SV_FakeServers_SendList
+*/
+static void SV_FakeServers_SendList( const netadr_t *address ) {
+	int i, port;
+	msg_t msg;
+	uint8_t msgData[MAX_PACKETLEN];
+	static const uint8_t loopback[4] = { 127, 0, 0, 1 };
+	static const char *header = "getserversResponse";
+
+	MSG_Init( &msg, msgData, sizeof( msgData ) );
+	MSG_WriteData( &msg, header, strlen( header ) );
+
+	for( i = 0; i < fakeServers.numServers; i++ ) {
+		if( i && !( i % FAKE_SERVERS_PER_PACKET ) ) {
+			Netchan_OutOfBand( &fakeServers.master, address, msg.cursize, msg.data );
+			MSG_Clear( &msg );
+			MSG_WriteData( &msg, header, strlen( header ) );
+		}
+
+		port = FAKE_SERVERS_PORT + 1 + i;
+		MSG_WriteInt8( &msg, '\\' );
+		MSG_WriteData( &msg, loopback, sizeof( loopback ) );
+		MSG_WriteInt8( &msg, ( port >> 8 ) & 0xff );
+		MSG_WriteInt8( &msg, port & 0xff );
+	}
+
+	// the end of the list is an address with a zero port
+	MSG_WriteData( &msg, "\\EOT\0\0\0", 7 );
+	Netchan_OutOfBand( &fakeServers.master, address, msg.cursize, msg.data );
+
+	fakeServers.lists++;
+}
+
+/*
+* SV_FakeServers_Reply
+*/
+static void SV_FakeServers_Reply( int server, const netadr_t *address ) {
+	int players = 1 + server % 15;
+
+	// neither empty nor full so that the default filters keep them
+	Netchan_OutOfBandPrint( &fakeServers.servers[server], address,
+							"info\n\\\\n\\\\fake server %i\\\\m\\\\%8s\\\\u\\\\%2i/%2i\\\\g\\\\%6s\\\\EOT",
+							server + 1, "wdm1", players, 16, "ffa" );
+	fakeServers.answered++;
+}
+
+/*
+* SV_FakeServers_Query
+*/
+static void SV_FakeServers_Query( int server, const netadr_t *address, msg_t *msg ) {
+	const char *s;
+	fakereply_t *reply;
+
+	MSG_BeginReading( msg );
+	MSG_ReadInt32( msg );
+	s = MSG_ReadStringLine( msg );
+	Cmd_TokenizeString( s );
+
+	if( server < 0 ) {
+		if( !Q_stricmp( Cmd_Argv( 0 ), "getservers" ) ) {
+			SV_FakeServers_SendList( address );
+		}
+		return;
+	}
+
+	if( strcmp( Cmd_Argv( 0 ), "info" ) ) {
+		return;
+	}
+
+	fakeServers.queries++;
+	fakeServers.secondQueries++;
+
+	if( rand() % 100 < fakeServers.loss ) {
+		fakeServers.dropped++;
+		return;
+	}
+
+	if( fakeServers.rate ) {
+		if( fakeServers.credit < 1.0 ) {
+			fakeServers.dropped++;
+			return;
+		}
+		fakeServers.credit -= 1.0;
+	}
+
+	if( !fakeServers.latency ) {
+		SV_FakeServers_Reply( server, address );
+		return;
+	}
+
+	if( fakeServers.numDelayed == MAX_FAKE_SERVER_DELAYED ) {
+		fakeServers.dropped++;
+		return;
+	}
+
+	reply = &fakeServers.delayed[( fakeServers.delayedHead + fakeServers.numDelayed ) % MAX_FAKE_SERVER_DELAYED];
+	reply->time = Sys_Milliseconds() + fakeServers.latency;
+	reply->server = server;
+	reply->address = *address;
+	fakeServers.numDelayed++;
+}
+
+/*
+* SV_FakeServers_Frame
+*/
+void SV_FakeServers_Frame( void ) {
+	int i, ret;
+	int64_t now;
+	unsigned int frameQueries;
+	netadr_t address;
+	socket_t *socket;
+	fakereply_t *reply;
+	static msg_t msg;
+	static uint8_t msgData[MAX_MSGLEN];
+
+	if( !fakeServers.servers ) {
+		return;
+	}
+
+	now = Sys_Milliseconds();
+
+	if( fakeServers.rate ) {
+		// allow a burst of a tenth of a second
+		fakeServers.credit += fakeServers.rate * (double)( now - fakeServers.lastTime ) * 0.001;
+		fakeServers.credit = min( fakeServers.credit, max( fakeServers.rate * 0.1, 1.0 ) );
+	}
+	fakeServers.lastTime = now;
+
+	if( now >= fakeServers.secondTime + 1000 ) {
+		fakeServers.maxQueriesPerSecond = max( fakeServers.maxQueriesPerSecond, fakeServers.secondQueries );
+		fakeServers.secondQueries = 0;
+		fakeServers.secondTime = now;
+	}
+
+	MSG_Init( &msg, msgData, sizeof( msgData ) );
+
+	frameQueries = fakeServers.queries;
+	for( i = -1; i < fakeServers.numServers; i++ ) {
+		socket = i < 0 ? &fakeServers.master : &fakeServers.servers[i];
+		if( !socket->open ) {
+			continue;
+		}
+
+		while( ( ret = NET_GetPacket( socket, &address, &msg ) ) != 0 ) {
+			if( ret == 1 && msg.cursize >= 4 && *(int *)msg.data == -1 ) {
+				SV_FakeServers_Query( i, &address, &msg );
+			}
+			MSG_Clear( &msg );
+		}
+	}
+	fakeServers.maxQueriesPerFrame = max( fakeServers.maxQueriesPerFrame, fakeServers.queries - frameQueries );
+
+	while( fakeServers.numDelayed ) {
+		reply = &fakeServers.delayed[fakeServers.delayedHead];
+		if( reply->time > now ) {
+			break;
+		}
+
+		SV_FakeServers_Reply( reply->server, &reply->address );
+		fakeServers.delayedHead = ( fakeServers.delayedHead + 1 ) % MAX_FAKE_SERVER_DELAYED;
+		fakeServers.numDelayed--;
+	}
+}
+
+/*
+* SV_FakeServers_f
+*/
+static void SV_FakeServers_f( void ) {
+	int i, count;
+	netadr_t address;
+
+	if( Cmd_Argc() < 2 ) {
+		if( fakeServers.servers ) {
+			SV_FakeServers_PrintStats();
+		} else {
+			Com_Printf( "Usage: %s <count> [loss percent] [max queries per second] [latency msecs]\n", Cmd_Argv( 0 ) );
+		}
+		return;
+	}
+
+	if( fakeServers.servers ) {
+		SV_FakeServers_PrintStats();
+		SV_FakeServers_Stop();
+	}
+
+	count = min( atoi( Cmd_Argv( 1 ) ), MAX_FAKE_SERVERS );
+	if( count <= 0 ) {
+		return;
+	}
+
+	memset( &fakeServers, 0, sizeof( fakeServers ) );
+	fakeServers.loss = Q_bound( 0, atoi( Cmd_Argv( 2 ) ), 100 );
+	fakeServers.rate = max( atoi( Cmd_Argv( 3 ) ), 0 );
+	fakeServers.latency = max( atoi( Cmd_Argv( 4 ) ), 0 );
+	fakeServers.startTime = fakeServers.secondTime = fakeServers.lastTime = Sys_Milliseconds();
+
+	NET_StringToAddress( "127.0.0.1", &address );
+	NET_SetAddressPort( &address, FAKE_SERVERS_PORT );
+	if( !NET_OpenSocket( &fakeServers.master, SOCKET_UDP, &address, true ) ) {
+		Com_Printf( "Couldn't open the fake master server socket: %s\n", NET_ErrorString() );
+		return;
+	}
+
+	fakeServers.servers = Mem_Alloc( sv_mempool, count * sizeof( socket_t ) );
+	fakeServers.numServers = count;
+	for( i = 0; i < count; i++ ) {
+		NET_SetAddressPort( &address, FAKE_SERVERS_PORT + 1 + i );
+		if( !NET_OpenSocket( &fakeServers.servers[i], SOCKET_UDP, &address, true ) ) {
+			// most likely out of file descriptors
+			Com_Printf( "Couldn't open the socket of fake server %i: %s\n", i + 1, NET_ErrorString() );
+			fakeServers.numServers = i;
+			break;
+		}
+	}
+
+	SV_FakeServers_PrintStats();
+}
+
+/*
+* SV_FakeServers_Init
+*/
+void SV_FakeServers_Init( void ) {
+	memset( &fakeServers, 0, sizeof( fakeServers ) );
+
+	Cmd_AddCommand( "fakeservers", SV_FakeServers_f );
+}
+
+/*
+* SV_FakeServers_Shutdown
+*/
+void SV_FakeServers_Shutdown( void ) {
+	SV_FakeServers_Stop();
+
+	Cmd_RemoveCommand( "fakeservers" );
+}
@@ -547,6 +547,12 @@ void SV_InitGameProgs( void ) {
 
 	import.LocateEntities = SV_LocateEntities;
 
+	import.Jobs_NumWorkers = QJobs_NumWorkers;
+	import.Job_Schedule = QJob_Schedule;
+	import.Job_Wait = QJob_Wait;
+	import.Job_Release = QJob_Release;
+	import.Jobs_ParallelFor = QJobs_ParallelFor;
+
 	import.asGetAngelExport = Com_asGetAngelExport;
 
 	import.GetStatQueryAPI = PF_StatQuery_GetAPI;
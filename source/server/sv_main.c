@@ -92,6 +92,7 @@ cvar_t *sv_autoUpdate;
 cvar_t *sv_lastAutoUpdate;
 
 cvar_t *sv_demodir;
+cvar_t *sv_democompression;
 
 //============================================================================
 
@@ -628,6 +629,9 @@ static void SV_CheckMatchUUID( void ) {
 void SV_Frame( unsigned realmsec, unsigned gamemsec ) {
 	time_before_game = time_after_game = 0;
 
+	// answer server browser queries, even without a game running
+	SV_FakeServers_Frame();
+
 	// if server is not active, do nothing
 	if( !svs.initialized ) {
 		SV_CheckDefaultMap();
@@ -858,6 +862,7 @@ void SV_Init( void ) {
 		Com_Printf( "Invalid demo prefix string: %s\n", sv_demodir->string );
 		Cvar_ForceSet( "sv_demodir", "" );
 	}
+	sv_democompression = Cvar_Get( "sv_democompression", "1", CVAR_ARCHIVE );
 
 	// wsw : jal : cap client's exceding server rules
 	sv_maxrate =            Cvar_Get( "sv_maxrate", "0", CVAR_DEVELOPER );
@@ -919,6 +924,8 @@ void SV_Init( void ) {
 
 	SV_Web_Init();
 
+	SV_FakeServers_Init();
+
 	sv_initialized = true;
 }
 
@@ -933,6 +940,7 @@ void SV_Shutdown( const char *finalmsg ) {
 	}
 	sv_initialized = false;
 
+	SV_FakeServers_Shutdown();
 	SV_Web_Shutdown();
 	ML_Shutdown();
 	SV_MM_Shutdown( true );
@@ -43,12 +43,16 @@ int qvorbis_load_file( const char *filename, int *channels, int *rate, short **d
 	trap_FS_Read( fcontents, flen, filenum );
 	trap_FS_FCloseFile( filenum );
 
-	samples = stb_vorbis_decode_memory( fcontents, flen, channels, rate, data );
+	samples = qvorbis_load_memory( fcontents, flen, channels, rate, data );
 	S_Free( fcontents );
 
 	return samples;
 }
 
+int qvorbis_load_memory( const uint8_t *buffer, int len, int *channels, int *rate, short **data ) {
+	return stb_vorbis_decode_memory( buffer, len, channels, rate, data );
+}
+
 int qvorbis_stream_readbytes( qvorbis_stream_t *ogg_stream, int c ) {
 	int w;
 
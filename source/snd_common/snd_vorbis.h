@@ -40,6 +40,7 @@ typedef struct {
 } qvorbis_stream_t;
 
 int qvorbis_load_file( const char* filename, int* channels, int* rate, short** data );
+int qvorbis_load_memory( const uint8_t *buffer, int len, int *channels, int *rate, short **data );
 
 int qvorbis_stream_readbytes( qvorbis_stream_t *ogg_stream, int c );
 int qvorbis_stream_advance( qvorbis_stream_t *ogg_stream, int c );
@@ -0,0 +1,389 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// snd_chan.c -- voice management
+
+#include "snd_local.h"
+
+// Busy channels are kept in a binary min-heap ordered by priority, so that the
+// least audible channel with the least life left is the first one to be stolen.
+// Free channels are kept on a stack and channels playing on a specific entity
+// channel are hashed by (entnum, entchannel) for override lookups.
+//
+// Only the s_mixchannels most audible channels are mixed, the others become
+// virtual: they keep advancing in time but are not painted.
+
+#define CHANNEL_HASH_SIZE   256
+
+channel_t *s_channels;
+int s_numchannels;
+
+static int *s_channelHeap;              // indices of busy channels
+static int s_channelHeapSize;
+static int *s_freeChannels;             // indices of free channels
+static int s_numFreeChannels;
+static int s_channelHash[CHANNEL_HASH_SIZE]; // index + 1 of the first channel
+static int s_numVirtualChannels;
+
+/*
+* S_ChannelHashKey
+*/
+static inline int S_ChannelHashKey( int entnum, int entchannel ) {
+	return ( ( entnum << 3 ) ^ entchannel ) & ( CHANNEL_HASH_SIZE - 1 );
+}
+
+/*
+* S_ChannelPriority
+*
+* Audibility first, then the end time, which orders by the remaining life.
+*/
+static inline int64_t S_ChannelPriority( const channel_t *ch ) {
+	int audibility = max( ch->leftvol, ch->rightvol );
+	return ( (int64_t)audibility << 32 ) | ch->end;
+}
+
+/*
+* S_HeapSwap
+*/
+static inline void S_HeapSwap( int i, int j ) {
+	int tmp = s_channelHeap[i];
+
+	s_channelHeap[i] = s_channelHeap[j];
+	s_channelHeap[j] = tmp;
+	s_channels[s_channelHeap[i]].heapIndex = i;
+	s_channels[s_channelHeap[j]].heapIndex = j;
+}
+
+/*
+* S_HeapSiftUp
+*/
+static void S_HeapSiftUp( int i ) {
+	while( i > 0 ) {
+		int parent = ( i - 1 ) >> 1;
+		if( s_channels[s_channelHeap[parent]].priority <= s_channels[s_channelHeap[i]].priority ) {
+			break;
+		}
+		S_HeapSwap( i, parent );
+		i = parent;
+	}
+}
+
+/*
+* S_HeapSiftDown
+*/
+static void S_HeapSiftDown( int i ) {
+	while( 1 ) {
+		int smallest = i;
+		int left = i * 2 + 1, right = left + 1;
+
+		if( left < s_channelHeapSize &&
+			s_channels[s_channelHeap[left]].priority < s_channels[s_channelHeap[smallest]].priority ) {
+			smallest = left;
+		}
+		if( right < s_channelHeapSize &&
+			s_channels[s_channelHeap[right]].priority < s_channels[s_channelHeap[smallest]].priority ) {
+			smallest = right;
+		}
+		if( smallest == i ) {
+			break;
+		}
+		S_HeapSwap( i, smallest );
+		i = smallest;
+	}
+}
+
+/*
+* S_HeapRemove
+*/
+static void S_HeapRemove( channel_t *ch ) {
+	int i = ch->heapIndex;
+
+	s_channelHeapSize--;
+	if( i != s_channelHeapSize ) {
+		S_HeapSwap( i, s_channelHeapSize );
+		S_HeapSiftDown( i );
+		S_HeapSiftUp( i );
+	}
+	ch->heapIndex = -1;
+}
+
+/*
+* S_HashRemove
+*/
+static void S_HashRemove( channel_t *ch ) {
+	int *link;
+	int idx = ch - s_channels + 1;
+
+	link = &s_channelHash[S_ChannelHashKey( ch->entnum, ch->entchannel )];
+	while( *link ) {
+		if( *link == idx ) {
+			*link = ch->hashNext;
+			break;
+		}
+		link = &s_channels[*link - 1].hashNext;
+	}
+	ch->hashNext = 0;
+}
+
+/*
+* S_InitChannels
+*/
+void S_InitChannels( void ) {
+	s_numchannels = Q_bound( 16, s_maxchannels->integer, MAX_CHANNELS );
+
+	s_channels = S_Malloc( sizeof( *s_channels ) * s_numchannels );
+	s_channelHeap = S_Malloc( sizeof( *s_channelHeap ) * s_numchannels );
+	s_freeChannels = S_Malloc( sizeof( *s_freeChannels ) * s_numchannels );
+
+	S_ClearChannels();
+}
+
+/*
+* S_ShutdownChannels
+*/
+void S_ShutdownChannels( void ) {
+	if( !s_channels ) {
+		return;
+	}
+
+	S_ClearChannels();
+
+	S_Free( s_channels );
+	S_Free( s_channelHeap );
+	S_Free( s_freeChannels );
+
+	s_channels = NULL;
+	s_channelHeap = s_freeChannels = NULL;
+	s_numchannels = s_channelHeapSize = s_numFreeChannels = 0;
+}
+
+/*
+* S_ClearChannels
+*/
+void S_ClearChannels( void ) {
+	int i;
+
+	if( !s_channels ) {
+		return;
+	}
+
+	for( i = 0; i < s_numchannels; i++ ) {
+		if( s_channels[i].stream ) {
+			S_CloseSfxStream( s_channels[i].stream );
+		}
+	}
+
+	memset( s_channels, 0, sizeof( *s_channels ) * s_numchannels );
+	memset( s_channelHash, 0, sizeof( s_channelHash ) );
+
+	// hand out the lowest indices first
+	for( i = 0; i < s_numchannels; i++ ) {
+		s_channels[i].heapIndex = -1;
+		s_freeChannels[i] = s_numchannels - 1 - i;
+	}
+	s_numFreeChannels = s_numchannels;
+	s_channelHeapSize = 0;
+	s_numVirtualChannels = 0;
+}
+
+/*
+* S_FreeChannel
+*/
+void S_FreeChannel( channel_t *ch ) {
+	if( ch->heapIndex < 0 ) {
+		return;
+	}
+
+	S_HeapRemove( ch );
+	if( ch->entchannel ) {
+		S_HashRemove( ch );
+	}
+	if( ch->stream ) {
+		S_CloseSfxStream( ch->stream );
+	}
+
+	memset( ch, 0, sizeof( *ch ) );
+	ch->heapIndex = -1;
+	s_freeChannels[s_numFreeChannels++] = ch - s_channels;
+}
+
+/*
+* S_UpdateChannel
+*
+* Must be called whenever the volume or the end time of a busy channel changes.
+*/
+void S_UpdateChannel( channel_t *ch ) {
+	int64_t priority;
+
+	if( ch->heapIndex < 0 ) {
+		return;
+	}
+
+	priority = S_ChannelPriority( ch );
+	if( priority == ch->priority ) {
+		return;
+	}
+
+	ch->priority = priority;
+	S_HeapSiftUp( ch->heapIndex );
+	S_HeapSiftDown( ch->heapIndex );
+}
+
+/*
+* S_PickChannel
+*
+* Returns the channel already playing on the entity channel, a free channel or steals
+* the one with the lowest priority. Entity channel 0 never overrides.
+*/
+channel_t *S_PickChannel( int entnum, int entchannel ) {
+	int idx;
+	channel_t *ch = NULL;
+
+	if( entchannel < 0 ) {
+		S_Error( "S_PickChannel: entchannel < 0" );
+	}
+	if( !s_numchannels ) {
+		return NULL;
+	}
+
+	// check for replacement sound
+	if( entchannel != 0 ) {
+		for( idx = s_channelHash[S_ChannelHashKey( entnum, entchannel )]; idx; idx = s_channels[idx - 1].hashNext ) {
+			if( s_channels[idx - 1].entnum == entnum && s_channels[idx - 1].entchannel == entchannel ) {
+				ch = &s_channels[idx - 1];
+				break;
+			}
+		}
+	}
+
+	// or steal the least important one if there are no free channels
+	if( !ch && !s_numFreeChannels ) {
+		ch = &s_channels[s_channelHeap[0]];
+	}
+	if( ch ) {
+		S_FreeChannel( ch );
+	}
+
+	ch = &s_channels[s_freeChannels[--s_numFreeChannels]];
+	ch->entnum = entnum;
+	ch->entchannel = entchannel;
+
+	if( entchannel ) {
+		int key = S_ChannelHashKey( entnum, entchannel );
+		ch->hashNext = s_channelHash[key];
+		s_channelHash[key] = ch - s_channels + 1;
+	}
+
+	ch->priority = S_ChannelPriority( ch );
+	ch->heapIndex = s_channelHeapSize++;
+	s_channelHeap[ch->heapIndex] = ch - s_channels;
+	S_HeapSiftUp( ch->heapIndex );
+
+	return ch;
+}
+
+/*
+* S_UpdateVirtualChannels
+*
+* Leaves only the s_mixchannels most audible channels to the mixer.
+*/
+void S_UpdateVirtualChannels( void ) {
+	int i, k, lo, hi;
+	int numMixed, threshold, numAtThreshold;
+	static int audibility[MAX_CHANNELS];
+
+	numMixed = max( s_mixchannels->integer, 1 );
+
+	s_numVirtualChannels = 0;
+	for( i = 0; i < s_channelHeapSize; i++ ) {
+		s_channels[s_channelHeap[i]].isVirtual = false;
+	}
+
+	if( s_channelHeapSize <= numMixed ) {
+		return;
+	}
+
+	for( i = 0; i < s_channelHeapSize; i++ ) {
+		const channel_t *ch = &s_channels[s_channelHeap[i]];
+		audibility[i] = max( ch->leftvol, ch->rightvol );
+	}
+
+	// quickselect the audibility of the numMixed-th most audible channel
+	k = numMixed - 1;
+	lo = 0;
+	hi = s_channelHeapSize - 1;
+	while( lo < hi ) {
+		int pivot = audibility[( lo + hi ) >> 1];
+		int l = lo, r = hi;
+
+		while( l <= r ) {
+			while( audibility[l] > pivot ) l++;
+			while( audibility[r] < pivot ) r--;
+			if( l <= r ) {
+				int tmp = audibility[l];
+				audibility[l++] = audibility[r];
+				audibility[r--] = tmp;
+			}
+		}
+
+		if( k <= r ) {
+			hi = r;
+		} else if( k >= l ) {
+			lo = l;
+		} else {
+			break;
+		}
+	}
+	threshold = audibility[k];
+
+	// channels as audible as the threshold share what's left of the budget
+	numAtThreshold = numMixed;
+	for( i = 0; i < s_channelHeapSize; i++ ) {
+		const channel_t *ch = &s_channels[s_channelHeap[i]];
+		if( max( ch->leftvol, ch->rightvol ) > threshold ) {
+			numAtThreshold--;
+		}
+	}
+
+	for( i = 0; i < s_channelHeapSize; i++ ) {
+		channel_t *ch = &s_channels[s_channelHeap[i]];
+		int a = max( ch->leftvol, ch->rightvol );
+
+		if( a > threshold ) {
+			continue;
+		}
+		if( a == threshold && numAtThreshold > 0 ) {
+			numAtThreshold--;
+			continue;
+		}
+
+		ch->isVirtual = true;
+		s_numVirtualChannels++;
+	}
+}
+
+/*
+* S_NumBusyChannels
+*/
+int S_NumBusyChannels( int *numVirtual ) {
+	if( numVirtual ) {
+		*numVirtual = s_numVirtualChannels;
+	}
+	return s_channelHeapSize;
+}
@@ -32,8 +32,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define RIGHT   1
 #define UP      2
 
-channel_t s_channels[MAX_CHANNELS];
-
 bool snd_initialized = false;
 
 dma_t dma;
@@ -78,6 +76,8 @@ static void S_ClearRawSounds( void );
 static void S_FreeRawSounds( void );
 static void S_BeginAviDemo( void );
 static void S_StopAviDemo( void );
+static void S_WriteWavHeader( int file );
+static void S_FinishWavFile( int file, unsigned numSamples );
 
 // highfrequency attenuation parameters
 // 340/0.15 (speed of sound/width of head) gives us 2267hz
@@ -105,9 +105,13 @@ static void S_SoundList_f( void ) {
 		}
 		sc = sfx->cache;
 		if( sc ) {
-			size = sc->length * sc->width * sc->channels;
+			size = sfx->cacheSize;
 			total += size;
-			Com_Printf( " (%2db) %6i : %s\n", sc->width * 8, size, sfx->name );
+			if( sfx->stream ) {
+				Com_Printf( " (%2db) stream : %s\n", sc->width * 8, sfx->name );
+			} else {
+				Com_Printf( " (%2db) %6i : %s\n", sc->width * 8, size, sfx->name );
+			}
 		} else {
 			if( sfx->name[0] == '*' ) {
 				Com_Printf( "  placeholder : %s\n", sfx->name );
@@ -117,6 +121,49 @@ static void S_SoundList_f( void ) {
 		}
 	}
 	Com_Printf( "Total resident: %i\n", total );
+	S_SoundCacheStats();
+}
+
+/*
+* S_MixBenchmark_f
+*
+* Times the integer and the float mixers on the same synthetic channels and dumps
+* what each of them rendered to a WAV file for comparison.
+*/
+static void S_MixBenchmark_f( int numChannels, int seconds ) {
+	int mode;
+	int file;
+	int64_t time[2];
+	char filename[MAX_QPATH];
+	static const char *modeNames[2] = { "int", "float" };
+
+	numChannels = Q_bound( 1, numChannels, MAX_CHANNELS );
+	seconds = Q_bound( 1, seconds, 600 );
+
+	if( !dma.buffer || !dma.speed ) {
+		Com_Printf( "No sound device\n" );
+		return;
+	}
+
+	for( mode = 0; mode < 2; mode++ ) {
+		Q_snprintfz( filename, sizeof( filename ), "avi/mixbench_%s.wav", modeNames[mode] );
+		if( trap_FS_FOpenFile( filename, &file, FS_WRITE ) == -1 ) {
+			Com_Printf( "S_MixBenchmark_f: Failed to open %s for writing.\n", filename );
+			file = 0;
+		} else {
+			S_WriteWavHeader( file );
+		}
+
+		time[mode] = S_MixBenchmark( numChannels, seconds, mode != 0, file );
+
+		if( file ) {
+			S_FinishWavFile( file, seconds * dma.speed );
+		}
+
+		Com_Printf( "%5s: %i channels, %i seconds in %" PRIi64 " ms (%.1fx realtime)\n",
+					modeNames[mode], numChannels, seconds, time[mode],
+					time[mode] ? seconds * 1000.0 / time[mode] : 0.0 );
+	}
 }
 
 /*
@@ -142,6 +189,10 @@ static bool S_Init( void *hwnd, int maxEntities, bool verbose ) {
 
 	S_InitScaletable();
 
+	S_InitResampler();
+
+	S_InitChannels();
+
 	// highfrequency attenuation filter
 	s_lpf_cw = S_LowpassCW( HQ_HF_FREQUENCY, dma.speed );
 
@@ -172,6 +223,10 @@ static void S_Shutdown( bool verbose ) {
 
 	SNDOGG_Shutdown( verbose );
 
+	S_ShutdownChannels();
+
+	S_ShutdownResampler();
+
 	num_loopsfx = 0;
 }
 
@@ -187,53 +242,6 @@ static void S_ClearSoundTime( void ) {
 
 //=============================================================================
 
-/*
-* S_PickChannel
-*
-* Picks a channel based on priorities, empty slots, number of channels
-*/
-channel_t *S_PickChannel( int entnum, int entchannel ) {
-	int ch_idx;
-	int first_to_die;
-	int life_left;
-	channel_t *ch;
-
-	if( entchannel < 0 ) {
-		S_Error( "S_PickChannel: entchannel < 0" );
-	}
-
-	// Check for replacement sound, or find the best one to replace
-	first_to_die = -1;
-	life_left = 0x7fffffff;
-	for( ch_idx = 0; ch_idx < MAX_CHANNELS; ch_idx++ ) {
-		if( entchannel != 0 // channel 0 never overrides
-			&& s_channels[ch_idx].entnum == entnum
-			&& s_channels[ch_idx].entchannel == entchannel ) { // always override sound from same entity
-			first_to_die = ch_idx;
-			break;
-		}
-
-		// don't let monster sounds override player sounds
-		// wsw: Medar: Disabled. Don't wanna use cl.playernum much in client code, because of chasecam and stuff
-		//if (channels[ch_idx].entnum == cl.playernum+1 && entnum != cl.playernum+1 && channels[ch_idx].sfx)
-		//	continue;
-
-		if( s_channels[ch_idx].end < life_left + paintedtime ) {
-			life_left = s_channels[ch_idx].end - paintedtime;
-			first_to_die = ch_idx;
-		}
-	}
-
-	if( first_to_die == -1 ) {
-		return NULL;
-	}
-
-	ch = &s_channels[first_to_die];
-	memset( ch, 0, sizeof( *ch ) );
-
-	return ch;
-}
-
 /*
 * S_SetAttenuationModel
 */
@@ -490,6 +498,7 @@ void S_IssuePlaysound( playsound_t *ps ) {
 	}
 	sc = S_LoadSound( ps->sfx );
 	if( !sc ) {
+		S_FreeChannel( ch );
 		S_FreePlaysound( ps );
 		return;
 	}
@@ -497,9 +506,15 @@ void S_IssuePlaysound( playsound_t *ps ) {
 	// spatialize
 	ch->dist_mult = ps->attenuation;
 	ch->master_vol = ps->volume;
-	ch->entnum = ps->entnum;
-	ch->entchannel = ps->entchannel;
 	ch->sfx = ps->sfx;
+	if( ps->sfx->stream ) {
+		ch->stream = S_OpenSfxStream( ps->sfx );
+		if( !ch->stream ) {
+			S_FreeChannel( ch );
+			S_FreePlaysound( ps );
+			return;
+		}
+	}
 	VectorCopy( ps->origin, ch->origin );
 	ch->fixed_origin = ps->fixed_origin;
 
@@ -507,6 +522,7 @@ void S_IssuePlaysound( playsound_t *ps ) {
 
 	ch->pos = 0;
 	ch->end = paintedtime + sc->length;
+	S_UpdateChannel( ch );
 
 	// free the playsound
 	S_FreePlaysound( ps );
@@ -531,7 +547,7 @@ static void S_ClearPlaysounds( void ) {
 		s_playsounds[i].next->prev = &s_playsounds[i];
 	}
 
-	memset( s_channels, 0, sizeof( s_channels ) );
+	S_ClearChannels();
 }
 
 // =======================================================================
@@ -697,8 +713,12 @@ static void S_AddLoopSounds( void ) {
 
 		sfx = loop_sfx[i].sfx;
 		sc = sfx->cache;
-		if( !sc ) {
-			continue;
+		if( !sc || sfx->stream ) {
+			// evicted or streamed, loops need all samples in memory
+			sc = S_LoadSoundResident( sfx );
+			if( !sc ) {
+				continue;
+			}
 		}
 
 		// find the total contribution of all sounds of this type
@@ -758,6 +778,7 @@ static void S_AddLoopSounds( void ) {
 		ch->sfx = sfx;
 		ch->pos = paintedtime % sc->length;
 		ch->end = paintedtime + sc->length - ch->pos;
+		S_UpdateChannel( ch );
 	}
 
 	num_loopsfx = 0;
@@ -1161,24 +1182,27 @@ static void S_Spatialize( void ) {
 
 	// update spatialization for dynamic sounds
 	ch = s_channels;
-	for( i = 0; i < MAX_CHANNELS; i++, ch++ ) {
+	for( i = 0; i < s_numchannels; i++, ch++ ) {
 		if( !ch->sfx ) {
 			continue;
 		}
 		if( ch->autosound ) {
 			// autosounds are regenerated fresh each frame
-			memset( ch, 0, sizeof( *ch ) );
+			S_FreeChannel( ch );
 			continue;
 		}
 		S_SpatializeChannel( ch ); // respatialize channel
 		if( !ch->leftvol && !ch->rightvol ) {
-			memset( ch, 0, sizeof( *ch ) );
+			S_FreeChannel( ch );
 			continue;
 		}
+		S_UpdateChannel( ch );
 	}
 
 	S_AddLoopSounds();
 
+	S_UpdateVirtualChannels();
+
 	S_SpatializeRawSounds();
 }
 
@@ -1199,15 +1223,19 @@ static void S_Update( void ) {
 	// debugging output
 	//
 	if( s_show->integer ) {
+		int busy, numVirtual;
+
 		total = 0;
 		ch = s_channels;
-		for( i = 0; i < MAX_CHANNELS; i++, ch++ )
+		for( i = 0; i < s_numchannels; i++, ch++ )
 			if( ch->sfx && ( ch->leftvol || ch->rightvol ) ) {
-				Com_Printf( "%3i %3i %s\n", ch->leftvol, ch->rightvol, ch->sfx->name );
+				Com_Printf( "%3i %3i %s%s\n", ch->leftvol, ch->rightvol, ch->sfx->name, ch->isVirtual ? " (virtual)" : "" );
 				total++;
 			}
 
-		Com_Printf( "----(%i)---- painted: %i\n", total, paintedtime );
+		busy = S_NumBusyChannels( &numVirtual );
+		Com_Printf( "----(%i)---- painted: %i, channels: %i/%i, virtual: %i\n", total, paintedtime,
+					busy, s_numchannels, numVirtual );
 	}
 
 	// mix some sound
@@ -1216,6 +1244,61 @@ static void S_Update( void ) {
 	S_Update_();
 }
 
+/*
+* S_WriteWavHeader
+*
+* Writes the header of a WAV file in the DMA format. The lengths are left at their
+* maximum until S_FinishWavFile fills them in.
+*/
+static void S_WriteWavHeader( int file ) {
+	int i;
+	short s;
+
+	trap_FS_Write( "RIFF", 4, file );  // "RIFF"
+	i = LittleLong( INT_MAX );
+	trap_FS_Write( &i, 4, file );      // WAVE chunk length
+	trap_FS_Write( "WAVE", 4, file );  // "WAVE"
+
+	trap_FS_Write( "fmt ", 4, file );  // "fmt "
+	i = LittleLong( 16 );
+	trap_FS_Write( &i, 4, file );      // fmt chunk size
+	s = LittleShort( 1 );
+	trap_FS_Write( &s, 2, file );      // audio format. 1 - PCM uncompressed
+	s = LittleShort( dma.channels );
+	trap_FS_Write( &s, 2, file );      // number of channels
+	i = LittleLong( dma.speed );
+	trap_FS_Write( &i, 4, file );      // sample rate
+	i = LittleLong( dma.speed * dma.channels * ( dma.samplebits / 8 ) );
+	trap_FS_Write( &i, 4, file );      // byte rate
+	s = LittleShort( dma.channels * ( dma.samplebits / 8 ) );
+	trap_FS_Write( &s, 2, file );      // block align
+	s = LittleLong( dma.samplebits );
+	trap_FS_Write( &s, 2, file );      // block align
+
+	trap_FS_Write( "data", 4, file );  // "data"
+	i = LittleLong( INT_MAX - 36 );
+	trap_FS_Write( &i, 4, file );      // data chunk length
+}
+
+/*
+* S_FinishWavFile
+*
+* Fills in the missing values in RIFF header and closes the file.
+*/
+static void S_FinishWavFile( int file, unsigned numSamples ) {
+	unsigned size;
+
+	size = ( numSamples * dma.channels * ( dma.samplebits / 8 ) ) + 36;
+	trap_FS_Seek( file, 4, FS_SEEK_SET );
+	trap_FS_Write( &size, 4, file );
+
+	size -= 36;
+	trap_FS_Seek( file, 40, FS_SEEK_SET );
+	trap_FS_Write( &size, 4, file );
+
+	trap_FS_FCloseFile( file );
+}
+
 /*
 * S_BeginAviDemo
 */
@@ -1235,35 +1318,7 @@ static void S_BeginAviDemo( void ) {
 	if( trap_FS_FOpenFile( checkname, &s_aviDumpFile, FS_WRITE ) == -1 ) {
 		Com_Printf( "S_BeginAviDemo: Failed to open %s for writing.\n", checkname );
 	} else {
-		int i;
-		short s;
-
-		// write the WAV header
-
-		trap_FS_Write( "RIFF", 4, s_aviDumpFile );  // "RIFF"
-		i = LittleLong( INT_MAX );
-		trap_FS_Write( &i, 4, s_aviDumpFile );      // WAVE chunk length
-		trap_FS_Write( "WAVE", 4, s_aviDumpFile );  // "WAVE"
-
-		trap_FS_Write( "fmt ", 4, s_aviDumpFile );  // "fmt "
-		i = LittleLong( 16 );
-		trap_FS_Write( &i, 4, s_aviDumpFile );      // fmt chunk size
-		s = LittleShort( 1 );
-		trap_FS_Write( &s, 2, s_aviDumpFile );      // audio format. 1 - PCM uncompressed
-		s = LittleShort( dma.channels );
-		trap_FS_Write( &s, 2, s_aviDumpFile );      // number of channels
-		i = LittleLong( dma.speed );
-		trap_FS_Write( &i, 4, s_aviDumpFile );      // sample rate
-		i = LittleLong( dma.speed * dma.channels * ( dma.samplebits / 8 ) );
-		trap_FS_Write( &i, 4, s_aviDumpFile );      // byte rate
-		s = LittleShort( dma.channels * ( dma.samplebits / 8 ) );
-		trap_FS_Write( &s, 2, s_aviDumpFile );      // block align
-		s = LittleLong( dma.samplebits );
-		trap_FS_Write( &s, 2, s_aviDumpFile );      // block align
-
-		trap_FS_Write( "data", 4, s_aviDumpFile );  // "data"
-		i = LittleLong( INT_MAX - 36 );
-		trap_FS_Write( &i, 4, s_aviDumpFile );      // data chunk length
+		S_WriteWavHeader( s_aviDumpFile );
 
 		s_aviDumpFileName = S_Malloc( checkname_size );
 		memcpy( s_aviDumpFileName, checkname, checkname_size );
@@ -1282,18 +1337,7 @@ static void S_StopAviDemo( void ) {
 			trap_FS_FCloseFile( s_aviDumpFile );
 			trap_FS_RemoveFile( s_aviDumpFileName );
 		} else {
-			unsigned size;
-
-			// fill in the missing values in RIFF header
-			size = ( s_aviNumSamples * dma.channels * ( dma.samplebits / 8 ) ) + 36;
-			trap_FS_Seek( s_aviDumpFile, 4, FS_SEEK_SET );
-			trap_FS_Write( &size, 4, s_aviDumpFile );
-
-			size -= 36;
-			trap_FS_Seek( s_aviDumpFile, 40, FS_SEEK_SET );
-			trap_FS_Write( &size, 4, s_aviDumpFile );
-
-			trap_FS_FCloseFile( s_aviDumpFile );
+			S_FinishWavFile( s_aviDumpFile, s_aviNumSamples );
 		}
 
 		s_aviDumpFile = 0;
@@ -1352,10 +1396,7 @@ static unsigned S_HandleFreeSfxCmd( const sndCmdFreeSfx_t *cmd ) {
 	sfx_t *sfx;
 	//Com_Printf("S_HandleFreeSfxCmd\n");
 	sfx = known_sfx + cmd->sfx;
-	if( sfx->cache ) {
-		S_Free( sfx->cache );
-		sfx->cache = NULL;
-	}
+	S_UnloadSound( sfx );
 	return sizeof( *cmd );
 }
 
@@ -1552,8 +1593,12 @@ static unsigned S_HandlePositionedRawSamplesCmd( const sndPositionedRawSamplesCm
 * S_HandleStuffCmd
 */
 static unsigned S_HandleStuffCmd( const sndStuffCmd_t *cmd ) {
+	int numChannels, seconds;
+
 	if( !Q_stricmp( cmd->text, "soundlist" ) ) {
 		S_SoundList_f();
+	} else if( sscanf( cmd->text, "mixbench %i %i", &numChannels, &seconds ) == 2 ) {
+		S_MixBenchmark_f( numChannels, seconds );
 	}
 	return sizeof( *cmd );
 }
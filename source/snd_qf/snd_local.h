@@ -46,11 +46,24 @@ typedef struct {
 	uint8_t data[1];          // variable sized
 } sfxcache_t;
 
+typedef struct {
+	int rate;
+	short width;
+	short channels;
+	int samples;
+	int dataofs;            // chunk starts this many bytes from file start
+} wavinfo_t;
+
 typedef struct sfx_s {
 	char name[MAX_QPATH];
 	int registration_sequence;
 	bool isUrl;
 	sfxcache_t *cache;
+	size_t cacheSize;           // bytes held by cache
+	struct sfx_s *lruPrev;      // loaded sounds, most recently used first
+	struct sfx_s *lruNext;
+	bool stream;                // cache only holds the format, samples are decoded on demand
+	wavinfo_t streamInfo;       // source format of a streamed sound
 } sfx_t;
 
 typedef struct {
@@ -114,16 +127,13 @@ typedef struct {
 	unsigned int ldelay;    // invidual ear delay offset for both channels
 	unsigned int rdelay;
 	rawsound_t *rawsamples; // got no static sfx, read samples directly
+	struct sfxstream_s *stream; // decoder state of a streamed sfx
+	bool isVirtual;         // tracked but not mixed
+	int64_t priority;       // key in the voice heap
+	int heapIndex;          // position in the voice heap, -1 if free
+	int hashNext;           // index + 1 of the next channel with the same (entnum, entchannel) hash
 } channel_t;
 
-typedef struct {
-	int rate;
-	short width;
-	short channels;
-	int samples;
-	int dataofs;            // chunk starts this many bytes from file start
-} wavinfo_t;
-
 typedef struct bgTrack_s {
 	char *filename;
 	bool ignore;
@@ -195,7 +205,7 @@ void    SNDDMA_Submit( void );
 void    SNDOGG_Init( bool verbose );
 void    SNDOGG_Shutdown( bool verbose );
 bool SNDOGG_OpenTrack( bgTrack_t *track );
-sfxcache_t *SNDOGG_Load( sfx_t *s );
+sfxcache_t *SNDOGG_Load( sfx_t *s, bool allowStream );
 
 //====================================================================
 
@@ -207,8 +217,9 @@ sfxcache_t *SNDOGG_Load( sfx_t *s );
 extern sfx_t known_sfx[MAX_SFX];
 extern int num_sfx;
 
-#define MAX_CHANNELS        128
-extern channel_t s_channels[MAX_CHANNELS];
+#define MAX_CHANNELS        1024    // upper limit of s_maxchannels
+extern channel_t *s_channels;
+extern int s_numchannels;
 
 extern volatile unsigned int paintedtime;
 extern dma_t dma;
@@ -218,6 +229,11 @@ extern bool s_active;
 
 #define MAX_RAW_SAMPLES 16384
 
+#define PAINTBUFFER_SIZE    2048
+
+// samples kept before the read position of a streamed sfx for the ear delays
+#define SFX_STREAM_LOOKBACK 256
+
 #define MAX_RAW_SOUNDS 16
 extern rawsound_t *raw_sounds[MAX_RAW_SOUNDS];
 
@@ -232,6 +248,13 @@ extern cvar_t *s_mixahead;
 extern cvar_t *s_testsound;
 extern cvar_t *s_swapstereo;
 extern cvar_t *s_pseudoAcoustics;
+extern cvar_t *s_floatmix;
+extern cvar_t *s_maxchannels;
+extern cvar_t *s_mixchannels;
+extern cvar_t *s_sfxcachesize;
+extern cvar_t *s_sfxstreamlength;
+extern cvar_t *s_resamplequality;
+extern cvar_t *s_resamplecache;
 extern cvar_t *s_separationDelay;
 extern cvar_t *s_globalfocus;
 
@@ -251,11 +274,39 @@ unsigned int ResampleSfx( unsigned int numsamples, unsigned int speed, unsigned
 
 void S_InitScaletable( void );
 
+void S_InitResampler( void );
+void S_ShutdownResampler( void );
+int S_ResampleQuality( void );
+int S_ResampleHalfTaps( void );
+unsigned int S_ResampleRange( unsigned int inrate, unsigned int outrate, unsigned short channels, unsigned short width,
+							  const uint8_t *in, unsigned int infirst, unsigned int incount,
+							  uint8_t *out, unsigned int outfirst, unsigned int outcount );
+
+void S_InitChannels( void );
+void S_ShutdownChannels( void );
+void S_ClearChannels( void );
+channel_t *S_PickChannel( int entnum, int entchannel );
+void S_FreeChannel( channel_t *ch );
+void S_UpdateChannel( channel_t *ch );
+void S_UpdateVirtualChannels( void );
+int S_NumBusyChannels( int *numVirtual );
+
+void S_InitSoundCache( void );
+void S_ShutdownSoundCache( void );
 sfxcache_t *S_LoadSound( sfx_t *s );
+sfxcache_t *S_PrecacheSound( sfx_t *s );
+sfxcache_t *S_LoadSoundResident( sfx_t *s );
+void S_UnloadSound( sfx_t *s );
+void S_SoundCacheStats( void );
+
+struct sfxstream_s *S_OpenSfxStream( sfx_t *s );
+void S_CloseSfxStream( struct sfxstream_s *stream );
+sfxcache_t *S_ReadSfxStream( struct sfxstream_s *stream, unsigned int pos, unsigned int count, unsigned int *start );
 
 void S_IssuePlaysound( playsound_t *ps );
 
 int S_PaintChannels( unsigned int endtime, int dumpfile, float gain );
+int64_t S_MixBenchmark( int numChannels, int seconds, bool floatmix, int file );
 
 //====================================================================
 
@@ -45,6 +45,13 @@ cvar_t *s_show;
 cvar_t *s_mixahead;
 cvar_t *s_swapstereo;
 cvar_t *s_pseudoAcoustics;
+cvar_t *s_floatmix;
+cvar_t *s_maxchannels;
+cvar_t *s_mixchannels;
+cvar_t *s_sfxcachesize;
+cvar_t *s_sfxstreamlength;
+cvar_t *s_resamplequality;
+cvar_t *s_resamplecache;
 cvar_t *s_separationDelay;
 cvar_t *s_globalfocus;
 
@@ -82,6 +89,23 @@ static void SF_SoundList_f( void ) {
 	S_IssueStuffCmd( s_cmdPipe, "soundlist" );
 }
 
+/*
+* SF_MixBenchmark_f
+*/
+static void SF_MixBenchmark_f( void ) {
+	char text[80];
+
+	if( trap_Cmd_Argc() < 2 ) {
+		Com_Printf( "usage: mixbench <channels> [seconds]\n" );
+		return;
+	}
+
+	// run on the mixer thread, which owns the paint buffers
+	Q_snprintfz( text, sizeof( text ), "mixbench %i %i", atoi( trap_Cmd_Argv( 1 ) ),
+				 trap_Cmd_Argc() > 2 ? atoi( trap_Cmd_Argv( 2 ) ) : 10 );
+	S_IssueStuffCmd( s_cmdPipe, text );
+}
+
 /*
 * S_Music
 */
@@ -199,7 +223,7 @@ sfx_t *SF_RegisterSound( const char *name ) {
 		if( !s_registering || sfxnum & 1 ) {
 			S_IssueLoadSfxCmd( s_cmdPipe, sfxnum );
 		} else {
-			S_LoadSound( sfx );
+			S_PrecacheSound( sfx );
 		}
 	}
 	return sfx;
@@ -220,7 +244,7 @@ void SF_FreeSounds( void ) {
 		if( !sfx->name[0] ) {
 			continue;
 		}
-		S_Free( sfx->cache );
+		S_UnloadSound( sfx );
 		memset( sfx, 0, sizeof( *sfx ) );
 	}
 }
@@ -244,7 +268,7 @@ void SF_EndRegistration( void ) {
 		}
 		if( sfx->registration_sequence != s_registration_sequence ) {
 			// we don't need this sound
-			S_Free( sfx->cache );
+			S_UnloadSound( sfx );
 			memset( sfx, 0, sizeof( *sfx ) );
 		}
 	}
@@ -266,6 +290,13 @@ bool SF_Init( void *hwnd, int maxEntities, bool verbose ) {
 	s_testsound = trap_Cvar_Get( "s_testsound", "0", 0 );
 	s_swapstereo = trap_Cvar_Get( "s_swapstereo", "0", CVAR_ARCHIVE );
 	s_pseudoAcoustics = trap_Cvar_Get( "s_pseudoAcoustics", "0", CVAR_ARCHIVE );
+	s_floatmix = trap_Cvar_Get( "s_floatmix", "1", CVAR_ARCHIVE );
+	s_maxchannels = trap_Cvar_Get( "s_maxchannels", "256", CVAR_ARCHIVE | CVAR_LATCH_SOUND );
+	s_mixchannels = trap_Cvar_Get( "s_mixchannels", "128", CVAR_ARCHIVE );
+	s_sfxcachesize = trap_Cvar_Get( "s_sfxcachesize", "64", CVAR_ARCHIVE );
+	s_sfxstreamlength = trap_Cvar_Get( "s_sfxstreamlength", "5", CVAR_ARCHIVE );
+	s_resamplequality = trap_Cvar_Get( "s_resamplequality", "1", CVAR_ARCHIVE | CVAR_LATCH_SOUND );
+	s_resamplecache = trap_Cvar_Get( "s_resamplecache", "1", CVAR_ARCHIVE );
 	s_separationDelay = trap_Cvar_Get( "s_separationDelay", "1.0", CVAR_ARCHIVE );
 	s_globalfocus = trap_Cvar_Get( "s_globalfocus", "0", CVAR_ARCHIVE );
 
@@ -280,6 +311,7 @@ bool SF_Init( void *hwnd, int maxEntities, bool verbose ) {
 	trap_Cmd_AddCommand( "pausemusic", SF_PauseBackgroundTrack );
 	trap_Cmd_AddCommand( "soundlist", SF_SoundList_f );
 	trap_Cmd_AddCommand( "soundinfo", SF_SoundInfo_f );
+	trap_Cmd_AddCommand( "mixbench", SF_MixBenchmark_f );
 
 	num_sfx = 0;
 
@@ -288,6 +320,8 @@ bool SF_Init( void *hwnd, int maxEntities, bool verbose ) {
 	s_registration_sequence = 1;
 	s_registering = false;
 
+	S_InitSoundCache();
+
 	s_cmdPipe = S_CreateSoundCmdPipe();
 	if( !s_cmdPipe ) {
 		return false;
@@ -338,6 +372,8 @@ void SF_Shutdown( bool verbose ) {
 
 	S_DestroySoundCmdPipe( &s_cmdPipe );
 
+	S_ShutdownSoundCache();
+
 #ifdef ENABLE_PLAY
 	trap_Cmd_RemoveCommand( "play" );
 #endif
@@ -349,6 +385,7 @@ void SF_Shutdown( bool verbose ) {
 	trap_Cmd_RemoveCommand( "pausemusic" );
 	trap_Cmd_RemoveCommand( "soundlist" );
 	trap_Cmd_RemoveCommand( "soundinfo" );
+	trap_Cmd_RemoveCommand( "mixbench" );
 
 	S_MemFreePool( &soundpool );
 
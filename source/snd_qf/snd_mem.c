@@ -22,155 +22,172 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "snd_local.h"
 #include "snd_vorbis.h"
 
+#define SFX_CACHE_DIR           "cache/sounds"
+#define SFX_CACHE_VERSION       1
+
+// resampled sounds written to the cache directory
+typedef struct {
+	char identifier[4];             // "QFSC"
+	int endianness;                 // 0x04030201 in the byte order of the samples
+	int version;
+	unsigned checksum;              // of the source file
+	int speed;
+	int quality;
+	int length;
+	int channels;
+	int width;
+} sfxcachefile_t;
+
+typedef struct sfxstream_s {
+	sfx_t *sfx;
+	int file;
+	qvorbis_stream_t *vorbis;       // NULL for .wav files
+	wavinfo_t info;                 // source format
+	unsigned int length;            // resampled length
+	unsigned int srcpos;            // source samples decoded so far
+	unsigned int srcstart;          // source position of the first sample in srcbuf
+	unsigned int srcmaxlength;      // capacity of srcbuf in samples
+	uint8_t *srcbuf;                // a second of source samples and the filter margins
+	unsigned int outpos;            // next sample position to resample
+	unsigned int start;             // sample position of the first sample in the window
+	unsigned int maxlength;         // capacity of the window in samples
+	sfxcache_t *window;             // resampled samples around the read position
+} sfxstream_t;
+
+static struct {
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int evictions;
+	unsigned int streams;
+} s_sfxCacheStats;
+
+static bool S_SetupSfxStream( sfx_t *s, const wavinfo_t *info );
+
 /*
 * ResampleSfx
 */
 unsigned int ResampleSfx( unsigned int numsamples, unsigned int speed, unsigned short channels, unsigned short width, const uint8_t *data, uint8_t *outdata, char *name ) {
-	size_t srclength, outcount;
-
-	outcount = (size_t) ( (double)numsamples * (double)dma.speed / (double)speed );
-	srclength = numsamples * channels;
-
-	// Trivial case (direct transfer)
-	if( speed == dma.speed ) {
-		if( width == 1 ) {
-			size_t i;
-
-			for( i = 0; i < srclength; i++ )
-				( (signed char*)outdata )[i] = data[i] - 128;
-		} else {   // if (width == 2)
-			memcpy( outdata, data, srclength * width );
-		}
-
-		return numsamples;
-	}
-
-	// General case (linear interpolation with a fixed-point fractional
-	// step, 18-bit integer part and 14-bit fractional part)
-	// Can handle up to 2^18 (262144) samples per second (> 96KHz stereo)
-#   define FRACTIONAL_BITS 14
-#   define FRACTIONAL_MASK ( ( 1 << FRACTIONAL_BITS ) - 1 )
-#   define INTEGER_BITS ( sizeof( samplefrac ) * 8 - FRACTIONAL_BITS )
-	else {
-		const unsigned int fracstep = (unsigned int)( (double)speed / dma.speed * ( 1 << FRACTIONAL_BITS ) );
-		size_t remain_in = srclength, total_out = 0;
-		unsigned int samplefrac;
-		const unsigned char *in_ptr = data;
-		unsigned char *out_ptr = outdata;
-
-		// Check that we can handle one second of that sound
-		if( speed * channels > ( 1 << INTEGER_BITS ) ) {
-			Com_Printf( "ResampleSfx: sound quality too high for resampling (%uHz, %u channel(s))\n",
-						speed, channels );
-			return 0;
-		}
+	unsigned int outcount;
 
-		// We work 1 sec at a time to make sure we don't accumulate any
-		// significant error when adding "fracstep" over several seconds, and
-		// also to be able to handle very long sounds.
-		while( total_out < outcount ) {
-			size_t tmpcount, interpolation_limit, i, j;
-			unsigned int srcsample;
-
-			samplefrac = 0;
-
-			// If more than 1 sec of sound remains to be converted
-			if( outcount > dma.speed + total_out ) {
-				tmpcount = dma.speed;
-				interpolation_limit = tmpcount;  // all samples can be interpolated
-			} else {
-				tmpcount = outcount - total_out;
-				interpolation_limit = (int)ceil( (double)( ( ( remain_in / channels ) - 1 ) << FRACTIONAL_BITS ) / fracstep );
-				if( interpolation_limit > tmpcount ) {
-					interpolation_limit = tmpcount;
-				}
-			}
+	outcount = (unsigned int)( (uint64_t)numsamples * dma.speed / speed );
 
-			// 16 bit samples
-			if( width == 2 ) {
-				const short* in_ptr_short;
-
-				// Interpolated part
-				for( i = 0; i < interpolation_limit; i++ ) {
-					srcsample = ( samplefrac >> FRACTIONAL_BITS ) * channels;
-					in_ptr_short = &( (const short*)in_ptr )[srcsample];
-
-					for( j = 0; j < channels; j++ ) {
-						int a, b;
-
-						a = *in_ptr_short;
-						b = *( in_ptr_short + channels );
-						*( (short*)out_ptr ) = ( ( ( b - a ) * ( samplefrac & FRACTIONAL_MASK ) ) >> FRACTIONAL_BITS ) + a;
-
-						in_ptr_short++;
-						out_ptr += sizeof( short );
-					}
-
-					samplefrac += fracstep;
-				}
+	return S_ResampleRange( speed, dma.speed, channels, width, data, 0, numsamples, outdata, 0, outcount );
+}
 
-				// Non-interpolated part
-				for( /* nothing */; i < tmpcount; i++ ) {
-					srcsample = ( samplefrac >> FRACTIONAL_BITS ) * channels;
-					in_ptr_short = &( (const short*)in_ptr )[srcsample];
+/*
+* S_SfxChecksum
+*/
+static unsigned S_SfxChecksum( const uint8_t *data, size_t size ) {
+	size_t i;
+	unsigned checksum = 2166136261u;
 
-					for( j = 0; j < channels; j++ ) {
-						*( (short*)out_ptr ) = *in_ptr_short;
+	// FNV-1a
+	for( i = 0; i < size; i++ ) {
+		checksum = ( checksum ^ data[i] ) * 16777619u;
+	}
+	return checksum;
+}
 
-						in_ptr_short++;
-						out_ptr += sizeof( short );
-					}
+/*
+* S_ResampledSfxFileName
+*/
+static void S_ResampledSfxFileName( const sfx_t *s, char *path, size_t size ) {
+	Q_snprintfz( path, size, "%s/%s_%u_%i.pcm", SFX_CACHE_DIR, s->name, dma.speed, S_ResampleQuality() );
+}
 
-					samplefrac += fracstep;
-				}
-			}
-			// 8 bit samples
-			else { // if (width == 1)
-				const unsigned char* in_ptr_byte;
+/*
+* S_LoadResampledSfx
+*
+* Loads the samples of the sound from the cache directory, if they were resampled from
+* the source file with the same checksum for the current rate and quality.
+*/
+static sfxcache_t *S_LoadResampledSfx( sfx_t *s, unsigned checksum ) {
+	int file, length;
+	size_t size;
+	char path[MAX_QPATH * 2];
+	sfxcachefile_t header;
+	sfxcache_t *sc;
 
-				// Convert up to 1 sec of sound
-				for( i = 0; i < interpolation_limit; i++ ) {
-					srcsample = ( samplefrac >> FRACTIONAL_BITS ) * channels;
-					in_ptr_byte = &( (const unsigned char*)in_ptr )[srcsample];
+	if( !s_resamplecache->integer ) {
+		return NULL;
+	}
 
-					for( j = 0; j < channels; j++ ) {
-						int a, b;
+	S_ResampledSfxFileName( s, path, sizeof( path ) );
+	length = trap_FS_FOpenFile( path, &file, FS_READ | FS_CACHE );
+	if( !file ) {
+		return NULL;
+	}
 
-						a = *in_ptr_byte - 128;
-						b = *( in_ptr_byte + channels ) - 128;
-						*( (signed char*)out_ptr ) = ( ( ( b - a ) * ( samplefrac & FRACTIONAL_MASK ) ) >> FRACTIONAL_BITS ) + a;
+	if( length < (int)sizeof( header ) || trap_FS_Read( &header, sizeof( header ), file ) != sizeof( header ) ) {
+		goto error;
+	}
+	if( memcmp( header.identifier, "QFSC", 4 ) || header.endianness != 0x04030201 ||
+		header.version != SFX_CACHE_VERSION || header.checksum != checksum ||
+		header.speed != (int)dma.speed || header.quality != S_ResampleQuality() ) {
+		goto error;
+	}
+	if( ( header.channels != 1 && header.channels != 2 ) || ( header.width != 1 && header.width != 2 ) ||
+		header.length <= 0 ) {
+		goto error;
+	}
 
-						in_ptr_byte++;
-						out_ptr += sizeof( signed char );
-					}
+	size = (size_t)header.length * header.channels * header.width;
+	if( size != length - sizeof( header ) ) {
+		goto error;
+	}
 
-					samplefrac += fracstep;
-				}
+	sc = S_Malloc( sizeof( sfxcache_t ) + size );
+	if( trap_FS_Read( sc->data, size, file ) != (int)size ) {
+		S_Free( sc );
+		goto error;
+	}
+	trap_FS_FCloseFile( file );
 
-				// Non-interpolated part
-				for( /* nothing */; i < tmpcount; i++ ) {
-					srcsample = ( samplefrac >> FRACTIONAL_BITS ) * channels;
-					in_ptr_byte = &( (const unsigned char*)in_ptr )[srcsample];
+	sc->length = header.length;
+	sc->speed = dma.speed;
+	sc->channels = header.channels;
+	sc->width = header.width;
+	s->cacheSize = sizeof( sfxcache_t ) + size;
+	s->cache = sc;
+	return sc;
 
-					for( j = 0; j < channels; j++ ) {
-						*( (signed char*)out_ptr ) = *in_ptr_byte - 128;
+error:
+	trap_FS_FCloseFile( file );
+	return NULL;
+}
 
-						in_ptr_byte++;
-						out_ptr += sizeof( signed char );
-					}
+/*
+* S_WriteResampledSfx
+*/
+static void S_WriteResampledSfx( const sfx_t *s, unsigned checksum ) {
+	int file;
+	char path[MAX_QPATH * 2];
+	sfxcachefile_t header;
+	const sfxcache_t *sc = s->cache;
 
-					samplefrac += fracstep;
-				}
-			}
+	if( !s_resamplecache->integer || !sc ) {
+		return;
+	}
 
-			// Update the counters and the buffer position
-			remain_in -= speed * channels;
-			in_ptr += speed * channels * width;
-			total_out += tmpcount;
-		}
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.identifier, "QFSC", 4 );
+	header.endianness = 0x04030201;
+	header.version = SFX_CACHE_VERSION;
+	header.checksum = checksum;
+	header.speed = dma.speed;
+	header.quality = S_ResampleQuality();
+	header.length = sc->length;
+	header.channels = sc->channels;
+	header.width = sc->width;
+
+	S_ResampledSfxFileName( s, path, sizeof( path ) );
+	if( trap_FS_FOpenFile( path, &file, FS_WRITE | FS_CACHE ) == -1 ) {
+		return;
 	}
 
-	return outcount;
+	trap_FS_Write( &header, sizeof( header ), file );
+	trap_FS_Write( sc->data, (size_t)sc->length * sc->channels * sc->width, file );
+	trap_FS_FCloseFile( file );
 }
 
 
@@ -179,13 +196,14 @@ unsigned int ResampleSfx( unsigned int numsamples, unsigned int speed, unsigned
 /*
 * S_LoadSound_Wav
 */
-sfxcache_t *S_LoadSound_Wav( sfx_t *s ) {
+static sfxcache_t *S_LoadSound_Wav( sfx_t *s, bool allowStream ) {
 	char namebuffer[MAX_QPATH];
 	uint8_t *data;
 	wavinfo_t info;
 	int len, file;
 	sfxcache_t *sc;
 	int size;
+	unsigned checksum = 0;
 
 	assert( s && s->name[0] );
 	assert( !s->cache );
@@ -210,6 +228,20 @@ sfxcache_t *S_LoadSound_Wav( sfx_t *s ) {
 		return NULL;
 	}
 
+	if( allowStream && S_SetupSfxStream( s, &info ) ) {
+		S_Free( data );
+		return s->cache;
+	}
+
+	if( info.rate != (int)dma.speed ) {
+		checksum = S_SfxChecksum( data, size );
+		sc = S_LoadResampledSfx( s, checksum );
+		if( sc ) {
+			S_Free( data );
+			return sc;
+		}
+	}
+
 	// calculate resampled length
 	len = (int) ( (double) info.samples * (double) dma.speed / (double) info.rate );
 	len = len * info.width * info.channels;
@@ -219,6 +251,7 @@ sfxcache_t *S_LoadSound_Wav( sfx_t *s ) {
 		S_Free( data );
 		return NULL;
 	}
+	s->cacheSize = len + sizeof( sfxcache_t );
 
 	if( sc->width == 2 ) {
 		int i;
@@ -237,16 +270,136 @@ sfxcache_t *S_LoadSound_Wav( sfx_t *s ) {
 	sc->speed = dma.speed;
 	s->cache = sc;
 
+	if( info.rate != (int)dma.speed ) {
+		S_WriteResampledSfx( s, checksum );
+	}
+
 	S_Free( data );
 
 	return sc;
 }
 
 /*
-* S_LoadSound
+===============================================================================
+
+Sound cache
+
+===============================================================================
 */
-sfxcache_t *S_LoadSound( sfx_t *s ) {
+
+// loaded sounds are kept in a list ordered by use, the main thread loads
+// sounds during registration while the mixer thread keeps playing
+static struct qmutex_s *s_sfxCacheLock;
+static sfx_t *s_sfxLRUHead, *s_sfxLRUTail;
+static size_t s_sfxCacheTotal;
+
+/*
+* S_InitSoundCache
+*/
+void S_InitSoundCache( void ) {
+	s_sfxCacheLock = trap_Mutex_Create();
+	s_sfxLRUHead = s_sfxLRUTail = NULL;
+	s_sfxCacheTotal = 0;
+}
+
+/*
+* S_ShutdownSoundCache
+*/
+void S_ShutdownSoundCache( void ) {
+	if( s_sfxCacheLock ) {
+		trap_Mutex_Destroy( &s_sfxCacheLock );
+	}
+	s_sfxLRUHead = s_sfxLRUTail = NULL;
+	s_sfxCacheTotal = 0;
+}
+
+/*
+* S_LinkSfx
+*
+* Puts the sound at the head of the LRU list. The caller must hold s_sfxCacheLock.
+*/
+static void S_LinkSfx( sfx_t *s ) {
+	s->lruPrev = NULL;
+	s->lruNext = s_sfxLRUHead;
+	if( s_sfxLRUHead ) {
+		s_sfxLRUHead->lruPrev = s;
+	} else {
+		s_sfxLRUTail = s;
+	}
+	s_sfxLRUHead = s;
+}
+
+/*
+* S_UnlinkSfx
+*
+* The caller must hold s_sfxCacheLock.
+*/
+static void S_UnlinkSfx( sfx_t *s ) {
+	if( s->lruPrev ) {
+		s->lruPrev->lruNext = s->lruNext;
+	} else if( s_sfxLRUHead == s ) {
+		s_sfxLRUHead = s->lruNext;
+	} else {
+		// not linked
+		return;
+	}
+	if( s->lruNext ) {
+		s->lruNext->lruPrev = s->lruPrev;
+	} else {
+		s_sfxLRUTail = s->lruPrev;
+	}
+	s->lruPrev = s->lruNext = NULL;
+}
+
+/*
+* S_TrimSoundCache
+*
+* Evicts the least recently used sounds until the cache fits into s_sfxcachesize.
+* Sounds are reloaded on demand. Must only run on the mixer thread, as the caches
+* of other sounds may be in use by the caller.
+*/
+static void S_TrimSoundCache( size_t budget ) {
+	int i;
+	sfx_t *sfx;
+	channel_t *ch;
+	static bool busy[MAX_SFX];
+
+	// never pull the samples from under a playing channel
+	memset( busy, 0, sizeof( busy ) );
+	for( i = 0, ch = s_channels; i < s_numchannels; i++, ch++ ) {
+		if( ch->sfx ) {
+			busy[ch->sfx - known_sfx] = true;
+		}
+	}
+
+	while( true ) {
+		trap_Mutex_Lock( s_sfxCacheLock );
+		sfx = NULL;
+		if( s_sfxCacheTotal > budget ) {
+			sfx = s_sfxLRUTail;
+			while( sfx && busy[sfx - known_sfx] ) {
+				sfx = sfx->lruPrev;
+			}
+		}
+		trap_Mutex_Unlock( s_sfxCacheLock );
+
+		if( !sfx ) {
+			break;
+		}
+
+		S_UnloadSound( sfx );
+		s_sfxCacheStats.evictions++;
+	}
+}
+
+/*
+* S_LoadSfx
+*/
+static sfxcache_t *S_LoadSfx( sfx_t *s, bool allowStream, bool trim ) {
 	const char *extension;
+	sfxcache_t *sc;
+	size_t budget;
+	bool overBudget;
 
 	if( !s->name[0] ) {
 		return NULL;
@@ -257,20 +410,352 @@ sfxcache_t *S_LoadSound( sfx_t *s ) {
 
 	// see if still in memory
 	if( s->cache ) {
+		s_sfxCacheStats.hits++;
+
+		trap_Mutex_Lock( s_sfxCacheLock );
+		if( s_sfxLRUHead != s ) {
+			S_UnlinkSfx( s );
+			S_LinkSfx( s );
+		}
+		trap_Mutex_Unlock( s_sfxCacheLock );
+
 		return s->cache;
 	}
 
+	s_sfxCacheStats.misses++;
+
+	sc = NULL;
 	extension = COM_FileExtension( s->name );
 	if( extension ) {
 		if( !Q_stricmp( extension, ".wav" ) ) {
-			return S_LoadSound_Wav( s );
+			sc = S_LoadSound_Wav( s, allowStream );
+		} else if( !Q_stricmp( extension, ".ogg" ) ) {
+			sc = SNDOGG_Load( s, allowStream );
+		}
+	}
+
+	if( !s->cache ) {
+		return sc;
+	}
+
+	budget = s_sfxcachesize->value > 0 ? (size_t)( s_sfxcachesize->value * 1024 * 1024 ) : 0;
+
+	trap_Mutex_Lock( s_sfxCacheLock );
+	S_LinkSfx( s );
+	s_sfxCacheTotal += s->cacheSize;
+	overBudget = budget && s_sfxCacheTotal > budget;
+	trap_Mutex_Unlock( s_sfxCacheLock );
+
+	if( overBudget && trim ) {
+		S_TrimSoundCache( budget );
+	}
+
+	return sc;
+}
+
+/*
+* S_LoadSound
+*
+* Long sounds may come back with only their format loaded, see S_OpenSfxStream.
+* Mixer thread only, evicts other sounds if the load goes over budget.
+*/
+sfxcache_t *S_LoadSound( sfx_t *s ) {
+	return S_LoadSfx( s, true, true );
+}
+
+/*
+* S_PrecacheSound
+*
+* Like S_LoadSound but never trims the cache, for the main thread during registration.
+*/
+sfxcache_t *S_PrecacheSound( sfx_t *s ) {
+	return S_LoadSfx( s, true, false );
+}
+
+/*
+* S_LoadSoundResident
+*
+* Like S_LoadSound but never streams, for looping sounds which jump around in the data.
+* Only called by the update loop.
+*/
+sfxcache_t *S_LoadSoundResident( sfx_t *s ) {
+	if( s->stream ) {
+		// streams of this sound keep their own copy of the format
+		S_UnloadSound( s );
+	}
+	return S_LoadSfx( s, false, true );
+}
+
+/*
+* S_UnloadSound
+*/
+void S_UnloadSound( sfx_t *s ) {
+	if( s->cache ) {
+		trap_Mutex_Lock( s_sfxCacheLock );
+		S_UnlinkSfx( s );
+		s_sfxCacheTotal -= s->cacheSize;
+		trap_Mutex_Unlock( s_sfxCacheLock );
+
+		S_Free( s->cache );
+	}
+	s->cache = NULL;
+	s->cacheSize = 0;
+	s->stream = false;
+}
+
+/*
+* S_SoundCacheStats
+*/
+void S_SoundCacheStats( void ) {
+	unsigned int lookups = s_sfxCacheStats.hits + s_sfxCacheStats.misses;
+
+	Com_Printf( "Cache budget: %s\n", s_sfxcachesize->value > 0 ?
+				va( "%.1f MB", s_sfxcachesize->value ) : "unlimited" );
+	Com_Printf( "Cache hits: %u, misses: %u (%.1f%% hit rate), evictions: %u, streams: %u\n",
+				s_sfxCacheStats.hits, s_sfxCacheStats.misses,
+				lookups ? 100.0 * s_sfxCacheStats.hits / lookups : 0.0,
+				s_sfxCacheStats.evictions, s_sfxCacheStats.streams );
+}
+
+/*
+===============================================================================
+
+SFX streaming
+
+===============================================================================
+*/
+
+/*
+* S_SetupSfxStream
+*
+* Long sounds only keep their format in the cache, every channel playing them
+* decodes its own window of samples around the read position.
+*/
+static bool S_SetupSfxStream( sfx_t *s, const wavinfo_t *info ) {
+	sfxcache_t *sc;
+
+	if( s_sfxstreamlength->value <= 0 ) {
+		return false;
+	}
+	if( info->samples < s_sfxstreamlength->value * info->rate ) {
+		return false;
+	}
+	if( info->width != 1 && info->width != 2 ) {
+		return false;
+	}
+
+	sc = S_Malloc( sizeof( sfxcache_t ) );
+	sc->length = (unsigned int)( (uint64_t)info->samples * dma.speed / info->rate );
+	sc->speed = dma.speed;
+	sc->channels = info->channels;
+	sc->width = info->width;
+
+	s->stream = true;
+	s->streamInfo = *info;
+	s->cacheSize = sizeof( sfxcache_t );
+	s->cache = sc;
+
+	return true;
+}
+
+/*
+* S_OpenSfxStream
+*/
+sfxstream_t *S_OpenSfxStream( sfx_t *s ) {
+	int file;
+	sfxstream_t *stream;
+	const wavinfo_t *info = &s->streamInfo;
+
+	if( !s->stream ) {
+		return NULL;
+	}
+
+	trap_FS_FOpenFile( s->name, &file, FS_READ | FS_NOSIZE );
+	if( !file ) {
+		return NULL;
+	}
+
+	stream = S_Malloc( sizeof( *stream ) );
+	stream->sfx = s;
+	stream->file = file;
+	stream->info = *info;
+	stream->length = s->cache->length;
+
+	if( !Q_stricmp( COM_FileExtension( s->name ), ".ogg" ) ) {
+		stream->vorbis = S_Malloc( sizeof( qvorbis_stream_t ) );
+		stream->vorbis->filenum = file;
+		if( !qvorbis_stream_init( stream->vorbis, NULL, NULL ) ) {
+			S_CloseSfxStream( stream );
+			return NULL;
 		}
-		if( !Q_stricmp( extension, ".ogg" ) ) {
-			return SNDOGG_Load( s );
+	} else {
+		trap_FS_Seek( file, info->dataofs, FS_SEEK_SET );
+	}
+
+	stream->srcmaxlength = info->rate + S_ResampleHalfTaps() * 2 + 2;
+	stream->srcbuf = S_Malloc( stream->srcmaxlength * info->channels * info->width );
+
+	// one decoded second on top of what a paint may read
+	stream->maxlength = SFX_STREAM_LOOKBACK + PAINTBUFFER_SIZE + dma.speed + 1;
+	stream->window = S_Malloc( sizeof( sfxcache_t ) + stream->maxlength * info->channels * info->width );
+	stream->window->speed = dma.speed;
+	stream->window->channels = info->channels;
+	stream->window->width = info->width;
+
+	s_sfxCacheStats.streams++;
+
+	return stream;
+}
+
+/*
+* S_CloseSfxStream
+*/
+void S_CloseSfxStream( sfxstream_t *stream ) {
+	if( stream->vorbis ) {
+		qvorbis_stream_deinit( stream->vorbis );
+		S_Free( stream->vorbis );
+	}
+	if( stream->file ) {
+		trap_FS_FCloseFile( stream->file );
+	}
+	if( stream->srcbuf ) {
+		S_Free( stream->srcbuf );
+	}
+	if( stream->window ) {
+		S_Free( stream->window );
+	}
+	S_Free( stream );
+}
+
+/*
+* S_RewindSfxStream
+*/
+static void S_RewindSfxStream( sfxstream_t *stream ) {
+	if( stream->vorbis ) {
+		qvorbis_stream_reset( stream->vorbis );
+	} else {
+		trap_FS_Seek( stream->file, stream->info.dataofs, FS_SEEK_SET );
+	}
+
+	stream->srcpos = 0;
+	stream->srcstart = 0;
+	stream->outpos = 0;
+	stream->start = 0;
+	stream->window->length = 0;
+}
+
+/*
+* S_DecodeSfxStream
+*
+* Appends up to a second of resampled audio to the window. The source samples around
+* the resampled range are kept for the filter, so the result is the same as resampling
+* the whole sound at once.
+*/
+static unsigned int S_DecodeSfxStream( sfxstream_t *stream ) {
+	int i, read;
+	unsigned int first, last, end, drop, want, count;
+	uint8_t *dst;
+	const wavinfo_t *info = &stream->info;
+	sfxcache_t *window = stream->window;
+	const int bps = info->channels * info->width;
+	const int half = S_ResampleHalfTaps();
+
+	if( window->length + dma.speed + 1 > stream->maxlength ) {
+		return 0;
+	}
+
+	count = min( dma.speed, stream->length - stream->outpos );
+	if( !count ) {
+		return 0;
+	}
+
+	// source samples the filter reads for this range
+	first = (unsigned int)( (uint64_t)stream->outpos * info->rate / dma.speed );
+	last = (unsigned int)( (uint64_t)( stream->outpos + count - 1 ) * info->rate / dma.speed );
+	first = first > (unsigned int)half ? first - half : 0;
+	end = min( last + half + 2, (unsigned int)info->samples );
+
+	// drop what's behind
+	if( first > stream->srcstart ) {
+		drop = min( first - stream->srcstart, stream->srcpos - stream->srcstart );
+		memmove( stream->srcbuf, stream->srcbuf + drop * bps, ( stream->srcpos - stream->srcstart - drop ) * bps );
+		stream->srcstart += drop;
+	}
+
+	if( end > stream->srcpos ) {
+		want = min( end - stream->srcpos, stream->srcmaxlength - ( stream->srcpos - stream->srcstart ) );
+		dst = stream->srcbuf + ( stream->srcpos - stream->srcstart ) * bps;
+
+		if( stream->vorbis ) {
+			read = qvorbis_stream_read_samples( stream->vorbis, want, info->channels, info->width, dst );
+		} else {
+			read = trap_FS_Read( dst, want * bps, stream->file ) / bps;
+			if( info->width == 2 ) {
+				for( i = 0; i < read * info->channels; i++ ) {
+					( (short *)dst )[i] = LittleShort( ( (short *)dst )[i] );
+				}
+			}
+		}
+		if( read > 0 ) {
+			stream->srcpos += read;
 		}
 	}
 
-	return NULL;
+	// a short read resamples silence, like the end of the sound
+	S_ResampleRange( info->rate, dma.speed, info->channels, info->width,
+					 stream->srcbuf, stream->srcstart, stream->srcpos - stream->srcstart,
+					 window->data + window->length * bps, stream->outpos, count );
+
+	stream->outpos += count;
+	window->length += count;
+	return count;
+}
+
+/*
+* S_ReadSfxStream
+*
+* Makes the samples from pos - SFX_STREAM_LOOKBACK to pos + count available and
+* returns the window they are in. start is set to the sample position of the first
+* sample in the window.
+*/
+sfxcache_t *S_ReadSfxStream( sfxstream_t *stream, unsigned int pos, unsigned int count, unsigned int *start ) {
+	unsigned int end, keep, drop, pad;
+	sfxcache_t *window = stream->window;
+	const size_t bps = window->channels * window->width;
+
+	assert( count <= PAINTBUFFER_SIZE );
+
+	// looping sounds start over
+	if( pos < stream->start ) {
+		S_RewindSfxStream( stream );
+	}
+
+	end = pos + count;
+	keep = pos > SFX_STREAM_LOOKBACK ? pos - SFX_STREAM_LOOKBACK : 0;
+
+	while( stream->start + window->length < end ) {
+		// drop what can't be read anymore
+		if( keep > stream->start ) {
+			drop = min( keep - stream->start, window->length );
+			memmove( window->data, window->data + drop * bps, ( window->length - drop ) * bps );
+			window->length -= drop;
+			stream->start += drop;
+		}
+
+		if( !S_DecodeSfxStream( stream ) ) {
+			// ran out of data, pad with silence
+			if( keep > stream->start ) {
+				stream->start = keep;
+			}
+			pad = end - stream->start - window->length;
+			memset( window->data + window->length * bps, 0, pad * bps );
+			window->length += pad;
+			break;
+		}
+	}
+
+	*start = stream->start;
+	return window;
 }
 
 
@@ -415,19 +900,115 @@ static int SNDOGG_Read( bgTrack_t *track, void *ptr, int samples );
 static bool SNDOGG_Reset( bgTrack_t *track );
 static void SNDOGG_FClose( bgTrack_t *track );
 
+/*
+* SNDOGG_Probe
+*
+* Reads the format from the headers and the length from the granule position
+* of the last page, without decoding the file.
+*/
+static bool SNDOGG_Probe( const char *name, wavinfo_t *info ) {
+	int i, j, file, size, tailsize;
+	int rate, channels;
+	uint64_t granule = (uint64_t)-1;
+	uint8_t *tail;
+	qvorbis_stream_t v;
+
+	size = trap_FS_FOpenFile( name, &file, FS_READ );
+	if( !file ) {
+		return false;
+	}
+
+	// pages are at most 65307 bytes long
+	tailsize = min( size, 65536 );
+	tail = S_Malloc( tailsize );
+	trap_FS_Seek( file, size - tailsize, FS_SEEK_SET );
+	tailsize = trap_FS_Read( tail, tailsize, file );
+
+	for( i = tailsize - 27; i >= 0; i-- ) {
+		if( memcmp( tail + i, "OggS", 4 ) || tail[i + 4] != 0 ) {
+			continue;
+		}
+		granule = 0;
+		for( j = 7; j >= 0; j-- ) {
+			granule = ( granule << 8 ) | tail[i + 6 + j];
+		}
+		if( granule != (uint64_t)-1 ) {
+			// -1 marks pages with no packet ending on them
+			break;
+		}
+	}
+	S_Free( tail );
+
+	if( !granule || granule > INT_MAX ) {
+		trap_FS_FCloseFile( file );
+		return false;
+	}
+
+	memset( &v, 0, sizeof( v ) );
+	v.filenum = file;
+	trap_FS_Seek( file, 0, FS_SEEK_SET );
+	if( !qvorbis_stream_init( &v, &rate, &channels ) ) {
+		qvorbis_stream_deinit( &v );
+		trap_FS_FCloseFile( file );
+		return false;
+	}
+	qvorbis_stream_deinit( &v );
+	trap_FS_FCloseFile( file );
+
+	if( channels != 1 && channels != 2 ) {
+		return false;
+	}
+
+	memset( info, 0, sizeof( *info ) );
+	info->rate = rate;
+	info->width = 2;
+	info->channels = channels;
+	info->samples = (int)granule;
+	return true;
+}
+
 /*
 * SNDOGG_Load
 */
-sfxcache_t *SNDOGG_Load( sfx_t *s ) {
+sfxcache_t *SNDOGG_Load( sfx_t *s, bool allowStream ) {
 	sfxcache_t *sc;
 	int channels = 0, rate = 0;
 	short *data;
 	int len, samples;
+	int file, size;
+	unsigned checksum;
+	uint8_t *buffer;
 
 	assert( s && s->name[0] );
 	assert( !s->cache );
 
-	samples = qvorbis_load_file( s->name, &channels, &rate, &data );
+	if( allowStream && s_sfxstreamlength->value > 0 ) {
+		wavinfo_t info;
+
+		if( SNDOGG_Probe( s->name, &info ) && S_SetupSfxStream( s, &info ) ) {
+			return s->cache;
+		}
+	}
+
+	size = trap_FS_FOpenFile( s->name, &file, FS_READ );
+	if( !file ) {
+		return NULL;
+	}
+
+	buffer = S_Malloc( size );
+	trap_FS_Read( buffer, size, file );
+	trap_FS_FCloseFile( file );
+
+	// the checksum of the compressed file is cheap and a hit skips the decoding too
+	checksum = S_SfxChecksum( buffer, size );
+	sc = S_LoadResampledSfx( s, checksum );
+	if( sc ) {
+		S_Free( buffer );
+		return sc;
+	}
+
+	samples = qvorbis_load_memory( buffer, size, &channels, &rate, &data );
+	S_Free( buffer );
 
 	if( samples < 0 ) {
 		Com_Printf( "Error unsupported .ogg file: %s\n", s->name );
@@ -443,7 +1024,7 @@ sfxcache_t *SNDOGG_Load( sfx_t *s ) {
 	len = (int) ( (double) samples * (double) dma.speed / (double) rate );
 	len = len * 2 * channels;
 
-	sc = s->cache = S_Malloc( len + sizeof( sfxcache_t ) );
+	sc = S_Malloc( len + sizeof( sfxcache_t ) );
 	sc->length = samples;
 	sc->speed = rate;
 	sc->channels = channels;
@@ -454,6 +1035,12 @@ sfxcache_t *SNDOGG_Load( sfx_t *s ) {
 		memcpy( sc->data, data, len );
 	}
 	sc->speed = dma.speed;
+	s->cacheSize = len + sizeof( sfxcache_t );
+	s->cache = sc;
+
+	if( rate != (int)dma.speed ) {
+		S_WriteResampledSfx( s, checksum );
+	}
 
 	free( data );
 
@@ -21,11 +21,12 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "snd_local.h"
 
-#define PAINTBUFFER_SIZE    2048
 static portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE];
+static float paintbufferf[PAINTBUFFER_SIZE * 2];  // interleaved left and right, same scale as paintbuffer
 static int snd_scaletable[32][256];
 static int *snd_p, snd_linear_count, snd_vol, music_vol;
 static short *snd_out;
+static bool snd_floatmix;
 
 #if defined ( __arm__ ) && defined ( __GNUC__ )
 // 40-50% faster than the C version.
@@ -190,20 +191,219 @@ static void S_WriteSwappedLinearBlastStereo16( void ) {
 }
 #endif
 
-static void S_TransferStereo16( unsigned int *pbuf, int endtime ) {
+/*
+===============================================================================
+
+FLOAT MIXING KERNELS
+
+The float paint buffer holds interleaved left and right samples in the same
+scale as the integer one, so that the 8 bits of fraction are dropped when
+converting to 16 bits. Kernels process 4 sample pairs per iteration and fall
+back to the scalar loop for the rest.
+
+===============================================================================
+*/
+
+#if ( defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 ) ) && !defined ( C_ONLY )
+# include <emmintrin.h>
+# define SND_SSE2
+#elif ( defined ( __ARM_NEON__ ) || defined ( __ARM_NEON ) ) && !defined ( C_ONLY )
+# include <arm_neon.h>
+# define SND_NEON
+#endif
+
+/*
+* S_MixMono16Float
+*/
+static void S_MixMono16Float( float *out, const short *in, unsigned int count, float lvol, float rvol ) {
+	unsigned int i = 0;
+
+#if defined( SND_SSE2 )
+	const __m128 vol = _mm_setr_ps( lvol, rvol, lvol, rvol );
+
+	for( ; i + 4 <= count; i += 4, out += 8 ) {
+		__m128i s16 = _mm_loadl_epi64( ( const __m128i * )( in + i ) );
+		__m128 s = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( s16, s16 ), 16 ) );
+
+		_mm_storeu_ps( out, _mm_add_ps( _mm_loadu_ps( out ), _mm_mul_ps( _mm_unpacklo_ps( s, s ), vol ) ) );
+		_mm_storeu_ps( out + 4, _mm_add_ps( _mm_loadu_ps( out + 4 ), _mm_mul_ps( _mm_unpackhi_ps( s, s ), vol ) ) );
+	}
+#elif defined( SND_NEON )
+	const float32x4_t vol = { lvol, rvol, lvol, rvol };
+
+	for( ; i + 4 <= count; i += 4, out += 8 ) {
+		float32x4_t s = vcvtq_f32_s32( vmovl_s16( vld1_s16( in + i ) ) );
+		float32x4x2_t ss = vzipq_f32( s, s );
+
+		vst1q_f32( out, vmlaq_f32( vld1q_f32( out ), ss.val[0], vol ) );
+		vst1q_f32( out + 4, vmlaq_f32( vld1q_f32( out + 4 ), ss.val[1], vol ) );
+	}
+#endif
+
+	for( ; i < count; i++, out += 2 ) {
+		out[0] += in[i] * lvol;
+		out[1] += in[i] * rvol;
+	}
+}
+
+/*
+* S_MixStereo16Float
+*/
+static void S_MixStereo16Float( float *out, const short *in, unsigned int count, float lvol, float rvol ) {
+	unsigned int i = 0;
+
+#if defined( SND_SSE2 )
+	const __m128 vol = _mm_setr_ps( lvol, rvol, lvol, rvol );
+
+	for( ; i + 4 <= count; i += 4, out += 8 ) {
+		__m128i s16 = _mm_loadu_si128( ( const __m128i * )( in + i * 2 ) );
+		__m128 lo = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( s16, s16 ), 16 ) );
+		__m128 hi = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( s16, s16 ), 16 ) );
+
+		_mm_storeu_ps( out, _mm_add_ps( _mm_loadu_ps( out ), _mm_mul_ps( lo, vol ) ) );
+		_mm_storeu_ps( out + 4, _mm_add_ps( _mm_loadu_ps( out + 4 ), _mm_mul_ps( hi, vol ) ) );
+	}
+#elif defined( SND_NEON )
+	const float32x4_t vol = { lvol, rvol, lvol, rvol };
+
+	for( ; i + 4 <= count; i += 4, out += 8 ) {
+		int16x8_t s16 = vld1q_s16( in + i * 2 );
+		float32x4_t lo = vcvtq_f32_s32( vmovl_s16( vget_low_s16( s16 ) ) );
+		float32x4_t hi = vcvtq_f32_s32( vmovl_s16( vget_high_s16( s16 ) ) );
+
+		vst1q_f32( out, vmlaq_f32( vld1q_f32( out ), lo, vol ) );
+		vst1q_f32( out + 4, vmlaq_f32( vld1q_f32( out + 4 ), hi, vol ) );
+	}
+#endif
+
+	for( ; i < count; i++, out += 2 ) {
+		out[0] += in[i * 2 + 0] * lvol;
+		out[1] += in[i * 2 + 1] * rvol;
+	}
+}
+
+/*
+* S_MixRawFloat
+*
+* Mixes a contiguous run of raw sample pairs.
+*/
+static void S_MixRawFloat( float *out, const portable_samplepair_t *in, unsigned int count, float lvol, float rvol ) {
+	unsigned int i = 0;
+
+#if defined( SND_SSE2 )
+	const __m128 vol = _mm_setr_ps( lvol, rvol, lvol, rvol );
+
+	for( ; i + 2 <= count; i += 2, out += 4 ) {
+		__m128 s = _mm_cvtepi32_ps( _mm_loadu_si128( ( const __m128i * )( in + i ) ) );
+		_mm_storeu_ps( out, _mm_add_ps( _mm_loadu_ps( out ), _mm_mul_ps( s, vol ) ) );
+	}
+#elif defined( SND_NEON )
+	const float32x4_t vol = { lvol, rvol, lvol, rvol };
+
+	for( ; i + 2 <= count; i += 2, out += 4 ) {
+		float32x4_t s = vcvtq_f32_s32( vld1q_s32( ( const int32_t * )( in + i ) ) );
+		vst1q_f32( out, vmlaq_f32( vld1q_f32( out ), s, vol ) );
+	}
+#endif
+
+	for( ; i < count; i++, out += 2 ) {
+		out[0] += (float)in[i].left * lvol;
+		out[1] += (float)in[i].right * rvol;
+	}
+}
+
+/*
+* S_WriteLinearBlastStereo16Float
+*
+* Scales, clamps and converts count interleaved samples to 16 bits.
+*/
+static void S_WriteLinearBlastStereo16Float( const float *in, short *out, int count, bool swap ) {
+	int i = 0;
+	int val;
+
+#if defined( SND_SSE2 )
+	const __m128 scale = _mm_set1_ps( 1.0f / 256.0f );
+
+	for( ; i + 8 <= count; i += 8 ) {
+		__m128 lo = _mm_mul_ps( _mm_loadu_ps( in + i ), scale );
+		__m128 hi = _mm_mul_ps( _mm_loadu_ps( in + i + 4 ), scale );
+
+		if( swap ) {
+			lo = _mm_shuffle_ps( lo, lo, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+			hi = _mm_shuffle_ps( hi, hi, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+		}
+
+		// packing saturates to the 16 bits range
+		_mm_storeu_si128( ( __m128i * )( out + i ), _mm_packs_epi32( _mm_cvttps_epi32( lo ), _mm_cvttps_epi32( hi ) ) );
+	}
+#elif defined( SND_NEON )
+	const float32x4_t scale = vdupq_n_f32( 1.0f / 256.0f );
+
+	for( ; i + 8 <= count; i += 8 ) {
+		float32x4_t lo = vmulq_f32( vld1q_f32( in + i ), scale );
+		float32x4_t hi = vmulq_f32( vld1q_f32( in + i + 4 ), scale );
+
+		if( swap ) {
+			lo = vrev64q_f32( lo );
+			hi = vrev64q_f32( hi );
+		}
+
+		// narrowing saturates to the 16 bits range
+		vst1q_s16( out + i, vcombine_s16( vqmovn_s32( vcvtq_s32_f32( lo ) ), vqmovn_s32( vcvtq_s32_f32( hi ) ) ) );
+	}
+#endif
+
+	for( ; i < count; i += 2 ) {
+		val = (int)( in[i + swap] * ( 1.0f / 256.0f ) );
+		out[i] = Q_bound( -32768, val, 0x7fff );
+
+		val = (int)( in[i + !swap] * ( 1.0f / 256.0f ) );
+		out[i + 1] = Q_bound( -32768, val, 0x7fff );
+	}
+}
+
+/*
+* S_TransferStereo16Float
+*/
+static void S_TransferStereo16Float( const dma_t *target, unsigned int *pbuf, int starttime, int endtime ) {
+	int lpos;
+	int lpaintedtime;
+	int count;
+	const float *p;
+
+	p = paintbufferf;
+	lpaintedtime = starttime;
+
+	while( lpaintedtime < endtime ) {
+		// handle recirculating buffer issues
+		lpos = lpaintedtime & ( ( target->samples >> 1 ) - 1 );
+
+		count = ( target->samples >> 1 ) - lpos;
+		if( lpaintedtime + count > endtime ) {
+			count = endtime - lpaintedtime;
+		}
+
+		S_WriteLinearBlastStereo16Float( p, (short *) pbuf + ( lpos << 1 ), count << 1, s_swapstereo->integer != 0 );
+
+		p += count << 1;
+		lpaintedtime += count;
+	}
+}
+
+static void S_TransferStereo16( const dma_t *target, unsigned int *pbuf, int starttime, int endtime ) {
 	int lpos;
 	int lpaintedtime;
 
 	snd_p = (int *) paintbuffer;
-	lpaintedtime = paintedtime;
+	lpaintedtime = starttime;
 
 	while( lpaintedtime < endtime ) {
 		// handle recirculating buffer issues
-		lpos = lpaintedtime & ( ( dma.samples >> 1 ) - 1 );
+		lpos = lpaintedtime & ( ( target->samples >> 1 ) - 1 );
 
 		snd_out = (short *) pbuf + ( lpos << 1 );
 
-		snd_linear_count = ( dma.samples >> 1 ) - lpos;
+		snd_linear_count = ( target->samples >> 1 ) - lpos;
 		if( lpaintedtime + snd_linear_count > endtime ) {
 			snd_linear_count = endtime - lpaintedtime;
 		}
@@ -227,12 +427,13 @@ static void S_TransferStereo16( unsigned int *pbuf, int endtime ) {
 */
 void S_ClearPaintBuffer( void ) {
 	memset( paintbuffer, 0, sizeof( paintbuffer ) );
+	memset( paintbufferf, 0, sizeof( paintbufferf ) );
 }
 
 /*
 * S_TransferPaintBuffer
 */
-static void S_TransferPaintBuffer( int endtime ) {
+static void S_TransferPaintBuffer( const dma_t *target, int starttime, int endtime ) {
 	int out_idx;
 	int count;
 	int out_mask;
@@ -241,7 +442,7 @@ static void S_TransferPaintBuffer( int endtime ) {
 	int val;
 	unsigned int *pbuf;
 
-	pbuf = (unsigned int *)dma.buffer;
+	pbuf = (unsigned int *)target->buffer;
 /*
     if( s_testsound->integer )
     {
@@ -249,21 +450,44 @@ static void S_TransferPaintBuffer( int endtime ) {
         int count;
 
         // write a fixed sine wave
-        count = endtime - paintedtime;
+        count = endtime - starttime;
         for( i = 0; i < count; i++ )
-            paintbuffer[i].left = paintbuffer[i].right = sin( ( paintedtime+i )*0.1 )*20000*256;
+            paintbuffer[i].left = paintbuffer[i].right = sin( ( starttime+i )*0.1 )*20000*256;
     }
 */
-	if( dma.samplebits == 16 && dma.channels == 2 ) { // optimized case
-		S_TransferStereo16( pbuf, endtime );
+	if( target->samplebits == 16 && target->channels == 2 ) { // optimized case
+		if( snd_floatmix ) {
+			S_TransferStereo16Float( target, pbuf, starttime, endtime );
+		} else {
+			S_TransferStereo16( target, pbuf, starttime, endtime );
+		}
+	} else if( snd_floatmix ) {
+		const float *p = paintbufferf;
+
+		count = ( endtime - starttime ) * target->channels;
+		out_mask = target->samples - 1;
+		out_idx = starttime * target->channels & out_mask;
+		step = 3 - target->channels;
+
+		while( count-- ) {
+			val = (int)( *p * ( 1.0f / 256.0f ) );
+			p += step;
+			val = Q_bound( -32768, val, 0x7fff );
+			if( target->samplebits == 16 ) {
+				( (short *)pbuf )[out_idx] = val;
+			} else {
+				( (unsigned char *)pbuf )[out_idx] = ( val >> 8 ) + 128;
+			}
+			out_idx = ( out_idx + 1 ) & out_mask;
+		}
 	} else {   // general case
 		p = (int *)paintbuffer;
-		count = ( endtime - paintedtime ) * dma.channels;
-		out_mask = dma.samples - 1;
-		out_idx = paintedtime * dma.channels & out_mask;
-		step = 3 - dma.channels;
+		count = ( endtime - starttime ) * target->channels;
+		out_mask = target->samples - 1;
+		out_idx = starttime * target->channels & out_mask;
+		step = 3 - target->channels;
 
-		if( dma.samplebits == 16 ) {
+		if( target->samplebits == 16 ) {
 			short *out = (short *)pbuf;
 			while( count-- ) {
 				val = *p >> 8;
@@ -276,7 +500,7 @@ static void S_TransferPaintBuffer( int endtime ) {
 				out[out_idx] = val;
 				out_idx = ( out_idx + 1 ) & out_mask;
 			}
-		} else if( dma.samplebits == 8 ) {
+		} else if( target->samplebits == 8 ) {
 			unsigned char *out = (unsigned char *)pbuf;
 			while( count-- ) {
 				val = *p >> 8;
@@ -296,22 +520,22 @@ static void S_TransferPaintBuffer( int endtime ) {
 /*
 * S_DumpPaintBuffer
 */
-static void S_DumpPaintBuffer( int endtime, int file ) {
+static void S_DumpPaintBuffer( const dma_t *target, int starttime, int endtime, int file ) {
 	int in_idx;
 	int len, count;
 	int in_mask;
 	unsigned int *pbuf;
 	uint8_t *raw;
 
-	pbuf = (unsigned int *)dma.buffer;
-	count = ( endtime - paintedtime ) * dma.channels;
-	in_mask = dma.samples - 1;
-	in_idx = paintedtime * dma.channels & in_mask;
+	pbuf = (unsigned int *)target->buffer;
+	count = ( endtime - starttime ) * target->channels;
+	in_mask = target->samples - 1;
+	in_idx = starttime * target->channels & in_mask;
 
-	len = count * dma.samplebits / 8;
+	len = count * target->samplebits / 8;
 	raw = S_Malloc( len );
 
-	if( dma.samplebits == 16 ) {
+	if( target->samplebits == 16 ) {
 		short *in = (short *)pbuf;
 		short *out = (short *)raw;
 		while( count-- ) {
@@ -344,6 +568,94 @@ static void S_PaintChannelFrom8( channel_t *ch, sfxcache_t *sc, unsigned int end
 static void S_PaintChannelFrom16( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
 static void S_PaintChannelFrom8HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
 static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int endtime, int offset );
+static void S_PaintChannelFloat( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset );
+static void S_PaintChannelHQFloat( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset );
+
+/*
+* S_PaintRawSounds
+*/
+static void S_PaintRawSounds( unsigned int end ) {
+	int i;
+
+	for( i = 0; i < MAX_RAW_SOUNDS; i++ ) {
+		// copy from the streaming sound source
+		int s;
+		unsigned j, stop;
+		rawsound_t *rawsound = raw_sounds[i];
+
+		if( !rawsound ) {
+			continue;
+		}
+		if( !rawsound->left_volume && !rawsound->right_volume ) {
+			// not audible
+			continue;
+		}
+
+		stop = ( end < rawsound->rawend ) ? end : rawsound->rawend;
+
+		if( snd_floatmix ) {
+			unsigned n;
+
+			// mix contiguous runs of the ring buffer
+			for( j = paintedtime; j < stop; j += n ) {
+				s = j & ( MAX_RAW_SAMPLES - 1 );
+				n = min( stop - j, MAX_RAW_SAMPLES - s );
+				S_MixRawFloat( &paintbufferf[( j - paintedtime ) * 2], &rawsound->rawsamples[s], n,
+							   rawsound->left_volume, rawsound->right_volume );
+			}
+			continue;
+		}
+
+		for( j = paintedtime; j < stop; j++ ) {
+			s = j & ( MAX_RAW_SAMPLES - 1 );
+			paintbuffer[j - paintedtime].left += rawsound->rawsamples[s].left * rawsound->left_volume;
+			paintbuffer[j - paintedtime].right += rawsound->rawsamples[s].right * rawsound->right_volume;
+		}
+	}
+}
+
+/*
+* S_PaintChannel
+*/
+static void S_PaintChannel( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset ) {
+	unsigned int start = 0;
+
+	if( ch->isVirtual ) {
+		// keep the voice going without mixing it
+		ch->pos += count;
+		return;
+	}
+
+	if( ch->stream ) {
+		// paint from the decoded window, relative to its start
+		sc = S_ReadSfxStream( ch->stream, ch->pos, count, &start );
+		ch->pos -= start;
+		ch->ldelay = min( ch->ldelay, SFX_STREAM_LOOKBACK );
+		ch->rdelay = min( ch->rdelay, SFX_STREAM_LOOKBACK );
+	}
+
+	if( snd_floatmix ) {
+		if( s_pseudoAcoustics->value && sc->channels == 1 ) {
+			S_PaintChannelHQFloat( ch, sc, count, offset );
+		} else {
+			S_PaintChannelFloat( ch, sc, count, offset );
+		}
+	} else if( s_pseudoAcoustics->value ) {
+		if( sc->width == 1 ) {
+			S_PaintChannelFrom8HQ( ch, sc, count, offset );
+		} else {
+			S_PaintChannelFrom16HQ( ch, sc, count, offset );
+		}
+	} else {
+		if( sc->width == 1 ) {
+			S_PaintChannelFrom8( ch, sc, count, offset );
+		} else {
+			S_PaintChannelFrom16( ch, sc, count, offset );
+		}
+	}
+
+	ch->pos += start;
+}
 
 int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 	unsigned int i;
@@ -357,6 +669,7 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 	total = 0;
 	snd_vol = s_volume->value * gain * 256;
 	music_vol = s_musicvolume->value * gain * 256;
+	snd_floatmix = s_floatmix->integer != 0;
 
 	while( paintedtime < endtime ) {
 		// if paintbuffer is smaller than DMA buffer
@@ -384,34 +697,18 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 		}
 
 		// clear the paint buffer
-		memset( paintbuffer, 0, ( end - paintedtime ) * sizeof( portable_samplepair_t ) );
+		if( snd_floatmix ) {
+			memset( paintbufferf, 0, ( end - paintedtime ) * 2 * sizeof( float ) );
+		} else {
+			memset( paintbuffer, 0, ( end - paintedtime ) * sizeof( portable_samplepair_t ) );
+		}
 
 		// paint in the raw samples
-		for( i = 0; i < MAX_RAW_SOUNDS; i++ ) {
-			// copy from the streaming sound source
-			int s;
-			unsigned j, stop;
-			rawsound_t *rawsound = raw_sounds[i];
-
-			if( !rawsound ) {
-				continue;
-			}
-			if( !rawsound->left_volume && !rawsound->right_volume ) {
-				// not audible
-				continue;
-			}
-
-			stop = ( end < rawsound->rawend ) ? end : rawsound->rawend;
-			for( j = paintedtime; j < stop; j++ ) {
-				s = j & ( MAX_RAW_SAMPLES - 1 );
-				paintbuffer[j - paintedtime].left += rawsound->rawsamples[s].left * rawsound->left_volume;
-				paintbuffer[j - paintedtime].right += rawsound->rawsamples[s].right * rawsound->right_volume;
-			}
-		}
+		S_PaintRawSounds( end );
 
 		// paint in the channels.
 		ch = s_channels;
-		for( i = 0; i < MAX_CHANNELS; i++, ch++ ) {
+		for( i = 0; i < (unsigned)s_numchannels; i++, ch++ ) {
 			ltime = paintedtime;
 
 			while( ltime < end ) {
@@ -431,25 +728,16 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 					count = ch->end > ltime ? ch->end - ltime : 0;
 				}
 
-				sc = S_LoadSound( ch->sfx );
+				// busy channels keep their sounds in the cache, unless the sound
+				// has been freed, which stops the channel
+				sc = ch->sfx->cache;
 				if( !sc ) {
+					S_FreeChannel( ch );
 					break;
 				}
 
 				if( count > 0 && ch->sfx ) {
-					if( s_pseudoAcoustics->value ) {
-						if( sc->width == 1 ) {
-							S_PaintChannelFrom8HQ( ch, sc, count, ltime - paintedtime );
-						} else {
-							S_PaintChannelFrom16HQ( ch, sc, count, ltime - paintedtime );
-						}
-					} else {
-						if( sc->width == 1 ) {
-							S_PaintChannelFrom8( ch, sc, count, ltime - paintedtime );
-						} else {
-							S_PaintChannelFrom16( ch, sc, count, ltime - paintedtime );
-						}
-					}
+					S_PaintChannel( ch, sc, count, ltime - paintedtime );
 					ltime += count;
 				}
 
@@ -458,8 +746,9 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 					if( ch->autosound ) { // autolooping sounds always go back to start
 						ch->pos = 0;
 						ch->end = ltime + sc->length;
+						S_UpdateChannel( ch );
 					} else {   // channel just stopped
-						ch->sfx = NULL;
+						S_FreeChannel( ch );
 					}
 				}
 			}
@@ -467,12 +756,12 @@ int S_PaintChannels( unsigned int endtime, int dumpfile, float gain ) {
 
 		// dump to file
 		if( dumpfile ) {
-			S_DumpPaintBuffer( end, dumpfile );
+			S_DumpPaintBuffer( &dma, paintedtime, end, dumpfile );
 		}
 
 		// transfer out according to DMA format
 		total += end - paintedtime;
-		S_TransferPaintBuffer( end );
+		S_TransferPaintBuffer( &dma, paintedtime, end );
 		paintedtime = end;
 	}
 
@@ -702,3 +991,256 @@ static void S_PaintChannelFrom16HQ( channel_t *ch, sfxcache_t *sc, unsigned int
 
 	ch->pos += count;
 }
+
+/*
+* S_PaintChannelFloat
+*/
+static void S_PaintChannelFloat( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset ) {
+	unsigned int i;
+	float lvol, rvol;
+	float *samp;
+
+	samp = &paintbufferf[offset * 2];
+
+	if( sc->width == 1 ) {
+		const signed char *sfx;
+
+		if( ch->leftvol > 255 ) {
+			ch->leftvol = 255;
+		}
+		if( ch->rightvol > 255 ) {
+			ch->rightvol = 255;
+		}
+
+		if( !s_volume->value ) {
+			ch->pos += count;
+			return;
+		}
+
+		// the scale of the sample 1 in the table, so that volume steps match the integer mixer
+		lvol = snd_scaletable[ch->leftvol >> 3][1];
+		rvol = snd_scaletable[ch->rightvol >> 3][1];
+
+		if( sc->channels == 2 ) {
+			sfx = (const signed char *)sc->data + ch->pos * 2;
+			for( i = 0; i < count; i++, samp += 2, sfx += 2 ) {
+				samp[0] += sfx[0] * lvol;
+				samp[1] += sfx[1] * rvol;
+			}
+		} else {
+			sfx = (const signed char *)sc->data + ch->pos;
+			for( i = 0; i < count; i++, samp += 2 ) {
+				samp[0] += sfx[i] * lvol;
+				samp[1] += sfx[i] * rvol;
+			}
+		}
+	} else {
+		if( !snd_vol ) {
+			ch->pos += count;
+			return;
+		}
+
+		lvol = ch->leftvol * snd_vol * ( 1.0f / 256.0f );
+		rvol = ch->rightvol * snd_vol * ( 1.0f / 256.0f );
+
+		if( sc->channels == 2 ) {
+			S_MixStereo16Float( samp, (const short *)sc->data + ch->pos * 2, count, lvol, rvol );
+		} else {
+			S_MixMono16Float( samp, (const short *)sc->data + ch->pos, count, lvol, rvol );
+		}
+	}
+
+	ch->pos += count;
+}
+
+/*
+* S_PaintChannelHQFloat
+*
+* Float version of S_PaintChannelFrom8HQ and S_PaintChannelFrom16HQ for mono sounds. The
+* lowpass filters are recursive so this stays scalar.
+*/
+static void S_PaintChannelHQFloat( channel_t *ch, sfxcache_t *sc, unsigned int count, int offset ) {
+	unsigned int i, j;
+	int l, r;
+	float lvol, rvol;
+	float *samp;
+	const uint8_t *sfx8 = NULL;
+	const short *sfx16 = NULL;
+
+	if( sc->width == 1 ) {
+		if( ch->leftvol > 255 ) {
+			ch->leftvol = 255;
+		}
+		if( ch->rightvol > 255 ) {
+			ch->rightvol = 255;
+		}
+		if( !s_volume->value ) {
+			ch->pos += count;
+			return;
+		}
+
+		lvol = snd_scaletable[ch->leftvol >> 3][1];
+		rvol = snd_scaletable[ch->rightvol >> 3][1];
+		sfx8 = (const uint8_t *)sc->data;
+	} else {
+		if( !snd_vol ) {
+			ch->pos += count;
+			return;
+		}
+
+		lvol = ch->leftvol * snd_vol * ( 1.0f / 256.0f );
+		rvol = ch->rightvol * snd_vol * ( 1.0f / 256.0f );
+		sfx16 = (const short *)sc->data;
+	}
+
+// 8-bit samples are filtered unsigned and wrapped back to signed, like in S_PaintChannelFrom8HQ
+#define SAMPLE( pos )   ( sfx8 ? sfx8[pos] << 8 : sfx16[pos] )
+#define FILTERED( v )   ( sfx8 ? (signed char)( ( v ) >> 8 ) : ( v ) )
+
+	samp = &paintbufferf[offset * 2];
+
+	i = 0;
+	j = ch->pos;
+	if( ch->pos < ch->ldelay ) {
+		// left channel delayed, write first right channels
+		unsigned int rights = min( count, ch->ldelay - ch->pos );
+		for( ; i < rights; i++, j++, samp += 2 ) {
+			r = S_Lowpass2pole( SAMPLE( j ), &ch->lpf_history[2], ch->lpf_rcoeff );
+			samp[1] += FILTERED( r ) * rvol;
+		}
+	} else if( ch->pos < ch->rdelay ) {
+		// right channel delayed, write first left channels
+		unsigned int lefts = min( count, ch->rdelay - ch->pos );
+		for( ; i < lefts; i++, j++, samp += 2 ) {
+			l = S_Lowpass2pole( SAMPLE( j ), &ch->lpf_history[0], ch->lpf_lcoeff );
+			samp[0] += FILTERED( l ) * lvol;
+		}
+	}
+
+	// write the common samples for both channels
+	for( ; i < count; i++, j++, samp += 2 ) {
+		l = S_Lowpass2pole( SAMPLE( j - ch->ldelay ), &ch->lpf_history[0], ch->lpf_lcoeff );
+		r = S_Lowpass2pole( SAMPLE( j - ch->rdelay ), &ch->lpf_history[2], ch->lpf_rcoeff );
+		samp[0] += FILTERED( l ) * lvol;
+		samp[1] += FILTERED( r ) * rvol;
+	}
+
+#undef FILTERED
+#undef SAMPLE
+
+	ch->pos += count;
+}
+
+/*
+===============================================================================
+
+MIXING BENCHMARK
+
+===============================================================================
+*/
+
+/*
+* S_MixBenchmark
+*
+* Mixes seconds worth of numChannels looping synthetic sounds into a private buffer with
+* either the integer or the float mixer and returns the time it took in milliseconds. If
+* file is not 0, the same output is rendered again and dumped to it, untimed.
+*/
+int64_t S_MixBenchmark( int numChannels, int seconds, bool floatmix, int file ) {
+	int i, k, pass;
+	unsigned int j, n, count, length, end, total, ltime;
+	unsigned int starttime;
+	int64_t time = 0;
+	bool oldFloatmix = snd_floatmix;
+	dma_t target;
+	sfxcache_t *caches[3];
+	channel_t *channels;
+
+	// one second of a 16 bits mono, a 16 bits stereo and an 8 bits mono sound
+	length = dma.speed;
+	for( k = 0; k < 3; k++ ) {
+		sfxcache_t *sc;
+		float freq = ( 220 + 110 * k ) * 2 * M_PI / length;
+
+		sc = caches[k] = S_Malloc( sizeof( sfxcache_t ) + length * 2 * 2 );
+		sc->length = length;
+		sc->speed = dma.speed;
+		sc->width = k == 2 ? 1 : 2;
+		sc->channels = k == 1 ? 2 : 1;
+
+		for( j = 0; j < length * sc->channels; j++ ) {
+			float v = sin( ( j / sc->channels ) * freq );
+			if( sc->width == 1 ) {
+				( (signed char *)sc->data )[j] = v * 100;
+			} else {
+				( (short *)sc->data )[j] = v * 16000;
+			}
+		}
+	}
+
+	channels = S_Malloc( sizeof( *channels ) * numChannels );
+
+	target = dma;
+	target.samples = PAINTBUFFER_SIZE * dma.channels;
+	target.buffer = S_Malloc( target.samples * dma.samplebits / 8 );
+
+	snd_vol = s_volume->value * 256;
+	snd_floatmix = floatmix;
+	total = seconds * dma.speed;
+
+	for( pass = 0; pass < ( file ? 2 : 1 ); pass++ ) {
+		int64_t start = trap_Milliseconds();
+
+		memset( channels, 0, sizeof( *channels ) * numChannels );
+		for( i = 0; i < numChannels; i++ ) {
+			channels[i].leftvol = 64 + ( i * 37 ) % 192;
+			channels[i].rightvol = 64 + ( i * 91 ) % 192;
+			channels[i].pos = ( i * 997 ) % length;
+		}
+
+		for( starttime = 0; starttime < total; starttime = end ) {
+			end = min( starttime + PAINTBUFFER_SIZE, total );
+			count = end - starttime;
+
+			if( floatmix ) {
+				memset( paintbufferf, 0, count * 2 * sizeof( float ) );
+			} else {
+				memset( paintbuffer, 0, count * sizeof( portable_samplepair_t ) );
+			}
+
+			for( i = 0; i < numChannels; i++ ) {
+				channel_t *ch = &channels[i];
+				sfxcache_t *sc = caches[i % 3];
+
+				for( ltime = 0; ltime < count; ltime += n ) {
+					n = min( count - ltime, sc->length - ch->pos );
+					S_PaintChannel( ch, sc, n, ltime );
+					if( ch->pos >= sc->length ) {
+						ch->pos = 0;
+					}
+				}
+			}
+
+			S_TransferPaintBuffer( &target, starttime, end );
+
+			if( pass ) {
+				S_DumpPaintBuffer( &target, starttime, end, file );
+			}
+		}
+
+		if( !pass ) {
+			time = trap_Milliseconds() - start;
+		}
+	}
+
+	snd_floatmix = oldFloatmix;
+	S_ClearPaintBuffer();
+
+	S_Free( target.buffer );
+	S_Free( channels );
+	for( k = 0; k < 3; k++ ) {
+		S_Free( caches[k] );
+	}
+
+	return time;
+}
@@ -0,0 +1,326 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// snd_resample.c -- sample rate conversion
+
+#include "snd_local.h"
+
+// Polyphase resampler: each output sample is the dot product of the source
+// samples around its position and one of SFX_RESAMPLE_PHASES rows of a windowed
+// sinc filter, picked by the fractional part of the position. Positions are
+// computed exactly from the output index, so arbitrary ranges of a sound can be
+// resampled separately and still match resampling it as a whole.
+//
+// s_resamplequality selects the number of taps, 0 being plain linear interpolation.
+
+#define SFX_RESAMPLE_PHASES     256
+#define MAX_RESAMPLE_FILTERS    8
+
+#if ( defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 ) ) && !defined ( C_ONLY )
+# include <emmintrin.h>
+# define SND_SSE2
+#elif ( defined ( __ARM_NEON__ ) || defined ( __ARM_NEON ) ) && !defined ( C_ONLY )
+# include <arm_neon.h>
+# define SND_NEON
+#endif
+
+typedef struct {
+	unsigned int inrate, outrate;
+	float *coeffs;                  // SFX_RESAMPLE_PHASES rows of s_resampleTaps
+} resamplefilter_t;
+
+static const int s_resampleTapsForQuality[] = { 4, 16, 32 };
+
+static int s_resampleQuality;
+static int s_resampleTaps;          // always a multiple of 4
+
+static struct qmutex_s *s_resampleFiltersLock;
+static resamplefilter_t s_resampleFilters[MAX_RESAMPLE_FILTERS];
+static int s_numResampleFilters;
+
+/*
+* S_InitResampler
+*/
+void S_InitResampler( void ) {
+	s_resampleQuality = Q_bound( 0, s_resamplequality->integer, (int)( sizeof( s_resampleTapsForQuality ) / sizeof( s_resampleTapsForQuality[0] ) ) - 1 );
+	s_resampleTaps = s_resampleTapsForQuality[s_resampleQuality];
+
+	s_resampleFiltersLock = trap_Mutex_Create();
+	s_numResampleFilters = 0;
+}
+
+/*
+* S_ShutdownResampler
+*/
+void S_ShutdownResampler( void ) {
+	int i;
+
+	for( i = 0; i < s_numResampleFilters; i++ ) {
+		S_Free( s_resampleFilters[i].coeffs );
+	}
+	s_numResampleFilters = 0;
+
+	if( s_resampleFiltersLock ) {
+		trap_Mutex_Destroy( &s_resampleFiltersLock );
+	}
+}
+
+/*
+* S_ResampleQuality
+*/
+int S_ResampleQuality( void ) {
+	return s_resampleQuality;
+}
+
+/*
+* S_ResampleHalfTaps
+*
+* How many source samples on each side of its position an output sample depends on.
+*/
+int S_ResampleHalfTaps( void ) {
+	return s_resampleTaps / 2;
+}
+
+/*
+* S_BuildResampleFilter
+*/
+static void S_BuildResampleFilter( float *coeffs, int taps, unsigned int inrate, unsigned int outrate ) {
+	int p, k;
+	int half = taps / 2;
+	double x, t, h, sum, frac;
+	double cutoff;
+
+	// leave some room for the transition band, and band-limit to the output when downsampling
+	cutoff = 0.92 * min( 1.0, (double)outrate / (double)inrate );
+
+	for( p = 0; p < SFX_RESAMPLE_PHASES; p++, coeffs += taps ) {
+		frac = (double)p / SFX_RESAMPLE_PHASES;
+
+		if( s_resampleQuality == 0 ) {
+			memset( coeffs, 0, taps * sizeof( *coeffs ) );
+			coeffs[half - 1] = 1.0 - frac;
+			coeffs[half] = frac;
+			continue;
+		}
+
+		sum = 0;
+		for( k = 0; k < taps; k++ ) {
+			// distance from the output position, in source samples
+			x = k - ( half - 1 ) - frac;
+			t = x / half;
+
+			if( fabs( t ) >= 1.0 ) {
+				h = 0;
+			} else {
+				// Blackman windowed sinc
+				h = cutoff * ( x == 0 ? 1.0 : sin( M_PI * cutoff * x ) / ( M_PI * cutoff * x ) );
+				h *= 0.42 + 0.5 * cos( M_PI * t ) + 0.08 * cos( 2.0 * M_PI * t );
+			}
+
+			coeffs[k] = h;
+			sum += h;
+		}
+
+		// unity gain at DC
+		for( k = 0; k < taps; k++ ) {
+			coeffs[k] /= sum;
+		}
+	}
+}
+
+/*
+* S_FindResampleFilter
+*
+* Filters are kept until shutdown. If there are too many different rates, the filter
+* is built just for the caller and *temporary is set.
+*/
+static const float *S_FindResampleFilter( unsigned int inrate, unsigned int outrate, bool *temporary ) {
+	int i;
+	float *coeffs = NULL;
+	const size_t size = SFX_RESAMPLE_PHASES * s_resampleTaps * sizeof( float );
+
+	*temporary = false;
+
+	trap_Mutex_Lock( s_resampleFiltersLock );
+
+	for( i = 0; i < s_numResampleFilters; i++ ) {
+		if( s_resampleFilters[i].inrate == inrate && s_resampleFilters[i].outrate == outrate ) {
+			coeffs = s_resampleFilters[i].coeffs;
+			break;
+		}
+	}
+
+	if( !coeffs ) {
+		coeffs = S_Malloc( size );
+		S_BuildResampleFilter( coeffs, s_resampleTaps, inrate, outrate );
+
+		if( s_numResampleFilters < MAX_RESAMPLE_FILTERS ) {
+			s_resampleFilters[s_numResampleFilters].inrate = inrate;
+			s_resampleFilters[s_numResampleFilters].outrate = outrate;
+			s_resampleFilters[s_numResampleFilters].coeffs = coeffs;
+			s_numResampleFilters++;
+		} else {
+			*temporary = true;
+		}
+	}
+
+	trap_Mutex_Unlock( s_resampleFiltersLock );
+
+	return coeffs;
+}
+
+/*
+* S_ResampleDot
+*
+* n must be a multiple of 4.
+*/
+static inline float S_ResampleDot( const float *a, const float *b, int n ) {
+	int i;
+
+#if defined( SND_SSE2 )
+	__m128 sum = _mm_setzero_ps();
+
+	for( i = 0; i < n; i += 4 ) {
+		sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( a + i ), _mm_loadu_ps( b + i ) ) );
+	}
+	sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+	sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+	return _mm_cvtss_f32( sum );
+#elif defined( SND_NEON )
+	float32x4_t sum = vdupq_n_f32( 0.0f );
+	float32x2_t sum2;
+
+	for( i = 0; i < n; i += 4 ) {
+		sum = vmlaq_f32( sum, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+	}
+	sum2 = vadd_f32( vget_low_f32( sum ), vget_high_f32( sum ) );
+	return vget_lane_f32( vpadd_f32( sum2, sum2 ), 0 );
+#else
+	float sum = 0;
+
+	for( i = 0; i < n; i++ ) {
+		sum += a[i] * b[i];
+	}
+	return sum;
+#endif
+}
+
+/*
+* S_ResampleRange
+*
+* Writes output samples outfirst to outfirst + outcount - 1 of the sound, converting it
+* from inrate to outrate. The input holds source samples infirst to infirst + incount - 1,
+* samples out of that range are read as silence. 8-bit input is unsigned, 8-bit output
+* is signed. Returns the number of samples written.
+*/
+unsigned int S_ResampleRange( unsigned int inrate, unsigned int outrate, unsigned short channels, unsigned short width,
+							  const uint8_t *in, unsigned int infirst, unsigned int incount,
+							  uint8_t *out, unsigned int outfirst, unsigned int outcount ) {
+	int c, k;
+	int taps = s_resampleTaps, half = taps / 2;
+	unsigned int i, n, planelen;
+	int64_t ipos, base;
+	uint64_t num;
+	bool temporary;
+	float v, *planes;
+	const float *plane, *row, *coeffs;
+
+	// trivial case (direct transfer)
+	if( inrate == outrate ) {
+		for( i = 0; i < outcount; i++ ) {
+			ipos = (int64_t)( outfirst + i ) - infirst;
+
+			for( c = 0; c < channels; c++ ) {
+				n = i * channels + c;
+				if( ipos < 0 || ipos >= incount ) {
+					if( width == 2 ) {
+						( (short *)out )[n] = 0;
+					} else {
+						( (signed char *)out )[n] = 0;
+					}
+				} else if( width == 2 ) {
+					( (short *)out )[n] = ( (const short *)in )[ipos * channels + c];
+				} else {
+					( (signed char *)out )[n] = in[ipos * channels + c] - 128;
+				}
+			}
+		}
+		return outcount;
+	}
+
+	coeffs = S_FindResampleFilter( inrate, outrate, &temporary );
+
+	// deinterleave into zero padded float planes, source sample i is at i - infirst + taps
+	planelen = incount + taps * 2;
+	planes = S_Malloc( planelen * channels * sizeof( float ) );
+	memset( planes, 0, planelen * channels * sizeof( float ) );
+
+	for( c = 0; c < channels; c++ ) {
+		float *p = planes + c * planelen + taps;
+
+		if( width == 2 ) {
+			const short *s = (const short *)in + c;
+			for( i = 0; i < incount; i++, s += channels ) {
+				p[i] = *s;
+			}
+		} else {
+			const uint8_t *s = in + c;
+			for( i = 0; i < incount; i++, s += channels ) {
+				p[i] = (int)*s - 128;
+			}
+		}
+	}
+
+	for( i = 0; i < outcount; i++ ) {
+		num = (uint64_t)( outfirst + i ) * inrate;
+		ipos = num / outrate;
+		row = coeffs + ( ( num % outrate ) * SFX_RESAMPLE_PHASES / outrate ) * taps;
+		base = ipos - ( half - 1 ) - infirst + taps;
+
+		for( c = 0; c < channels; c++ ) {
+			plane = planes + c * planelen;
+
+			if( base >= 0 && base + taps <= planelen ) {
+				v = S_ResampleDot( plane + base, row, taps );
+			} else {
+				// way out of the input
+				v = 0;
+				for( k = 0; k < taps; k++ ) {
+					if( base + k >= 0 && base + k < planelen ) {
+						v += plane[base + k] * row[k];
+					}
+				}
+			}
+
+			v += v < 0 ? -0.5f : 0.5f;
+			if( width == 2 ) {
+				( (short *)out )[i * channels + c] = Q_bound( -32768, (int)v, 32767 );
+			} else {
+				( (signed char *)out )[i * channels + c] = Q_bound( -128, (int)v, 127 );
+			}
+		}
+	}
+
+	S_Free( planes );
+	if( temporary ) {
+		S_Free( (void *)coeffs );
+	}
+
+	return outcount;
+}
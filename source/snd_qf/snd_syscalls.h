@@ -236,3 +236,25 @@ static inline void trap_BufPipe_Wait( qbufPipe_t *queue, int ( *read )( qbufPipe
 									  unsigned( **cmdHandlers )( const void * ), unsigned timeout_msec ) {
 	SOUND_IMPORT.BufPipe_Wait( queue, read, cmdHandlers, timeout_msec );
 }
+
+static inline int trap_Jobs_NumWorkers( void ) {
+	return SOUND_IMPORT.Jobs_NumWorkers();
+}
+
+static inline struct qjob_s *trap_Job_Schedule( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+												unsigned items, unsigned grain, struct qjob_s **deps, unsigned numDeps ) {
+	return SOUND_IMPORT.Job_Schedule( func, arg, items, grain, deps, numDeps );
+}
+
+static inline void trap_Job_Wait( struct qjob_s *job ) {
+	SOUND_IMPORT.Job_Wait( job );
+}
+
+static inline void trap_Job_Release( struct qjob_s **pjob ) {
+	SOUND_IMPORT.Job_Release( pjob );
+}
+
+static inline void trap_Jobs_ParallelFor( void ( *func )( unsigned first, unsigned items, void *arg ), void *arg,
+										  unsigned items, unsigned grain ) {
+	SOUND_IMPORT.Jobs_ParallelFor( func, arg, items, grain );
+}
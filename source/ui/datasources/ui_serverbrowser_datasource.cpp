@@ -334,11 +334,8 @@ void ServerInfoFetcher::addQuery( const char *adr ) {
 // called to tell fetcher to remove this from jobs
 void ServerInfoFetcher::queryDone( const char *adr ) {
 	// remove from active list
-	ActiveList::iterator it = std::find_if(
-		activeQueries.begin(), activeQueries.end(), CompareAddress( adr ) );
-
-	if( it != activeQueries.end() ) {
-		activeQueries.erase( it );
+	if( activeQueries.erase( adr ) ) {
+		lastActivityTime = trap::Milliseconds();
 	}
 }
 
@@ -353,37 +350,56 @@ void ServerInfoFetcher::clearQueries() {
 // advance queries
 void ServerInfoFetcher::updateFrame() {
 	int64_t now = trap::Milliseconds();
-	int64_t treshold = now - ( TIMEOUT_SEC * 1000 );
-	ActiveList::iterator it;
-
-	// remove old items (timeout)
-	for( it = activeQueries.begin(); it != activeQueries.end(); ) {
-		if( it->first < treshold ) {
-			// Com_Printf("timeout: %s %u %u\n", it->second.c_str(), it->first, treshold );
-			// we should notify serverBrowser here about timeout
-			it = activeQueries.erase( it );
-		} else {
-			++it;
-		}
+	std::vector<std::string> batch;
+	size_t batchLength = 0;
+
+	// the client retries unanswered queries by itself and replies keep coming in while
+	// it's working through the list, so only give up on the rest once they stop
+	if( !activeQueries.empty() && now > lastActivityTime + TIMEOUT_SEC * 1000 ) {
+		// we should notify serverBrowser here about timeout
+		activeQueries.clear();
 	}
 
-	// populate active queries with ones on the waiting line
-	if( now > lastQueryTime + QUERY_TIMEOUT_MSEC && numWaiting() > 0 ) {
-		lastQueryTime = now;
-		startQuery( serverQueue.front() );
+	// hand the waiting line over to the client
+	for( unsigned int i = 0; i < MAX_QUERIES_PER_FRAME && numWaiting() > 0; i++ ) {
+		const std::string &adr = serverQueue.front();
+
+		// keep the command within what the command buffer tokenizes
+		if( batchLength + adr.size() + 1 >= MAX_STRING_CHARS - 16 ) {
+			startQueries( batch );
+			batch.clear();
+			batchLength = 0;
+		}
+
+		batch.push_back( adr );
+		batchLength += adr.size() + 1;
 		serverQueue.pop();
 	}
+
+	if( !batch.empty() ) {
+		startQueries( batch );
+	}
 }
 
-// initiates a query
-void ServerInfoFetcher::startQuery( const std::string &adr ) {
-	numIssuedQueries++;
+// initiates queries to a batch of servers
+void ServerInfoFetcher::startQueries( const std::vector<std::string> &adrs ) {
+	int64_t now = trap::Milliseconds();
+	std::string command( "pingserver" );
+
+	lastActivityTime = now;
 
-	// add to the active list
-	activeQueries.push_back( std::make_pair( trap::Milliseconds(), adr ) );
+	for( std::vector<std::string>::const_iterator it = adrs.begin(); it != adrs.end(); ++it ) {
+		numIssuedQueries++;
+
+		// add to the active list
+		activeQueries.insert( *it );
+
+		command += " " + *it;
+	}
 
-	// execute command to initiate the query
-	trap::Cmd_ExecuteText( EXEC_APPEND, va( "pingserver %s\n", adr.c_str() ) );
+	// execute command to initiate the queries
+	command += "\n";
+	trap::Cmd_ExecuteText( EXEC_APPEND, command.c_str() );
 }
 
 //=====================================
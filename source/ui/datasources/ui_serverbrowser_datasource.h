@@ -7,6 +7,7 @@
 #include <vector>
 #include <list>
 #include <queue>
+#include <set>
 
 #include "kernel/ui_utils.h"
 /*
@@ -192,25 +193,23 @@ public:
 	std::string gametype;
 };
 
-// Module that will queue server pings
+// Module that will queue server pings, the client paces the actual queries
 class ServerInfoFetcher
 {
-	// amount if simultaneous queries
-	static const unsigned int TIMEOUT_SEC = 5;      // secs until we replace with another job
-	static const unsigned int QUERY_TIMEOUT_MSEC = 50;      // time between subsequent queries to individual servers
+	static const unsigned int TIMEOUT_SEC = 5;      // secs without replies or new queries until active queries are given up on
+	static const unsigned int MAX_QUERIES_PER_FRAME = 256;
 
 	// waiting line
 	typedef std::queue<std::string> StringQueue;
 	StringQueue serverQueue;
 	// active queries
-	typedef std::pair<int64_t, std::string> ActiveQuery;
-	typedef std::list<ActiveQuery> ActiveList;
+	typedef std::set<std::string> ActiveSet;
 
-	ActiveList activeQueries;
+	ActiveSet activeQueries;
 
 public:
 	ServerInfoFetcher()
-		: lastQueryTime( 0 ), numIssuedQueries( 0 )
+		: lastActivityTime( 0 ), numIssuedQueries( 0 )
 	{}
 	~ServerInfoFetcher() {}
 
@@ -228,20 +227,11 @@ public:
 	unsigned int numIssued() const { return numIssuedQueries; }
 
 private:
-	int64_t lastQueryTime;
+	int64_t lastActivityTime;
 	unsigned int numIssuedQueries;
 
-	// compare address of active query
-	struct CompareAddress {
-		std::string address;
-		CompareAddress( const char *_address ) : address( _address ) {}
-		bool operator()( const ActiveQuery &other ) {
-			return address == other.second;
-		}
-	};
-
-	// initiates a query
-	void startQuery( const std::string &adr );
+	// initiates queries to a batch of servers
+	void startQueries( const std::vector<std::string> &adrs );
 };
 
 //================================================
@@ -87,6 +87,11 @@ float UI_FontEngineInterface::GetUnderline( FontFaceHandle handle, float &thickn
 	return pos;
 }
 
+int UI_FontEngineInterface::GetVersion( FontFaceHandle handle ) {
+	// the compiled string geometry keeps the texture coordinates of the glyphs
+	return (int)trap::SCR_FontAtlasGeneration( (qfontface_s *)( handle ) );
+}
+
 int UI_FontEngineInterface::GetStringWidth( FontFaceHandle handle, const String& string, Rml::Core::Character prior_character) {
 	return trap::SCR_strWidth( string.c_str(), (qfontface_s *)( handle ), 0 );
 }
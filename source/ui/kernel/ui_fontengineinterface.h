@@ -37,6 +37,9 @@ public:
 
 	virtual int GenerateString( Rml::Core::FontFaceHandle, Rml::Core::FontEffectsHandle , const Rml::Core::String & string, const Rml::Core::Vector2f & position, const Rml::Core::Colourb & colour, Rml::Core::GeometryList& geometry ) override;
 
+	// bumped when glyphs are evicted from the font images, RmlUi then generates the strings again
+	virtual int GetVersion( Rml::Core::FontFaceHandle ) override;
+
 	Rml::Core::RenderInterface *GetRenderInterface() { return render_interface; }
 
 	static void DrawCharCallback( int x, int y, int w, int h, float s1, float t1, float s2, float t2, const vec4_t color, const struct shader_s *shader );
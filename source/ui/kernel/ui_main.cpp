@@ -117,6 +117,7 @@ UI_Main::UI_Main( int vidWidth, int vidHeight, float pixelRatio,
 	trap::Cmd_AddCommand( "ui_reload", ReloadUI_Cmd_f );
 	trap::Cmd_AddCommand( "ui_dumpapi", DumpAPI_f );
 	trap::Cmd_AddCommand( "ui_printdocs", PrintDocuments_Cmd );
+	trap::Cmd_AddCommand( "ui_renderstats", PrintRenderStats_Cmd );
 
 	trap::Cmd_AddCommand( "menu_force", M_Menu_Force_f );
 	trap::Cmd_AddCommand( "menu_open", M_Menu_Open_f );
@@ -130,6 +131,7 @@ UI_Main::~UI_Main() {
 	trap::Cmd_RemoveCommand( "ui_reload" );
 	trap::Cmd_RemoveCommand( "ui_dumpapi" );
 	trap::Cmd_RemoveCommand( "ui_printdocs" );
+	trap::Cmd_RemoveCommand( "ui_renderstats" );
 
 	trap::Cmd_RemoveCommand( "menu_force" );
 	trap::Cmd_RemoveCommand( "menu_open" );
@@ -740,6 +742,8 @@ void UI_Main::refreshScreen( unsigned int time, int clientState, int serverState
 	// rocket update+render
 	rocketModule->update();
 
+	rocketModule->getRenderInterface()->BeginFrame();
+
 	if( overlayMenuVisible ) {
 		rocketModule->render( UI_CONTEXT_OVERLAY );
 	}
@@ -958,4 +962,12 @@ void UI_Main::PrintDocuments_Cmd( void ) {
 	}
 }
 
+void UI_Main::PrintRenderStats_Cmd( void ) {
+	if( !self ) {
+		return;
+	}
+
+	self->rocketModule->getRenderInterface()->PrintStats();
+}
+
 }
@@ -89,6 +89,7 @@ public:
 
 	// DEBUG
 	static void PrintDocuments_Cmd( void );
+	static void PrintRenderStats_Cmd( void );
 
 	// Other static functions
 	static UI_Main *Instance( int vidWidth, int vidHeight, float pixelRatio,
@@ -22,6 +22,10 @@ typedef Rml::Core::CompiledGeometryHandle CompiledGeometryHandle;
 
 typedef struct shader_s shader_t;
 
+// merged polys are copied to the renderer command buffer as a whole, so keep them reasonably small
+#define UI_MAX_BATCH_VERTS  4096
+#define UI_MAX_BATCH_ELEMS  ( UI_MAX_BATCH_VERTS * 3 )
+
 UI_RenderInterface::UI_RenderInterface( int vidWidth, int vidHeight, float pixelRatio )
 	: vid_width( vidWidth ), vid_height( vidHeight ), pixelRatio( pixelRatio ), polyAlloc() {
 	pixelsPerInch = basePixelsPerInch * pixelRatio;
@@ -35,9 +39,21 @@ UI_RenderInterface::UI_RenderInterface( int vidWidth, int vidHeight, float pixel
 	scissorHeight = vid_height;
 
 	whiteShader = trap::R_RegisterPic( "$whiteimage" );
+
+	currentSegments = nullptr;
+	currentContext = 0;
+	numCurrentSegments = 0;
+
+	memset( &stats, 0, sizeof( stats ) );
+	memset( &lastFrameStats, 0, sizeof( lastFrameStats ) );
 }
 
 UI_RenderInterface::~UI_RenderInterface() {
+	for( int i = 0; i < UI_NUM_CONTEXTS; i++ ) {
+		for( BatchSegment &segment : segments[i] ) {
+			FreeBatches( segment );
+		}
+	}
 }
 
 Rml::Core::CompiledGeometryHandle UI_RenderInterface::CompileGeometry( Rml::Core::Vertex *vertices, int num_vertices, int *indices, int num_indices, Rml::Core::TextureHandle texture ) {
@@ -53,7 +69,14 @@ void UI_RenderInterface::ReleaseCompiledGeometry( Rml::Core::CompiledGeometryHan
 		return;
 	}
 
+	// pending geometry may be released while rendering
+	FlushBatches();
+
 	poly_t *poly = ( poly_t * )geometry;
+
+	// the handle may be reused by new geometry
+	InvalidateBatches( poly );
+
 	polyAlloc.free( poly );
 }
 
@@ -64,18 +87,37 @@ void UI_RenderInterface::RenderCompiledGeometry( Rml::Core::CompiledGeometryHand
 
 	poly_t *poly = ( poly_t * )geometry;
 
-	trap::R_DrawStretchPoly( poly, translation.x, translation.y );
+	stats.geometries++;
+
+	if( !currentSegments ) {
+		stats.polys++;
+		stats.verts += poly->numverts;
+		trap::R_DrawStretchPoly( poly, translation.x, translation.y );
+		return;
+	}
+
+	BatchEntry entry = { poly, translation.x, translation.y };
+	pendingEntries.push_back( entry );
 }
 
 void UI_RenderInterface::RenderGeometry( Rml::Core::Vertex *vertices, int num_vertices, int *indices, int num_indices, Rml::Core::TextureHandle texture, const Rml::Core::Vector2f & translation ) {
 	poly_t *poly;
 
+	FlushBatches();
+
 	poly = RmlUiGeometry2Poly( true, vertices, num_vertices, indices, num_indices, texture );
 
+	stats.immediate++;
+	stats.polys++;
+	stats.verts += num_vertices;
 	trap::R_DrawStretchPoly( poly, translation.x, translation.y );
 }
 
 void UI_RenderInterface::SetScissorRegion( int x, int y, int width, int height ) {
+	if( scissorEnabled ) {
+		FlushBatches();
+	}
+
 	scissorX = x;
 	scissorY = y;
 	scissorWidth = width;
@@ -87,6 +129,8 @@ void UI_RenderInterface::SetScissorRegion( int x, int y, int width, int height )
 }
 
 void UI_RenderInterface::EnableScissorRegion( bool enable ) {
+	FlushBatches();
+
 	if( enable ) {
 		trap::R_Scissor( scissorX, scissorY, scissorWidth, scissorHeight );
 	} else {
@@ -155,6 +199,8 @@ bool UI_RenderInterface::LoadTexture( Rml::Core::TextureHandle & texture_handle,
 }
 
 void UI_RenderInterface::SetTransform( const Rml::Core::Matrix4f* transform ) {
+	FlushBatches();
+
 	if( transform == nullptr ) {
 		trap::R_SetTransformMatrix( NULL );
 		return;
@@ -231,4 +277,165 @@ void UI_RenderInterface::TouchAllCachedShaders( void ) {
 	}
 }
 
+void UI_RenderInterface::BeginFrame( void ) {
+	lastFrameStats = stats;
+	memset( &stats, 0, sizeof( stats ) );
+}
+
+void UI_RenderInterface::BeginRender( int contextId ) {
+	assert( contextId >= 0 && contextId < UI_NUM_CONTEXTS );
+
+	currentSegments = &segments[contextId];
+	currentContext = contextId;
+	numCurrentSegments = 0;
+	pendingEntries.clear();
+}
+
+void UI_RenderInterface::EndRender( void ) {
+	FlushBatches();
+
+	// free the batches of segments that are no longer rendered
+	for( size_t i = numCurrentSegments; i < currentSegments->size(); i++ ) {
+		UnlinkSegment( currentContext, i );
+		FreeBatches( ( *currentSegments )[i] );
+	}
+	currentSegments->resize( numCurrentSegments );
+
+	currentSegments = nullptr;
+}
+
+void UI_RenderInterface::FlushBatches( void ) {
+	if( !currentSegments || pendingEntries.empty() ) {
+		return;
+	}
+
+	if( numCurrentSegments == currentSegments->size() ) {
+		currentSegments->push_back( BatchSegment() );
+	}
+
+	size_t index = numCurrentSegments++;
+	BatchSegment &segment = ( *currentSegments )[index];
+	if( !segment.valid || segment.entries != pendingEntries ) {
+		UnlinkSegment( currentContext, index );
+		segment.entries.swap( pendingEntries );
+		LinkSegment( currentContext, index );
+		BuildBatches( segment );
+		stats.rebuilt++;
+	}
+	pendingEntries.clear();
+
+	for( const Batch &batch : segment.batches ) {
+		stats.polys++;
+		stats.verts += batch.poly->numverts;
+		trap::R_DrawStretchPoly( batch.poly, batch.x, batch.y );
+	}
+}
+
+void UI_RenderInterface::BuildBatches( BatchSegment &segment ) {
+	size_t i, j, numEntries = segment.entries.size();
+
+	FreeBatches( segment );
+
+	for( i = 0; i < numEntries; i = j ) {
+		const BatchEntry &first = segment.entries[i];
+		int numverts = first.poly->numverts, numelems = first.poly->numelems;
+
+		// merge the following geometry with the same shader
+		for( j = i + 1; j < numEntries; j++ ) {
+			const poly_t *poly = segment.entries[j].poly;
+			if( poly->shader != first.poly->shader ) {
+				break;
+			}
+			if( numverts + poly->numverts > UI_MAX_BATCH_VERTS || numelems + poly->numelems > UI_MAX_BATCH_ELEMS ) {
+				break;
+			}
+			numverts += poly->numverts;
+			numelems += poly->numelems;
+		}
+
+		if( j == i + 1 ) {
+			Batch batch = { first.poly, first.x, first.y, false };
+			segment.batches.push_back( batch );
+			continue;
+		}
+
+		poly_t *merged = polyAlloc.alloc( numverts, numelems );
+		int firstvert = 0, firstelem = 0;
+
+		for( size_t k = i; k < j; k++ ) {
+			const BatchEntry &entry = segment.entries[k];
+			const poly_t *poly = entry.poly;
+
+			for( int v = 0; v < poly->numverts; v++ ) {
+				vec_t *dest = merged->verts[firstvert + v];
+				dest[0] = poly->verts[v][0] + entry.x;
+				dest[1] = poly->verts[v][1] + entry.y;
+				dest[2] = poly->verts[v][2];
+				dest[3] = poly->verts[v][3];
+			}
+			memcpy( merged->normals + firstvert, poly->normals, poly->numverts * sizeof( vec4_t ) );
+			memcpy( merged->stcoords + firstvert, poly->stcoords, poly->numverts * sizeof( vec2_t ) );
+			memcpy( merged->colors + firstvert, poly->colors, poly->numverts * sizeof( byte_vec4_t ) );
+
+			for( int e = 0; e < poly->numelems; e++ ) {
+				merged->elems[firstelem + e] = poly->elems[e] + firstvert;
+			}
+
+			firstvert += poly->numverts;
+			firstelem += poly->numelems;
+		}
+
+		merged->shader = first.poly->shader;
+		merged->fognum = first.poly->fognum;
+		merged->renderfx = first.poly->renderfx;
+
+		Batch batch = { merged, 0, 0, true };
+		segment.batches.push_back( batch );
+	}
+
+	segment.valid = true;
+}
+
+void UI_RenderInterface::FreeBatches( BatchSegment &segment ) {
+	for( Batch &batch : segment.batches ) {
+		if( batch.owned ) {
+			polyAlloc.free( batch.poly );
+		}
+	}
+	segment.batches.clear();
+	segment.valid = false;
+}
+
+void UI_RenderInterface::LinkSegment( int contextId, size_t index ) {
+	for( const BatchEntry &entry : segments[contextId][index].entries ) {
+		polySegments.insert( PolySegmentMap::value_type( entry.poly, BatchSegmentRef( contextId, index ) ) );
+	}
+}
+
+void UI_RenderInterface::UnlinkSegment( int contextId, size_t index ) {
+	for( const BatchEntry &entry : segments[contextId][index].entries ) {
+		auto range = polySegments.equal_range( entry.poly );
+		for( auto it = range.first; it != range.second; ++it ) {
+			if( it->second.first == contextId && it->second.second == index ) {
+				polySegments.erase( it );
+				break;
+			}
+		}
+	}
+}
+
+void UI_RenderInterface::InvalidateBatches( const poly_t *poly ) {
+	// only the segments merging the geometry, they keep the entries to be relinked when rebuilt
+	auto range = polySegments.equal_range( poly );
+	for( auto it = range.first; it != range.second; ++it ) {
+		segments[it->second.first][it->second.second].valid = false;
+	}
+}
+
+void UI_RenderInterface::PrintStats( void ) const {
+	Com_Printf( "%u compiled geometries, %u immediate\n", lastFrameStats.geometries, lastFrameStats.immediate );
+	Com_Printf( "%u polys, %u verts submitted\n", lastFrameStats.polys, lastFrameStats.verts );
+	Com_Printf( "%u batch segments rebuilt\n", lastFrameStats.rebuilt );
+}
+
 }
@@ -11,6 +11,7 @@
 #define UI_RENDERINTERFACE_H_
 
 #include <map>
+#include <vector>
 #include "kernel/ui_polyallocator.h"
 #include <RmlUi/Core/RenderInterface.h>
 
@@ -62,6 +63,16 @@ public:
 	void ClearShaderCache( void );
 	void TouchAllCachedShaders( void );
 
+	/// Starts a new frame, resetting the statistics.
+	void BeginFrame( void );
+	/// Compiled geometry of the context is batched between these calls.
+	void BeginRender( int contextId );
+	void EndRender( void );
+	/// Submits the batched geometry, must be called before drawing anything without RmlUi.
+	void FlushBatches( void );
+
+	void PrintStats( void ) const;
+
    private:
 	const float basePixelsPerInch = Q_BASE_DPI;
 
@@ -80,6 +91,61 @@ public:
 	PolyAllocator polyAlloc;
 	struct shader_s *whiteShader;
 
+	// compiled geometry rendered with the same scissor and transform
+	struct BatchEntry {
+		poly_t *poly;
+		float x, y;
+
+		bool operator==( const BatchEntry &other ) const {
+			return poly == other.poly && x == other.x && y == other.y;
+		}
+	};
+
+	// merged geometry sent to the renderer
+	struct Batch {
+		poly_t *poly;
+		float x, y;
+		bool owned;
+	};
+
+	// batches are kept between frames and only rebuilt if the geometry in them changes
+	struct BatchSegment {
+		std::vector<BatchEntry> entries;
+		std::vector<Batch> batches;
+		bool valid;
+
+		BatchSegment() : valid( false ) {}
+	};
+
+	typedef std::vector<BatchSegment> BatchSegmentList;
+
+	// context and index of a segment, which keeps its index for as long as it is rendered
+	typedef std::pair<int, size_t> BatchSegmentRef;
+	typedef std::multimap<const poly_t *, BatchSegmentRef> PolySegmentMap;
+
+	struct RenderStats {
+		unsigned int geometries;        // compiled geometry rendered
+		unsigned int immediate;         // geometry rendered without compiling
+		unsigned int polys;             // polys submitted to the renderer
+		unsigned int verts;
+		unsigned int rebuilt;           // segments rebuilt because their geometry changed
+	};
+
+	BatchSegmentList segments[UI_NUM_CONTEXTS];
+	BatchSegmentList *currentSegments;
+	int currentContext;
+	unsigned int numCurrentSegments;
+	PolySegmentMap polySegments;    // segments referencing each compiled geometry
+	std::vector<BatchEntry> pendingEntries;
+
+	RenderStats stats, lastFrameStats;
+
+	void BuildBatches( BatchSegment &segment );
+	void FreeBatches( BatchSegment &segment );
+	void LinkSegment( int contextId, size_t index );
+	void UnlinkSegment( int contextId, size_t index );
+	void InvalidateBatches( const poly_t *poly );
+
 	typedef std::map<std::string, char> ShaderMap;
 	ShaderMap shaderMap;
 
@@ -379,7 +379,9 @@ void RocketModule::update( void ) {
 }
 
 void RocketModule::render( int contextId ) {
+	renderInterface->BeginRender( contextId );
 	contextForId( contextId )->Render();
+	renderInterface->EndRender();
 }
 
 void RocketModule::registerCustoms() {
@@ -233,6 +233,10 @@ inline size_t SCR_FontXHeight( struct qfontface_s *font ) {
 	return UI_IMPORT.SCR_FontXHeight( font );
 }
 
+inline unsigned int SCR_FontAtlasGeneration( struct qfontface_s *font ) {
+	return UI_IMPORT.SCR_FontAtlasGeneration( font );
+}
+
 inline size_t SCR_strWidth( const char *str, struct qfontface_s *font, size_t maxlen ) {
 	return UI_IMPORT.SCR_strWidth( str, font, maxlen, UI_IMPORT_TEXTDRAWFLAGS );
 }
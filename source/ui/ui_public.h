@@ -21,7 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #ifndef __UI_PUBLIC_H__
 #define __UI_PUBLIC_H__
 
-#define UI_API_VERSION      67
+#define UI_API_VERSION      68
 
 typedef size_t ( *ui_async_stream_read_cb_t )( const void *buf, size_t numb, float percentage,
 											 int status, const char *contentType, void *privatep );
@@ -126,6 +126,7 @@ typedef struct {
 	int ( *SCR_FontUnderline )( struct qfontface_s *font, int *thickness );
 	size_t ( *SCR_FontAdvance )( struct qfontface_s *font );
 	size_t ( *SCR_FontXHeight )( struct qfontface_s *font );
+	unsigned int ( *SCR_FontAtlasGeneration )( struct qfontface_s *font );
 	size_t ( *SCR_strWidth )( const char *str, struct qfontface_s *font, size_t maxlen, int flags );
 	size_t ( *SCR_StrlenForWidth )( const char *str, struct qfontface_s *font, size_t maxwidth, int flags );
 	ui_fdrawchar_t ( *SCR_SetDrawCharIntercept )( ui_fdrawchar_t intercept );
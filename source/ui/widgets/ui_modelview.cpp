@@ -120,6 +120,12 @@ public:
 		refdef.scissor_width = std::min( scissor_w, refdef.width );
 		refdef.scissor_height = std::min( scissor_h, refdef.height );
 
+		// draw the batched UI geometry behind the scene first
+		UI_RenderInterface *renderer = dynamic_cast<UI_RenderInterface *>( GetRenderInterface() );
+		if( renderer ) {
+			renderer->FlushBatches();
+		}
+
 		trap::R_ClearScene();
 
 		trap::R_AddEntityToScene( &entity );
@@ -145,6 +145,12 @@ public:
 		refdef.scissor_height = std::min( scissor_h, refdef.height );
 		refdef.colorCorrection = colorCorrectionShader;
 
+		// draw the batched UI geometry behind the scene first
+		UI_RenderInterface *renderer = dynamic_cast<UI_RenderInterface *>( GetRenderInterface() );
+		if( renderer ) {
+			renderer->FlushBatches();
+		}
+
 		trap::R_ClearScene();
 
 		AddLightStylesToScene();
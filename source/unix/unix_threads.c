@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "../qcommon/sys_threads.h"
 #include <pthread.h>
 #include <sched.h>
+#include <unistd.h>
 #include <sys/time.h>
 
 struct qthread_s {
@@ -120,6 +121,14 @@ void Sys_Thread_Yield( void ) {
 	sched_yield();
 }
 
+/*
+* Sys_GetNumberOfProcessors
+*/
+int Sys_GetNumberOfProcessors( void ) {
+	long numProcs = sysconf( _SC_NPROCESSORS_ONLN );
+	return numProcs > 0 ? (int)numProcs : 1;
+}
+
 /*
 * Sys_Atomic_Add
 */
@@ -173,6 +173,16 @@ void Sys_Thread_Yield( void ) {
 	Sys_Sleep( 0 );
 }
 
+/*
+* Sys_GetNumberOfProcessors
+*/
+int Sys_GetNumberOfProcessors( void ) {
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
 /*
 * Sys_Atomic_Add
 */